@@ -0,0 +1,65 @@
+/*
+ * Nombre del archivo: BlockDevice.h
+ * Descripción: Sustituto de la interfaz BlockDevice de Mbed OS para compilar en PC.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef HOST_BLOCKDEVICE_H
+#define HOST_BLOCKDEVICE_H
+
+/** @file
+ ** @brief Interfaz BlockDevice de Mbed OS (solo la superficie usada).
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdint.h>
+
+/* === Public macros definitions =============================================================== */
+
+#define BD_ERROR_OK 0  ///< Operación correcta
+#define BD_ERROR_DEVICE_ERROR -4001  ///< Falla del dispositivo
+
+/* === Public data type declarations =========================================================== */
+
+typedef uint64_t bd_addr_t;
+typedef uint64_t bd_size_t;
+
+/* === Public class declarations =============================================================== */
+
+class BlockDevice {
+public:
+    virtual ~BlockDevice() {}
+    virtual int init() = 0;
+    virtual int deinit() = 0;
+    virtual int read(void* buffer, bd_addr_t addr, bd_size_t size) = 0;
+    virtual int program(const void* buffer, bd_addr_t addr, bd_size_t size) = 0;
+    virtual int erase(bd_addr_t addr, bd_size_t size) = 0;
+    virtual bd_size_t get_read_size() const = 0;
+    virtual bd_size_t get_program_size() const = 0;
+    virtual bd_size_t get_erase_size() const = 0;
+    virtual int get_erase_value() const { return -1; }
+    virtual bd_size_t size() const = 0;
+};
+
+/* === End of documentation ==================================================================== */
+
+#endif /* HOST_BLOCKDEVICE_H */
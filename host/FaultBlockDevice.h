@@ -0,0 +1,140 @@
+/*
+ * Nombre del archivo: FaultBlockDevice.h
+ * Descripción: Envoltorio de BlockDevice con cortes de energía simulados.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef HOST_FAULTBLOCKDEVICE_H
+#define HOST_FAULTBLOCKDEVICE_H
+
+/** @file
+ ** @brief Inyección de fallas sobre otro BlockDevice (solo PC).
+ **
+ ** Con armCut(n) el corte de energía ocurre al cabo de n bytes programados:
+ ** la programación en curso queda a medias (los primeros bytes escritos, el
+ ** resto intacto) y un borrado en curso deja el bloque con basura. Desde ese
+ ** momento todas las operaciones fallan hasta powerOn(). También cuenta los
+ ** borrados de cada bloque para medir el desgaste.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdlib.h>
+
+#include <vector>
+
+#include "BlockDevice.h"
+
+/* === Public class declarations =============================================================== */
+
+class FaultBlockDevice : public BlockDevice {
+public:
+    FaultBlockDevice(BlockDevice* device)
+        : device(device), erases(device->size() / device->get_erase_size(), 0) {}
+
+    /** @brief Programa un corte de energía al cabo de bytes bytes programados o borrados. */
+    void armCut(uint64_t bytes) {
+        budget = bytes;
+        armed = true;
+    }
+
+    /** @brief Restablece la energía. */
+    void powerOn() {
+        armed = false;
+        lost = false;
+    }
+
+    bool powerLost() const { return lost; }
+    uint32_t eraseCount(size_t block) const { return erases[block]; }
+    size_t blockCount() const { return erases.size(); }
+    uint64_t bytesProgrammed() const { return programmed; }
+
+    int init() override { return lost ? BD_ERROR_DEVICE_ERROR : device->init(); }
+    int deinit() override { return device->deinit(); }
+
+    int read(void* buffer, bd_addr_t addr, bd_size_t size) override {
+        return lost ? BD_ERROR_DEVICE_ERROR : device->read(buffer, addr, size);
+    }
+
+    int program(const void* buffer, bd_addr_t addr, bd_size_t size) override {
+        if (lost) {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+        if (armed && budget < size) {
+            // Escritura cortada: solo llegan las unidades completas anteriores al corte
+            bd_size_t unit = device->get_program_size();
+            bd_size_t partial = budget / unit * unit;
+            if (partial > 0) {
+                device->program(buffer, addr, partial);
+            }
+            lost = true;
+            return BD_ERROR_DEVICE_ERROR;
+        }
+        if (armed) {
+            budget -= size;
+        }
+        programmed += size;
+        return device->program(buffer, addr, size);
+    }
+
+    int erase(bd_addr_t addr, bd_size_t size) override {
+        if (lost) {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+        if (armed && budget < size) {
+            // Borrado interrumpido: el bloque queda con contenido indeterminado
+            std::vector<uint8_t> noise(device->get_program_size());
+            for (bd_size_t offset = 0; offset < size; offset += noise.size()) {
+                for (uint8_t& byte : noise) {
+                    byte = (uint8_t)rand();
+                }
+                device->program(noise.data(), addr + offset, noise.size());
+            }
+            lost = true;
+            return BD_ERROR_DEVICE_ERROR;
+        }
+        if (armed) {
+            budget -= size;
+        }
+        for (bd_size_t offset = 0; offset < size; offset += device->get_erase_size()) {
+            erases[(addr + offset) / device->get_erase_size()]++;
+        }
+        return device->erase(addr, size);
+    }
+
+    bd_size_t get_read_size() const override { return device->get_read_size(); }
+    bd_size_t get_program_size() const override { return device->get_program_size(); }
+    bd_size_t get_erase_size() const override { return device->get_erase_size(); }
+    int get_erase_value() const override { return device->get_erase_value(); }
+    bd_size_t size() const override { return device->size(); }
+
+private:
+    BlockDevice* device;
+    std::vector<uint32_t> erases;
+    uint64_t budget = 0;
+    uint64_t programmed = 0;
+    bool armed = false;
+    bool lost = false;
+};
+
+/* === End of documentation ==================================================================== */
+
+#endif /* HOST_FAULTBLOCKDEVICE_H */
@@ -0,0 +1,54 @@
+/*
+ * Nombre del archivo: FlashIAPBlockDevice.h
+ * Descripción: Sustituto de FlashIAPBlockDevice de Mbed OS sobre memoria del PC.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef HOST_FLASHIAPBLOCKDEVICE_H
+#define HOST_FLASHIAPBLOCKDEVICE_H
+
+/** @file
+ ** @brief FlashIAPBlockDevice simulado con la geometría de los sectores de
+ ** 128 KB del banco 2 del STM32F429ZI.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include "HeapBlockDevice.h"
+
+/* === Public macros definitions =============================================================== */
+
+#define HOST_FLASH_SECTOR_SIZE (128 * 1024)  ///< Sectores 17 a 23 del STM32F429ZI
+#define HOST_FLASH_PROGRAM_SIZE 4  ///< Programación por palabras
+
+/* === Public class declarations =============================================================== */
+
+class FlashIAPBlockDevice : public HeapBlockDevice {
+public:
+    FlashIAPBlockDevice(uint32_t address, uint32_t size)
+        : HeapBlockDevice(size, 1, HOST_FLASH_PROGRAM_SIZE, HOST_FLASH_SECTOR_SIZE) {
+        (void)address;
+    }
+};
+
+/* === End of documentation ==================================================================== */
+
+#endif /* HOST_FLASHIAPBLOCKDEVICE_H */
@@ -0,0 +1,97 @@
+/*
+ * Nombre del archivo: HeapBlockDevice.h
+ * Descripción: Dispositivo de bloques en memoria con semántica de flash NOR.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef HOST_HEAPBLOCKDEVICE_H
+#define HOST_HEAPBLOCKDEVICE_H
+
+/** @file
+ ** @brief HeapBlockDevice de Mbed OS con semántica de flash NOR.
+ **
+ ** A diferencia del de Mbed, el borrado deja 0xFF y la programación solo
+ ** puede bajar bits (AND con el contenido), de modo que programar dos veces
+ ** la misma zona sin borrar produce datos corruptos, como en el chip real.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <assert.h>
+#include <string.h>
+
+#include <vector>
+
+#include "BlockDevice.h"
+
+/* === Public class declarations =============================================================== */
+
+class HeapBlockDevice : public BlockDevice {
+public:
+    HeapBlockDevice(bd_size_t size, bd_size_t read, bd_size_t program, bd_size_t erase)
+        : data(size, 0xFF), readSize(read), programSize(program), eraseSize(erase) {
+        assert(size % erase == 0 && erase % program == 0 && program % read == 0);
+    }
+    HeapBlockDevice(bd_size_t size, bd_size_t block = 512) : HeapBlockDevice(size, block, block, block) {}
+
+    int init() override { return BD_ERROR_OK; }
+    int deinit() override { return BD_ERROR_OK; }
+
+    int read(void* buffer, bd_addr_t addr, bd_size_t size) override {
+        assert(addr % readSize == 0 && size % readSize == 0 && addr + size <= data.size());
+        memcpy(buffer, &data[addr], size);
+        return BD_ERROR_OK;
+    }
+
+    int program(const void* buffer, bd_addr_t addr, bd_size_t size) override {
+        assert(addr % programSize == 0 && size % programSize == 0 && addr + size <= data.size());
+        const uint8_t* bytes = (const uint8_t*)buffer;
+        for (bd_size_t i = 0; i < size; i++) {
+            data[addr + i] &= bytes[i];
+        }
+        return BD_ERROR_OK;
+    }
+
+    int erase(bd_addr_t addr, bd_size_t size) override {
+        assert(addr % eraseSize == 0 && size % eraseSize == 0 && addr + size <= data.size());
+        memset(&data[addr], 0xFF, size);
+        return BD_ERROR_OK;
+    }
+
+    bd_size_t get_read_size() const override { return readSize; }
+    bd_size_t get_program_size() const override { return programSize; }
+    bd_size_t get_erase_size() const override { return eraseSize; }
+    int get_erase_value() const override { return 0xFF; }
+    bd_size_t size() const override { return data.size(); }
+
+    /** @brief Acceso directo al contenido, solo para herramientas de PC. */
+    uint8_t* raw() { return data.data(); }
+
+private:
+    std::vector<uint8_t> data;
+    bd_size_t readSize;
+    bd_size_t programSize;
+    bd_size_t eraseSize;
+};
+
+/* === End of documentation ==================================================================== */
+
+#endif /* HOST_HEAPBLOCKDEVICE_H */
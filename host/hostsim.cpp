@@ -0,0 +1,504 @@
+/*
+ * Nombre del archivo: hostsim.cpp
+ * Descripción: Simulador de la plataforma (reloj virtual, pines, puerto serie y colas de eventos).
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Implementación del simulador de la plataforma.
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include "mbed.h"
+#include "stm32f4xx_hal.h"
+
+#include <assert.h>
+#include <errno.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <set>
+
+#include "hostsim.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define HOST_PIN_COUNT 128  ///< Pines simulados
+#define HOST_SERIAL_TXBUF_SIZE 256  ///< Igual que MBED_CONF_DRIVERS_UART_SERIAL_TXBUF_SIZE
+#define US_PER_S 1000000ULL
+#define HOST_BACKUP_WORDS 1024  ///< Igual que CHECKPOINT_BACKUP_WORDS
+
+/* === Private variable declarations =========================================================== */
+
+static std::atomic<uint64_t> clockUs(0);  ///< Atómico: con Thread lo leen varios hilos
+static time_t rtcOffset = 0;  ///< Segundos del RTC en el instante 0 del reloj virtual
+static bool rtcEnabled = false;  ///< El RTC recibió una fecha con set_time()
+static const hostStimulus_t* stimulus = NULL;
+
+static uint8_t pinLevels[HOST_PIN_COUNT];
+static std::multimap<int, InterruptIn*> interruptPins;
+
+static hostSerialSink_t serialSink = NULL;
+static uint64_t serialBytes = 0;
+static uint64_t serialBlockedUs = 0;
+static std::deque<char> serialInput;
+static std::set<BufferedSerial*> sigioPorts;  ///< Puertos con sigio() registrado
+
+static int capturePin = -1;  ///< Pin del modelo de captura (-1 = sin captura)
+static uint32_t* captureRing = NULL;
+static size_t captureLength = 0;
+static size_t captureIndex = 0;
+static uint32_t captureFilterUs = 0;
+static int captureLevel = 0;  ///< Nivel a la salida del filtro
+static bool capturePending = false;  ///< Hay un cambio esperando a que pase el filtro
+static uint64_t capturePendingUs = 0;
+
+static volatile uint32_t backupMemory[HOST_BACKUP_WORDS];
+static int64_t backupBudget = -1;  ///< Escrituras hasta el corte (negativo = sin corte)
+static uint64_t backupWrites = 0;
+
+static hostIdle_t idleHook = NULL;
+static thread_local Thread* currentThread = NULL;  ///< Thread que corre en este hilo del sistema
+static hostEventStats_t eventStats;
+
+/* === Private function implementation ========================================================= */
+
+/**
+ * @brief Confirma el cambio pendiente si el nivel se mantuvo durante el filtro hasta untilUs.
+ */
+static void captureSettle(uint64_t untilUs) {
+    if (capturePending && untilUs >= capturePendingUs + captureFilterUs) {
+        captureLevel = !captureLevel;
+        captureRing[captureIndex] = (uint32_t)(capturePendingUs + captureFilterUs);
+        captureIndex = (captureIndex + 1) % captureLength;
+        capturePending = false;
+    }
+}
+
+/**
+ * @brief Flanco en el pin de captura: un cambio que se deshace antes del filtro no se captura.
+ */
+static void captureEdge(int level) {
+    captureSettle(clockUs);
+    if (capturePending) {
+        capturePending = false;  // Volvió al nivel filtrado antes de tiempo
+    } else if (level != captureLevel) {
+        capturePending = true;
+        capturePendingUs = clockUs;
+    }
+}
+
+/* === Public function implementation ========================================================== */
+
+uint64_t hostClockNowUs() {
+    return clockUs;
+}
+
+void hostClockAdvanceTo(uint64_t targetUs) {
+    uint64_t edgeUs;
+
+    while (stimulus != NULL && (edgeUs = stimulus->next()) <= targetUs) {
+        if (edgeUs > clockUs) {
+            clockUs = edgeUs;
+        }
+        stimulus->fire();
+    }
+    if (targetUs > clockUs) {
+        clockUs = targetUs;
+    }
+}
+
+void hostSetStimulus(const hostStimulus_t* source) {
+    stimulus = source;
+}
+
+void hostPinWrite(int pin, int level) {
+    assert(pin >= 0 && pin < HOST_PIN_COUNT);
+
+    level = level != 0;
+    if (pinLevels[pin] == level) {
+        return;
+    }
+    pinLevels[pin] = level;
+    if (pin == capturePin) {
+        captureEdge(level);
+    }
+
+    auto range = interruptPins.equal_range(pin);
+    for (auto it = range.first; it != range.second; ++it) {
+        it->second->edge(level);
+    }
+}
+
+int hostPinRead(int pin) {
+    assert(pin >= 0 && pin < HOST_PIN_COUNT);
+
+    return pinLevels[pin];
+}
+
+void hostCaptureStart(int pin, uint32_t* ring, size_t length, uint32_t filterUs) {
+    assert(pin >= 0 && pin < HOST_PIN_COUNT);
+    assert(ring != NULL && length > 0);
+
+    capturePin = pin;
+    captureRing = ring;
+    captureLength = length;
+    captureIndex = 0;
+    captureFilterUs = filterUs;
+    captureLevel = pinLevels[pin];
+    capturePending = false;
+}
+
+size_t hostCaptureIndex() {
+    if (captureRing != NULL) {
+        captureSettle(clockUs);
+    }
+    return captureIndex;
+}
+
+volatile uint32_t* hostBackupMemory() {
+    return backupMemory;
+}
+
+void hostBackupWrite(volatile uint32_t* word, uint32_t value) {
+    assert(word >= backupMemory && word < backupMemory + HOST_BACKUP_WORDS);
+
+    if (backupBudget == 0) {
+        return;
+    }
+    if (backupBudget > 0) {
+        backupBudget--;
+    }
+    *word = value;
+    backupWrites++;
+}
+
+void hostBackupCutAfter(int64_t writes) {
+    backupBudget = writes;
+}
+
+uint64_t hostBackupWrites() {
+    return backupWrites;
+}
+
+void hostSerialSetSink(hostSerialSink_t sink) {
+    serialSink = sink;
+}
+
+uint64_t hostSerialBytesWritten() {
+    return serialBytes;
+}
+
+uint64_t hostSerialBlockedUs() {
+    return serialBlockedUs;
+}
+
+void hostSerialInject(const char* data, size_t length) {
+    serialInput.insert(serialInput.end(), data, data + length);
+    for (BufferedSerial* port : sigioPorts) {
+        port->input();
+    }
+}
+
+void hostSetIdle(hostIdle_t idle) {
+    idleHook = idle;
+}
+
+void hostEventGetStats(hostEventStats_t* stats) {
+    assert(stats != NULL);
+
+    *stats = eventStats;
+}
+
+/* === Mbed / HAL ============================================================================== */
+
+extern "C" uint32_t HAL_GetTick(void) {
+    return (uint32_t)(clockUs / 1000);
+}
+
+/*
+ * Reemplaza a time() de la biblioteca C para que el firmware vea el RTC
+ * virtual, igual que en Mbed donde time() lee el RTC.
+ */
+extern "C" time_t time(time_t* timer) __THROW {
+    time_t now = rtc_read();
+    if (timer != NULL) {
+        *timer = now;
+    }
+    return now;
+}
+
+void set_time(time_t seconds) {
+    rtcOffset = seconds - (time_t)(clockUs / US_PER_S);
+    rtcEnabled = true;
+}
+
+int rtc_isenabled() {
+    return rtcEnabled ? 1 : 0;
+}
+
+time_t rtc_read() {
+    return rtcOffset + (time_t)(clockUs / US_PER_S);
+}
+
+uint32_t us_ticker_read() {
+    return (uint32_t)clockUs;
+}
+
+void thread_sleep_for(uint32_t millisec) {
+    hostClockAdvanceTo(clockUs + (uint64_t)millisec * 1000);
+}
+
+int PortIn::read() {
+    int value = 0;
+    for (int bit = 0; bit < 16; bit++) {
+        value |= hostPinRead((int)port * 16 + bit) << bit;
+    }
+    return value & mask;
+}
+
+InterruptIn::InterruptIn(PinName pin) : pin(pin) {
+    interruptPins.insert(std::make_pair((int)pin, this));
+}
+
+InterruptIn::InterruptIn(PinName pin, PinMode) : InterruptIn(pin) {}
+
+InterruptIn::~InterruptIn() {
+    auto range = interruptPins.equal_range(pin);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == this) {
+            interruptPins.erase(it);
+            break;
+        }
+    }
+}
+
+void InterruptIn::edge(int level) {
+    Callback<void()>& handler = level ? riseHandler : fallHandler;
+    if (handler) {
+        handler();
+    }
+}
+
+BufferedSerial::BufferedSerial(PinName, PinName, int baud) : baud(baud) {}
+
+BufferedSerial::~BufferedSerial() {
+    sigioPorts.erase(this);
+}
+
+void BufferedSerial::sigio(Callback<void()> function) {
+    sigioHandler = function;
+    if (function) {
+        sigioPorts.insert(this);
+    } else {
+        sigioPorts.erase(this);
+    }
+}
+
+void BufferedSerial::input() {
+    if (sigioHandler) {
+        sigioHandler();
+    }
+}
+
+/*
+ * Vacía el buffer de transmisión simulado al ritmo de la línea:
+ * 10 bits por byte (inicio + 8 datos + parada).
+ */
+void BufferedSerial::drain() {
+    if (txLevel == 0) {
+        lastDrainUs = clockUs;
+        return;
+    }
+
+    uint64_t sent = (clockUs - lastDrainUs) * baud / 10 / US_PER_S;
+    if (sent >= txLevel) {
+        txLevel = 0;
+        lastDrainUs = clockUs;
+    } else if (sent > 0) {
+        txLevel -= sent;
+        lastDrainUs += sent * 10 * US_PER_S / baud;
+    }
+}
+
+ssize_t BufferedSerial::write(const void* buffer, size_t length) {
+    const char* data = (const char*)buffer;
+    size_t written = 0;
+
+    drain();
+    while (written < length) {
+        size_t space = HOST_SERIAL_TXBUF_SIZE - txLevel;
+        if (space == 0) {
+            if (!blocking) {
+                break;
+            }
+            // Espera bloqueante: el reloj avanza lo que tarda en salir un byte
+            uint64_t waitUs = (10 * US_PER_S + baud - 1) / baud;
+            serialBlockedUs += waitUs;
+            hostClockAdvanceTo(clockUs + waitUs);
+            drain();
+            continue;
+        }
+        size_t chunk = length - written < space ? length - written : space;
+        if (serialSink != NULL) {
+            serialSink(data + written, chunk);
+        }
+        txLevel += chunk;
+        written += chunk;
+    }
+
+    serialBytes += written;
+    if (written == 0 && length > 0) {
+        return -EAGAIN;
+    }
+    return (ssize_t)written;
+}
+
+ssize_t BufferedSerial::read(void* buffer, size_t length) {
+    char* data = (char*)buffer;
+    size_t count = 0;
+
+    while (count < length && !serialInput.empty()) {
+        data[count++] = serialInput.front();
+        serialInput.pop_front();
+    }
+    if (count == 0 && length > 0) {
+        return -EAGAIN;
+    }
+    return (ssize_t)count;
+}
+
+bool BufferedSerial::readable() {
+    return !serialInput.empty();
+}
+
+bool BufferedSerial::writable() {
+    drain();
+    return txLevel < HOST_SERIAL_TXBUF_SIZE;
+}
+
+Thread::~Thread() {
+    if (thread.joinable()) {
+        thread.detach();
+    }
+}
+
+osStatus Thread::start(Callback<void()> task) {
+    if (thread.joinable()) {
+        return osError;
+    }
+    thread = std::thread([this, task]() {
+        currentThread = this;
+        task();
+    });
+    return osOK;
+}
+
+osStatus Thread::join() {
+    if (!thread.joinable()) {
+        return osError;
+    }
+    thread.join();
+    return osOK;
+}
+
+uint32_t Thread::flags_set(uint32_t set) {
+    std::lock_guard<std::mutex> lock(mutex);
+    flags |= set;
+    signal.notify_all();
+    return flags;
+}
+
+uint32_t Thread::waitFlags(uint32_t wanted, bool clear, int64_t timeoutUs) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto ready = [this, wanted]() { return (flags & wanted) != 0; };
+
+    if (timeoutUs < 0) {
+        signal.wait(lock, ready);
+    } else {
+        signal.wait_for(lock, std::chrono::microseconds(timeoutUs), ready);
+    }
+
+    uint32_t result = flags;
+    if (clear) {
+        flags &= ~wanted;
+    }
+    return result;
+}
+
+uint32_t ThisThread::waitFlags(uint32_t flags, bool clear, int64_t timeoutUs) {
+    assert(currentThread != NULL);  // Solo los Thread tienen marcas
+
+    return currentThread->waitFlags(flags, clear, timeoutUs);
+}
+
+int EventQueue::post(uint64_t delayUs, uint64_t periodUs, Callback<void()> function) {
+    if (events.size() >= capacity) {
+        return 0;  // Como Mbed: sin lugar en el buffer el evento no se encola
+    }
+    int id = nextId++;
+    events[id] = Event{clockUs + delayUs, periodUs, function};
+    return id;
+}
+
+void EventQueue::dispatch_forever() {
+    breakRequested = false;
+
+    while (!breakRequested) {
+        auto next = events.end();
+        for (auto it = events.begin(); it != events.end(); ++it) {
+            if (next == events.end() || it->second.dueUs < next->second.dueUs) {
+                next = it;
+            }
+        }
+
+        if (next != events.end() && next->second.dueUs <= clockUs) {
+            Callback<void()> function = next->second.function;
+            if (next->second.periodUs != 0) {
+                next->second.dueUs += next->second.periodUs;
+            } else {
+                events.erase(next);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            function();
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            eventStats.dispatched++;
+            eventStats.busyNs += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+            continue;
+        }
+
+        uint64_t nextDue = next != events.end() ? next->second.dueUs : HOST_TIME_NEVER;
+        if (idleHook != NULL) {
+            if (!idleHook(nextDue)) {
+                break;
+            }
+        } else if (nextDue == HOST_TIME_NEVER) {
+            break;
+        } else {
+            hostClockAdvanceTo(nextDue);
+        }
+    }
+}
+
+/* === End of documentation ==================================================================== */
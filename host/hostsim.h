@@ -0,0 +1,160 @@
+/*
+ * Nombre del archivo: hostsim.h
+ * Descripción: Control del simulador de la plataforma para compilación en PC.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef HOSTSIM_H
+#define HOSTSIM_H
+
+/** @file
+ ** @brief Control del simulador de la plataforma.
+ **
+ ** Los sustitutos de host/mbed.h y host/stm32f4xx_hal.h funcionan sobre un
+ ** reloj virtual en microsegundos que solo avanza cuando lo pide la
+ ** herramienta que conduce la simulación (o una escritura bloqueante del
+ ** puerto serie). Los flancos de entrada se inyectan mediante un estímulo:
+ ** al avanzar el reloj, cada flanco pendiente se aplica exactamente en su
+ ** instante, disparando las InterruptIn asociadas como lo haría el hardware.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* === Public macros definitions =============================================================== */
+
+#define HOST_TIME_NEVER UINT64_MAX  ///< Instante que nunca llega
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Fuente de flancos simulada.
+ */
+typedef struct {
+    uint64_t (*next)(void);  ///< Instante en us del próximo flanco, o HOST_TIME_NEVER
+    void (*fire)(void);  ///< Aplica el próximo flanco (el reloj ya está en su instante)
+} hostStimulus_t;
+
+/**
+ * @brief Destino de los bytes escritos en un BufferedSerial.
+ */
+typedef void (*hostSerialSink_t)(const char* data, size_t length);
+
+/**
+ * @brief Función llamada por EventQueue::dispatch_forever() cuando no hay eventos vencidos.
+ *
+ * Debe avanzar el reloj (como máximo hasta nextDue) y retornar false para
+ * terminar el despacho.
+ */
+typedef bool (*hostIdle_t)(uint64_t nextDue);
+
+/**
+ * @brief Actividad acumulada de las EventQueue simuladas.
+ */
+typedef struct {
+    uint64_t dispatched;  ///< Eventos despachados
+    uint64_t busyNs;  ///< Tiempo real de CPU del PC dentro de los eventos, en ns
+} hostEventStats_t;
+
+/* === Public function declarations ============================================================ */
+
+/** @brief Instante actual del reloj virtual en us. */
+uint64_t hostClockNowUs(void);
+
+/**
+ * @brief Avanza el reloj virtual hasta targetUs aplicando los flancos pendientes.
+ *
+ * @param targetUs Instante destino en us; si es anterior al actual no hace nada.
+ */
+void hostClockAdvanceTo(uint64_t targetUs);
+
+/** @brief Registra la fuente de flancos (NULL la desactiva). */
+void hostSetStimulus(const hostStimulus_t* stimulus);
+
+/** @brief Fija el nivel lógico de un pin y dispara sus interrupciones si cambió. */
+void hostPinWrite(int pin, int level);
+
+/** @brief Lee el nivel lógico de un pin. */
+int hostPinRead(int pin);
+
+/**
+ * @brief Modelo del temporizador en captura de entrada con DMA circular.
+ *
+ * Cada flanco del pin que sobrevive al filtro digital (el nivel debe quedar
+ * estable filterUs) escribe su instante en us, retrasado filterUs como en el
+ * hardware, en la siguiente posición de ring. Los pulsos más cortos que el
+ * filtro no llegan a la captura.
+ *
+ * @param pin Pin de captura.
+ * @param ring Buffer circular destino (lo escribe el modelo, como la DMA).
+ * @param length Capturas en ring.
+ * @param filterUs Duración del filtro digital de entrada.
+ */
+void hostCaptureStart(int pin, uint32_t* ring, size_t length, uint32_t filterUs);
+
+/** @brief Posición de la próxima escritura en ring, como length - NDTR de la DMA. */
+size_t hostCaptureIndex(void);
+
+/**
+ * @brief Memoria de respaldo simulada (la BKPSRAM de 4 KB).
+ *
+ * Conserva su contenido mientras dure el proceso, como la real a través de
+ * los reinicios. Las escrituras de checkpoint pasan por hostBackupWrite().
+ */
+volatile uint32_t* hostBackupMemory(void);
+
+/** @brief Escribe una palabra de la memoria de respaldo, salvo que ya se haya cortado la energía. */
+void hostBackupWrite(volatile uint32_t* word, uint32_t value);
+
+/**
+ * @brief Simula un corte de energía tras una cantidad de escrituras.
+ *
+ * @param writes Escrituras que todavía llegan a la memoria; las siguientes se
+ *        pierden. Un valor negativo restablece la energía.
+ */
+void hostBackupCutAfter(int64_t writes);
+
+/** @brief Escrituras que llegaron a la memoria de respaldo en total. */
+uint64_t hostBackupWrites(void);
+
+/** @brief Registra el destino de la salida serie (NULL la descarta). */
+void hostSerialSetSink(hostSerialSink_t sink);
+
+/** @brief Bytes escritos en total por los puertos serie. */
+uint64_t hostSerialBytesWritten(void);
+
+/** @brief Tiempo virtual total en us que las escrituras bloqueantes esperaron por la línea. */
+uint64_t hostSerialBlockedUs(void);
+
+/** @brief Entrega bytes como si llegaran por la línea serie. */
+void hostSerialInject(const char* data, size_t length);
+
+/** @brief Registra la función de espera de las EventQueue. */
+void hostSetIdle(hostIdle_t idle);
+
+/** @brief Copia la actividad acumulada de las EventQueue. */
+void hostEventGetStats(hostEventStats_t* stats);
+
+/* === End of documentation ==================================================================== */
+
+#endif /* HOSTSIM_H */
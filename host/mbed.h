@@ -0,0 +1,335 @@
+/*
+ * Nombre del archivo: mbed.h
+ * Descripción: Sustituto de la API de Mbed OS para compilar el firmware en PC.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef HOST_MBED_H
+#define HOST_MBED_H
+
+/** @file
+ ** @brief Sustituto de la API de Mbed OS sobre el reloj virtual de hostsim.
+ **
+ ** Solo cubre la superficie que usa el firmware. Se activa poniendo el
+ ** directorio host/ antes que cualquier otro en la ruta de inclusión.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "hostsim.h"
+
+/* === Public macros definitions =============================================================== */
+
+#define EVENTS_EVENT_SIZE 64  ///< Bytes por evento, como en Mbed
+#define OS_STACK_SIZE 4096  ///< Pila por defecto de un Thread, como en Mbed
+#define osOK 0  ///< Resultado correcto de las funciones del núcleo
+#define osError (-1)  ///< Error no especificado del núcleo
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Pines de la NUCLEO-F429ZI usados por el firmware.
+ */
+typedef enum {
+    NC = -1,
+    PA_0 = 0,
+    PC_13 = 45,
+    PB_0 = 16,
+    PB_7 = 23,
+    PB_14 = 30,
+    PD_8 = 56,
+    PD_9 = 57,
+    BUTTON1 = PC_13,
+    LED1 = PB_0,
+    LED2 = PB_7,
+    LED3 = PB_14,
+    USBTX = PD_8,
+    USBRX = PD_9,
+} PinName;
+
+typedef enum {
+    PortA,
+    PortB,
+    PortC,
+    PortD,
+    PortE,
+    PortF,
+    PortG,
+} PortName;
+
+typedef enum {
+    PullNone,
+    PullUp,
+    PullDown,
+} PinMode;
+
+/**
+ * @brief Prioridades de CMSIS-RTOS2. En el PC no se aplican: los hilos del sistema no las respetan sin privilegios.
+ */
+typedef enum {
+    osPriorityIdle = 1,
+    osPriorityLow = 8,
+    osPriorityBelowNormal = 16,
+    osPriorityNormal = 24,
+    osPriorityAboveNormal = 32,
+    osPriorityHigh = 40,
+    osPriorityRealtime = 48,
+} osPriority;
+
+typedef int32_t osStatus;
+
+template <typename F>
+using Callback = std::function<F>;
+
+/* === Public function declarations ============================================================ */
+
+template <typename F>
+Callback<void()> callback(F function) {
+    return Callback<void()>(function);
+}
+
+template <typename T, typename M>
+Callback<void()> callback(T* object, M method) {
+    return [object, method]() { (object->*method)(); };
+}
+
+void set_time(time_t seconds);
+time_t rtc_read(void);
+int rtc_isenabled(void);
+uint32_t us_ticker_read(void);
+void thread_sleep_for(uint32_t millisec);
+
+/* === Public class declarations =============================================================== */
+
+class DigitalIn {
+public:
+    DigitalIn(PinName pin) : pin(pin) {}
+    DigitalIn(PinName pin, PinMode) : pin(pin) {}
+    int read() { return hostPinRead(pin); }
+    void mode(PinMode) {}
+    operator int() { return read(); }
+
+private:
+    PinName pin;
+};
+
+class DigitalOut {
+public:
+    DigitalOut(PinName pin, int value = 0) : pin(pin) { write(value); }
+    void write(int value) { hostPinWrite(pin, value != 0); }
+    int read() { return hostPinRead(pin); }
+    DigitalOut& operator=(int value) {
+        write(value);
+        return *this;
+    }
+    operator int() { return read(); }
+
+private:
+    PinName pin;
+};
+
+class PortIn {
+public:
+    PortIn(PortName port, int mask = 0xFFFF) : port(port), mask(mask) {}
+    int read();
+    void mode(PinMode) {}
+    operator int() { return read(); }
+
+private:
+    PortName port;
+    int mask;
+};
+
+class InterruptIn {
+public:
+    InterruptIn(PinName pin);
+    InterruptIn(PinName pin, PinMode mode);
+    ~InterruptIn();
+    int read() { return hostPinRead(pin); }
+    void mode(PinMode) {}
+    void rise(Callback<void()> function) { riseHandler = function; }
+    void fall(Callback<void()> function) { fallHandler = function; }
+
+    /** @brief Usado por hostsim al cambiar el nivel del pin. */
+    void edge(int level);
+
+private:
+    PinName pin;
+    Callback<void()> riseHandler;
+    Callback<void()> fallHandler;
+};
+
+class BufferedSerial {
+public:
+    BufferedSerial(PinName tx, PinName rx, int baud = 9600);
+    ~BufferedSerial();
+    ssize_t write(const void* buffer, size_t length);
+    ssize_t read(void* buffer, size_t length);
+    bool readable();
+    bool writable();
+    int set_blocking(bool blocking) {
+        this->blocking = blocking;
+        return 0;
+    }
+    void set_baud(int baud) { this->baud = baud; }
+    void sigio(Callback<void()> function);
+
+    /** @brief Usado por hostsim al recibir bytes. */
+    void input();
+
+private:
+    void drain();
+
+    int baud;
+    bool blocking = true;
+    size_t txLevel = 0;  ///< Bytes en el buffer de transmisión simulado
+    uint64_t lastDrainUs = 0;
+    Callback<void()> sigioHandler;
+};
+
+/**
+ * @brief Hilo de Mbed sobre std::thread.
+ *
+ * Las esperas de Thread y ThisThread usan el reloj real, no el virtual: los
+ * hilos corren en paralelo de verdad y el reloj virtual lo sigue avanzando la
+ * herramienta que conduce la simulación.
+ */
+class Thread {
+public:
+    Thread(osPriority priority = osPriorityNormal, uint32_t stack_size = OS_STACK_SIZE,
+           unsigned char* stack_mem = nullptr, const char* name = nullptr)
+        : priority(priority), name(name) {}
+    ~Thread();
+    osStatus start(Callback<void()> task);
+    osStatus join();
+    uint32_t flags_set(uint32_t flags);
+    osPriority get_priority() const { return priority; }
+    const char* get_name() const { return name; }
+
+    /** @brief Usado por ThisThread: espera alguna de las marcas hasta timeoutUs (negativo = sin límite). */
+    uint32_t waitFlags(uint32_t flags, bool clear, int64_t timeoutUs);
+
+private:
+    osPriority priority;
+    const char* name;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable signal;
+    uint32_t flags = 0;
+};
+
+/**
+ * @brief Mutex de Mbed sobre std::mutex.
+ */
+class Mutex {
+public:
+    void lock() { mutex.lock(); }
+    bool trylock() { return mutex.try_lock(); }
+    void unlock() { mutex.unlock(); }
+
+private:
+    std::mutex mutex;
+};
+
+namespace ThisThread {
+
+/** @brief Usado por las plantillas: espera en el Thread en curso. */
+uint32_t waitFlags(uint32_t flags, bool clear, int64_t timeoutUs);
+
+inline uint32_t flags_wait_any(uint32_t flags, bool clear = true) {
+    return waitFlags(flags, clear, -1);
+}
+
+template <typename R, typename P>
+uint32_t flags_wait_any_for(uint32_t flags, std::chrono::duration<R, P> rel_time, bool clear = true) {
+    return waitFlags(flags, clear, std::chrono::duration_cast<std::chrono::microseconds>(rel_time).count());
+}
+
+template <typename R, typename P>
+void sleep_for(std::chrono::duration<R, P> rel_time) {
+    std::this_thread::sleep_for(rel_time);
+}
+
+inline void yield() {
+    std::this_thread::yield();
+}
+
+}  // namespace ThisThread
+
+class EventQueue {
+public:
+    EventQueue(unsigned size = 32 * EVENTS_EVENT_SIZE) : capacity(size / EVENTS_EVENT_SIZE) {}
+
+    template <typename F>
+    int call(F function) {
+        return post(0, 0, Callback<void()>(function));
+    }
+
+    template <typename R, typename P, typename F>
+    int call_in(std::chrono::duration<R, P> delay, F function) {
+        return post(toUs(delay), 0, Callback<void()>(function));
+    }
+
+    template <typename R, typename P, typename F>
+    int call_every(std::chrono::duration<R, P> period, F function) {
+        return post(toUs(period), toUs(period), Callback<void()>(function));
+    }
+
+    bool cancel(int id) { return events.erase(id) != 0; }
+    void dispatch_forever();
+    void break_dispatch() { breakRequested = true; }
+
+private:
+    struct Event {
+        uint64_t dueUs;
+        uint64_t periodUs;
+        Callback<void()> function;
+    };
+
+    template <typename R, typename P>
+    static uint64_t toUs(std::chrono::duration<R, P> delay) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(delay).count();
+    }
+
+    int post(uint64_t delayUs, uint64_t periodUs, Callback<void()> function);
+
+    std::map<int, Event> events;
+    size_t capacity;  ///< Eventos pendientes que admite, como el buffer de Mbed
+    int nextId = 1;
+    bool breakRequested = false;
+};
+
+/* === End of documentation ==================================================================== */
+
+#endif /* HOST_MBED_H */
@@ -9,25 +9,47 @@
 #include "mbed.h"
 #include "arm_book_lib.h"
 #include "pluviometer.h"
+#include "eventloop.h"
+#include "pipeline.h"
+#include "logger.h"
+#include "probe.h"
 
 #define RAINFALL_CHECK_INTERVAL 60  ///< Intervalo de verificación de lluvia en segundos
 
+#if MAIN_LOOP_MODE == MAIN_LOOP_EVENTS && ACQUISITION_MODE == ACQUISITION_POLLING
+#error "MAIN_LOOP_EVENTS requiere ACQUISITION_INTERRUPT o ACQUISITION_TIMER"
+#endif
+#if MAIN_LOOP_MODE == MAIN_LOOP_PIPELINE && ACQUISITION_MODE == ACQUISITION_POLLING
+#error "MAIN_LOOP_PIPELINE requiere ACQUISITION_INTERRUPT o ACQUISITION_TIMER"
+#endif
+
 
 int main()
 {
     initializeSensors();
+    scheduleReports(RAINFALL_CHECK_INTERVAL);
+#if MAIN_LOOP_MODE == MAIN_LOOP_EVENTS
+    eventLoopRun();
+#elif MAIN_LOOP_MODE == MAIN_LOOP_PIPELINE
+    pipelineRun();
+#else
     while (true) {
+        PROBE_START(iterationStart);
         if (isRaining()) {
             actOnRainfall();
         } else {
-            alarmLed = OFF;
             tickLed = OFF;
         }
 
-        if (hasTimePassedMinutesRTC(RAINFALL_CHECK_INTERVAL)) {
-            reportRainfall();
+        if (isScheduleDue()) {
+            runSchedule();
         }
+
+        loggerDrain();
+        serviceCommands();
+        PROBE_STOP(PROBE_LOOP_ITERATION, iterationStart);
     }
+#endif
 }
 
 
@@ -0,0 +1,359 @@
+/*
+ * Nombre del archivo: alarm.cpp
+ * Descripción: Reglas de alarma por umbral de lluvia evaluadas en forma incremental.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Implementación de las reglas de alarma.
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <assert.h>
+#include <string.h>
+
+#include "alarm.h"
+
+/* === Macros definitions ====================================================================== */
+
+static_assert(ALARM_RULES_MAX <= UINT8_MAX, "los índices de regla ocupan un byte");
+static_assert(ALARM_TRACKERS_MAX <= UINT8_MAX, "los índices de seguidor ocupan un byte");
+
+/* === Private function implementation ========================================================= */
+
+/**
+ * @brief Indica si una regla tiene sentido.
+ */
+static bool validRule(const alarmRule_t* rule) {
+    if (rule->seconds == 0) {
+        return false;
+    }
+    switch (rule->kind) {
+    case ALARM_RULE_AMOUNT:
+        return rule->limit < UINT32_MAX;
+    case ALARM_RULE_WET_RUN:
+        return rule->wetThreshold > 0 && rule->limit > 0;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Valor del seguidor a partir del cual la regla está activa.
+ */
+static uint32_t triggerValue(const alarmRule_t* rule) {
+    return rule->kind == ALARM_RULE_AMOUNT ? rule->limit + 1 : rule->limit;
+}
+
+/**
+ * @brief Busca el seguidor de la regla o crea uno nuevo.
+ *
+ * @return Índice del seguidor, o ALARM_TRACKERS_MAX si no hay lugar.
+ */
+static size_t findTracker(alarmEngine_t* engine, const alarmRule_t* rule) {
+    uint32_t wetThreshold = rule->kind == ALARM_RULE_WET_RUN ? rule->wetThreshold : 0;
+
+    for (size_t i = 0; i < engine->trackerCount; i++) {
+        const alarmTracker_t* tracker = &engine->trackers[i];
+        if (tracker->kind == rule->kind && tracker->seconds == rule->seconds && tracker->wetThreshold == wetThreshold) {
+            return i;
+        }
+    }
+    if (engine->trackerCount == ALARM_TRACKERS_MAX) {
+        return ALARM_TRACKERS_MAX;
+    }
+
+    alarmTracker_t* tracker = &engine->trackers[engine->trackerCount];
+    memset(tracker, 0, sizeof(*tracker));
+    tracker->kind = rule->kind;
+    tracker->seconds = rule->seconds;
+    tracker->wetThreshold = wetThreshold;
+    if (rule->kind == ALARM_RULE_AMOUNT) {
+        tracker->bucketSeconds = (rule->seconds + ALARM_BUCKETS - 1) / ALARM_BUCKETS;
+        tracker->bucketCount = (rule->seconds + tracker->bucketSeconds - 1) / tracker->bucketSeconds;
+        tracker->current = engine->now / tracker->bucketSeconds;
+    } else {
+        tracker->current = engine->now / rule->seconds;
+    }
+    return engine->trackerCount++;
+}
+
+/**
+ * @brief Activa o desactiva las reglas del seguidor cuyo valor de disparo cruzó su valor.
+ *
+ * Las activas son un prefijo de las reglas ordenadas: solo se recorren las que cambian.
+ */
+static void updateRules(alarmEngine_t* engine, alarmTracker_t* tracker, uint32_t timestamp) {
+    while (tracker->active < tracker->count) {
+        const alarmRule_t* rule = &engine->rules[engine->order[tracker->first + tracker->active]];
+        if (triggerValue(rule) > tracker->value) {
+            break;
+        }
+        tracker->active++;
+        engine->activeCount++;
+        engine->touched++;
+        if (engine->notify != NULL) {
+            engine->notify(engine->context, rule, true, timestamp);
+        }
+    }
+    while (tracker->active > 0) {
+        const alarmRule_t* rule = &engine->rules[engine->order[tracker->first + tracker->active - 1]];
+        if (triggerValue(rule) <= tracker->value) {
+            break;
+        }
+        tracker->active--;
+        engine->activeCount--;
+        engine->touched++;
+        if (engine->notify != NULL) {
+            engine->notify(engine->context, rule, false, timestamp);
+        }
+    }
+}
+
+/**
+ * @brief Lleva un seguidor al instante now, descontando lo que sale de la ventana.
+ */
+static void advanceTracker(alarmTracker_t* tracker, uint32_t now) {
+    if (tracker->kind == ALARM_RULE_AMOUNT) {
+        uint32_t bucket = now / tracker->bucketSeconds;
+        uint32_t expired = bucket - tracker->current;
+        if (expired > tracker->bucketCount) {
+            expired = tracker->bucketCount;
+        }
+        // Las cubetas que reutiliza la ventana nueva son las que salen de ella
+        for (uint32_t i = 1; i <= expired; i++) {
+            uint32_t* slot = &tracker->buckets[(tracker->current + i) % tracker->bucketCount];
+            tracker->value -= *slot;
+            *slot = 0;
+        }
+        tracker->current = bucket;
+        return;
+    }
+
+    uint32_t period = now / tracker->seconds;
+    if (period == tracker->current) {
+        return;
+    }
+    bool wet = tracker->periodRain >= tracker->wetThreshold;
+    // Un período sin ningún tick en el medio corta la racha
+    tracker->run = period == tracker->current + 1 && wet ? tracker->run + 1 : 0;
+    tracker->current = period;
+    tracker->periodRain = 0;
+    tracker->value = tracker->run;
+}
+
+/**
+ * @brief Suma lluvia a un seguidor ya llevado al instante actual.
+ */
+static void addToTracker(alarmTracker_t* tracker, uint32_t timestamp, uint32_t micrometers) {
+    if (tracker->kind == ALARM_RULE_AMOUNT) {
+        uint32_t bucket = timestamp / tracker->bucketSeconds;
+        if (tracker->current - bucket >= tracker->bucketCount) {
+            return;  // Fuera de la ventana
+        }
+        uint32_t* slot = &tracker->buckets[bucket % tracker->bucketCount];
+        uint32_t room = ALARM_BUCKET_MAX - *slot;
+        uint32_t added = micrometers < room ? micrometers : room;
+        *slot += added;
+        tracker->value += added;
+        return;
+    }
+
+    if (timestamp / tracker->seconds != tracker->current) {
+        return;  // De un período ya cerrado
+    }
+    bool wasWet = tracker->periodRain >= tracker->wetThreshold;
+    tracker->periodRain =
+        tracker->periodRain + micrometers < tracker->periodRain ? UINT32_MAX : tracker->periodRain + micrometers;
+    if (!wasWet && tracker->periodRain >= tracker->wetThreshold) {
+        tracker->value = tracker->run + 1;
+    }
+}
+
+/**
+ * @brief Lee una palabra de la línea y saltea los espacios que la siguen.
+ *
+ * @return Largo de la palabra.
+ */
+static size_t nextWord(const char* text, size_t length, size_t* at) {
+    size_t start = *at;
+    while (*at < length && text[*at] != ' ') {
+        (*at)++;
+    }
+    size_t word = *at - start;
+    while (*at < length && text[*at] == ' ') {
+        (*at)++;
+    }
+    return word;
+}
+
+/**
+ * @brief Lee un entero decimal sin signo que ocupe toda la palabra siguiente.
+ */
+static bool nextNumber(const char* text, size_t length, size_t* at, uint32_t* value) {
+    size_t start = *at;
+    size_t word = nextWord(text, length, at);
+    if (word == 0 || word > 9) {
+        return false;
+    }
+    uint32_t result = 0;
+    for (size_t i = 0; i < word; i++) {
+        uint32_t digit = (uint32_t)(text[start + i] - '0');
+        if (digit > 9) {
+            return false;
+        }
+        result = result * 10 + digit;
+    }
+    *value = result;
+    return true;
+}
+
+/* === Public function implementation ========================================================== */
+
+bool alarmEngineInit(alarmEngine_t* engine, const alarmRule_t* rules, size_t count, uint32_t now,
+                     alarmNotify_t notify, void* context) {
+    assert(engine != NULL);
+    assert(rules != NULL || count == 0);
+
+    if (count > ALARM_RULES_MAX) {
+        return false;
+    }
+    engine->rules = rules;
+    engine->ruleCount = count;
+    engine->trackerCount = 0;
+    engine->now = now;
+    engine->activeCount = 0;
+    engine->touched = 0;
+    engine->notify = notify;
+    engine->context = context;
+
+    for (size_t i = 0; i < count; i++) {
+        size_t tracker = validRule(&rules[i]) ? findTracker(engine, &rules[i]) : ALARM_TRACKERS_MAX;
+        if (tracker == ALARM_TRACKERS_MAX) {
+            return false;
+        }
+        engine->tracker[i] = (uint8_t)tracker;
+        engine->trackers[tracker].count++;
+    }
+
+    // Reglas agrupadas por seguidor y, dentro de cada uno, por valor de disparo (inserción)
+    size_t first = 0;
+    for (size_t t = 0; t < engine->trackerCount; t++) {
+        alarmTracker_t* tracker = &engine->trackers[t];
+        tracker->first = (uint8_t)first;
+        size_t placed = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (engine->tracker[i] != t) {
+                continue;
+            }
+            size_t slot = first + placed++;
+            while (slot > first && triggerValue(&rules[engine->order[slot - 1]]) > triggerValue(&rules[i])) {
+                engine->order[slot] = engine->order[slot - 1];
+                slot--;
+            }
+            engine->order[slot] = (uint8_t)i;
+        }
+        first += placed;
+    }
+    for (size_t slot = 0; slot < count; slot++) {
+        size_t rule = engine->order[slot];
+        engine->position[rule] = (uint8_t)(slot - engine->trackers[engine->tracker[rule]].first);
+    }
+    return true;
+}
+
+void alarmEngineAddRain(alarmEngine_t* engine, uint32_t timestamp, uint32_t micrometers) {
+    assert(engine != NULL);
+
+    if (timestamp > engine->now) {
+        engine->now = timestamp;
+    }
+    // Se avanza y se suma antes de avisar: un tick que renueva la ventana no la desactiva y reactiva
+    for (size_t t = 0; t < engine->trackerCount; t++) {
+        alarmTracker_t* tracker = &engine->trackers[t];
+        advanceTracker(tracker, engine->now);
+        addToTracker(tracker, timestamp, micrometers);
+        updateRules(engine, tracker, engine->now);
+    }
+}
+
+void alarmEngineAdvance(alarmEngine_t* engine, uint32_t now) {
+    assert(engine != NULL);
+
+    if (now <= engine->now) {
+        return;
+    }
+    engine->now = now;
+    for (size_t t = 0; t < engine->trackerCount; t++) {
+        alarmTracker_t* tracker = &engine->trackers[t];
+        advanceTracker(tracker, now);
+        updateRules(engine, tracker, now);
+    }
+}
+
+uint32_t alarmEngineActiveCount(const alarmEngine_t* engine) {
+    assert(engine != NULL);
+
+    return engine->activeCount;
+}
+
+bool alarmEngineRuleActive(const alarmEngine_t* engine, size_t rule) {
+    assert(engine != NULL);
+    assert(rule < engine->ruleCount);
+
+    return engine->position[rule] < engine->trackers[engine->tracker[rule]].active;
+}
+
+bool alarmParseRule(const char* text, size_t length, alarmRule_t* rule) {
+    assert(text != NULL);
+    assert(rule != NULL);
+
+    while (length > 0 && (text[length - 1] == '\n' || text[length - 1] == '\r' || text[length - 1] == ' ')) {
+        length--;
+    }
+
+    size_t at = 0;
+    size_t word = nextWord(text, length, &at);
+    uint32_t id;
+    if (word == 6 && memcmp(text, "amount", 6) == 0) {
+        rule->kind = ALARM_RULE_AMOUNT;
+        rule->wetThreshold = 0;
+        if (!nextNumber(text, length, &at, &id) || !nextNumber(text, length, &at, &rule->seconds) ||
+            !nextNumber(text, length, &at, &rule->limit)) {
+            return false;
+        }
+    } else if (word == 3 && memcmp(text, "wet", 3) == 0) {
+        rule->kind = ALARM_RULE_WET_RUN;
+        if (!nextNumber(text, length, &at, &id) || !nextNumber(text, length, &at, &rule->seconds) ||
+            !nextNumber(text, length, &at, &rule->wetThreshold) || !nextNumber(text, length, &at, &rule->limit)) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+    if (at != length || id > UINT8_MAX) {
+        return false;
+    }
+    rule->id = (uint8_t)id;
+    return validRule(rule);
+}
+
+/* === End of documentation ==================================================================== */
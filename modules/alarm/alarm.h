@@ -0,0 +1,213 @@
+/*
+ * Nombre del archivo: alarm.h
+ * Descripción: Reglas de alarma por umbral de lluvia evaluadas en forma incremental.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+#ifndef ALARM_H
+#define ALARM_H
+
+/** @file
+ ** @brief Reglas de alarma por umbral de lluvia.
+ **
+ ** Dos tipos de regla: lluvia mayor que un límite en una ventana deslizante
+ ** (por ejemplo más de 20 mm en 1 h) y una cantidad de períodos seguidos con
+ ** lluvia (por ejemplo 3 horas seguidas con al menos un tick). Las reglas que
+ ** comparten ventana, o período y umbral de período húmedo, comparten un
+ ** seguidor con el valor corriente (la lluvia en la ventana o la racha) y
+ ** quedan ordenadas por el valor que las dispara; las activas son siempre un
+ ** prefijo de ese orden. Un tick suma en cada seguidor y solo se tocan las
+ ** reglas cuyo límite cruzó el valor: O(seguidores + reglas tocadas) por
+ ** tick, sin volver a recorrer lo ya sumado.
+ **
+ ** Las ventanas se cuentan en ALARM_BUCKETS cubetas, así que su resolución
+ ** es 1/ALARM_BUCKETS de la ventana: cubren la cubeta en curso y las
+ ** anteriores. Los períodos se alinean a la época (las horas, a las horas
+ ** UTC).
+ **
+ ** La lluvia se expresa en micrómetros, la unidad de la lluvia corregida de
+ ** modules/gauge, para que cada tick sume su lluvia corregida por intensidad
+ ** y no el vuelco nominal.
+ **
+ ** Las reglas son una tabla fija armada al compilar o leída de una
+ ** configuración con alarmParseRule(). Sin memoria dinámica.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef ALARM_RULES_MAX
+#define ALARM_RULES_MAX 128  ///< Reglas que admite un motor
+#endif
+#ifndef ALARM_TRACKERS_MAX
+#define ALARM_TRACKERS_MAX 16  ///< Ventanas y períodos distintos que admite un motor
+#endif
+#define ALARM_BUCKETS 60  ///< Cubetas de una ventana deslizante
+#define ALARM_BUCKET_MAX (UINT32_MAX / ALARM_BUCKETS)  ///< Tope de una cubeta en um: la ventana entera no desborda
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Tipos de regla.
+ */
+typedef enum {
+    ALARM_RULE_AMOUNT,  ///< Lluvia en la ventana mayor que limit um
+    ALARM_RULE_WET_RUN,  ///< Al menos limit períodos seguidos con wetThreshold um o más
+} alarmRuleKind_t;
+
+/**
+ * @brief Regla de alarma.
+ */
+typedef struct {
+    uint8_t kind;  ///< alarmRuleKind_t
+    uint8_t id;  ///< Identificador informado en los eventos de alarma
+    uint32_t seconds;  ///< Ventana (AMOUNT) o período (WET_RUN), en segundos
+    uint32_t wetThreshold;  ///< WET_RUN: um para que un período cuente como húmedo
+    uint32_t limit;  ///< AMOUNT: um; WET_RUN: períodos seguidos
+} alarmRule_t;
+
+/**
+ * @brief Aviso de una regla que se activa o se desactiva.
+ *
+ * @param context Contexto registrado con el motor.
+ * @param rule Regla.
+ * @param raised true al activarse, false al desactivarse.
+ * @param timestamp Instante del tick o del avance que la cambió.
+ */
+typedef void (*alarmNotify_t)(void* context, const alarmRule_t* rule, bool raised, uint32_t timestamp);
+
+/**
+ * @brief Seguidor de una ventana o de un período, compartido por sus reglas.
+ */
+typedef struct {
+    uint8_t kind;  ///< alarmRuleKind_t
+    uint32_t seconds;
+    uint32_t wetThreshold;
+    uint32_t bucketSeconds;  ///< AMOUNT: segundos por cubeta
+    uint32_t bucketCount;  ///< AMOUNT: cubetas de la ventana
+    uint32_t current;  ///< Cubeta (AMOUNT) o período (WET_RUN) en curso, desde la época
+    uint32_t value;  ///< Lluvia en la ventana o períodos húmedos seguidos, contando el actual
+    uint32_t periodRain;  ///< WET_RUN: lluvia del período en curso
+    uint32_t run;  ///< WET_RUN: períodos húmedos seguidos anteriores al actual
+    uint32_t buckets[ALARM_BUCKETS];  ///< AMOUNT: lluvia por cubeta, indexada por cubeta % bucketCount
+    uint8_t first;  ///< Primera de sus reglas en order
+    uint8_t count;  ///< Cantidad de sus reglas
+    uint8_t active;  ///< Reglas activas: las primeras de order
+} alarmTracker_t;
+
+/**
+ * @brief Motor de reglas.
+ */
+typedef struct {
+    const alarmRule_t* rules;
+    size_t ruleCount;
+    alarmTracker_t trackers[ALARM_TRACKERS_MAX];
+    size_t trackerCount;
+    uint8_t order[ALARM_RULES_MAX];  ///< Reglas agrupadas por seguidor y ordenadas por el valor que las dispara
+    uint8_t position[ALARM_RULES_MAX];  ///< Posición de cada regla dentro de las de su seguidor
+    uint8_t tracker[ALARM_RULES_MAX];  ///< Seguidor de cada regla
+    uint32_t now;  ///< Último instante incorporado
+    uint32_t activeCount;  ///< Reglas activas
+    uint32_t touched;  ///< Activaciones y desactivaciones desde el inicio
+    alarmNotify_t notify;
+    void* context;
+} alarmEngine_t;
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Prepara un motor para una tabla de reglas, sin lluvia.
+ *
+ * @param engine Motor.
+ * @param rules Tabla de reglas; debe vivir mientras se use el motor.
+ * @param count Reglas de la tabla, hasta ALARM_RULES_MAX.
+ * @param now Instante actual en segundos desde la época.
+ * @param notify Aviso de los cambios (puede ser NULL).
+ * @param context Contexto para notify.
+ * @return false si alguna regla es inválida o se excede ALARM_TRACKERS_MAX.
+ */
+bool alarmEngineInit(alarmEngine_t* engine, const alarmRule_t* rules, size_t count, uint32_t now,
+                     alarmNotify_t notify, void* context);
+
+/**
+ * @brief Suma lluvia en un instante y avisa las reglas que se activan.
+ *
+ * Un instante posterior avanza el reloj; uno anterior (un tick procesado con
+ * demora) se cuenta en su cubeta si sigue dentro de la ventana, y en los
+ * períodos solo si es del período en curso.
+ *
+ * @param engine Motor.
+ * @param timestamp Instante de la lluvia.
+ * @param micrometers Lluvia en um.
+ */
+void alarmEngineAddRain(alarmEngine_t* engine, uint32_t timestamp, uint32_t micrometers);
+
+/**
+ * @brief Avanza el reloj sin lluvia y avisa las reglas que se desactivan.
+ *
+ * Un instante anterior al último incorporado no tiene efecto.
+ */
+void alarmEngineAdvance(alarmEngine_t* engine, uint32_t now);
+
+/**
+ * @brief Cantidad de reglas activas.
+ */
+uint32_t alarmEngineActiveCount(const alarmEngine_t* engine);
+
+/**
+ * @brief Indica si una regla está activa.
+ *
+ * @param engine Motor.
+ * @param rule Índice de la regla en la tabla.
+ */
+bool alarmEngineRuleActive(const alarmEngine_t* engine, size_t rule);
+
+/**
+ * @brief Lee una regla de una línea de configuración.
+ *
+ * Formatos: "amount <id> <segundos> <um>" y
+ * "wet <id> <segundos> <um por período> <períodos>"; por ejemplo
+ * "amount 1 3600 20000" es más de 20 mm en 1 h.
+ *
+ * @param text Línea (no necesita terminador).
+ * @param length Largo de la línea.
+ * @param rule Regla de salida, válida solo si retorna true.
+ * @return true si la línea es una regla válida.
+ */
+bool alarmParseRule(const char* text, size_t length, alarmRule_t* rule);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ALARM_H */
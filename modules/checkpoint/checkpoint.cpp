@@ -0,0 +1,167 @@
+/*
+ * Nombre del archivo: checkpoint.cpp
+ * Descripción: Puntos de control del estado en la memoria de respaldo para reinicios rápidos.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Implementación de los puntos de control en la memoria de respaldo.
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include "mbed.h"
+#include "stm32f4xx_hal.h"
+#if defined(__linux__)
+#include "hostsim.h"
+#endif
+
+#include <assert.h>
+
+#include "checkpoint.h"
+#include "crc32.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define SLOT_SEQUENCE 0  ///< Palabra de la secuencia en la cabecera
+#define SLOT_CRC 1  ///< Palabra del CRC en la cabecera
+
+#if defined(__linux__)
+#define BACKUP_WRITE(word, value) hostBackupWrite((word), (value))  ///< El PC puede simular un corte
+#else
+#define BACKUP_WRITE(word, value) (*(word) = (value))
+#endif
+
+/* === Private function declarations =========================================================== */
+
+static uint32_t headerCrc(uint32_t tag, uint32_t sequence);
+static bool slotValid(const checkpoint_t* checkpoint, int slot);
+
+/* === Private function implementation ========================================================= */
+
+/**
+ * @brief CRC parcial de la cabecera, al que se agrega el contenido.
+ */
+static uint32_t headerCrc(uint32_t tag, uint32_t sequence) {
+    uint32_t crc = crc32Update(0, &tag, sizeof(tag));
+    return crc32Update(crc, &sequence, sizeof(sequence));
+}
+
+/**
+ * @brief Verifica el CRC de una ranura.
+ */
+static bool slotValid(const checkpoint_t* checkpoint, int slot) {
+    volatile uint32_t* words = checkpoint->slots[slot];
+    uint32_t crc = headerCrc(checkpoint->tag, words[SLOT_SEQUENCE]);
+
+    for (size_t i = 0; i < checkpoint->payloadWords; i++) {
+        uint32_t word = words[CHECKPOINT_HEADER_WORDS + i];
+        crc = crc32Update(crc, &word, sizeof(word));
+    }
+    return crc == words[SLOT_CRC];
+}
+
+/* === Public function implementation ========================================================== */
+
+volatile uint32_t* checkpointBackupMemory() {
+#if defined(__linux__)
+    return hostBackupMemory();
+#else
+    __HAL_RCC_PWR_CLK_ENABLE();
+    HAL_PWR_EnableBkUpAccess();
+    __HAL_RCC_BKPSRAM_CLK_ENABLE();
+    // Sin el regulador de respaldo la BKPSRAM se pierde al cortar VDD aunque haya VBAT
+    HAL_PWREx_EnableBkUpReg();
+    return (volatile uint32_t*)BKPSRAM_BASE;
+#endif
+}
+
+size_t checkpointRegionWords(size_t payloadSize) {
+    return 2 * (CHECKPOINT_HEADER_WORDS + payloadSize / sizeof(uint32_t));
+}
+
+void checkpointInit(checkpoint_t* checkpoint, volatile uint32_t* region, size_t payloadSize, uint32_t tag) {
+    assert(checkpoint != NULL);
+    assert(region != NULL);
+    assert(payloadSize > 0 && payloadSize % sizeof(uint32_t) == 0);
+
+    checkpoint->payloadWords = payloadSize / sizeof(uint32_t);
+    checkpoint->slots[0] = region;
+    checkpoint->slots[1] = region + CHECKPOINT_HEADER_WORDS + checkpoint->payloadWords;
+    checkpoint->tag = tag;
+    checkpoint->sequence = 0;
+    checkpoint->next = 0;
+    checkpoint->lastWrites = 0;
+}
+
+bool checkpointRestore(checkpoint_t* checkpoint, void* payload) {
+    assert(checkpoint != NULL);
+    assert(payload != NULL && (uintptr_t)payload % sizeof(uint32_t) == 0);
+
+    bool valid[2] = {slotValid(checkpoint, 0), slotValid(checkpoint, 1)};
+    int slot;
+    if (valid[0] && valid[1]) {
+        uint32_t first = checkpoint->slots[0][SLOT_SEQUENCE];
+        uint32_t second = checkpoint->slots[1][SLOT_SEQUENCE];
+        slot = (int32_t)(second - first) > 0 ? 1 : 0;
+    } else if (valid[0] || valid[1]) {
+        slot = valid[0] ? 0 : 1;
+    } else {
+        return false;
+    }
+
+    volatile uint32_t* words = checkpoint->slots[slot];
+    uint32_t* destination = (uint32_t*)payload;
+    for (size_t i = 0; i < checkpoint->payloadWords; i++) {
+        destination[i] = words[CHECKPOINT_HEADER_WORDS + i];
+    }
+    checkpoint->sequence = words[SLOT_SEQUENCE];
+    checkpoint->next = (uint8_t)(1 - slot);
+    return true;
+}
+
+void checkpointSave(checkpoint_t* checkpoint, const void* payload) {
+    assert(checkpoint != NULL);
+    assert(payload != NULL && (uintptr_t)payload % sizeof(uint32_t) == 0);
+
+    volatile uint32_t* words = checkpoint->slots[checkpoint->next];
+    const uint32_t* source = (const uint32_t*)payload;
+    uint32_t sequence = checkpoint->sequence + 1;
+    uint32_t crc = headerCrc(checkpoint->tag, sequence);
+    uint32_t writes = 0;
+
+    // Mientras se escribe el contenido la cabecera vieja ya no coincide: la ranura queda inválida
+    for (size_t i = 0; i < checkpoint->payloadWords; i++) {
+        uint32_t word = source[i];
+        crc = crc32Update(crc, &word, sizeof(word));
+        if (words[CHECKPOINT_HEADER_WORDS + i] != word) {
+            BACKUP_WRITE(&words[CHECKPOINT_HEADER_WORDS + i], word);
+            writes++;
+        }
+    }
+    BACKUP_WRITE(&words[SLOT_SEQUENCE], sequence);
+    BACKUP_WRITE(&words[SLOT_CRC], crc);
+
+    checkpoint->sequence = sequence;
+    checkpoint->next = (uint8_t)(1 - checkpoint->next);
+    checkpoint->lastWrites = writes + CHECKPOINT_HEADER_WORDS;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,131 @@
+/*
+ * Nombre del archivo: checkpoint.h
+ * Descripción: Puntos de control del estado en la memoria de respaldo para reinicios rápidos.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+/** @file
+ ** @brief Puntos de control del estado en la memoria de respaldo.
+ **
+ ** La SRAM de respaldo (BKPSRAM, 4 KB) conserva su contenido durante un
+ ** reinicio y, con el regulador de respaldo y VBAT, también sin alimentación
+ ** principal, igual que el RTC. Un punto de control guarda ahí una copia del
+ ** estado para que el arranque la recupere en microsegundos, sin recorrer la
+ ** flash.
+ **
+ ** Se usan dos ranuras alternadas, cada una con una cabecera (secuencia y
+ ** CRC-32) y el contenido. Cada guardado escribe la ranura inactiva palabra a
+ ** palabra, solo donde difiere de lo que ya tiene, y la cabecera al final: un
+ ** corte de energía a mitad de camino deja esa ranura con un CRC inválido y
+ ** la otra intacta. Al restaurar se elige la ranura válida de mayor secuencia.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#define CHECKPOINT_BACKUP_WORDS 1024  ///< Palabras de 32 bits de la SRAM de respaldo
+#define CHECKPOINT_HEADER_WORDS 2  ///< Secuencia y CRC al comienzo de cada ranura
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Punto de control de dos ranuras.
+ */
+typedef struct {
+    volatile uint32_t* slots[2];  ///< Comienzo de cada ranura en la memoria de respaldo
+    size_t payloadWords;  ///< Palabras del contenido
+    uint32_t tag;  ///< Semilla del CRC: distingue contenidos de distinto formato
+    uint32_t sequence;  ///< Secuencia del último guardado válido
+    uint8_t next;  ///< Ranura que escribirá el próximo guardado
+    uint32_t lastWrites;  ///< Palabras escritas por el último guardado
+} checkpoint_t;
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Habilita el acceso a la SRAM de respaldo y su regulador.
+ *
+ * @return Comienzo de la memoria de respaldo, de CHECKPOINT_BACKUP_WORDS palabras.
+ */
+volatile uint32_t* checkpointBackupMemory(void);
+
+/**
+ * @brief Palabras de la memoria de respaldo que ocupa un punto de control.
+ *
+ * @param payloadSize Bytes del contenido.
+ */
+size_t checkpointRegionWords(size_t payloadSize);
+
+/**
+ * @brief Asocia un punto de control a una región de la memoria de respaldo.
+ *
+ * No lee ni escribe la región.
+ *
+ * @param checkpoint Punto de control.
+ * @param region Comienzo de la región, de checkpointRegionWords(payloadSize) palabras.
+ * @param payloadSize Bytes del contenido (múltiplo de 4).
+ * @param tag Identificador del formato del contenido; cambiarlo invalida lo guardado.
+ */
+void checkpointInit(checkpoint_t* checkpoint, volatile uint32_t* region, size_t payloadSize, uint32_t tag);
+
+/**
+ * @brief Recupera el contenido del último guardado completo.
+ *
+ * Debe llamarse una vez tras checkpointInit() y antes del primer guardado.
+ *
+ * @param checkpoint Punto de control.
+ * @param payload Destino del contenido; no se modifica si retorna false.
+ * @return true si alguna ranura era válida.
+ */
+bool checkpointRestore(checkpoint_t* checkpoint, void* payload);
+
+/**
+ * @brief Guarda el contenido en la ranura inactiva y la vuelve la vigente.
+ *
+ * Solo escribe las palabras que difieren de lo que ya tenía la ranura, y la
+ * cabecera al final.
+ *
+ * @param checkpoint Punto de control.
+ * @param payload Contenido a guardar.
+ */
+void checkpointSave(checkpoint_t* checkpoint, const void* payload);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CHECKPOINT_H */
@@ -0,0 +1,169 @@
+/*
+ * Nombre del archivo: tipcodec.cpp
+ * Descripción: Codificación compacta de flujos de ticks por diferencia de diferencias.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Implementación de la codificación de flujos de ticks.
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <assert.h>
+#include <string.h>
+
+#include "tipcodec.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define TAG_MARK 1u  ///< Bit 0 del primer varint de una marca
+
+// Campos de un elemento en el decodificador
+#define FIELD_HEADER 0
+#define FIELD_MARK_TIME 1
+#define FIELD_MARK_VALUE 2
+
+/* === Private function implementation ========================================================= */
+
+static uint64_t zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+/**
+ * @brief Escribe un varint (7 bits por byte, el bit 7 indica que sigue otro).
+ */
+static size_t putVarint(uint64_t value, uint8_t* out) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        out[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = (uint8_t)value;
+    return length;
+}
+
+/**
+ * @brief Completa un tick y actualiza el estado con su instante.
+ */
+static void applyTip(tipCodecState_t* state, int64_t deltaOfDelta, tipCodecItem_t* item) {
+    int64_t delta = (int64_t)((uint64_t)state->delta + (uint64_t)deltaOfDelta);  // Sin desborde con datos corruptos
+    uint64_t timestamp = state->last + (uint64_t)delta;
+    if (state->tips > 0) {
+        state->delta = delta;
+    }
+    state->last = timestamp;
+    state->tips++;
+
+    item->mark = false;
+    item->kind = 0;
+    item->timestamp = timestamp;
+    item->value = 0;
+}
+
+/* === Public function implementation ========================================================== */
+
+void tipEncoderInit(tipEncoder_t* encoder) {
+    assert(encoder != NULL);
+
+    memset(encoder, 0, sizeof(*encoder));
+}
+
+size_t tipEncodeTip(tipEncoder_t* encoder, uint64_t timestamp, uint8_t* out) {
+    assert(encoder != NULL);
+    assert(out != NULL);
+    assert(timestamp < TIP_CODEC_TIMESTAMP_LIMIT);  // Así la diferencia de diferencias cabe junto al bit de marca
+
+    // El primer tick queda completo: last y delta parten de 0
+    int64_t delta = (int64_t)(timestamp - encoder->last);
+    int64_t deltaOfDelta = delta - encoder->delta;
+    if (encoder->tips > 0) {
+        encoder->delta = delta;
+    }
+    encoder->last = timestamp;
+    encoder->tips++;
+    return putVarint(zigzag(deltaOfDelta) << 1, out);
+}
+
+size_t tipEncodeMark(tipEncoder_t* encoder, uint8_t kind, uint64_t timestamp, int32_t value, uint8_t* out) {
+    assert(encoder != NULL);
+    assert(out != NULL);
+    assert(kind < 0x80);
+
+    size_t length = putVarint(((uint64_t)kind << 1) | TAG_MARK, out);
+    length += putVarint(zigzag((int64_t)(timestamp - encoder->last)), &out[length]);
+    length += putVarint(zigzag(value), &out[length]);
+    return length;
+}
+
+void tipDecoderInit(tipDecoder_t* decoder) {
+    assert(decoder != NULL);
+
+    memset(decoder, 0, sizeof(*decoder));
+}
+
+bool tipDecoderPush(tipDecoder_t* decoder, uint8_t byte, tipCodecItem_t* item) {
+    assert(decoder != NULL);
+    assert(item != NULL);
+
+    decoder->varint |= (uint64_t)(byte & 0x7F) << decoder->shift;
+    decoder->shift += 7;
+    if (byte & 0x80) {
+        if (decoder->shift >= 7 * TIP_CODEC_VARINT_MAX) {
+            // Varint imposible: se descarta y se espera el comienzo de otro elemento
+            decoder->errors++;
+            decoder->varint = 0;
+            decoder->shift = 0;
+            decoder->field = FIELD_HEADER;
+        }
+        return false;
+    }
+
+    uint64_t value = decoder->varint;
+    decoder->varint = 0;
+    decoder->shift = 0;
+
+    switch (decoder->field) {
+    case FIELD_HEADER:
+        if ((value & TAG_MARK) == 0) {
+            applyTip(&decoder->state, unzigzag(value >> 1), item);
+            return true;
+        }
+        decoder->item.mark = true;
+        decoder->item.kind = (uint8_t)(value >> 1);
+        decoder->field = FIELD_MARK_TIME;
+        return false;
+    case FIELD_MARK_TIME:
+        decoder->item.timestamp = decoder->state.last + (uint64_t)unzigzag(value);
+        decoder->field = FIELD_MARK_VALUE;
+        return false;
+    default:
+        decoder->item.value = (int32_t)unzigzag(value);
+        decoder->field = FIELD_HEADER;
+        *item = decoder->item;
+        return true;
+    }
+}
+
+/* === End of documentation ==================================================================== */
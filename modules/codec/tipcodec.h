@@ -0,0 +1,150 @@
+/*
+ * Nombre del archivo: tipcodec.h
+ * Descripción: Codificación compacta de flujos de ticks por diferencia de diferencias.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef TIPCODEC_H
+#define TIPCODEC_H
+
+/** @file
+ ** @brief Codificación compacta de flujos de ticks.
+ **
+ ** Cada tick se representa por su instante en ms desde la época. El primero
+ ** se escribe completo y los siguientes como la diferencia entre su
+ ** intervalo y el intervalo anterior (diferencia de diferencias, como en
+ ** Gorilla), en zigzag y varint: durante una tormenta pareja un tick ocupa
+ ** uno o dos bytes en lugar de la línea de texto de ~40.
+ **
+ ** Entre los ticks pueden intercalarse marcas (reportes, avisos) con un tipo,
+ ** un instante y un valor; no alteran el estado de los ticks. Cada elemento
+ ** comienza con un varint cuyo bit 0 distingue tick (0) de marca (1).
+ **
+ ** El codificador y el decodificador son incrementales (elemento a elemento y
+ ** byte a byte) y no asignan memoria, así que sirven tanto para la salida
+ ** serie como para un almacenamiento. El flujo no se resincroniza solo: un
+ ** receptor debe empezar al comienzo del flujo o tras tipEncoderInit().
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#define TIP_CODEC_VARINT_MAX 10  ///< Bytes máximos de un varint de 64 bits
+#define TIP_CODEC_ITEM_MAX (2 * TIP_CODEC_VARINT_MAX + 5)  ///< Bytes máximos de un elemento
+#define TIP_CODEC_TIMESTAMP_LIMIT (1ULL << 61)  ///< Instantes de tick admitidos: [0, límite) ms
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Estado compartido por el codificador y el decodificador.
+ */
+typedef struct {
+    uint64_t last;  ///< Instante del último tick en ms
+    int64_t delta;  ///< Intervalo entre los dos últimos ticks en ms
+    uint32_t tips;  ///< Ticks del flujo
+} tipCodecState_t;
+
+typedef tipCodecState_t tipEncoder_t;
+
+/**
+ * @brief Elemento decodificado.
+ */
+typedef struct {
+    bool mark;  ///< false = tick, true = marca
+    uint8_t kind;  ///< Tipo de la marca (0 en los ticks)
+    uint64_t timestamp;  ///< Instante en ms desde la época
+    int32_t value;  ///< Valor de la marca (0 en los ticks)
+} tipCodecItem_t;
+
+/**
+ * @brief Decodificador byte a byte.
+ */
+typedef struct {
+    tipCodecState_t state;
+    tipCodecItem_t item;  ///< Elemento en armado
+    uint64_t varint;  ///< Varint en armado
+    uint8_t shift;  ///< Bits ya leídos del varint
+    uint8_t field;  ///< Campo en lectura dentro del elemento
+    uint32_t errors;  ///< Varints demasiado largos descartados
+} tipDecoder_t;
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Comienza un flujo nuevo; el próximo tick se escribe completo.
+ */
+void tipEncoderInit(tipEncoder_t* encoder);
+
+/**
+ * @brief Codifica un tick.
+ *
+ * @param encoder Estado del codificador.
+ * @param timestamp Instante del tick en ms desde la época, menor que TIP_CODEC_TIMESTAMP_LIMIT.
+ * @param out Destino de al menos TIP_CODEC_ITEM_MAX bytes.
+ * @return Bytes escritos.
+ */
+size_t tipEncodeTip(tipEncoder_t* encoder, uint64_t timestamp, uint8_t* out);
+
+/**
+ * @brief Codifica una marca; el instante se escribe relativo al último tick.
+ *
+ * @param encoder Estado del codificador.
+ * @param kind Tipo de la marca (0 a 127).
+ * @param timestamp Instante en ms desde la época.
+ * @param value Valor de la marca.
+ * @param out Destino de al menos TIP_CODEC_ITEM_MAX bytes.
+ * @return Bytes escritos.
+ */
+size_t tipEncodeMark(tipEncoder_t* encoder, uint8_t kind, uint64_t timestamp, int32_t value, uint8_t* out);
+
+/**
+ * @brief Comienza a decodificar un flujo nuevo.
+ */
+void tipDecoderInit(tipDecoder_t* decoder);
+
+/**
+ * @brief Entrega un byte al decodificador.
+ *
+ * @param decoder Estado del decodificador.
+ * @param byte Byte del flujo.
+ * @param item Elemento de salida, válido solo si retorna true.
+ * @return true si el byte completó un elemento.
+ */
+bool tipDecoderPush(tipDecoder_t* decoder, uint8_t byte, tipCodecItem_t* item);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIPCODEC_H */
@@ -0,0 +1,204 @@
+/*
+ * Nombre del archivo: command.cpp
+ * Descripción: Intérprete incremental de comandos de consulta recibidos por la UART.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Implementación del intérprete de comandos.
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <assert.h>
+#include <string.h>
+
+#include "command.h"
+
+/* === Private data type declarations ========================================================== */
+
+/**
+ * @brief Descripción de un comando.
+ */
+typedef struct {
+    const char* name;
+    commandId_t id;
+    uint8_t minArgs;
+    uint8_t maxArgs;
+    const char* usage;
+} commandSpec_t;
+
+/* === Private variable declarations =========================================================== */
+
+static const commandSpec_t commandSpecs[] = {
+    {"total", COMMAND_TOTAL, 2, 2, "total <from> <to>  nominal rainfall between two instants (epoch seconds)"},
+    {"tips", COMMAND_TIPS, 0, 1, "tips [n]  last n logged tips"},
+    {"rate", COMMAND_RATE, 0, 0, "rate  nominal rainfall and rate over 1, 5, 15, 60 min and 24 h"},
+    {"stats", COMMAND_STATS, 0, 0, "stats  device counters"},
+    {"tipstats", COMMAND_TIPSTATS, 0, 0, "tipstats  inter-tip intervals and debounce rejections"},
+    {"help", COMMAND_HELP, 0, 0, "help  this list"},
+};
+
+#define COMMAND_SPEC_COUNT (sizeof(commandSpecs) / sizeof(commandSpecs[0]))
+
+/* === Private function declarations =========================================================== */
+
+static void resetLine(commandParser_t* parser);
+static void finishLine(commandParser_t* parser, command_t* command);
+
+/* === Private function implementation ========================================================= */
+
+/**
+ * @brief Prepara el intérprete para una línea nueva.
+ */
+static void resetLine(commandParser_t* parser) {
+    parser->nameLength = 0;
+    parser->argCount = 0;
+    parser->lineLength = 0;
+    parser->inToken = false;
+    parser->error = COMMAND_ERROR_NONE;
+}
+
+/**
+ * @brief Busca el comando de la línea terminada y valida sus argumentos.
+ */
+static void finishLine(commandParser_t* parser, command_t* command) {
+    memset(command, 0, sizeof(*command));
+    command->error = parser->error;
+
+    const commandSpec_t* spec = NULL;
+    for (size_t i = 0; i < COMMAND_SPEC_COUNT && command->error == COMMAND_ERROR_NONE; i++) {
+        if (strlen(commandSpecs[i].name) == parser->nameLength &&
+            memcmp(commandSpecs[i].name, parser->name, parser->nameLength) == 0) {
+            spec = &commandSpecs[i];
+        }
+    }
+    if (command->error == COMMAND_ERROR_NONE && spec == NULL) {
+        command->error = COMMAND_ERROR_UNKNOWN;
+    }
+    if (command->error == COMMAND_ERROR_NONE && (parser->argCount < spec->minArgs || parser->argCount > spec->maxArgs)) {
+        command->error = COMMAND_ERROR_ARGUMENTS;
+    }
+
+    parser->commands++;
+    if (command->error != COMMAND_ERROR_NONE) {
+        parser->errors++;
+        command->id = COMMAND_INVALID;
+        return;
+    }
+
+    command->id = spec->id;
+    command->argCount = parser->argCount;
+    memcpy(command->args, parser->args, sizeof(command->args));
+    if (command->id == COMMAND_TIPS && command->argCount == 0) {
+        command->args[0] = COMMAND_TIPS_DEFAULT;
+    }
+}
+
+/* === Public function implementation ========================================================== */
+
+void commandParserInit(commandParser_t* parser) {
+    assert(parser != NULL);
+
+    memset(parser, 0, sizeof(*parser));
+    resetLine(parser);
+}
+
+bool commandParserIdle(const commandParser_t* parser) {
+    assert(parser != NULL);
+
+    return parser->lineLength == 0;
+}
+
+bool commandParserPush(commandParser_t* parser, char byte, command_t* command) {
+    assert(parser != NULL);
+    assert(command != NULL);
+
+    if (byte == '\r' || byte == '\n') {
+        // Un CR LF o una línea en blanco no son comandos
+        bool empty = parser->nameLength == 0 && parser->error == COMMAND_ERROR_NONE;
+        if (!empty) {
+            finishLine(parser, command);
+        }
+        resetLine(parser);
+        return !empty;
+    }
+
+    if (parser->lineLength < COMMAND_LINE_MAX) {
+        parser->lineLength++;
+    } else {
+        parser->error = COMMAND_ERROR_TOO_LONG;
+    }
+    if (parser->error != COMMAND_ERROR_NONE) {
+        return false;  // El resto de la línea se descarta
+    }
+
+    if (byte == ' ' || byte == '\t') {
+        parser->inToken = false;
+        return false;
+    }
+
+    bool newToken = !parser->inToken;
+    parser->inToken = true;
+    if (parser->argCount == 0 && (!newToken || parser->nameLength == 0)) {
+        // Nombre del comando, sin distinguir mayúsculas
+        if (parser->nameLength >= COMMAND_NAME_MAX) {
+            parser->error = COMMAND_ERROR_UNKNOWN;
+            return false;
+        }
+        parser->name[parser->nameLength++] = (byte >= 'A' && byte <= 'Z') ? (char)(byte - 'A' + 'a') : byte;
+        return false;
+    }
+
+    if (newToken) {
+        if (parser->argCount >= COMMAND_ARGS_MAX) {
+            parser->error = COMMAND_ERROR_ARGUMENTS;
+            return false;
+        }
+        parser->args[parser->argCount++] = 0;
+    }
+    uint32_t* value = &parser->args[parser->argCount - 1];
+    uint32_t digit = (uint32_t)(byte - '0');
+    if (byte < '0' || byte > '9' || *value > (UINT32_MAX - digit) / 10) {
+        parser->error = COMMAND_ERROR_ARGUMENTS;
+        return false;
+    }
+    *value = *value * 10 + digit;
+    return false;
+}
+
+const char* commandErrorText(commandError_t error) {
+    switch (error) {
+    case COMMAND_ERROR_UNKNOWN:
+        return "unknown command";
+    case COMMAND_ERROR_ARGUMENTS:
+        return "bad arguments";
+    case COMMAND_ERROR_TOO_LONG:
+        return "line too long";
+    default:
+        return "";
+    }
+}
+
+const char* commandUsage(size_t index) {
+    return index < COMMAND_SPEC_COUNT ? commandSpecs[index].usage : NULL;
+}
+
+/* === End of documentation ==================================================================== */
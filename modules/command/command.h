@@ -0,0 +1,155 @@
+/*
+ * Nombre del archivo: command.h
+ * Descripción: Intérprete incremental de comandos de consulta recibidos por la UART.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef COMMAND_H
+#define COMMAND_H
+
+/** @file
+ ** @brief Intérprete de comandos de consulta.
+ **
+ ** Los comandos son líneas de texto ("total 1593561600 1593648000",
+ ** "tips 20", "rate", "stats", "tipstats", "help") terminadas en CR o LF. El intérprete
+ ** recibe de a un byte y acumula solo el nombre (hasta COMMAND_NAME_MAX
+ ** caracteres) y los argumentos ya convertidos a número: no guarda la línea,
+ ** no reserva memoria y cada byte cuesta O(1), así que puede alimentarse
+ ** desde el bucle principal sin demorar la adquisición.
+ **
+ ** Es código puro (sin acceso a periféricos); la ejecución de cada comando y
+ ** sus respuestas quedan a cargo de quien lo usa.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#define COMMAND_NAME_MAX 8  ///< Caracteres del nombre de comando más largo admitido
+#define COMMAND_ARGS_MAX 2  ///< Argumentos numéricos por comando
+#define COMMAND_LINE_MAX 64  ///< Largo máximo de una línea; una más larga se descarta entera
+#define COMMAND_TIPS_DEFAULT 10  ///< Ticks que lista "tips" sin argumento
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Comandos reconocidos.
+ */
+typedef enum {
+    COMMAND_INVALID = 0,  ///< Línea con error; ver command_t::error
+    COMMAND_TOTAL,  ///< total <desde> <hasta>: lluvia entre dos instantes (segundos desde la época)
+    COMMAND_TIPS,  ///< tips [n]: últimos n ticks del registro persistente
+    COMMAND_RATE,  ///< rate: lluvia e intensidad de cada ventana deslizante
+    COMMAND_STATS,  ///< stats: contadores del equipo
+    COMMAND_TIPSTATS,  ///< tipstats: intervalos entre ticks y rebotes descartados
+    COMMAND_HELP,  ///< help: lista de comandos
+} commandId_t;
+
+/**
+ * @brief Errores de interpretación.
+ */
+typedef enum {
+    COMMAND_ERROR_NONE = 0,
+    COMMAND_ERROR_UNKNOWN,  ///< Nombre de comando desconocido
+    COMMAND_ERROR_ARGUMENTS,  ///< Cantidad de argumentos incorrecta o argumento no numérico
+    COMMAND_ERROR_TOO_LONG,  ///< Línea de más de COMMAND_LINE_MAX bytes
+} commandError_t;
+
+/**
+ * @brief Comando interpretado.
+ */
+typedef struct {
+    commandId_t id;
+    commandError_t error;  ///< Motivo si id es COMMAND_INVALID
+    uint8_t argCount;  ///< Argumentos recibidos
+    uint32_t args[COMMAND_ARGS_MAX];  ///< Argumentos; los omitidos toman su valor por defecto
+} command_t;
+
+/**
+ * @brief Estado del intérprete entre bytes.
+ */
+typedef struct {
+    char name[COMMAND_NAME_MAX];  ///< Nombre en lectura
+    uint8_t nameLength;
+    uint8_t argCount;  ///< Argumentos comenzados
+    uint32_t args[COMMAND_ARGS_MAX];
+    uint8_t lineLength;  ///< Bytes de la línea en curso
+    bool inToken;  ///< El último byte fue parte de una palabra
+    commandError_t error;  ///< Primer error de la línea en curso
+    uint32_t commands;  ///< Líneas interpretadas
+    uint32_t errors;  ///< Líneas con error
+} commandParser_t;
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Inicializa el intérprete.
+ */
+void commandParserInit(commandParser_t* parser);
+
+/**
+ * @brief Indica si no hay una línea comenzada.
+ *
+ * Permite atender teclas de un solo byte (como PROBE_DUMP_KEY) solo al
+ * comienzo de una línea.
+ */
+bool commandParserIdle(const commandParser_t* parser);
+
+/**
+ * @brief Entrega un byte recibido.
+ *
+ * @param parser Intérprete.
+ * @param byte Byte recibido.
+ * @param command Comando de salida, válido solo si retorna true.
+ * @return true si el byte terminó una línea no vacía (con o sin error).
+ */
+bool commandParserPush(commandParser_t* parser, char byte, command_t* command);
+
+/**
+ * @brief Texto de un error de interpretación.
+ */
+const char* commandErrorText(commandError_t error);
+
+/**
+ * @brief Uso de cada comando, para la respuesta de "help".
+ *
+ * @param index Índice desde 0.
+ * @return Texto de uso, o NULL pasado el último comando.
+ */
+const char* commandUsage(size_t index);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COMMAND_H */
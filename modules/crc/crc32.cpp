@@ -0,0 +1,61 @@
+/*
+ * Nombre del archivo: crc32.cpp
+ * Descripción: CRC-32 (IEEE 802.3) compacto para registros y tramas.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Implementación del CRC-32 con tabla de 16 entradas.
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <assert.h>
+
+#include "crc32.h"
+
+/* === Private variable declarations =========================================================== */
+
+/* CRC de cada valor de 4 bits con el polinomio reflejado 0xEDB88320 */
+static const uint32_t nibbleTable[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+/* === Public function implementation ========================================================== */
+
+uint32_t crc32Update(uint32_t crc, const void* data, size_t length) {
+    assert(data != NULL || length == 0);
+
+    const uint8_t* bytes = (const uint8_t*)data;
+    crc = ~crc;
+    while (length-- > 0) {
+        crc ^= *bytes++;
+        crc = (crc >> 4) ^ nibbleTable[crc & 0x0F];
+        crc = (crc >> 4) ^ nibbleTable[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+uint32_t crc32(const void* data, size_t length) {
+    return crc32Update(0, data, length);
+}
+
+/* === End of documentation ==================================================================== */
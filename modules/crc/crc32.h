@@ -0,0 +1,70 @@
+/*
+ * Nombre del archivo: crc32.h
+ * Descripción: CRC-32 (IEEE 802.3) compacto para registros y tramas.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef CRC32_H
+#define CRC32_H
+
+/** @file
+ ** @brief CRC-32 de IEEE 802.3 (el de zlib y Ethernet).
+ **
+ ** Usa una tabla de 16 entradas (64 bytes) y procesa medio byte por paso:
+ ** un compromiso entre la tabla de 1 KB y el cálculo bit a bit adecuado para
+ ** registros cortos en el MCU.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Continúa un CRC-32 con más datos.
+ *
+ * @param crc CRC de los datos anteriores, o 0 para comenzar.
+ * @param data Datos a agregar.
+ * @param length Cantidad de bytes.
+ * @return CRC-32 de todos los datos procesados.
+ */
+uint32_t crc32Update(uint32_t crc, const void* data, size_t length);
+
+/**
+ * @brief CRC-32 de un bloque de datos.
+ */
+uint32_t crc32(const void* data, size_t length);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CRC32_H */
@@ -0,0 +1,90 @@
+/*
+ * multidebounce.c
+ *
+ *  Created on: 18-07-2023
+ *      @Author: Luis Gómez
+ *      @Hardware: STM32F429ZI
+ *      @Objective: Debounce up to 32 tipping-bucket inputs at once using
+ *      vertical (bit-sliced) counters, one bit per channel.
+ */
+#include "mbed.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "multidebounce.h"
+
+static_assert(MULTI_DEBOUNCE_SAMPLES == 4, "the 2-bit vertical counter counts exactly 4 samples");
+
+/*
+ * @brief   Initializes a multi-channel debouncer.
+ *
+ * @param   debounce: pointer to the debouncer instance
+ * @param   mask: channels to debounce (bit n = channel n)
+ * @param   initialState: debounced level assumed at start
+ * @retval  None
+ */
+void multiDebounceInit(multiDebounce_t* debounce, uint32_t mask, uint32_t initialState) {
+    assert(debounce != NULL);
+
+    debounce->mask = mask;
+    debounce->state = initialState & mask;
+    debounce->count0 = 0;
+    debounce->count1 = 0;
+    debounce->rising = 0;
+    debounce->falling = 0;
+}
+
+/*
+ * @brief   Feeds one sample of every channel to the debouncer.
+ *
+ *          For each channel whose raw level differs from the debounced one the
+ *          2-bit counter (count1:count0) advances 0 -> 1 -> 2 -> 3; on the
+ *          fourth differing sample it wraps to 0 and the channel toggles.
+ *          A sample equal to the debounced level clears the counter, so any
+ *          bounce restarts the count.
+ *
+ * @param   debounce: pointer to the debouncer instance
+ * @param   sample: raw level of every channel (bit n = channel n)
+ * @retval  uint32_t: bitmask of channels with a debounced rising edge
+ */
+uint32_t multiDebounceUpdate(multiDebounce_t* debounce, uint32_t sample) {
+    assert(debounce != NULL);
+
+    uint32_t delta = (sample ^ debounce->state) & debounce->mask;
+
+    debounce->count1 = (debounce->count1 ^ debounce->count0) & delta;
+    debounce->count0 = ~debounce->count0 & delta;
+
+    uint32_t toggle = delta & ~(debounce->count0 | debounce->count1);
+    debounce->state ^= toggle;
+    debounce->rising = toggle & debounce->state;
+    debounce->falling = toggle & ~debounce->state;
+
+    return debounce->rising;
+}
+
+/*
+ * @brief   Reads a whole GPIO port in one access and feeds it to the debouncer.
+ *
+ * @param   debounce: pointer to the debouncer instance
+ * @param   port: port whose pins are the channels (pin n = channel n)
+ * @retval  uint32_t: bitmask of channels with a debounced rising edge
+ */
+uint32_t multiDebounceUpdatePort(multiDebounce_t* debounce, PortIn* port) {
+    assert(port != NULL);
+
+    return multiDebounceUpdate(debounce, (uint32_t)port->read());
+}
+
+/*
+ * @brief   Returns the debounced level of every enabled channel.
+ *
+ * @param   debounce: pointer to the debouncer instance
+ * @retval  uint32_t: debounced levels (bit n = channel n)
+ */
+uint32_t multiDebounceState(const multiDebounce_t* debounce) {
+    assert(debounce != NULL);
+
+    return debounce->state;
+}
@@ -0,0 +1,66 @@
+#ifndef MULTIDEBOUNCE_H
+#define MULTIDEBOUNCE_H
+
+#include "mbed.h"
+
+#include <stdint.h>  /* For standard uint32_t types */
+
+#define MULTI_DEBOUNCE_SAMPLES 4 /* Consecutive equal samples needed to accept a change */
+#define MULTI_DEBOUNCE_CHANNELS 32 /* One channel per bit of the sampled word */
+
+/*
+ * Bit-parallel debouncer for up to 32 inputs sampled together, e.g. a whole
+ * GPIO port read with PortIn. Each channel owns one bit of every field: the
+ * two count words form a 2-bit "vertical" counter per channel, so all
+ * channels are debounced with a handful of word-wide operations per sample.
+ *
+ * Sample every DEBOUNCE_TIME / MULTI_DEBOUNCE_SAMPLES ms to keep the same
+ * debounce time as the single-channel FSM.
+ */
+typedef struct {
+    uint32_t state;   // Debounced level of each channel
+    uint32_t count0;  // Bit 0 of the per-channel counters
+    uint32_t count1;  // Bit 1 of the per-channel counters
+    uint32_t mask;    // Enabled channels
+    uint32_t rising;  // Channels that went up on the last update
+    uint32_t falling; // Channels that went down on the last update
+} multiDebounce_t;
+
+/**
+ * @brief   Initializes a multi-channel debouncer.
+ *
+ * @param   debounce: pointer to the debouncer instance
+ * @param   mask: channels to debounce (bit n = channel n)
+ * @param   initialState: debounced level assumed at start
+ * @retval  None
+ */
+void multiDebounceInit(multiDebounce_t* debounce, uint32_t mask, uint32_t initialState);
+
+/**
+ * @brief   Feeds one sample of every channel to the debouncer.
+ *          A channel changes its debounced level after MULTI_DEBOUNCE_SAMPLES
+ *          consecutive samples that differ from it.
+ *
+ * @param   debounce: pointer to the debouncer instance
+ * @param   sample: raw level of every channel (bit n = channel n)
+ * @retval  uint32_t: bitmask of channels with a debounced rising edge (a tip)
+ */
+uint32_t multiDebounceUpdate(multiDebounce_t* debounce, uint32_t sample);
+
+/**
+ * @brief   Reads a whole GPIO port in one access and feeds it to the debouncer.
+ *
+ * @param   debounce: pointer to the debouncer instance
+ * @param   port: port whose pins are the channels (pin n = channel n)
+ * @retval  uint32_t: bitmask of channels with a debounced rising edge (a tip)
+ */
+uint32_t multiDebounceUpdatePort(multiDebounce_t* debounce, PortIn* port);
+
+/**
+ * @brief   Returns the debounced level of every enabled channel.
+ *
+ * @param   debounce: pointer to the debouncer instance
+ * @retval  uint32_t: debounced levels (bit n = channel n)
+ */
+uint32_t multiDebounceState(const multiDebounce_t* debounce);
+#endif // MULTIDEBOUNCE_H
@@ -16,6 +16,40 @@
 #include <assert.h>
 #include "delay.h"
 
+/** Rueda que contiene los temporizadores de todos los retardos */
+static timerWheel_t delayWheel;
+static bool_t delayWheelReady = false;
+
+/**
+ * @brief Lleva la rueda de los retardos hasta el tick actual.
+ */
+static void delayWheelUpdate(void)
+{
+    if (!delayWheelReady) {
+        timerWheelInit(&delayWheel, HAL_GetTick());
+        delayWheelReady = true;
+    } else {
+        timerWheelAdvance(&delayWheel, HAL_GetTick());
+    }
+}
+
+/**
+ * @brief Arranca el temporizador de un retardo; sin ticks restantes queda vencido en el acto.
+ *
+ * La rueda no vence nada en el tick ya procesado, pero un retardo de
+ * duración 0 (o acortado por delayWrite() por debajo de lo transcurrido)
+ * debe cumplirse en la próxima lectura, aunque sea en el mismo tick.
+ */
+static void delayArm(delay_t *delay, tick_t remaining)
+{
+    if (remaining == 0) {
+        timerWheelCancel(&delayWheel, &delay->timer);
+        delay->timer.expired = true;
+    } else {
+        timerWheelStart(&delayWheel, &delay->timer, remaining, 0);
+    }
+}
+
 /**
  * @brief Inicializa una estructura de retardo con una duración específica.
  *
@@ -32,6 +66,7 @@ void delayInit(delay_t *delay, tick_t duration)
 
     delay->duration = duration;
     delay->running = false;  // Inicializa el retardo como no activo
+    wheelTimerInit(&delay->timer, NULL, NULL);
 }
 
 /**
@@ -50,18 +85,21 @@ void delayInit(delay_t *delay, tick_t duration)
  */
 bool_t delayRead(delay_t *delay)
 {
-    static bool_t retValue = false;
+    bool_t retValue = false;
 
     assert(delay != NULL);
     assert(delay->duration >= 0);
 
+    delayWheelUpdate();
+
     if (delay->running == false) {
         // Si el retardo no está corriendo, guarda el tiempo de inicio y lo activa
         delay->startTime = HAL_GetTick();
         delay->running = true;
+        delayArm(delay, delay->duration);
     } else {
-        // Si el retardo está corriendo, verifica si se ha cumplido la duración
-        if ((HAL_GetTick() - delay->startTime) >= delay->duration) {
+        // Si el retardo está corriendo, verifica si su temporizador venció
+        if (delay->timer.expired) {
             delay->running = false;  // Desactiva el retardo
             retValue = true;         // Indica que el tiempo de retardo ha sido cumplido
         }
@@ -84,5 +122,12 @@ void delayWrite(delay_t *delay, tick_t duration)
     assert(duration >= 0);
 
     delay->duration = duration;  // Actualiza la duración del retardo
+
+    if (delay->running) {
+        // Reprograma el vencimiento contando desde el inicio original
+        delayWheelUpdate();
+        tick_t elapsed = HAL_GetTick() - delay->startTime;
+        delayArm(delay, elapsed < duration ? duration - elapsed : 0);
+    }
 }
 
@@ -6,14 +6,23 @@
 
 #include "stm32f4xx_hal.h"         /**< Inclusión de HAL */
 
+#include "timerwheel.h"            /**< Rueda de temporizadores que respalda a delay_t */
+
 
 typedef uint32_t tick_t;  /**< Definición de tipo para los ticks */
 typedef bool bool_t;      /**< Definición de tipo para los valores booleanos */
 
+/**
+ * @brief Retardo no bloqueante.
+ *
+ * Se mantiene como capa de compatibilidad sobre la rueda de temporizadores:
+ * cada retardo tiene su propio temporizador y su propio estado.
+ */
 typedef struct {
-    tick_t startTime;  /**< Tiempo de inicio del retardo */
-    tick_t duration;   /**< Duración del retardo en ticks */
-    bool_t running;    /**< Estado del retardo (activo/inactivo) */
+    tick_t startTime;    /**< Tiempo de inicio del retardo */
+    tick_t duration;     /**< Duración del retardo en ticks */
+    bool_t running;      /**< Estado del retardo (activo/inactivo) */
+    wheelTimer_t timer;  /**< Temporizador que marca el vencimiento */
 } delay_t;
 
 /**
@@ -47,6 +56,7 @@ bool_t delayRead(delay_t *delay);
  * @brief Modifica la duración de un retardo existente.
  *
  * Esta función permite cambiar dinámicamente la duración de un retardo ya inicializado.
+ * Si el retardo está corriendo, la nueva duración se cuenta desde su inicio.
  *
  * @param delay Puntero a la estructura de retardo.
  * @param duration Nueva duración del retardo en ticks.
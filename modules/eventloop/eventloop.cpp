@@ -0,0 +1,266 @@
+/*
+ * Nombre del archivo: eventloop.cpp
+ * Descripción: Bucle principal dirigido por eventos con reposo entre eventos.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Implementación del bucle principal dirigido por eventos.
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include "mbed.h"
+#include "arm_book_lib.h"
+
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+
+#include "tipcapture.h"
+#include "pulsecounter.h"
+#include "logger.h"
+#include "pluviometer.h"
+#include "eventloop.h"
+#include "probe.h"
+
+/* === Private variable declarations =========================================================== */
+
+static EventQueue eventQueue(EVENT_LOOP_QUEUE_EVENTS * EVENTS_EVENT_SIZE);
+
+static std::atomic<bool> tipsPosted(false);  ///< Hay un processTips() pendiente en la cola
+static int ledOffEvent = 0;  ///< Identificador del apagado de LEDs programado (0 = ninguno)
+static int drainEvent = 0;  ///< Identificador del reintento de salida programado (0 = ninguno)
+static eventLoopStats_t loopStats;
+static std::atomic<bool> commandsPosted(false);  ///< Hay un processCommands() pendiente en la cola
+static std::atomic<bool> tipsLost(false);  ///< Un aviso de ticks no entró en la cola
+static std::atomic<bool> commandsLost(false);  ///< Un aviso de comandos no entró en la cola
+static bool scheduleLost = false;  ///< La reprogramación de scheduleEvent() no entró en la cola
+static std::atomic<uint32_t> postFailures(0);  ///< Eventos que no entraron en la cola
+#if INSTRUMENTATION_ENABLED
+static probeTime_t workStart;  ///< probeNow() al comenzar el evento en curso
+#endif
+
+/* === Private function declarations =========================================================== */
+
+static void onTipQueued(void);
+static void processTips(void);
+static void turnOffLeds(void);
+static void scheduleEvent(void);
+static void postSchedule(uint32_t delayMs);
+static void retryLostPosts(void);
+static void drainLogger(void);
+static void retryDrain(void);
+static void onSerialEvent(void);
+static void processCommands(void);
+static uint32_t beginWork(void);
+static void endWork(uint32_t start);
+
+/* === Private function implementation ========================================================= */
+
+/**
+ * @brief Marca el inicio de la atención de un evento.
+ *
+ * @return Instante de inicio en us.
+ */
+static uint32_t beginWork() {
+    loopStats.wakeups++;
+#if INSTRUMENTATION_ENABLED
+    workStart = probeNow();
+#endif
+    return us_ticker_read();
+}
+
+/**
+ * @brief Acumula el tiempo ocupado desde start.
+ *
+ * @param start Instante devuelto por beginWork().
+ */
+static void endWork(uint32_t start) {
+    retryLostPosts();
+    drainLogger();
+    loopStats.busyUs += (uint32_t)(us_ticker_read() - start);
+    PROBE_STOP(PROBE_LOOP_ITERATION, workStart);
+}
+
+/**
+ * @brief Vuelve a encolar los avisos y la reprogramación que no entraron en la cola.
+ *
+ * Con la cola llena siempre hay otro evento pendiente, así que al terminar
+ * ese evento hay lugar para el reintento.
+ */
+static void retryLostPosts() {
+    if (tipsLost.exchange(false)) {
+        onTipQueued();
+    }
+    if (commandsLost.exchange(false)) {
+        onSerialEvent();
+    }
+    if (scheduleLost) {
+        postSchedule(0);
+    }
+}
+
+/**
+ * @brief Transmite el registro de eventos y, si la UART quedó llena, programa un reintento.
+ *
+ * Cuando termina una respuesta comienza la del próximo comando ya recibido.
+ */
+static void drainLogger() {
+    bool pending;
+
+    do {
+        pending = loggerDrain();
+    } while (!pending && serviceCommands());
+
+    if (pending && drainEvent == 0) {
+        drainEvent = eventQueue.call_in(std::chrono::milliseconds(EVENT_LOOP_DRAIN_RETRY_MS), retryDrain);
+    }
+}
+
+/**
+ * @brief Reintento de transmisión del registro de eventos.
+ */
+static void retryDrain() {
+    uint32_t start = beginWork();
+    drainEvent = 0;
+    endWork(start);
+}
+
+/**
+ * @brief Aviso de la ISR de captura: programa el proceso de los ticks.
+ *
+ * Solo se encola un processTips() a la vez, de modo que una ráfaga de ticks
+ * produce un único despertar.
+ */
+static void onTipQueued() {
+    if (!tipsPosted.exchange(true) && eventQueue.call(processTips) == 0) {
+        // Cola llena: sin bajar la marca ningún aviso posterior volvería a encolar
+        tipsPosted.store(false);
+        tipsLost.store(true);
+        postFailures++;
+    }
+}
+
+/**
+ * @brief Vacía la cola de captura y, si hubo ticks, reprograma el apagado del LED de tick.
+ *
+ * Con ACQUISITION_TIMER corre cada PULSE_COUNTER_POLL_MS aunque no haya ticks.
+ */
+static void processTips() {
+    uint32_t start = beginWork();
+    bool tipsSeen = false;
+
+    // Se baja la marca antes de vaciar: un tick que llegue después vuelve a avisar
+    tipsPosted.store(false);
+    while (isRaining()) {
+        actOnRainfall();
+        tipsSeen = true;
+    }
+
+    if (tipsSeen) {
+        if (ledOffEvent != 0) {
+            eventQueue.cancel(ledOffEvent);
+        }
+        ledOffEvent = eventQueue.call_in(std::chrono::milliseconds(DELAY_BETWEEN_TICK), turnOffLeds);
+    }
+
+    endWork(start);
+}
+
+/**
+ * @brief Apaga el LED de tick cuando vence la ventana posterior al último tick.
+ */
+static void turnOffLeds() {
+    uint32_t start = beginWork();
+
+    tickLed = OFF;
+    ledOffEvent = 0;
+
+    endWork(start);
+}
+
+/**
+ * @brief Corre las tareas vencidas del planificador y se reprograma para el próximo vencimiento.
+ */
+static void scheduleEvent() {
+    uint32_t start = beginWork();
+    postSchedule(runSchedule());
+    endWork(start);
+}
+
+/**
+ * @brief Programa scheduleEvent(); si la cola está llena lo marca para reintentarlo.
+ *
+ * @param delayMs Espera hasta el próximo vencimiento en ms.
+ */
+static void postSchedule(uint32_t delayMs) {
+    scheduleLost = eventQueue.call_in(std::chrono::milliseconds(delayMs), scheduleEvent) == 0;
+    if (scheduleLost) {
+        postFailures++;
+    }
+}
+
+/**
+ * @brief Aviso del puerto serie (contexto de interrupción): programa la atención de los comandos.
+ */
+static void onSerialEvent() {
+    if (pc.readable() && !commandsPosted.exchange(true) && eventQueue.call(processCommands) == 0) {
+        commandsPosted.store(false);
+        commandsLost.store(true);
+        postFailures++;
+    }
+}
+
+/**
+ * @brief Atiende los comandos recibidos; endWork() transmite la respuesta.
+ */
+static void processCommands() {
+    uint32_t start = beginWork();
+    commandsPosted.store(false);
+    serviceCommands();
+    endWork(start);
+}
+
+/* === Public function implementation ========================================================== */
+
+void eventLoopRun() {
+#if ACQUISITION_MODE == ACQUISITION_TIMER
+    // Sin interrupción por tick: las capturas de la DMA se leen periódicamente
+    eventQueue.call_every(std::chrono::milliseconds(PULSE_COUNTER_POLL_MS), processTips);
+#else
+    tipCaptureSetNotify(onTipQueued);
+#endif
+    postSchedule(0);
+    pc.sigio(callback(onSerialEvent));
+
+    // Procesa ticks que pudieran haber llegado antes de registrar el aviso
+    onTipQueued();
+    eventQueue.dispatch_forever();
+}
+
+void eventLoopGetStats(eventLoopStats_t* stats) {
+    assert(stats != NULL);
+
+    *stats = loopStats;
+    stats->postFailures = postFailures.load();
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,106 @@
+/*
+ * Nombre del archivo: eventloop.h
+ * Descripción: Bucle principal dirigido por eventos con reposo entre eventos.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef EVENTLOOP_H
+#define EVENTLOOP_H
+
+/** @file
+ ** @brief Bucle principal dirigido por eventos.
+ **
+ ** Los ticks encolados por la ISR, el apagado de los LEDs tras cada tick,
+ ** las tareas del planificador (el reporte periódico), los comandos recibidos por la UART y los
+ ** reintentos de salida serie se programan en
+ ** una EventQueue de Mbed. Entre eventos el despachador bloquea y el sistema operativo duerme el MCU
+ ** (reposo sin tick cuando la plataforma lo soporta), en lugar de sondear
+ ** delayRead() y rtc_read() en cada vuelta.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include "mbed.h"
+
+#include <stdint.h>
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+// Modos de ejecución del bucle principal
+#define MAIN_LOOP_POLLING 0  ///< Bucle de sondeo continuo
+#define MAIN_LOOP_EVENTS 1  ///< Bucle dirigido por eventos con reposo
+#define MAIN_LOOP_PIPELINE 2  ///< Etapas en hilos separados (ver modules/pipeline)
+#ifndef MAIN_LOOP_MODE
+#define MAIN_LOOP_MODE MAIN_LOOP_EVENTS  ///< Modo del bucle principal en uso
+#endif
+
+#ifndef EVENT_LOOP_QUEUE_EVENTS
+#define EVENT_LOOP_QUEUE_EVENTS 8  ///< Eventos simultáneos que admite la cola
+#endif
+#define EVENT_LOOP_DRAIN_RETRY_MS 20  ///< Espera antes de reintentar la salida con la UART llena
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Contadores de actividad del bucle de eventos.
+ */
+typedef struct {
+    uint32_t wakeups;  ///< Eventos despachados (cada uno implica salir del reposo)
+    uint64_t busyUs;  ///< Tiempo total de CPU ocupado atendiendo eventos, en us
+    uint32_t postFailures;  ///< Eventos que no entraron en la cola llena (se reintentan)
+} eventLoopStats_t;
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Programa los eventos del pluviómetro y despacha la cola para siempre.
+ *
+ * Requiere ACQUISITION_INTERRUPT, donde los ticks llegan como avisos de la
+ * ISR de captura, o ACQUISITION_TIMER, donde las capturas se leen cada
+ * PULSE_COUNTER_POLL_MS. Las tareas registradas con
+ * scheduleReports() corren en un evento que se reprograma para el próximo
+ * vencimiento del planificador. Un aviso de ticks o de comandos o una
+ * reprogramación del planificador que no entra en la cola llena se cuenta y
+ * se reintenta al terminar el próximo evento, que es el que libera lugar. No
+ * retorna.
+ */
+void eventLoopRun(void);
+
+/**
+ * @brief Copia los contadores de actividad del bucle de eventos.
+ *
+ * @param stats Puntero a la estructura destino.
+ */
+void eventLoopGetStats(eventLoopStats_t* stats);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVENTLOOP_H */
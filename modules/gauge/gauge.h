@@ -0,0 +1,237 @@
+/*
+ * Nombre del archivo: gauge.h
+ * Descripción: Pluviómetro calibrado en compilación con tabla de corrección en punto fijo.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef GAUGE_H
+#define GAUGE_H
+
+/** @file
+ ** @brief Pluviómetro de cubeta basculante calibrado en tiempo de compilación.
+ **
+ ** Las cubetas basculantes pierden agua mientras vuelcan, así que a alta
+ ** intensidad cada vuelco representa más lluvia que el volumen nominal. La
+ ** plantilla Pluviometer<Calibration, DebouncePolicy> recibe como
+ ** parámetros el volumen del vuelco, la curva de corrección según la
+ ** intensidad y la política de antirrebote. La tabla de corrección se genera
+ ** con código constexpr en punto fijo, de modo que por cada tick solo se
+ ** hace una división entera, una lectura de tabla y una multiplicación, sin
+ ** punto flotante ni ramas que dependan de la configuración.
+ **
+ ** Solo C++: las plantillas no pueden declararse dentro de extern "C".
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdint.h>
+
+#include "delay.h" /* tick_t */
+
+/* === Public macros definitions =============================================================== */
+
+#define GAUGE_TABLE_SIZE 128  ///< Entradas de la tabla de corrección
+#define GAUGE_TABLE_STEP 2  ///< mm/h por entrada: la tabla cubre hasta 256 mm/h
+#define GAUGE_FACTOR_SHIFT 16  ///< Factores en Q16 (1 << 16 = sin corrección)
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Calibración de una cubeta.
+ *
+ * El factor de corrección para una intensidad I en mm/h es
+ * 1 + LinearPpm * I / 10^6 + QuadraticPpb * I^2 / 10^9.
+ *
+ * @tparam DepthUm Lluvia nominal por vuelco en micrómetros.
+ * @tparam LinearPpm Término lineal de la corrección, en ppm por mm/h.
+ * @tparam QuadraticPpb Término cuadrático, en ppb por (mm/h)^2.
+ */
+template <uint32_t DepthUm, uint32_t LinearPpm, uint32_t QuadraticPpb = 0>
+struct BucketCalibration {
+    static_assert(DepthUm > 0 && DepthUm % 100 == 0, "el vuelco debe ser un múltiplo de 0,1 mm");
+
+    static constexpr uint32_t depthUm = DepthUm;
+    static constexpr uint32_t linearPpm = LinearPpm;
+    static constexpr uint32_t quadraticPpb = QuadraticPpb;
+};
+
+// Cubetas usadas en la red (coeficientes de la calibración dinámica de cada modelo)
+typedef BucketCalibration<100, 900> gaugeBucket01mm_t;  ///< 0,1 mm por vuelco
+typedef BucketCalibration<200, 500> gaugeBucket02mm_t;  ///< 0,2 mm por vuelco
+typedef BucketCalibration<500, 250, 1000> gaugeBucket05mm_t;  ///< 0,5 mm por vuelco
+
+/**
+ * @brief Solo el antirrebote de flanco (captura por interrupción o FSM).
+ */
+template <tick_t DebounceMs>
+struct EdgeDebounce {
+    static constexpr tick_t debounceTime = DebounceMs;
+    static constexpr tick_t lockoutTime = 0;
+};
+
+/**
+ * @brief Antirrebote de flanco más un intervalo mínimo entre ticks aceptados.
+ */
+template <tick_t DebounceMs, tick_t LockoutMs>
+struct LockoutDebounce {
+    static constexpr tick_t debounceTime = DebounceMs;
+    static constexpr tick_t lockoutTime = LockoutMs;
+};
+
+/**
+ * @brief Tabla de factores de corrección en Q16, por tramos de GAUGE_TABLE_STEP mm/h.
+ */
+struct gaugeTable_t {
+    uint32_t factor[GAUGE_TABLE_SIZE];
+};
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Genera la tabla de una calibración; cada tramo usa la intensidad de su centro.
+ */
+template <class Calibration>
+constexpr gaugeTable_t gaugeMakeTable() {
+    gaugeTable_t table = {};
+    for (uint32_t i = 0; i < GAUGE_TABLE_SIZE; i++) {
+        // Intensidad del centro del tramo en milésimas de mm/h, para no perder el medio paso
+        uint64_t milli = (uint64_t)i * GAUGE_TABLE_STEP * 1000 + GAUGE_TABLE_STEP * 500;
+        uint64_t one = (uint64_t)1 << GAUGE_FACTOR_SHIFT;
+        uint64_t linear = one * Calibration::linearPpm * milli;  // / 10^9
+        uint64_t quadratic = one * (Calibration::quadraticPpb * milli * milli / 1000);  // / 10^12
+        table.factor[i] = (uint32_t)(one + (linear + 500000000ull) / 1000000000ull +
+                                     (quadratic + 500000000000ull) / 1000000000000ull);
+    }
+    return table;
+}
+
+/**
+ * @brief Pluviómetro con calibración y antirrebote fijados en compilación.
+ *
+ * Acumula la lluvia corregida del período en curso. El instante del último
+ * tick se conserva entre períodos para medir la intensidad.
+ */
+template <class Calibration, class DebouncePolicy>
+class Pluviometer {
+public:
+    static constexpr tick_t debounceTime = DebouncePolicy::debounceTime;  ///< Para la captura o la FSM
+    static constexpr tick_t lockoutTime = DebouncePolicy::lockoutTime;
+    static constexpr gaugeTable_t table = gaugeMakeTable<Calibration>();
+
+    /**
+     * @brief Factor de corrección en Q16 para un intervalo entre ticks.
+     *
+     * @param intervalMs ms desde el tick anterior (0 = sin tick anterior).
+     */
+    static uint32_t correction(uint64_t intervalMs) {
+        if (intervalMs == 0) {
+            return table.factor[0];
+        }
+        uint64_t index = intensityScale / intervalMs;
+        return table.factor[index < GAUGE_TABLE_SIZE ? index : GAUGE_TABLE_SIZE - 1];
+    }
+
+    Pluviometer() : lastTip(0), periodTips(0), periodDepth(0) {}
+
+    /**
+     * @brief Procesa un tick.
+     *
+     * @param timestampMs Instante del tick en ms.
+     * @return false si la política de antirrebote lo descartó.
+     */
+    bool addTip(uint64_t timestampMs) {
+        uint64_t interval = lastTip != 0 && timestampMs > lastTip ? timestampMs - lastTip : 0;
+        if (lockoutTime > 0 && lastTip != 0 && interval < lockoutTime) {
+            return false;  // Con lockoutTime == 0 el compilador elimina la comparación
+        }
+        lastTip = timestampMs;
+        periodTips++;
+        periodDepth += (uint64_t)Calibration::depthUm * correction(interval);
+        return true;
+    }
+
+    /**
+     * @brief Repone ticks recuperados tras un reinicio, con su valor nominal.
+     *
+     * Para ticks cuya lluvia corregida no se conoce (recuperados del registro de ticks).
+     */
+    void restore(uint32_t tips) {
+        periodTips += tips;
+        periodDepth += ((uint64_t)Calibration::depthUm * tips) << GAUGE_FACTOR_SHIFT;
+    }
+
+    /**
+     * @brief Repone un período guardado con depth(), conservando su corrección por intensidad.
+     */
+    void restore(uint32_t tips, uint64_t depth) {
+        periodTips += tips;
+        periodDepth += depth;
+    }
+
+    /**
+     * @brief Comienza un período nuevo.
+     */
+    void startPeriod() {
+        periodTips = 0;
+        periodDepth = 0;
+    }
+
+    uint32_t tips() const {
+        return periodTips;
+    }
+
+    /**
+     * @brief Lluvia corregida del período en um, Q16, para guardarla y reponerla con restore().
+     */
+    uint64_t depth() const {
+        return periodDepth;
+    }
+
+    /**
+     * @brief Lluvia corregida del período, en décimas de mm.
+     */
+    int32_t rainfall() const {
+        const uint64_t tenth = (uint64_t)100 << GAUGE_FACTOR_SHIFT;  // 0,1 mm en um Q16
+        return (int32_t)((periodDepth + tenth / 2) / tenth);
+    }
+
+    /**
+     * @brief Lluvia nominal de una cantidad de ticks, en décimas de mm.
+     */
+    static constexpr int32_t nominalRainfall(uint32_t tips) {
+        return (int32_t)(tips * (Calibration::depthUm / 100));
+    }
+
+private:
+    // Índice de la tabla = intensityScale / intervalo en ms
+    static constexpr uint64_t intensityScale = (uint64_t)Calibration::depthUm * 3600 / GAUGE_TABLE_STEP;
+
+    uint64_t lastTip;  ///< Instante del último tick aceptado en ms (0 = ninguno)
+    uint32_t periodTips;
+    uint64_t periodDepth;  ///< Lluvia del período en um, Q16
+};
+
+template <class Calibration, class DebouncePolicy>
+constexpr gaugeTable_t Pluviometer<Calibration, DebouncePolicy>::table;
+
+/* === End of documentation ==================================================================== */
+
+#endif /* GAUGE_H */
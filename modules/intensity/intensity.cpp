@@ -0,0 +1,135 @@
+/*
+ * Nombre del archivo: intensity.cpp
+ * Descripción: Intensidad de lluvia en ventanas deslizantes con costo constante.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Implementación del motor de intensidad de lluvia.
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <assert.h>
+#include <string.h>
+
+#include "intensity.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define SECOND_WINDOWS INTENSITY_24_H  ///< Ventanas servidas por el anillo de segundos
+#define SECONDS_PER_MINUTE 60
+
+/* === Private variable declarations =========================================================== */
+
+static const uint32_t windowSeconds[INTENSITY_WINDOW_COUNT] = {60, 300, 900, 3600, 86400};
+
+static_assert(INTENSITY_SECONDS >= 3600, "el anillo de segundos debe cubrir la ventana de 60 minutos");
+static_assert(INTENSITY_MINUTES * SECONDS_PER_MINUTE == 86400, "el anillo de minutos cubre 24 horas");
+
+/* === Public function implementation ========================================================== */
+
+void intensityInit(intensity_t* intensity, uint32_t now) {
+    assert(intensity != NULL);
+
+    memset(intensity, 0, sizeof(*intensity));
+    intensity->now = now;
+}
+
+void intensityAdvance(intensity_t* intensity, uint32_t now) {
+    assert(intensity != NULL);
+
+    if (now <= intensity->now) {
+        return;
+    }
+
+    // Minutos que se cierran: cada uno saca de la ventana de 24 h el de hace 1440 minutos
+    uint32_t fromMinute = intensity->now / SECONDS_PER_MINUTE;
+    uint32_t toMinute = now / SECONDS_PER_MINUTE;
+    if (toMinute - fromMinute >= INTENSITY_MINUTES) {
+        memset(intensity->minutes, 0, sizeof(intensity->minutes));
+        intensity->sums[INTENSITY_24_H] = 0;
+    } else {
+        for (uint32_t minute = fromMinute + 1; minute <= toMinute; minute++) {
+            uint16_t* bucket = &intensity->minutes[minute % INTENSITY_MINUTES];
+            intensity->sums[INTENSITY_24_H] -= *bucket;
+            *bucket = 0;
+        }
+    }
+
+    // Segundos que pasan: cada ventana suelta el segundo que queda a su espalda
+    if (now - intensity->now >= INTENSITY_SECONDS) {
+        memset(intensity->seconds, 0, sizeof(intensity->seconds));
+        for (int window = 0; window < SECOND_WINDOWS; window++) {
+            intensity->sums[window] = 0;
+        }
+    } else {
+        for (uint32_t second = intensity->now + 1; second <= now; second++) {
+            for (int window = 0; window < SECOND_WINDOWS; window++) {
+                intensity->sums[window] -= intensity->seconds[(second - windowSeconds[window]) % INTENSITY_SECONDS];
+            }
+            intensity->seconds[second % INTENSITY_SECONDS] = 0;
+        }
+    }
+
+    intensity->now = now;
+}
+
+void intensityAddTips(intensity_t* intensity, uint32_t timestamp, uint32_t tips) {
+    assert(intensity != NULL);
+
+    intensityAdvance(intensity, timestamp);
+
+    uint32_t age = intensity->now - timestamp;
+    if (age < INTENSITY_SECONDS) {
+        uint16_t* bucket = &intensity->seconds[timestamp % INTENSITY_SECONDS];
+        assert(*bucket + tips <= UINT16_MAX);
+        *bucket += (uint16_t)tips;
+        for (int window = 0; window < SECOND_WINDOWS; window++) {
+            if (age < windowSeconds[window]) {
+                intensity->sums[window] += tips;
+            }
+        }
+    }
+
+    uint32_t minuteAge = intensity->now / SECONDS_PER_MINUTE - timestamp / SECONDS_PER_MINUTE;
+    if (minuteAge < INTENSITY_MINUTES) {
+        uint16_t* bucket = &intensity->minutes[(timestamp / SECONDS_PER_MINUTE) % INTENSITY_MINUTES];
+        assert(*bucket + tips <= UINT16_MAX);
+        *bucket += (uint16_t)tips;
+        intensity->sums[INTENSITY_24_H] += tips;
+    }
+}
+
+uint32_t intensityTips(intensity_t* intensity, intensityWindow_t window, uint32_t now) {
+    assert(intensity != NULL);
+    assert(window >= 0 && window < INTENSITY_WINDOW_COUNT);
+
+    intensityAdvance(intensity, now);
+    return intensity->sums[window];
+}
+
+uint32_t intensityWindowSeconds(intensityWindow_t window) {
+    assert(window >= 0 && window < INTENSITY_WINDOW_COUNT);
+
+    return windowSeconds[window];
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,127 @@
+/*
+ * Nombre del archivo: intensity.h
+ * Descripción: Intensidad de lluvia en ventanas deslizantes con costo constante.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef INTENSITY_H
+#define INTENSITY_H
+
+/** @file
+ ** @brief Intensidad de lluvia en ventanas deslizantes de 1, 5, 15 y 60 minutos y 24 horas.
+ **
+ ** Los ticks se cuentan en un anillo de INTENSITY_SECONDS cubetas de un
+ ** segundo y en otro de INTENSITY_MINUTES cubetas de un minuto. Cada ventana
+ ** mantiene su suma corriente: un tick suma en todas las ventanas y el paso
+ ** de cada segundo resta la cubeta que sale de cada una, así que agregar y
+ ** consultar cuesta O(1) (el avance del reloj, O(1) amortizado por segundo
+ ** transcurrido) con memoria fija.
+ **
+ ** Las ventanas de minutos son exactas al segundo; la de 24 horas tiene
+ ** resolución de un minuto: cubre el minuto en curso y los 1439 anteriores.
+ **
+ ** El motor cuenta ticks; la lluvia por tick la aplica quien consulta, como
+ ** con modules/rollup.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdint.h>
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#define INTENSITY_SECONDS 3600  ///< Cubetas de un segundo (ventana mayor en segundos)
+#define INTENSITY_MINUTES 1440  ///< Cubetas de un minuto (24 h)
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Ventanas disponibles.
+ */
+typedef enum {
+    INTENSITY_1_MIN,
+    INTENSITY_5_MIN,
+    INTENSITY_15_MIN,
+    INTENSITY_60_MIN,
+    INTENSITY_24_H,
+    INTENSITY_WINDOW_COUNT,
+} intensityWindow_t;
+
+/**
+ * @brief Estado del motor de intensidad.
+ */
+typedef struct {
+    uint16_t seconds[INTENSITY_SECONDS];  ///< Ticks de cada segundo, indexado por instante % INTENSITY_SECONDS
+    uint16_t minutes[INTENSITY_MINUTES];  ///< Ticks de cada minuto, indexado por minuto % INTENSITY_MINUTES
+    uint32_t sums[INTENSITY_WINDOW_COUNT];  ///< Ticks dentro de cada ventana
+    uint32_t now;  ///< Último segundo incorporado
+} intensity_t;
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Inicializa el motor sin lluvia.
+ *
+ * @param intensity Estado del motor.
+ * @param now Instante actual en segundos desde la época.
+ */
+void intensityInit(intensity_t* intensity, uint32_t now);
+
+/**
+ * @brief Registra ticks en un instante.
+ *
+ * Un instante posterior avanza el reloj; uno anterior (un tick procesado con
+ * demora) se cuenta en su cubeta si sigue dentro de alguna ventana.
+ *
+ * @param intensity Estado del motor.
+ * @param timestamp Instante de los ticks.
+ * @param tips Cantidad de ticks.
+ */
+void intensityAddTips(intensity_t* intensity, uint32_t timestamp, uint32_t tips);
+
+/**
+ * @brief Avanza el reloj del motor, descartando lo que sale de cada ventana.
+ */
+void intensityAdvance(intensity_t* intensity, uint32_t now);
+
+/**
+ * @brief Ticks dentro de una ventana que termina en now.
+ */
+uint32_t intensityTips(intensity_t* intensity, intensityWindow_t window, uint32_t now);
+
+/**
+ * @brief Duración de una ventana en segundos.
+ */
+uint32_t intensityWindowSeconds(intensityWindow_t window);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INTENSITY_H */
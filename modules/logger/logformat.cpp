@@ -0,0 +1,388 @@
+/*
+ * Nombre del archivo: logformat.cpp
+ * Descripción: Registros binarios del registro de eventos y su conversión a texto.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Implementación del formato de los registros.
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <assert.h>
+#include <string.h>
+
+#include "pluviometer.h"
+#include "timefmt.h"
+#include "logformat.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define MSG_DROPPED_RECORDS " - Dropped log records: "  ///< Aviso de registros descartados
+#define MSG_ALARM_RAISED " - Alarm raised: "  ///< Regla de alarma activada
+#define MSG_ALARM_CLEARED " - Alarm cleared: "  ///< Regla de alarma desactivada
+#define MSG_TIP_ANOMALY " - Tip anomaly: "  ///< Banderas de anomalía de los ticks
+#define MSG_RAIN_DETECTED_LENGTH (sizeof(MSG_RAIN_DETECTED) - 3)  ///< Sin el fin de línea
+#define MSG_MM " mm"  ///< Unidad al final de la lluvia acumulada
+
+/* === Private variable declarations =========================================================== */
+
+static timeFormat_t stampFormat;  ///< Fecha en caché del último registro convertido
+static bool stampFormatReady = false;
+
+/* === Private function implementation ========================================================= */
+
+/**
+ * @brief Agrega una cadena al texto si cabe.
+ */
+static size_t appendString(char* text, size_t length, const char* source) {
+    while (*source != '\0' && length < LOG_TEXT_MAX - 1) {
+        text[length++] = *source++;
+    }
+    return length;
+}
+
+/**
+ * @brief Agrega un entero en decimal al texto si cabe.
+ */
+static size_t appendInteger(char* text, size_t length, int32_t value) {
+    char digits[12];
+    size_t count = 0;
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+
+    do {
+        digits[count++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        digits[count++] = '-';
+    }
+    while (count > 0 && length < LOG_TEXT_MAX - 1) {
+        text[length++] = digits[--count];
+    }
+    return length;
+}
+
+/**
+ * @brief Escribe la marca de tiempo del registro con el largo pedido.
+ */
+static size_t appendStamp(char* text, uint32_t timestamp, size_t stampLength) {
+    if (!stampFormatReady) {
+        timeFormatInit(&stampFormat);
+        stampFormatReady = true;
+    }
+    return timeFormatCopy(&stampFormat, timestamp, stampLength, text);
+}
+
+static void putU32(uint8_t* wire, uint32_t value) {
+    wire[0] = (uint8_t)value;
+    wire[1] = (uint8_t)(value >> 8);
+    wire[2] = (uint8_t)(value >> 16);
+    wire[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t getU32(const uint8_t* wire) {
+    return (uint32_t)wire[0] | ((uint32_t)wire[1] << 8) | ((uint32_t)wire[2] << 16) | ((uint32_t)wire[3] << 24);
+}
+
+static uint8_t checksum(const uint8_t* wire) {
+    uint8_t sum = 0;
+    for (size_t i = 1; i < LOG_WIRE_SIZE - 1; i++) {
+        sum += wire[i];
+    }
+    return sum;
+}
+
+/**
+ * @brief Lee un número decimal de exactamente count dígitos.
+ */
+static bool parseDigits(const char* text, size_t count, uint32_t* value) {
+    uint32_t result = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t digit = (uint32_t)(text[i] - '0');
+        if (digit > 9) {
+            return false;
+        }
+        result = result * 10 + digit;
+    }
+    *value = result;
+    return true;
+}
+
+/**
+ * @brief Lee una marca "YYYY-MM-DD HH:MM[:SS]" en hora local y la convierte a segundos UTC.
+ */
+static bool parseStamp(const char* text, size_t stampLength, uint32_t* timestamp) {
+    uint32_t year, month, day, hour, minute, second = 0;
+
+    if (text[4] != '-' || text[7] != '-' || text[10] != ' ' || text[13] != ':' ||
+        (stampLength == TIME_FORMAT_SECONDS_LENGTH && text[16] != ':')) {
+        return false;
+    }
+    if (!parseDigits(&text[0], 4, &year) || !parseDigits(&text[5], 2, &month) || !parseDigits(&text[8], 2, &day) ||
+        !parseDigits(&text[11], 2, &hour) || !parseDigits(&text[14], 2, &minute) ||
+        (stampLength == TIME_FORMAT_SECONDS_LENGTH && !parseDigits(&text[17], 2, &second))) {
+        return false;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > timeDaysInMonth((int32_t)year, (uint8_t)month) || hour > 23 ||
+        minute > 59 || second > 59) {
+        return false;
+    }
+
+    timeCivil_t date = {(int32_t)year, (uint8_t)month, (uint8_t)day};
+    int64_t local = (int64_t)timeDaysFromCivil(&date) * (int64_t)SECONDS_PER_DAY + hour * 3600 + minute * 60 + second;
+    int64_t utc = local - (int64_t)TIME_FORMAT_UTC_OFFSET;
+    if (utc < 0 || utc > (int64_t)UINT32_MAX) {
+        return false;
+    }
+    *timestamp = (uint32_t)utc;
+    return true;
+}
+
+/**
+ * @brief Compara el texto en la posición at con un literal.
+ *
+ * @return Posición siguiente al literal, o 0 si no coincide.
+ */
+static size_t matchLiteral(const char* text, size_t length, size_t at, const char* literal, size_t literalLength) {
+    if (length - at < literalLength || memcmp(&text[at], literal, literalLength) != 0) {
+        return 0;
+    }
+    return at + literalLength;
+}
+
+/**
+ * @brief Lee un entero decimal sin signo de 1 a 9 dígitos.
+ *
+ * @return Posición siguiente al número, o 0 si no hay número.
+ */
+static size_t parseNumber(const char* text, size_t length, size_t at, uint32_t* value) {
+    size_t start = at;
+    uint32_t result = 0;
+    while (at < length && at - start < 9 && (uint32_t)(text[at] - '0') <= 9) {
+        result = result * 10 + (uint32_t)(text[at] - '0');
+        at++;
+    }
+    *value = result;
+    return at > start ? at : 0;
+}
+
+/* === Public function implementation ========================================================== */
+
+size_t logFormatText(const logRecord_t* record, char* text) {
+    assert(record != NULL);
+    assert(text != NULL);
+
+    size_t length = 0;
+
+    switch (record->id) {
+    case LOG_EVENT_RAIN_DETECTED:
+        length = appendStamp(text, record->timestamp, TIME_FORMAT_SECONDS_LENGTH);
+        length = appendString(text, length, MSG_RAIN_DETECTED);
+        break;
+    case LOG_EVENT_ACCUMULATED_RAINFALL:
+        length = appendStamp(text, record->timestamp, TIME_FORMAT_MINUTES_LENGTH);
+        length = appendString(text, length, MSG_ACCUMULATED_RAINFALL);
+        length = appendInteger(text, length, record->arg / 10);
+        length = appendString(text, length, ".");
+        length = appendInteger(text, length, (record->arg < 0 ? -record->arg : record->arg) % 10);
+        length = appendString(text, length, " mm\n");
+        break;
+    case LOG_EVENT_DROPPED:
+        length = appendStamp(text, record->timestamp, TIME_FORMAT_SECONDS_LENGTH);
+        length = appendString(text, length, MSG_DROPPED_RECORDS);
+        length = appendInteger(text, length, record->arg);
+        length = appendString(text, length, "\n");
+        break;
+    case LOG_EVENT_ALARM_RAISED:
+    case LOG_EVENT_ALARM_CLEARED:
+        length = appendStamp(text, record->timestamp, TIME_FORMAT_SECONDS_LENGTH);
+        length = appendString(text, length,
+                              record->id == LOG_EVENT_ALARM_RAISED ? MSG_ALARM_RAISED : MSG_ALARM_CLEARED);
+        length = appendInteger(text, length, record->arg);
+        length = appendString(text, length, "\n");
+        break;
+    case LOG_EVENT_TIP_ANOMALY:
+        length = appendStamp(text, record->timestamp, TIME_FORMAT_SECONDS_LENGTH);
+        length = appendString(text, length, MSG_TIP_ANOMALY);
+        length = appendInteger(text, length, record->arg);
+        length = appendString(text, length, "\n");
+        break;
+    default:
+        break;
+    }
+
+    text[length] = '\0';
+    return length;
+}
+
+bool logParseText(const char* text, size_t length, logRecord_t* record) {
+    assert(text != NULL);
+    assert(record != NULL);
+
+    while (length > 0 && (text[length - 1] == '\n' || text[length - 1] == '\r')) {
+        length--;
+    }
+
+    // Con segundos: tick, registros descartados, alarma o anomalía
+    if (length > TIME_FORMAT_SECONDS_LENGTH && text[TIME_FORMAT_SECONDS_LENGTH - 3] == ':') {
+        size_t at = TIME_FORMAT_SECONDS_LENGTH;
+        if (!parseStamp(text, TIME_FORMAT_SECONDS_LENGTH, &record->timestamp)) {
+            return false;
+        }
+        if (matchLiteral(text, length, at, MSG_RAIN_DETECTED, MSG_RAIN_DETECTED_LENGTH) == length) {
+            record->id = LOG_EVENT_RAIN_DETECTED;
+            record->arg = 0;
+            return true;
+        }
+        uint32_t count;
+        size_t next;
+        if ((next = matchLiteral(text, length, at, MSG_DROPPED_RECORDS, sizeof(MSG_DROPPED_RECORDS) - 1)) != 0) {
+            record->id = LOG_EVENT_DROPPED;
+        } else if ((next = matchLiteral(text, length, at, MSG_ALARM_RAISED, sizeof(MSG_ALARM_RAISED) - 1)) != 0) {
+            record->id = LOG_EVENT_ALARM_RAISED;
+        } else if ((next = matchLiteral(text, length, at, MSG_ALARM_CLEARED, sizeof(MSG_ALARM_CLEARED) - 1)) != 0) {
+            record->id = LOG_EVENT_ALARM_CLEARED;
+        } else if ((next = matchLiteral(text, length, at, MSG_TIP_ANOMALY, sizeof(MSG_TIP_ANOMALY) - 1)) != 0) {
+            record->id = LOG_EVENT_TIP_ANOMALY;
+        }
+        if (next == 0 || parseNumber(text, length, next, &count) != length) {
+            return false;
+        }
+        record->arg = (int32_t)count;
+        return true;
+    }
+
+    // Sin segundos: lluvia acumulada "X.Y mm", en décimas de mm
+    if (length <= TIME_FORMAT_MINUTES_LENGTH || !parseStamp(text, TIME_FORMAT_MINUTES_LENGTH, &record->timestamp)) {
+        return false;
+    }
+    size_t at = matchLiteral(text, length, TIME_FORMAT_MINUTES_LENGTH, MSG_ACCUMULATED_RAINFALL,
+                             sizeof(MSG_ACCUMULATED_RAINFALL) - 1);
+    bool negative = at != 0 && at < length && text[at] == '-';
+    uint32_t whole;
+    uint32_t fraction = 0;
+    at = at == 0 ? 0 : parseNumber(text, length, at + (negative ? 1 : 0), &whole);
+    if (at != 0 && at < length && text[at] == '.') {
+        // Décimas, redondeando las centésimas del formato histórico "X.XX mm"
+        size_t digits = at + 1;
+        at = parseNumber(text, length, digits, &fraction);
+        if (at - digits > 2) {
+            return false;
+        }
+        fraction = at - digits == 2 ? (fraction + 5) / 10 : fraction;
+    }
+    if (at == 0 || whole > INT32_MAX / 10 - 1 || matchLiteral(text, length, at, MSG_MM, sizeof(MSG_MM) - 1) != length) {
+        return false;
+    }
+    int32_t tenths = (int32_t)(whole * 10 + fraction);
+    record->id = LOG_EVENT_ACCUMULATED_RAINFALL;
+    record->arg = negative ? -tenths : tenths;
+    return true;
+}
+
+size_t logEncodeWire(const logRecord_t* record, uint8_t* wire) {
+    assert(record != NULL);
+    assert(wire != NULL);
+
+    wire[0] = LOG_WIRE_SYNC;
+    wire[1] = record->id;
+    putU32(&wire[2], record->timestamp);
+    putU32(&wire[6], (uint32_t)record->arg);
+    wire[10] = checksum(wire);
+    return LOG_WIRE_SIZE;
+}
+
+size_t logEncodeCompact(tipEncoder_t* encoder, const logRecord_t* record, uint8_t* out) {
+    assert(record != NULL);
+
+    uint64_t timestamp = (uint64_t)record->timestamp * 1000;
+    if (record->id == LOG_EVENT_RAIN_DETECTED) {
+        return tipEncodeTip(encoder, timestamp + (uint64_t)(int64_t)record->arg, out);
+    }
+    return tipEncodeMark(encoder, record->id, timestamp, record->arg, out);
+}
+
+void logAddToFrame(telemetryFramer_t* framer, const logRecord_t* record) {
+    assert(record != NULL);
+
+    uint64_t timestamp = (uint64_t)record->timestamp * 1000;
+    if (record->id == LOG_EVENT_RAIN_DETECTED) {
+        telemetryFramerAddTip(framer, timestamp + (uint64_t)(int64_t)record->arg);
+    } else {
+        telemetryFramerAddMark(framer, record->id, timestamp, record->arg);
+    }
+}
+
+void logCompactRecord(const tipCodecItem_t* item, logRecord_t* record) {
+    assert(item != NULL);
+    assert(record != NULL);
+
+    record->timestamp = (uint32_t)(item->timestamp / 1000);
+    if (item->mark) {
+        record->id = item->kind;
+        record->arg = item->value;
+    } else {
+        record->id = LOG_EVENT_RAIN_DETECTED;
+        record->arg = (int32_t)(item->timestamp % 1000);
+    }
+}
+
+void logDecoderInit(logDecoder_t* decoder) {
+    assert(decoder != NULL);
+
+    decoder->length = 0;
+    decoder->errors = 0;
+}
+
+bool logDecoderPush(logDecoder_t* decoder, uint8_t byte, logRecord_t* record) {
+    assert(decoder != NULL);
+    assert(record != NULL);
+
+    if (decoder->length == 0 && byte != LOG_WIRE_SYNC) {
+        decoder->errors++;
+        return false;
+    }
+    decoder->buffer[decoder->length++] = byte;
+    if (decoder->length < LOG_WIRE_SIZE) {
+        return false;
+    }
+
+    if (decoder->buffer[10] == checksum(decoder->buffer)) {
+        record->id = decoder->buffer[1];
+        record->timestamp = getU32(&decoder->buffer[2]);
+        record->arg = (int32_t)getU32(&decoder->buffer[6]);
+        decoder->length = 0;
+        return true;
+    }
+
+    // Registro corrupto: se resincroniza en el siguiente byte de sincronismo
+    size_t next = 1;
+    while (next < LOG_WIRE_SIZE && decoder->buffer[next] != LOG_WIRE_SYNC) {
+        next++;
+    }
+    decoder->errors += next;
+    decoder->length = LOG_WIRE_SIZE - next;
+    memmove(decoder->buffer, &decoder->buffer[next], decoder->length);
+    return false;
+}
+
+/* === End of documentation ==================================================================== */
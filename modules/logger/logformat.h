@@ -0,0 +1,177 @@
+/*
+ * Nombre del archivo: logformat.h
+ * Descripción: Registros binarios del registro de eventos y su conversión a texto.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef LOGFORMAT_H
+#define LOGFORMAT_H
+
+/** @file
+ ** @brief Formato de los registros del registro de eventos.
+ **
+ ** Es código puro (sin acceso a periféricos) para que el firmware y el
+ ** decodificador de PC compartan exactamente la misma conversión a texto.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tipcodec.h"
+#include "telemetry.h"
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#define LOG_WIRE_SYNC 0xA5  ///< Primer byte de cada registro binario en la línea
+#define LOG_WIRE_SIZE 11  ///< Bytes de un registro binario: sync, id, tiempo, argumento, suma
+#define LOG_TEXT_MAX 80  ///< Largo máximo de una línea de texto
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Identificadores de evento.
+ */
+typedef enum {
+    LOG_EVENT_RAIN_DETECTED = 1,  ///< Tick; arg = ms del tick a partir de timestamp * 1000
+    LOG_EVENT_ACCUMULATED_RAINFALL = 2,  ///< Reporte; arg = lluvia en décimas de mm
+    LOG_EVENT_DROPPED = 3,  ///< Registros descartados por cola llena; arg = cantidad
+    LOG_EVENT_ALARM_RAISED = 4,  ///< Regla de alarma activada; arg = identificador de la regla
+    LOG_EVENT_ALARM_CLEARED = 5,  ///< Regla de alarma desactivada; arg = identificador de la regla
+    LOG_EVENT_TIP_ANOMALY = 6,  ///< Anomalía de los ticks; arg = banderas tipAnomaly_t nuevas
+    LOG_EVENT_STATUS_UPTIME = 16,  ///< Estado; arg = segundos desde el arranque
+    LOG_EVENT_STATUS_DROPPED = 17,  ///< Estado; arg = registros descartados desde el arranque
+    LOG_EVENT_STATUS_BOUNCES = 18,  ///< Estado; arg = flancos descartados por el antirrebote
+    LOG_EVENT_STATUS_OVERFLOWS = 19,  ///< Estado; arg = ticks perdidos por cola de captura llena
+} logEventId_t;
+
+/**
+ * @brief Registro compacto que se encola en el camino rápido.
+ */
+typedef struct {
+    uint8_t id;  ///< logEventId_t
+    uint32_t timestamp;  ///< Segundos desde la época
+    int32_t arg;  ///< Argumento según el evento
+} logRecord_t;
+
+/**
+ * @brief Estado del decodificador incremental de la línea binaria.
+ */
+typedef struct {
+    uint8_t buffer[LOG_WIRE_SIZE];
+    size_t length;
+    uint32_t errors;  ///< Bytes descartados al resincronizar
+} logDecoder_t;
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Convierte un registro a la línea de texto histórica del pluviómetro.
+ *
+ * Los registros de estado no tienen línea de texto: solo viajan en los
+ * formatos binarios.
+ *
+ * @param record Registro a convertir.
+ * @param text Buffer destino de al menos LOG_TEXT_MAX bytes.
+ * @return Largo de la línea (sin terminador).
+ */
+size_t logFormatText(const logRecord_t* record, char* text);
+
+/**
+ * @brief Convierte una línea de texto del pluviómetro en el registro equivalente.
+ *
+ * Inversa de logFormatText(): reconoce las líneas de tick, de lluvia
+ * acumulada, de registros descartados, de alarmas y de anomalías, con o sin el
+ * fin de línea. Lee la línea en su lugar, sin copiarla ni reservar memoria. Los ticks no llevan
+ * ms en el texto, así que su argumento es 0.
+ *
+ * @param text Línea (no necesita terminador).
+ * @param length Largo de la línea.
+ * @param record Registro de salida, válido solo si retorna true.
+ * @return true si la línea es un registro válido.
+ */
+bool logParseText(const char* text, size_t length, logRecord_t* record);
+
+/**
+ * @brief Serializa un registro para la línea binaria (little endian, con suma de control).
+ *
+ * @param record Registro a serializar.
+ * @param wire Buffer destino de LOG_WIRE_SIZE bytes.
+ * @return LOG_WIRE_SIZE.
+ */
+size_t logEncodeWire(const logRecord_t* record, uint8_t* wire);
+
+/**
+ * @brief Codifica un registro en el flujo compacto (ticks por diferencia de diferencias en ms).
+ *
+ * @param encoder Estado del flujo.
+ * @param record Registro a codificar.
+ * @param out Buffer destino de al menos TIP_CODEC_ITEM_MAX bytes.
+ * @return Bytes escritos.
+ */
+size_t logEncodeCompact(tipEncoder_t* encoder, const logRecord_t* record, uint8_t* out);
+
+/**
+ * @brief Agrega un registro como mensaje de una trama de telemetría.
+ *
+ * @param framer Trama en armado, con lugar (telemetryFramerHasRoom()).
+ * @param record Registro a agregar.
+ */
+void logAddToFrame(telemetryFramer_t* framer, const logRecord_t* record);
+
+/**
+ * @brief Convierte un elemento del flujo compacto o de una trama en el registro equivalente.
+ *
+ * @param item Elemento decodificado por tipDecoderPush() o telemetryDecoderPush().
+ * @param record Registro de salida.
+ */
+void logCompactRecord(const tipCodecItem_t* item, logRecord_t* record);
+
+/**
+ * @brief Inicializa el decodificador de la línea binaria.
+ */
+void logDecoderInit(logDecoder_t* decoder);
+
+/**
+ * @brief Entrega un byte recibido al decodificador.
+ *
+ * @param decoder Estado del decodificador.
+ * @param byte Byte recibido.
+ * @param record Registro de salida, válido solo si retorna true.
+ * @return true si el byte completó un registro válido.
+ */
+bool logDecoderPush(logDecoder_t* decoder, uint8_t byte, logRecord_t* record);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOGFORMAT_H */
@@ -0,0 +1,235 @@
+/*
+ * Nombre del archivo: logger.cpp
+ * Descripción: Registro de eventos no bloqueante con formato diferido sobre la UART.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Implementación del registro de eventos no bloqueante.
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include "mbed.h"
+
+#include <assert.h>
+#include <atomic>
+
+#include "logger.h"
+#include "probe.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define LOGGER_QUEUE_MASK (LOGGER_QUEUE_SIZE - 1)
+
+static_assert((LOGGER_QUEUE_SIZE & LOGGER_QUEUE_MASK) == 0, "LOGGER_QUEUE_SIZE debe ser potencia de 2");
+static_assert(LOG_WIRE_SIZE <= LOG_TEXT_MAX && TIP_CODEC_ITEM_MAX <= LOG_TEXT_MAX,
+              "el buffer de salida contiene todos los formatos");
+
+#if LOGGER_WIRE_MODE == LOGGER_WIRE_FRAMED
+#define LOGGER_OUTPUT_SIZE TELEMETRY_FRAME_MAX
+static_assert(LOG_TEXT_MAX <= TELEMETRY_TEXT_MAX, "una línea de la fuente entra en una trama de texto");
+#else
+#define LOGGER_OUTPUT_SIZE LOG_TEXT_MAX
+#endif
+
+/* === Private variable declarations =========================================================== */
+
+/* Cola de un productor (camino de detección) y un consumidor (loggerDrain) */
+static logRecord_t logQueue[LOGGER_QUEUE_SIZE];
+static std::atomic<uint32_t> logHead(0);
+static std::atomic<uint32_t> logTail(0);
+
+static uint32_t droppedPending = 0;  ///< Descartes aún no informados con LOG_EVENT_DROPPED
+static loggerStats_t stats;
+
+static BufferedSerial* serialPort = NULL;
+static loggerSource_t lineSource = NULL;  ///< Respuestas intercaladas con los registros
+static bool sourceTurn = false;  ///< La próxima salida le toca a lineSource
+static char output[LOGGER_OUTPUT_SIZE];  ///< Registro o trama en transmisión
+static size_t outputLength = 0;
+static size_t outputSent = 0;
+#if LOGGER_WIRE_MODE == LOGGER_WIRE_COMPACT
+static tipEncoder_t wireEncoder;  ///< Estado del flujo compacto
+#elif LOGGER_WIRE_MODE == LOGGER_WIRE_FRAMED
+static telemetryFramer_t wireFramer;  ///< Trama en armado
+static char sourceLine[LOG_TEXT_MAX];  ///< Línea de la fuente antes de armar su trama de texto
+#endif
+
+/* === Private function implementation ========================================================= */
+
+/**
+ * @brief Escribe un registro en la cola si hay espacio.
+ */
+static bool push(uint8_t id, uint32_t timestamp, int32_t arg) {
+    uint32_t head = logHead.load(std::memory_order_relaxed);
+    uint32_t tail = logTail.load(std::memory_order_acquire);
+
+    if (head - tail >= LOGGER_QUEUE_SIZE) {
+        return false;
+    }
+
+    logRecord_t* record = &logQueue[head & LOGGER_QUEUE_MASK];
+    record->id = id;
+    record->timestamp = timestamp;
+    record->arg = arg;
+    logHead.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Extrae el registro más antiguo de la cola.
+ */
+static bool pop(logRecord_t* record) {
+    uint32_t tail = logTail.load(std::memory_order_relaxed);
+    uint32_t head = logHead.load(std::memory_order_acquire);
+
+    if (tail == head) {
+        return false;
+    }
+    *record = logQueue[tail & LOGGER_QUEUE_MASK];
+    logTail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+/* === Public function implementation ========================================================== */
+
+void loggerInit(BufferedSerial* port) {
+    assert(port != NULL);
+
+    serialPort = port;
+    serialPort->set_blocking(false);
+#if LOGGER_WIRE_MODE == LOGGER_WIRE_COMPACT
+    tipEncoderInit(&wireEncoder);
+#elif LOGGER_WIRE_MODE == LOGGER_WIRE_FRAMED
+    telemetryFramerInit(&wireFramer);
+#endif
+}
+
+bool logEvent(logEventId_t id, uint32_t timestamp, int32_t arg) {
+    // Primero se informa cuántos registros se perdieron, en orden con el resto
+    if (droppedPending > 0 && push(LOG_EVENT_DROPPED, timestamp, (int32_t)droppedPending)) {
+        droppedPending = 0;
+    }
+
+    if (droppedPending > 0 || !push((uint8_t)id, timestamp, arg)) {
+        droppedPending++;
+        stats.dropped++;
+        return false;
+    }
+    stats.enqueued++;
+    PROBE_VALUE(PROBE_LOG_QUEUE_DEPTH, logHead.load(std::memory_order_relaxed) - logTail.load(std::memory_order_relaxed));
+    return true;
+}
+
+bool loggerDrain() {
+    assert(serialPort != NULL);
+
+    bool sourceEmpty = lineSource == NULL;
+    while (true) {
+        if (outputSent < outputLength) {
+            PROBE_START(writeStart);
+            ssize_t written = serialPort->write(&output[outputSent], outputLength - outputSent);
+            PROBE_STOP(PROBE_UART_WRITE, writeStart);
+            if (written <= 0) {
+                return true;  // La UART está llena: se continúa en la próxima llamada
+            }
+            outputSent += (size_t)written;
+            stats.bytesWritten += (uint32_t)written;
+            continue;
+        }
+
+        // Una línea de la fuente y un registro (o una trama) por turno: ninguno espera al otro entero
+        if (lineSource != NULL && sourceTurn) {
+            sourceTurn = false;
+#if LOGGER_WIRE_MODE == LOGGER_WIRE_FRAMED
+            // Cada línea en su propia trama: el receptor la separa sin perder la trama de datos siguiente
+            size_t lineLength = lineSource(sourceLine, sizeof(sourceLine));
+            outputLength = lineLength > 0 ? telemetryFrameText(sourceLine, lineLength, (uint8_t*)output) : 0;
+#else
+            outputLength = lineSource(output, LOGGER_OUTPUT_SIZE);
+#endif
+            sourceEmpty = outputLength == 0;
+            if (!sourceEmpty) {
+                outputSent = 0;
+                continue;
+            }
+        }
+        sourceTurn = true;
+
+#if LOGGER_WIRE_MODE == LOGGER_WIRE_FRAMED
+        // Todo lo que se acumuló mientras la UART estaba ocupada viaja en una trama
+        logRecord_t record;
+        while (telemetryFramerHasRoom(&wireFramer) && pop(&record)) {
+            logAddToFrame(&wireFramer, &record);
+        }
+        if (telemetryFramerIsEmpty(&wireFramer)) {
+            if (!sourceEmpty) {
+                continue;
+            }
+            return false;
+        }
+        outputLength = telemetryFramerFinish(&wireFramer, (uint8_t*)output);
+#else
+        logRecord_t record;
+        if (!pop(&record)) {
+            if (!sourceEmpty) {
+                continue;
+            }
+            return false;
+        }
+#if LOGGER_WIRE_MODE == LOGGER_WIRE_BINARY
+        outputLength = logEncodeWire(&record, (uint8_t*)output);
+#elif LOGGER_WIRE_MODE == LOGGER_WIRE_COMPACT
+        outputLength = logEncodeCompact(&wireEncoder, &record, (uint8_t*)output);
+#else
+        outputLength = logFormatText(&record, output);
+#endif
+#endif
+        outputSent = 0;
+    }
+}
+
+void loggerSetSource(loggerSource_t source) {
+#if LOGGER_WIRE_MODE == LOGGER_WIRE_COMPACT
+    // El flujo compacto no se resincroniza: una línea de texto intercalada lo corrompería para siempre
+    assert(source == NULL);
+    (void)source;
+#else
+    lineSource = source;
+#endif
+}
+
+void loggerFlush() {
+    assert(serialPort != NULL);
+
+    // Con escrituras bloqueantes loggerDrain() solo retorna con la cola vacía
+    serialPort->set_blocking(true);
+    loggerDrain();
+    serialPort->set_blocking(false);
+}
+
+void loggerGetStats(loggerStats_t* copy) {
+    assert(copy != NULL);
+
+    *copy = stats;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,153 @@
+/*
+ * Nombre del archivo: logger.h
+ * Descripción: Registro de eventos no bloqueante con formato diferido sobre la UART.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+/** @file
+ ** @brief Registro de eventos no bloqueante.
+ **
+ ** El camino de detección solo encola un registro binario compacto con
+ ** logEvent(). loggerDrain(), llamado desde el bucle principal, convierte los
+ ** registros a texto (o los serializa en modo binario, compacto o en tramas) y los escribe en la
+ ** UART sin bloquear: si la línea está ocupada retorna y continúa en la
+ ** siguiente llamada. Con la cola llena los registros se descartan y se
+ ** cuentan, y el total se informa con un registro LOG_EVENT_DROPPED.
+ **
+ ** Una fuente registrada con loggerSetSource() (las respuestas a los
+ ** comandos) entrega líneas de texto que se alternan con los registros, de a
+ ** una, sin cortar ninguno a la mitad. En modo binario las líneas viajan tal
+ ** cual (no contienen LOG_WIRE_SYNC, así que el receptor las saltea sin
+ ** perder registros) y en modo en tramas cada una va en su propia trama de
+ ** texto. El flujo compacto no admite fuente.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include "mbed.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "logformat.h"
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+// Formatos de salida en la línea serie
+#define LOGGER_WIRE_TEXT 0  ///< Líneas de texto como las históricas
+#define LOGGER_WIRE_BINARY 1  ///< Registros binarios de LOG_WIRE_SIZE bytes (ver tools/logdecode)
+#define LOGGER_WIRE_COMPACT 2  ///< Flujo de modules/codec desde el arranque, sin resincronización
+#define LOGGER_WIRE_FRAMED 3  ///< Tramas de modules/telemetry con lotes, secuencia y CRC
+#ifndef LOGGER_WIRE_MODE
+#define LOGGER_WIRE_MODE LOGGER_WIRE_TEXT  ///< Formato de salida en uso
+#endif
+
+#define LOGGER_QUEUE_SIZE 64  ///< Registros en espera (potencia de 2)
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Contadores del registro de eventos.
+ */
+typedef struct {
+    uint32_t enqueued;  ///< Registros aceptados
+    uint32_t dropped;  ///< Registros descartados por cola llena
+    uint32_t bytesWritten;  ///< Bytes entregados a la UART
+} loggerStats_t;
+
+/**
+ * @brief Fuente de líneas que loggerDrain() intercala con los registros.
+ *
+ * @param text Buffer destino.
+ * @param size Tamaño del buffer destino.
+ * @return Largo de la línea escrita en text, o 0 si no hay más por ahora.
+ */
+typedef size_t (*loggerSource_t)(char* text, size_t size);
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Asocia el registro a un puerto serie y lo pasa a modo no bloqueante.
+ *
+ * @param port Puerto de salida.
+ */
+void loggerInit(BufferedSerial* port);
+
+/**
+ * @brief Encola un evento. No formatea ni escribe; nunca bloquea.
+ *
+ * Debe llamarse desde un único productor.
+ *
+ * @param id Identificador del evento.
+ * @param timestamp Instante del evento en segundos desde la época.
+ * @param arg Argumento del evento.
+ * @return true si se encoló, false si se descartó por cola llena.
+ */
+bool logEvent(logEventId_t id, uint32_t timestamp, int32_t arg);
+
+/**
+ * @brief Formatea y transmite registros mientras la UART acepte bytes.
+ *
+ * @return true si queda salida pendiente.
+ */
+bool loggerDrain(void);
+
+/**
+ * @brief Registra la fuente de líneas intercaladas (NULL la quita).
+ *
+ * La fuente corre dentro de loggerDrain(), en su mismo contexto. Con
+ * LOGGER_WIRE_COMPACT solo admite NULL: ese flujo no se resincroniza.
+ *
+ * @param source Fuente de líneas.
+ */
+void loggerSetSource(loggerSource_t source);
+
+/**
+ * @brief Transmite todo lo pendiente esperando a la UART.
+ *
+ * Bloquea hasta vaciar la cola; sirve para intercalar una salida a pedido
+ * (por ejemplo probeDump()) sin cortar un registro o una trama a la mitad.
+ */
+void loggerFlush(void);
+
+/**
+ * @brief Copia los contadores del registro.
+ *
+ * @param stats Puntero a la estructura destino.
+ */
+void loggerGetStats(loggerStats_t* stats);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOGGER_H */
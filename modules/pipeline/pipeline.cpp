@@ -0,0 +1,291 @@
+/*
+ * Nombre del archivo: pipeline.cpp
+ * Descripción: Adquisición, agregación y E/S en hilos separados unidos por colas acotadas.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Implementación del pipeline de adquisición, agregación y E/S.
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include "mbed.h"
+#include "arm_book_lib.h"
+
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+
+#include "tipcapture.h"
+#include "pulsecounter.h"
+#include "logger.h"
+#include "pluviometer.h"
+#include "eventloop.h"
+#include "spscqueue.h"
+#include "probe.h"
+#include "pipeline.h"
+
+#if MAIN_LOOP_MODE == MAIN_LOOP_PIPELINE
+
+/* === Macros definitions ====================================================================== */
+
+#define PIPELINE_FLAG_WORK 0x1  ///< Marca de hilo: hay trabajo para la etapa o se pidió terminar
+
+/* === Private variable declarations =========================================================== */
+
+static Thread acquisitionThread(osPriorityHigh, PIPELINE_ACQUISITION_STACK, NULL, "acquisition");
+static Thread aggregationThread(osPriorityNormal, PIPELINE_AGGREGATION_STACK, NULL, "aggregation");
+static Thread ioThread(osPriorityBelowNormal, PIPELINE_IO_STACK, NULL, "io");
+
+static SpscQueue<tipEvent_t, PIPELINE_TIP_QUEUE_SIZE> tipQueue;  ///< Adquisición -> agregación
+static std::atomic<bool> acquisitionBlocked(false);  ///< La adquisición espera lugar en tipQueue
+static std::atomic<bool> stopRequested(false);
+static pipelineStats_t pipelineStats;
+
+/* === Private function declarations =========================================================== */
+
+static void onTipQueued(void);
+static void acquisitionStage(void);
+static void aggregationStage(void);
+static void ioStage(void);
+static void onSerialEvent(void);
+static size_t popTips(tipEvent_t* tips, size_t maxTips);
+
+/* === Private function implementation ========================================================= */
+
+/**
+ * @brief Aviso de la ISR de captura: despierta a la adquisición.
+ */
+static void onTipQueued() {
+    acquisitionThread.flags_set(PIPELINE_FLAG_WORK);
+}
+
+/**
+ * @brief Etapa de adquisición: pasa los ticks de la cola de la ISR a la cola de la agregación.
+ *
+ * Solo extrae de la cola de la ISR tantos ticks como quepan en tipQueue, así
+ * que nunca descarta ni espera: con tipQueue llena los ticks siguen en la
+ * cola de la ISR y la agregación la despierta al hacer lugar. Con
+ * ACQUISITION_TIMER no hay ISR: las capturas de la DMA se leen cada
+ * PULSE_COUNTER_POLL_MS y el buffer circular hace de cola de la ISR.
+ */
+static void acquisitionStage() {
+    tipEvent_t batch[TIP_CAPTURE_BATCH_SIZE];
+
+    while (!stopRequested.load()) {
+#if ACQUISITION_MODE == ACQUISITION_TIMER
+        ThisThread::flags_wait_any_for(PIPELINE_FLAG_WORK, std::chrono::milliseconds(PULSE_COUNTER_POLL_MS));
+#else
+        ThisThread::flags_wait_any(PIPELINE_FLAG_WORK);
+#endif
+
+        while (true) {
+            uint32_t space = tipQueue.space();
+            if (space == 0) {
+                // Se vuelve a mirar tras publicar la marca: la agregación pudo vaciar la cola en el medio
+                acquisitionBlocked.store(true);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if ((space = tipQueue.space()) == 0) {
+                    pipelineStats.tipQueueStalls++;
+                    break;
+                }
+            }
+
+            size_t maxTips = space < TIP_CAPTURE_BATCH_SIZE ? space : TIP_CAPTURE_BATCH_SIZE;
+#if ACQUISITION_MODE == ACQUISITION_TIMER
+            size_t count = pulseCounterDrain(batch, maxTips);
+#else
+            size_t count = tipCaptureDrain(batch, maxTips);
+#endif
+            if (count == 0) {
+                break;
+            }
+
+            tick_t now = HAL_GetTick();
+            for (size_t i = 0; i < count; i++) {
+                PROBE_STOP(PROBE_EDGE_TO_ACQUISITION, batch[i].edgeTime);
+                if (now - batch[i].timestamp > pipelineStats.maxAcquisitionMs) {
+                    pipelineStats.maxAcquisitionMs = now - batch[i].timestamp;
+                }
+                tipQueue.push(batch[i]);
+            }
+            pipelineStats.tipsAcquired += (uint32_t)count;
+            aggregationThread.flags_set(PIPELINE_FLAG_WORK);
+        }
+    }
+}
+
+/**
+ * @brief Extrae hasta maxTips ticks de la cola de la agregación.
+ *
+ * @return Cantidad de ticks extraídos.
+ */
+static size_t popTips(tipEvent_t* tips, size_t maxTips) {
+    size_t count = 0;
+
+    while (count < maxTips && tipQueue.pop(&tips[count])) {
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Etapa de agregación: procesa los ticks, apaga los LEDs y corre el planificador.
+ *
+ * Duerme hasta un aviso de la adquisición, el próximo vencimiento del
+ * planificador o el apagado de los LEDs, lo que ocurra primero.
+ */
+static void aggregationStage() {
+    tipEvent_t batch[TIP_CAPTURE_BATCH_SIZE];
+    tick_t scheduleAt = HAL_GetTick() + runSchedule();
+    tick_t ledsOffAt = 0;
+    bool ledsOn = false;
+
+    while (!stopRequested.load()) {
+        tick_t now = HAL_GetTick();
+        uint32_t waitMs = (int32_t)(scheduleAt - now) > 0 ? scheduleAt - now : 0;
+        if (ledsOn) {
+            uint32_t ledsWaitMs = (int32_t)(ledsOffAt - now) > 0 ? ledsOffAt - now : 0;
+            waitMs = ledsWaitMs < waitMs ? ledsWaitMs : waitMs;
+        }
+        ThisThread::flags_wait_any_for(PIPELINE_FLAG_WORK, std::chrono::milliseconds(waitMs));
+
+        PROBE_START(workStart);
+        pipelineStats.aggregationWakeups++;
+
+        size_t count;
+        while ((count = popTips(batch, TIP_CAPTURE_BATCH_SIZE)) > 0) {
+            if (acquisitionBlocked.exchange(false)) {
+                acquisitionThread.flags_set(PIPELINE_FLAG_WORK);
+            }
+            actOnTips(batch, count);
+            pipelineStats.tipsAggregated += (uint32_t)count;
+            ledsOn = true;
+            ledsOffAt = HAL_GetTick() + DELAY_BETWEEN_TICK;
+            // Se avisa por lote: en una ráfaga larga la E/S vacía la cola de almacenamiento a la par
+            ioThread.flags_set(PIPELINE_FLAG_WORK);
+        }
+
+        now = HAL_GetTick();
+        if (ledsOn && (int32_t)(now - ledsOffAt) >= 0) {
+            tickLed = OFF;
+            ledsOn = false;
+        }
+        if (isScheduleDue()) {
+            scheduleAt = now + runSchedule();
+            ioThread.flags_set(PIPELINE_FLAG_WORK);
+        }
+        PROBE_STOP(PROBE_LOOP_ITERATION, workStart);
+    }
+}
+
+/**
+ * @brief Etapa de E/S: escribe la flash y transmite el registro de eventos.
+ *
+ * Con la UART llena reintenta a los EVENT_LOOP_DRAIN_RETRY_MS, igual que el
+ * bucle de eventos; sin salida pendiente despierta al menos cada
+ * PIPELINE_IO_IDLE_MS para atender la cola de almacenamiento. Los comandos
+ * recibidos por la UART la despiertan con onSerialEvent() y sus respuestas
+ * salen intercaladas con el registro de eventos.
+ */
+static void ioStage() {
+    bool pending = false;
+
+    while (!stopRequested.load()) {
+        uint32_t waitMs = pending ? EVENT_LOOP_DRAIN_RETRY_MS : PIPELINE_IO_IDLE_MS;
+        ThisThread::flags_wait_any_for(PIPELINE_FLAG_WORK, std::chrono::milliseconds(waitMs));
+
+        pipelineStats.ioWakeups++;
+        serviceStorage();
+        serviceCommands();
+        do {
+            pending = loggerDrain();
+        } while (!pending && serviceCommands());
+    }
+}
+
+/**
+ * @brief Aviso del puerto serie (contexto de interrupción): despierta a la E/S.
+ */
+static void onSerialEvent() {
+    ioThread.flags_set(PIPELINE_FLAG_WORK);
+}
+
+/* === Public function implementation ========================================================== */
+
+void pipelineStart() {
+    osStatus status;
+
+    stopRequested.store(false);
+    status = ioThread.start(callback(ioStage));
+    assert(status == osOK);
+    status = aggregationThread.start(callback(aggregationStage));
+    assert(status == osOK);
+    status = acquisitionThread.start(callback(acquisitionStage));
+    assert(status == osOK);
+    (void)status;
+
+    tipCaptureSetNotify(onTipQueued);
+    pc.sigio(callback(onSerialEvent));
+    // Procesa ticks que pudieran haber llegado antes de registrar el aviso
+    onTipQueued();
+}
+
+void pipelineStop() {
+    tipCaptureSetNotify(NULL);
+    pc.sigio(nullptr);
+    stopRequested.store(true);
+
+    acquisitionThread.flags_set(PIPELINE_FLAG_WORK);
+    aggregationThread.flags_set(PIPELINE_FLAG_WORK);
+    ioThread.flags_set(PIPELINE_FLAG_WORK);
+    acquisitionThread.join();
+    aggregationThread.join();
+    ioThread.join();
+}
+
+void pipelineRun() {
+    pipelineStart();
+    acquisitionThread.join();
+}
+
+void pipelineGetStats(pipelineStats_t* stats) {
+    assert(stats != NULL);
+
+    storageStats_t storage;
+    tipCaptureStats_t capture;
+    loggerStats_t logger;
+
+    getStorageStats(&storage);
+    tipCaptureGetStats(&capture);
+    loggerGetStats(&logger);
+
+    *stats = pipelineStats;
+    stats->tipQueueHighWater = tipQueue.highWater();
+    stats->storageHighWater = storage.highWater;
+    stats->storageStalls = storage.stalls;
+    stats->captureOverflows = capture.overflows;
+    stats->logDropped = logger.dropped;
+}
+
+#endif /* MAIN_LOOP_MODE == MAIN_LOOP_PIPELINE */
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,128 @@
+/*
+ * Nombre del archivo: pipeline.h
+ * Descripción: Adquisición, agregación y E/S en hilos separados unidos por colas acotadas.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+/** @file
+ ** @brief Adquisición, agregación y E/S en hilos separados.
+ **
+ ** Alternativa al bucle de eventos (MAIN_LOOP_MODE == MAIN_LOOP_PIPELINE) en
+ ** la que cada etapa corre en su propio hilo de Mbed:
+ **
+ ** - Adquisición (osPriorityHigh): despertada por la ISR de captura (o cada
+ **   PULSE_COUNTER_POLL_MS con ACQUISITION_TIMER), pasa los ticks de la cola
+ **   chica de la ISR a una cola profunda hacia la agregación, de modo que una
+ **   agregación o una E/S lentas no desborden la captura.
+ ** - Agregación (osPriorityNormal): corrige y acumula cada tick, actualiza las
+ **   ventanas y los acumulados, enciende y apaga los LEDs y corre el
+ **   planificador de reportes. Es el único productor del registro de eventos
+ **   y de la cola de almacenamiento.
+ ** - E/S (osPriorityBelowNormal): escribe en la flash los registros de la cola
+ **   de almacenamiento y transmite el registro de eventos por la UART.
+ **
+ ** Las colas entre etapas son de un productor y un consumidor sin bloqueos. La
+ ** adquisición nunca espera: si la cola de ticks se llena deja los ticks en la
+ ** cola de la ISR (contrapresión), donde un desborde se cuenta como
+ ** tipCaptureStats_t::overflows. La agregación espera a la E/S cuando la cola
+ ** de almacenamiento se llena, ya que un registro persistente no se descarta;
+ ** el registro de eventos descarta y cuenta como siempre.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include "mbed.h"
+
+#include <stdint.h>
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#define PIPELINE_TIP_QUEUE_SIZE 256  ///< Ticks entre la adquisición y la agregación (potencia de 2)
+#define PIPELINE_ACQUISITION_STACK 1024  ///< Pila del hilo de adquisición, en bytes
+#define PIPELINE_AGGREGATION_STACK 2048  ///< Pila del hilo de agregación, en bytes
+#define PIPELINE_IO_STACK 2048  ///< Pila del hilo de E/S, en bytes
+#define PIPELINE_IO_IDLE_MS 100  ///< Espera máxima de la E/S sin avisos (almacenamiento y sondas)
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Contadores del pipeline. Cada campo lo escribe una sola etapa.
+ */
+typedef struct {
+    uint32_t tipsAcquired;  ///< Ticks pasados a la cola de la agregación
+    uint32_t tipsAggregated;  ///< Ticks procesados por la agregación
+    uint32_t tipQueueHighWater;  ///< Máxima ocupación de la cola de ticks
+    uint32_t tipQueueStalls;  ///< Veces que la adquisición encontró la cola de ticks llena
+    uint32_t maxAcquisitionMs;  ///< Peor demora del flanco a la cola de ticks, en ms
+    uint32_t storageHighWater;  ///< Máxima ocupación de la cola de almacenamiento
+    uint32_t storageStalls;  ///< Esperas de la agregación con la cola de almacenamiento llena
+    uint32_t captureOverflows;  ///< Ticks perdidos en la cola de la ISR
+    uint32_t logDropped;  ///< Registros de eventos descartados
+    uint32_t aggregationWakeups;  ///< Despertares del hilo de agregación
+    uint32_t ioWakeups;  ///< Despertares del hilo de E/S
+} pipelineStats_t;
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Arranca los tres hilos del pipeline.
+ *
+ * Requiere ACQUISITION_INTERRUPT o ACQUISITION_TIMER, initializeSensors() y
+ * scheduleReports() ya llamados. Retorna enseguida.
+ */
+void pipelineStart(void);
+
+/**
+ * @brief Pide a los hilos que terminen y espera a que lo hagan.
+ *
+ * Los ticks y registros aún encolados quedan sin procesar. Pensada para las
+ * herramientas del PC; en el equipo el pipeline corre para siempre.
+ */
+void pipelineStop(void);
+
+/**
+ * @brief Arranca el pipeline y bloquea el hilo que llama. No retorna.
+ */
+void pipelineRun(void);
+
+/**
+ * @brief Copia los contadores del pipeline.
+ *
+ * @param stats Puntero a la estructura destino.
+ */
+void pipelineGetStats(pipelineStats_t* stats);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PIPELINE_H */
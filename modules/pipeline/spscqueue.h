@@ -0,0 +1,132 @@
+/*
+ * Nombre del archivo: spscqueue.h
+ * Descripción: Cola acotada sin bloqueos de un productor y un consumidor.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+/** @file
+ ** @brief Cola acotada sin bloqueos de un productor y un consumidor.
+ **
+ ** Es la misma cola circular con índices atómicos de la captura y del
+ ** registro de eventos, como plantilla para cualquier tipo de elemento. Los
+ ** índices corren libres y se enmascaran al acceder, así que la capacidad
+ ** debe ser potencia de 2. Lleva la cuenta de los elementos descartados por
+ ** cola llena y de la máxima ocupación alcanzada.
+ **
+ ** El productor elige qué hacer con la cola llena: push() descarta y cuenta,
+ ** y full() permite esperar antes de encolar (contrapresión).
+ **
+ ** Solo C++: las plantillas no pueden declararse dentro de extern "C".
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <atomic>
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Cola de un productor y un consumidor.
+ *
+ * @tparam T Tipo de los elementos (copiable).
+ * @tparam Size Capacidad en elementos (potencia de 2).
+ */
+template <typename T, uint32_t Size>
+class SpscQueue {
+    static_assert(Size > 0 && (Size & (Size - 1)) == 0, "la capacidad debe ser potencia de 2");
+
+public:
+    static constexpr uint32_t capacity = Size;
+
+    /**
+     * @brief Encola un elemento. Solo el productor.
+     *
+     * @param item Elemento a copiar en la cola.
+     * @return true si se encoló, false si se descartó por cola llena.
+     */
+    bool push(const T& item) {
+        uint32_t head = headIndex.load(std::memory_order_relaxed);
+        uint32_t tail = tailIndex.load(std::memory_order_acquire);
+
+        if (head - tail >= Size) {
+            dropCount.store(dropCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        items[head & (Size - 1)] = item;
+        headIndex.store(head + 1, std::memory_order_release);
+        if (head + 1 - tail > highWaterMark.load(std::memory_order_relaxed)) {
+            highWaterMark.store(head + 1 - tail, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Extrae el elemento más antiguo. Solo el consumidor.
+     *
+     * @param item Destino del elemento.
+     * @return true si había un elemento.
+     */
+    bool pop(T* item) {
+        uint32_t tail = tailIndex.load(std::memory_order_relaxed);
+        uint32_t head = headIndex.load(std::memory_order_acquire);
+
+        if (tail == head) {
+            return false;
+        }
+        *item = items[tail & (Size - 1)];
+        tailIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** @brief Elementos en la cola; exacto desde el productor o el consumidor, aproximado desde otro hilo. */
+    uint32_t size() const {
+        return headIndex.load(std::memory_order_acquire) - tailIndex.load(std::memory_order_acquire);
+    }
+
+    /** @brief Lugares libres; desde el productor no puede disminuir sin que él encole. */
+    uint32_t space() const { return Size - size(); }
+
+    bool full() const { return size() >= Size; }
+
+    /** @brief Elementos descartados por push() con la cola llena. */
+    uint32_t dropped() const { return dropCount.load(std::memory_order_relaxed); }
+
+    /** @brief Máxima ocupación observada al encolar. */
+    uint32_t highWater() const { return highWaterMark.load(std::memory_order_relaxed); }
+
+private:
+    T items[Size];
+    std::atomic<uint32_t> headIndex{0};  ///< Lo escribe solo el productor
+    std::atomic<uint32_t> tailIndex{0};  ///< Lo escribe solo el consumidor
+    std::atomic<uint32_t> dropCount{0};  ///< Lo escribe solo el productor
+    std::atomic<uint32_t> highWaterMark{0};  ///< Lo escribe solo el productor
+};
+
+/* === End of documentation ==================================================================== */
+
+#endif /* SPSCQUEUE_H */
@@ -29,39 +29,201 @@
 /* === Headers files inclusions =============================================================== */
 #include "mbed.h"
 #include "arm_book_lib.h"
+#include "FlashIAPBlockDevice.h"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
 #include "debounce.h"
+#include "tipcapture.h"
+#include "pulsecounter.h"
+#include "logger.h"
+#include "timefmt.h"
+#include "tiplog.h"
+#include "gauge.h"
+#include "probe.h"
+#include "scheduler.h"
+#include "eventloop.h"
+#include "checkpoint.h"
+#include "command.h"
+#include "alarm.h"
+#include "tipstats.h"
 #include "pluviometer.h"
+#if MAIN_LOOP_MODE == MAIN_LOOP_PIPELINE
+#include "spscqueue.h"
+#endif
 
 /* === Macros definitions ====================================================================== */
 
+#define CHECKPOINT_TAG 0x504C5603  ///< Formato de rainCheckpoint_t ("PLV" y versión)
+#define CHECKPOINT_MINUTES 60  ///< Minutos recientes con ticks por minuto en el punto de control
+#define CHECKPOINT_HOURS 24  ///< Horas recientes con ticks por hora en el punto de control
+
+#if MAIN_LOOP_MODE == MAIN_LOOP_PIPELINE
+// Las ventanas y las estadísticas de los ticks las escribe la agregación y las consultan los comandos desde la E/S
+#define WINDOWS_LOCK() windowsMutex.lock()
+#define WINDOWS_UNLOCK() windowsMutex.unlock()
+#else
+#define WINDOWS_LOCK() ((void)0)
+#define WINDOWS_UNLOCK() ((void)0)
+#endif
 
 /* === Private data type declarations ========================================================== */
 
+typedef Pluviometer<GAUGE_CALIBRATION, GAUGE_DEBOUNCE> gauge_t;
+
+/**
+ * @brief Estado que se conserva en la memoria de respaldo
+ *
+ * Las ventanas completas (rainIntensity y rainRollup) no entran en los 4 KB
+ * de la BKPSRAM; se guardan los ticks y la lluvia corregida por minuto de la
+ * última hora y por hora del último día, y al restaurar se vuelven a sumar a
+ * las ventanas.
+ */
+typedef struct {
+    uint32_t savedAt;  ///< RTC del último guardado
+    uint32_t lastReport;  ///< RTC del último reporte
+    int32_t rainfallCount;  ///< Ticks del período en curso
+    uint32_t minute;  ///< Minuto desde la época más reciente de los anillos
+    uint64_t periodDepth;  ///< Lluvia corregida del período (gauge_t::depth())
+    uint16_t minuteTips[CHECKPOINT_MINUTES];  ///< Ticks por minuto, indexados por minuto % CHECKPOINT_MINUTES
+    uint16_t hourTips[CHECKPOINT_HOURS];  ///< Ticks por hora, indexados por hora % CHECKPOINT_HOURS
+    uint32_t minuteDepth[CHECKPOINT_MINUTES];  ///< Lluvia corregida por minuto en um, como minuteTips
+    uint32_t hourDepth[CHECKPOINT_HOURS];  ///< Lluvia corregida por hora en um, como hourTips
+} rainCheckpoint_t;
+
+static_assert(sizeof(rainCheckpoint_t) % sizeof(uint32_t) == 0, "el punto de control se guarda por palabras");
+
+/**
+ * @brief Respuesta a un comando en transmisión
+ *
+ * Cada línea se arma recién cuando loggerDrain() la pide, a partir de las
+ * ventanas en memoria o del registro persistente.
+ */
+typedef struct {
+    command_t command;  ///< Comando en respuesta
+    bool active;  ///< Quedan líneas por entregar
+    uint32_t line;  ///< Líneas ya entregadas
+    uint32_t skip;  ///< tips: ticks a saltear antes del primero listado
+    uint32_t remaining;  ///< tips: ticks por listar
+    tipLogCursor_t cursor;  ///< tips: posición en el registro persistente
+} response_t;
+
+static_assert(GAUGE_CALIBRATION::depthUm == MM_PER_TICK * 100, "MM_PER_TICK debe ser el vuelco nominal de la calibración");
+
 /* === Private variable declarations =========================================================== */
 
 DigitalOut alarmLed(LED1);
 DigitalOut tickLed(LED2);
+#if ACQUISITION_MODE == ACQUISITION_POLLING
 DigitalIn tickRain(SWITCH_TICK_RAIN);  ///< Botón de detección de lluvia
+#endif
 
 int rainfallCount = RAINFALL_COUNT_INI;  ///< Contador de lluvia
 int lastMinute = LAST_MINUTE_INI;  ///< Último minuto
 
+/**
+ * @brief Reglas de alarma por umbral de lluvia
+ *
+ * Lluvia corregida por intensidad en um, la misma que informa el reporte
+ * periódico; la racha cuenta horas con al menos un tick (ninguna corrección
+ * deja un tick por debajo del vuelco nominal).
+ */
+static const alarmRule_t alarmRules[] = {
+    {ALARM_RULE_AMOUNT, 1, SCHEDULER_HOUR, 0, 20000},  ///< Más de 20 mm en 1 h
+    {ALARM_RULE_AMOUNT, 2, 10 * SCHEDULER_MINUTE, 0, 5000},  ///< Más de 5 mm en 10 min
+    {ALARM_RULE_WET_RUN, 3, SCHEDULER_HOUR, GAUGE_CALIBRATION::depthUm, 3},  ///< 3 horas seguidas con lluvia
+};
+
 static delay_t debounceDelay;
 static bool buttonPressed = false;
 static delay_t analyzeDelay;
 
+static FlashIAPBlockDevice tipLogDevice(TIP_LOG_FLASH_ADDRESS, TIP_LOG_FLASH_SIZE);
+static tipLog_t tipLog;  ///< Registro persistente de ticks y reportes
+static bool tipLogReady = false;  ///< El registro abrió y no ha fallado
+static intensity_t rainIntensity;  ///< Ventanas deslizantes de lluvia
+static rollup_t rainRollup;  ///< Acumulados por minuto, hora, día y mes
+static gauge_t gauge;  ///< Lluvia corregida del período en curso
+static checkpoint_t checkpoint;  ///< Copia del estado en la memoria de respaldo
+static rainCheckpoint_t saved;  ///< Contenido del último guardado
+static bool resumed = false;  ///< El arranque continuó el estado del punto de control
+static uint32_t bootTime = TIME_INI;  ///< RTC al arrancar
+#if MAIN_LOOP_MODE == MAIN_LOOP_PIPELINE
+static Mutex windowsMutex;  ///< Protege rainIntensity, rainRollup y las estadísticas de los ticks
+#endif
+
+static commandParser_t commandParser;  ///< Comandos recibidos por la UART
+static command_t receivedCommand;  ///< Comando completo a la espera de la respuesta en curso
+static bool commandReceived = false;
+static response_t response;
+static timeFormat_t responseTime;  ///< Fechas de las respuestas, aparte de las del registro
+#if MAIN_LOOP_MODE == MAIN_LOOP_PIPELINE
+static SpscQueue<tipLogRecord_t, STORAGE_QUEUE_SIZE> storageQueue;  ///< Agregación -> E/S
+static uint32_t storageStalls = 0;
+#endif
+
+static scheduler_t schedule;  ///< Tareas alineadas al reloj de pared
+static schedulerJob_t reportJob;  ///< Reporte de la lluvia acumulada
+static schedulerJob_t alarmJob;  ///< Avance de las reglas de alarma sin ticks
+static alarmEngine_t alarms;  ///< Estado de las reglas de alarma
+static tipStats_t periodTipStats;  ///< Intervalos entre ticks y rebotes del período en curso
+static tipStats_t totalTipStats;  ///< Intervalos entre ticks y rebotes de los períodos ya reportados
+static tipMonitor_t tipMonitor;  ///< Anomalías de los ticks por ventanas
+static uint64_t lastTipMs = 0;  ///< Instante en ms del último tick aceptado (0 = ninguno)
+static uint32_t bouncesSeen = 0;  ///< Descartes de la captura ya sumados a las estadísticas
+static tick_t scheduleTick = 0;  ///< HAL_GetTick() de la próxima consulta del planificador
+
+static uint64_t epochMsBase = 0;  ///< ms desde la época en el instante epochTickBase
+static tick_t epochTickBase = 0;  ///< HAL_GetTick() de la última extensión del reloj en ms
+
+#if ACQUISITION_MODE != ACQUISITION_POLLING
+static tipEvent_t pendingTips[TIP_CAPTURE_BATCH_SIZE];  ///< Lote de ticks extraídos de la cola
+static size_t pendingTipCount = 0;
+#endif
+
 
 /* === Private function declarations =========================================================== */
 
 // Análisis de Datos
 void analyzeRainfall();
-void accumulateRainfall();
-bool hasTimePassedMinutesRTC(int waiting_seconds);
+void analyzeTip(const tipEvent_t* tip);
+uint32_t addedDepth(uint64_t depthBefore);
+void accumulateRainfall(time_t tipTime, uint32_t depthUm);
+uint64_t epochMsAt(tick_t tick);
+void recordTipInterval(time_t tipTime, uint64_t tipMs);
+void recordRejections(uint32_t now, uint32_t count);
+void sampleRejections(void);
 
 // Actuación 
-void printRain(const char* buffer);
+void printRain(time_t tipTime, uint64_t tipMs);
+void reportDue(uint32_t deadline, uint32_t missed, void* context);
+void alarmDue(uint32_t deadline, uint32_t missed, void* context);
+void onAlarm(void* context, const alarmRule_t* rule, bool raised, uint32_t timestamp);
 void printAccumulatedRainfall();
+void printStatus();
 const char* DateTimeNow(void);
+const char* DateTimeAt(time_t seconds);
+
+// Registro persistente
+void storeRecord(tipLogType_t type, time_t timestamp, int32_t value);
+void commitRecord(const tipLogRecord_t* record);
+int recoverRainfallCount(void);
+
+// Punto de control
+void advanceCheckpoint(uint32_t now);
+void checkpointTip(uint32_t tipTime, uint32_t depthUm);
+void saveCheckpoint(uint32_t now);
+void restoreWindows(void);
+
+// Comandos
+bool receiveCommand(void);
+void startResponse(const command_t* command);
+size_t respondLine(char* text, size_t size);
+size_t nextTipLine(char* text, size_t size);
+bool statValue(uint32_t index, const char** name, uint32_t* value);
+bool tipStatValue(uint32_t index, const char** scope, const char** name, uint32_t* value);
 
 // Variables globales
 BufferedSerial pc(USBTX, USBRX, BAUD_RATE);  ///< Comunicación serial
@@ -84,7 +246,7 @@ BufferedSerial pc(USBTX, USBRX, BAUD_RATE);  ///< Comunicación serial
  */
 void initializeDebounce() {
     debounceFSM_init();
-    delayInit(&debounceDelay, DEBOUNCE_TIME);  // 40 ms de debounce
+    delayInit(&debounceDelay, gauge_t::debounceTime);
 }
 
 /**
@@ -106,61 +268,716 @@ void updateDebounce(){
 /**
  * @brief Analiza la lluvia detectada
  * 
- * Imprime la hora actual y acumula la lluvia detectada.
+ * Imprime la hora actual y acumula la lluvia detectada. Los ticks que llegan
+ * antes de DELAY_BETWEEN_TICK desde el último aceptado, o que la política de
+ * antirrebote descarta, se ignoran.
  */
 void analyzeRainfall() {
   static bool analyzing = false;
 
-    if (!analyzing) {
-        // Comenzar el análisis
-        const char* currentTime = DateTimeNow();
-        printRain(currentTime);
-        accumulateRainfall();
-        analyzing = true;
-    } else if (delayRead(&analyzeDelay)) {
-        // El delay ha terminado
-        analyzing = false;
+    if (analyzing && !delayRead(&analyzeDelay)) {
+        // Todavía dentro de la ventana del tick anterior
+        return;
+    }
+
+    // Comenzar el análisis
+    time_t now = time(NULL);
+    uint64_t nowMs = epochMsAt(HAL_GetTick());
+    uint64_t depthBefore = gauge.depth();
+    if (!gauge.addTip(nowMs)) {
+        recordRejections((uint32_t)now, 1);
+        return;
+    }
+    printRain(now, nowMs);
+    recordTipInterval(now, nowMs);
+    accumulateRainfall(now, addedDepth(depthBefore));
+    analyzing = true;
+    delayRead(&analyzeDelay);  // Arranca la ventana de DELAY_BETWEEN_TICK
+}
+
+/**
+ * @brief Analiza un tick capturado por interrupción
+ *
+ * Imprime la hora en que ocurrió el tick (no la hora de proceso) y acumula
+ * la lluvia. El antirrebote de flanco ya fue aplicado por la ISR.
+ *
+ * @param tip Evento extraído de la cola de captura
+ */
+void analyzeTip(const tipEvent_t* tip) {
+    time_t tipTime = time(NULL) - (time_t)((HAL_GetTick() - tip->timestamp) / 1000);
+    uint64_t tipMs = epochMsAt(tip->timestamp);
+    uint64_t depthBefore = gauge.depth();
+    if (!gauge.addTip(tipMs)) {
+        recordRejections((uint32_t)tipTime, 1);
+        return;
+    }
+    printRain(tipTime, tipMs);
+    PROBE_STOP(PROBE_EDGE_TO_RECORD, tip->edgeTime);
+    recordTipInterval(tipTime, tipMs);
+    accumulateRainfall(tipTime, addedDepth(depthBefore));
+}
+
+/**
+ * @brief Lluvia corregida del tick recién sumado a gauge, en um
+ *
+ * Es la diferencia entre gauge.depth() antes y después del tick, truncadas
+ * a um enteros, así que los redondeos no se acumulan: los ticks de un
+ * período suman lo mismo que el período.
+ *
+ * @param depthBefore gauge.depth() antes de gauge.addTip()
+ * @return Lluvia del tick en um
+ */
+uint32_t addedDepth(uint64_t depthBefore) {
+    return (uint32_t)((gauge.depth() >> GAUGE_FACTOR_SHIFT) - (depthBefore >> GAUGE_FACTOR_SHIFT));
+}
+
+/**
+ * @brief Convierte un valor de HAL_GetTick() en ms desde la época
+ *
+ * Extiende el contador de 32 bits a partir de la última llamada, así que
+ * debe llamarse al menos una vez cada 49 días (cada reporte lo hace). La
+ * fracción de segundo sale del contador en ms, que el RTC no ofrece.
+ *
+ * @param tick Instante en ms de HAL_GetTick(), no posterior al actual
+ * @return Instante en ms desde la época
+ */
+uint64_t epochMsAt(tick_t tick) {
+    tick_t now = HAL_GetTick();
+    epochMsBase += (tick_t)(now - epochTickBase);
+    epochTickBase = now;
+    return epochMsBase - (tick_t)(now - tick);
+}
+
+/**
+ * @brief Registra el intervalo desde el tick aceptado anterior
+ *
+ * Lo suma a las estadísticas del período y al monitor de anomalías; una
+ * anomalía nueva se encola como "YYYY-MM-DD HH:MM:SS - Tip anomaly: N". El
+ * primer tick desde el arranque no tiene intervalo.
+ *
+ * @param tipTime Instante del tick
+ * @param tipMs Instante del tick en ms desde la época
+ */
+void recordTipInterval(time_t tipTime, uint64_t tipMs) {
+    uint64_t previous = lastTipMs;
+
+    lastTipMs = tipMs;
+    if (previous == 0 || tipMs < previous) {
+        return;
+    }
+    uint32_t intervalMs = tipMs - previous < UINT32_MAX ? (uint32_t)(tipMs - previous) : UINT32_MAX;
+
+    WINDOWS_LOCK();
+    tipStatsAddInterval(&periodTipStats, intervalMs);
+    uint8_t raised = tipMonitorAddInterval(&tipMonitor, (uint32_t)tipTime, intervalMs);
+    periodTipStats.anomalies |= raised;
+    WINDOWS_UNLOCK();
+    if (raised != 0) {
+        logEvent(LOG_EVENT_TIP_ANOMALY, (uint32_t)tipTime, raised);
+    }
+}
+
+/**
+ * @brief Registra descartes del antirrebote
+ *
+ * @param now Instante de los descartes
+ * @param count Cantidad de descartes
+ */
+void recordRejections(uint32_t now, uint32_t count) {
+    WINDOWS_LOCK();
+    tipStatsAddRejections(&periodTipStats, count);
+    uint8_t raised = tipMonitorAddRejections(&tipMonitor, now, count);
+    periodTipStats.anomalies |= raised;
+    WINDOWS_UNLOCK();
+    if (raised != 0) {
+        logEvent(LOG_EVENT_TIP_ANOMALY, now, raised);
+    }
+}
+
+/**
+ * @brief Suma los flancos que descartó el antirrebote de la captura desde la lectura anterior
+ *
+ * Cada flanco descartado llegó a menos de DEBOUNCE_TIME del anterior. En
+ * modo sondeo la FSM de antirrebote no los cuenta.
+ */
+void sampleRejections() {
+#if ACQUISITION_MODE == ACQUISITION_INTERRUPT
+    tipCaptureStats_t captureStats;
+    tipCaptureGetStats(&captureStats);
+    uint32_t bounces = captureStats.bounces;
+#elif ACQUISITION_MODE == ACQUISITION_TIMER
+    pulseCounterStats_t counterStats;
+    pulseCounterGetStats(&counterStats);
+    uint32_t bounces = counterStats.bounces;
+#else
+    uint32_t bounces = bouncesSeen;
+#endif
+
+    if (bounces != bouncesSeen) {
+        recordRejections((uint32_t)time(NULL), bounces - bouncesSeen);
+        bouncesSeen = bounces;
     }
 }
 
 /**
  * @brief Acumula la cantidad de lluvia detectada
+ *
+ * Además suma el tick a las ventanas de intensidad, a los acumulados por
+ * minuto, hora, día y mes y a las reglas de alarma, lo agrega al registro
+ * persistente con el conteo del intervalo y actualiza el punto de control.
+ * Las ventanas y los acumulados cuentan ticks; las reglas de alarma y el
+ * punto de control reciben la lluvia corregida del tick.
+ *
+ * @param tipTime Instante del tick
+ * @param depthUm Lluvia corregida del tick en um
  */
-void accumulateRainfall() {
+void accumulateRainfall(time_t tipTime, uint32_t depthUm) {
     rainfallCount++;
+    WINDOWS_LOCK();
+    intensityAddTips(&rainIntensity, (uint32_t)tipTime, 1);
+    rollupAddTips(&rainRollup, (uint32_t)tipTime, 1);
+    WINDOWS_UNLOCK();
+    alarmEngineAddRain(&alarms, (uint32_t)tipTime, depthUm);
+    storeRecord(TIP_LOG_TIP, tipTime, rainfallCount);
+    checkpointTip((uint32_t)tipTime, depthUm);
 }
 
 /**
  * @brief Imprime un mensaje de detección de lluvia
  * 
- * @param buffer Cadena de caracteres con la hora actual
+ * Solo encola el evento; el texto "YYYY-MM-DD HH:MM:SS - Rain detected" se
+ * arma y se transmite desde loggerDrain(). Los ms viajan en el argumento para
+ * el formato compacto.
+ *
+ * @param tipTime Instante del tick
+ * @param tipMs Instante del tick en ms desde la época
  */
-void printRain(const char* buffer) {
-    pc.write(buffer, strlen(buffer));
-    pc.write(MSG_RAIN_DETECTED, strlen(MSG_RAIN_DETECTED));
+void printRain(time_t tipTime, uint64_t tipMs) {
+    logEvent(LOG_EVENT_RAIN_DETECTED, (uint32_t)tipTime, (int32_t)(tipMs - (uint64_t)tipTime * 1000));
+}
+
+/**
+ * @brief Tarea del planificador que reporta la lluvia acumulada
+ *
+ * Tras una demora de varios períodos corre una sola vez: el reporte ya
+ * incluye todos los ticks desde el anterior.
+ *
+ * @param deadline Vencimiento atendido
+ * @param missed Vencimientos salteados
+ * @param context No se usa
+ */
+void reportDue(uint32_t deadline, uint32_t missed, void* context) {
+    reportRainfall();
+}
+
+/**
+ * @brief Tarea del planificador que avanza las reglas de alarma sin ticks
+ *
+ * Las ventanas que se vacían y las rachas que se cortan desactivan sus
+ * reglas aunque no llueva.
+ *
+ * @param deadline Vencimiento atendido
+ * @param missed Vencimientos salteados
+ * @param context No se usa
+ */
+void alarmDue(uint32_t deadline, uint32_t missed, void* context) {
+    alarmEngineAdvance(&alarms, deadline);
+}
+
+/**
+ * @brief Aviso de una regla de alarma que se activa o se desactiva
+ *
+ * Encola el evento ("YYYY-MM-DD HH:MM:SS - Alarm raised: N" o "Alarm
+ * cleared: N") y deja el LED de alarma encendido mientras haya alguna regla
+ * activa.
+ *
+ * @param context No se usa
+ * @param rule Regla que cambió
+ * @param raised true si se activó
+ * @param timestamp Instante del cambio
+ */
+void onAlarm(void* context, const alarmRule_t* rule, bool raised, uint32_t timestamp) {
+    logEvent(raised ? LOG_EVENT_ALARM_RAISED : LOG_EVENT_ALARM_CLEARED, timestamp, rule->id);
+    alarmLed = alarmEngineActiveCount(&alarms) > 0 ? ON : OFF;
 }
 
 /**
  * @brief Imprime la cantidad de lluvia acumulada
  * 
- * Calcula e imprime la cantidad de lluvia acumulada en el formato "YYYY-MM-DD HH:MM - Accumulated rainfall: X.XX mm".
+ * Encola el reporte; loggerDrain() lo imprime en el formato "YYYY-MM-DD HH:MM - Accumulated rainfall: X.XX mm".
+ * La lluvia incluye la corrección por intensidad de GAUGE_CALIBRATION.
  */
 void printAccumulatedRainfall() {
-    time_t seconds = time(NULL);
-    struct tm* timeinfo = localtime(&seconds);
-    char dateTime[80];
-    strftime(dateTime, sizeof(dateTime), DATE_FORMAT, timeinfo);
+    // Lluvia corregida del período en décimas de mm
+    int accumulatedRainfall = gauge.rainfall();
+
+    logEvent(LOG_EVENT_ACCUMULATED_RAINFALL, (uint32_t)time(NULL), accumulatedRainfall);
+
+    // Solo los intervalos con lluvia ocupan flash; el reporte cierra la página en curso
+    if (rainfallCount > 0) {
+        storeRecord(TIP_LOG_TOTAL, time(NULL), accumulatedRainfall);
+    }
+}
+
+/**
+ * @brief Encola los contadores de estado del equipo
+ *
+ * No tienen línea de texto; viajan en los formatos binarios y en las tramas
+ * de telemetría.
+ */
+void printStatus() {
+    uint32_t now = (uint32_t)time(NULL);
+    loggerStats_t logStats;
+
+    loggerGetStats(&logStats);
+    logEvent(LOG_EVENT_STATUS_UPTIME, now, (int32_t)(now - bootTime));
+    logEvent(LOG_EVENT_STATUS_DROPPED, now, (int32_t)logStats.dropped);
+#if ACQUISITION_MODE == ACQUISITION_INTERRUPT
+    tipCaptureStats_t captureStats;
+    tipCaptureGetStats(&captureStats);
+    logEvent(LOG_EVENT_STATUS_BOUNCES, now, (int32_t)captureStats.bounces);
+    logEvent(LOG_EVENT_STATUS_OVERFLOWS, now, (int32_t)captureStats.overflows);
+#elif ACQUISITION_MODE == ACQUISITION_TIMER
+    pulseCounterStats_t counterStats;
+    pulseCounterGetStats(&counterStats);
+    logEvent(LOG_EVENT_STATUS_BOUNCES, now, (int32_t)counterStats.bounces);
+    logEvent(LOG_EVENT_STATUS_OVERFLOWS, now, (int32_t)counterStats.overruns);
+#endif
+}
+
+/**
+ * @brief Agrega un registro al registro persistente
+ *
+ * En modo pipeline solo lo encola para la etapa de E/S; si la cola está
+ * llena espera a que la E/S haga lugar en lugar de perder el registro.
+ *
+ * @param type Tipo de registro
+ * @param timestamp Instante del registro
+ * @param value Valor según el tipo
+ */
+void storeRecord(tipLogType_t type, time_t timestamp, int32_t value) {
+    tipLogRecord_t record;
+    record.type = (uint8_t)type;
+    record.timestamp = (uint32_t)timestamp;
+    record.value = value;
+#if MAIN_LOOP_MODE == MAIN_LOOP_PIPELINE
+    while (storageQueue.full()) {
+        storageStalls++;
+        ThisThread::sleep_for(std::chrono::milliseconds(STORAGE_STALL_MS));
+    }
+    storageQueue.push(record);
+#else
+    commitRecord(&record);
+#endif
+}
+
+/**
+ * @brief Escribe un registro en la flash
+ *
+ * Un reporte cierra la página en curso. Tras una falla del dispositivo se
+ * deja de escribir para no demorar la detección.
+ *
+ * @param record Registro a escribir
+ */
+void commitRecord(const tipLogRecord_t* record) {
+    if (!tipLogReady) {
+        return;
+    }
+
+    if (tipLogAppend(&tipLog, record) != 0 ||
+        (record->type == TIP_LOG_TOTAL && tipLogFlush(&tipLog) != 0)) {
+        tipLogReady = false;
+    }
+}
 
-    // Calcular la lluvia acumulada en décimas de mm
-    int accumulatedRainfall = rainfallCount * MM_PER_TICK; // MM_PER_TICK es ahora 0.1 para décimas de mm
+/**
+ * @brief Recupera el conteo del intervalo en curso tras un reinicio
+ *
+ * Recorre solo los últimos TIP_LOG_RECOVERY_SECTORS sectores: el último tick
+ * posterior al último reporte guarda el conteo acumulado.
+ *
+ * @return Ticks del intervalo interrumpido
+ */
+int recoverRainfallCount() {
+    tipLogCursor_t cursor;
+    tipLogRecord_t record;
+    int count = RAINFALL_COUNT_INI;
 
-    // Preparar el buffer para imprimir
-    char buffer[100];
-    int len = sprintf(buffer, "%s%s%d.%01d mm\n", 
-                      dateTime, MSG_ACCUMULATED_RAINFALL, accumulatedRainfall / 10, accumulatedRainfall % 10);
-    
-    // Imprimir el resultado
-    pc.write(buffer, len);
+    tipLogRewindRecent(&tipLog, &cursor, TIP_LOG_RECOVERY_SECTORS);
+    while (tipLogNext(&tipLog, &cursor, &record)) {
+        if (record.type == TIP_LOG_TIP) {
+            count = record.value;
+        } else if (record.type == TIP_LOG_TOTAL) {
+            count = RAINFALL_COUNT_INI;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Descarta de los anillos del punto de control los minutos y horas vencidos
+ *
+ * @param now Instante hasta el que avanzan los anillos
+ */
+void advanceCheckpoint(uint32_t now) {
+    uint32_t minute = now / 60;
+    uint32_t hour = minute / 60;
+    uint32_t savedHour = saved.minute / 60;
+
+    if (minute <= saved.minute) {
+        return;
+    }
+    for (uint32_t m = saved.minute + 1; m <= minute && m - saved.minute <= CHECKPOINT_MINUTES; m++) {
+        saved.minuteTips[m % CHECKPOINT_MINUTES] = 0;
+        saved.minuteDepth[m % CHECKPOINT_MINUTES] = 0;
+    }
+    for (uint32_t h = savedHour + 1; h <= hour && h - savedHour <= CHECKPOINT_HOURS; h++) {
+        saved.hourTips[h % CHECKPOINT_HOURS] = 0;
+        saved.hourDepth[h % CHECKPOINT_HOURS] = 0;
+    }
+    saved.minute = minute;
+}
+
+/**
+ * @brief Suma un tick al punto de control y lo guarda
+ *
+ * Usa el instante del tick como hora del guardado para no leer el RTC de
+ * nuevo en el camino de cada tick.
+ *
+ * @param tipTime Instante del tick
+ * @param depthUm Lluvia corregida del tick en um
+ */
+void checkpointTip(uint32_t tipTime, uint32_t depthUm) {
+    uint32_t minute = tipTime / 60;
+
+    advanceCheckpoint(tipTime);
+    if (saved.minute - minute < CHECKPOINT_MINUTES && saved.minuteTips[minute % CHECKPOINT_MINUTES] < UINT16_MAX) {
+        saved.minuteTips[minute % CHECKPOINT_MINUTES]++;
+        saved.minuteDepth[minute % CHECKPOINT_MINUTES] += depthUm;
+    }
+    if (saved.minute / 60 - minute / 60 < CHECKPOINT_HOURS && saved.hourTips[(minute / 60) % CHECKPOINT_HOURS] < UINT16_MAX) {
+        saved.hourTips[(minute / 60) % CHECKPOINT_HOURS]++;
+        saved.hourDepth[(minute / 60) % CHECKPOINT_HOURS] += depthUm;
+    }
+    saveCheckpoint(tipTime > saved.savedAt ? tipTime : saved.savedAt);
+}
+
+/**
+ * @brief Guarda el estado en la memoria de respaldo
+ *
+ * Solo escribe las palabras que cambiaron: un tick típico modifica el
+ * conteo, la lluvia corregida, los ticks y la lluvia de un minuto y de una
+ * hora y la hora del guardado.
+ *
+ * @param now Instante del guardado
+ */
+void saveCheckpoint(uint32_t now) {
+    advanceCheckpoint(now);
+    saved.savedAt = now;
+    saved.rainfallCount = rainfallCount;
+    saved.periodDepth = gauge.depth();
+    checkpointSave(&checkpoint, &saved);
+}
+
+/**
+ * @brief Vuelve a sumar a las ventanas de lluvia los ticks del punto de control
+ *
+ * Los minutos de la última hora conservan su minuto; el resto de cada hora
+ * se suma al comienzo de la hora. Las reglas de alarma recuperan la lluvia
+ * corregida que sigue dentro de sus ventanas (las rachas de horas húmedas
+ * empiezan de nuevo) y las que vuelven a cumplirse se informan de nuevo al
+ * arrancar.
+ */
+void restoreWindows() {
+    uint32_t newestHour = saved.minute / 60;
+
+    for (uint32_t h = newestHour - (CHECKPOINT_HOURS - 1); h <= newestHour; h++) {
+        uint32_t hourTips = saved.hourTips[h % CHECKPOINT_HOURS];
+        uint32_t hourDepth = saved.hourDepth[h % CHECKPOINT_HOURS];
+
+        for (uint32_t m = h * 60; m < (h + 1) * 60 && m <= saved.minute; m++) {
+            uint32_t minuteTips = saved.minuteTips[m % CHECKPOINT_MINUTES];
+            uint32_t minuteDepth = saved.minuteDepth[m % CHECKPOINT_MINUTES];
+            if (saved.minute - m >= CHECKPOINT_MINUTES || minuteTips == 0) {
+                continue;
+            }
+            intensityAddTips(&rainIntensity, m * 60, minuteTips);
+            rollupAddTips(&rainRollup, m * 60, minuteTips);
+            alarmEngineAddRain(&alarms, m * 60, minuteDepth);
+            hourTips -= minuteTips < hourTips ? minuteTips : hourTips;
+            hourDepth -= minuteDepth < hourDepth ? minuteDepth : hourDepth;
+        }
+        if (hourTips > 0) {
+            intensityAddTips(&rainIntensity, h * 3600, hourTips);
+            rollupAddTips(&rainRollup, h * 3600, hourTips);
+            alarmEngineAddRain(&alarms, h * 3600, hourDepth);
+        }
+    }
+}
+
+/**
+ * @brief Lee bytes de la UART hasta completar un comando
+ *
+ * Con un comando ya completo a la espera no lee más: el resto queda en el
+ * buffer de recepción de la UART hasta que termine la respuesta en curso.
+ * Las teclas de las sondas se atienden al comienzo de una línea. Con
+ * LOGGER_WIRE_COMPACT no hay comandos: la entrada se descarta.
+ *
+ * @return true si hay un comando completo a la espera
+ */
+bool receiveCommand() {
+    char byte;
+
+#if LOGGER_WIRE_MODE == LOGGER_WIRE_COMPACT
+    // El flujo compacto no tiene lugar para respuestas: los comandos (y las teclas de las sondas) se descartan
+    while (pc.readable() && pc.read(&byte, 1) == 1) {
+    }
+#else
+    while (!commandReceived && pc.readable() && pc.read(&byte, 1) == 1) {
+#if INSTRUMENTATION_ENABLED
+        if (commandParserIdle(&commandParser) && byte == PROBE_DUMP_KEY) {
+            loggerFlush();
+            probeDump(&pc);
+#if LOGGER_WIRE_MODE == LOGGER_WIRE_FRAMED
+            // Un delimitador cierra el volcado: el receptor lo descarta como trama inválida y no pierde la siguiente
+            pc.set_blocking(true);
+            pc.write("", 1);
+            pc.set_blocking(false);
+#endif
+            continue;
+        }
+        if (commandParserIdle(&commandParser) && byte == PROBE_RESET_KEY) {
+            probeReset();
+            continue;
+        }
+#endif
+        commandReceived = commandParserPush(&commandParser, byte, &receivedCommand);
+    }
+#endif
+    return commandReceived;
+}
+
+/**
+ * @brief Prepara la respuesta a un comando
+ *
+ * Para "tips" ubica el comienzo: cuenta los ticks de los últimos
+ * TIP_LOG_RECOVERY_SECTORS sectores, la misma lectura acotada que la
+ * recuperación del arranque, y saltea los más antiguos.
+ *
+ * @param command Comando a responder
+ */
+void startResponse(const command_t* command) {
+    response.command = *command;
+    response.active = true;
+    response.line = 0;
+    response.skip = 0;
+    response.remaining = 0;
+
+    if (command->id == COMMAND_TIPS && tipLogReady) {
+        tipLogRecord_t record;
+        uint32_t tips = 0;
+
+        tipLogRewindRecent(&tipLog, &response.cursor, TIP_LOG_RECOVERY_SECTORS);
+        while (tipLogNext(&tipLog, &response.cursor, &record)) {
+            tips += record.type == TIP_LOG_TIP;
+        }
+        response.remaining = tips < command->args[0] ? tips : command->args[0];
+        response.skip = tips - response.remaining;
+        tipLogRewindRecent(&tipLog, &response.cursor, TIP_LOG_RECOVERY_SECTORS);
+    }
+}
+
+/**
+ * @brief Arma la próxima línea de "tips"
+ *
+ * @return Largo de la línea, o 0 si ya se listaron todos
+ */
+size_t nextTipLine(char* text, size_t size) {
+    tipLogRecord_t record;
+
+    while (response.remaining > 0 && tipLogNext(&tipLog, &response.cursor, &record)) {
+        if (record.type != TIP_LOG_TIP) {
+            continue;
+        }
+        if (response.skip > 0) {
+            response.skip--;
+            continue;
+        }
+        response.remaining--;
+        return (size_t)snprintf(text, size, "tip %s %ld\r\n", timeFormatUpdate(&responseTime, record.timestamp),
+                                (long)record.value);
+    }
+    response.remaining = 0;
+    return 0;
+}
+
+/**
+ * @brief Contadores de la respuesta a "stats"
+ *
+ * @param index Índice desde 0
+ * @param name Nombre del contador
+ * @param value Valor del contador
+ * @return false pasado el último contador
+ */
+bool statValue(uint32_t index, const char** name, uint32_t* value) {
+    loggerStats_t logStats;
+    tipLogStats_t storageStats = {};
+
+    loggerGetStats(&logStats);
+    if (tipLogReady) {
+        tipLogGetStats(&tipLog, &storageStats);
+    }
+#if ACQUISITION_MODE == ACQUISITION_INTERRUPT
+    tipCaptureStats_t captureStats;
+    tipCaptureGetStats(&captureStats);
+    uint32_t bounces = captureStats.bounces;
+    uint32_t overflows = captureStats.overflows;
+#elif ACQUISITION_MODE == ACQUISITION_TIMER
+    pulseCounterStats_t counterStats;
+    pulseCounterGetStats(&counterStats);
+    uint32_t bounces = counterStats.bounces;
+    uint32_t overflows = counterStats.overruns;
+#else
+    uint32_t bounces = 0;
+    uint32_t overflows = 0;
+#endif
+
+    switch (index) {
+    case 0: *name = "uptime"; *value = (uint32_t)time(NULL) - bootTime; break;
+    case 1: *name = "period_tips"; *value = (uint32_t)rainfallCount; break;
+    case 2: *name = "bounces"; *value = bounces; break;
+    case 3: *name = "overflows"; *value = overflows; break;
+    case 4: *name = "log_enqueued"; *value = logStats.enqueued; break;
+    case 5: *name = "log_dropped"; *value = logStats.dropped; break;
+    case 6: *name = "log_bytes"; *value = logStats.bytesWritten; break;
+    case 7: *name = "storage_appended"; *value = storageStats.appended; break;
+    case 8: *name = "storage_pages"; *value = storageStats.pagesWritten; break;
+    case 9: *name = "storage_erased"; *value = storageStats.sectorsErased; break;
+    case 10: *name = "storage_corrupt"; *value = storageStats.corruptRecords; break;
+    case 11: *name = "commands"; *value = commandParser.commands; break;
+    case 12: *name = "command_errors"; *value = commandParser.errors; break;
+    default: return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Valores de la respuesta a "tipstats"
+ *
+ * Los primeros son los del período en curso ("period") y los siguientes los
+ * de los períodos ya reportados desde el arranque ("total").
+ *
+ * @param index Índice desde 0
+ * @param scope Período de los valores
+ * @param name Nombre del valor
+ * @param value Valor, en ms para los intervalos
+ * @return false pasado el último valor
+ */
+bool tipStatValue(uint32_t index, const char** scope, const char** name, uint32_t* value) {
+    static const char* const names[] = {"count",  "min_ms", "max_ms", "mean_ms",  "sd_ms",
+                                        "p50_ms", "p90_ms", "p99_ms", "rejected", "flags"};
+    const uint32_t fields = sizeof(names) / sizeof(names[0]);
+
+    if (index >= 2 * fields) {
+        return false;
+    }
+    *scope = index < fields ? "period" : "total";
+    *name = names[index % fields];
+
+    WINDOWS_LOCK();
+    const tipStats_t* stats = index < fields ? &periodTipStats : &totalTipStats;
+    switch (index % fields) {
+    case 0: *value = stats->intervals.count; break;
+    case 1: *value = stats->intervals.count > 0 ? stats->intervals.min : 0; break;
+    case 2: *value = stats->intervals.max; break;
+    case 3: *value = (uint32_t)(stats->mean + 0.5); break;
+    case 4: *value = (uint32_t)(sqrt(tipStatsVariance(stats)) + 0.5); break;
+    case 5: *value = tipStatsQuantile(stats, 500); break;
+    case 6: *value = tipStatsQuantile(stats, 900); break;
+    case 7: *value = tipStatsQuantile(stats, 990); break;
+    case 8: *value = stats->rejections; break;
+    default: *value = stats->anomalies; break;
+    }
+    WINDOWS_UNLOCK();
+    return true;
+}
+
+/**
+ * @brief Fuente de loggerDrain(): arma la próxima línea de la respuesta en curso
+ *
+ * La última línea es "ok" (o "error <motivo>" para un comando inválido).
+ *
+ * @param text Buffer destino
+ * @param size Tamaño del buffer destino
+ * @return Largo de la línea, o 0 si no hay respuesta en curso
+ */
+size_t respondLine(char* text, size_t size) {
+    const command_t* command = &response.command;
+    size_t length = 0;
+
+    if (!response.active) {
+        return 0;
+    }
+
+    uint32_t line = response.line++;
+    switch (command->id) {
+    case COMMAND_TOTAL:
+        if (line == 0) {
+            rollupResult_t covered;
+            int32_t rainfall = getRainfallBetween((time_t)command->args[0], (time_t)command->args[1], &covered);
+            length = (size_t)snprintf(text, size, "total %lu %lu %ld.%ld mm covered %lu %lu\r\n",
+                                      (unsigned long)command->args[0], (unsigned long)command->args[1],
+                                      (long)(rainfall / 10), (long)(rainfall % 10), (unsigned long)covered.from,
+                                      (unsigned long)covered.to);
+        }
+        break;
+    case COMMAND_TIPS:
+        length = nextTipLine(text, size);
+        break;
+    case COMMAND_RATE:
+        if (line < INTENSITY_WINDOW_COUNT) {
+            intensityWindow_t window = (intensityWindow_t)line;
+            uint32_t seconds = intensityWindowSeconds(window);
+            int32_t rainfall = getRainfallInWindow(window);
+            int32_t rate = getRainfallRate(window);
+            length = (size_t)snprintf(text, size, "rate %lu%s %ld.%ld mm %ld.%ld mm/h\r\n",
+                                      (unsigned long)(seconds >= 3600 * 24 ? seconds / 3600 : seconds / 60),
+                                      seconds >= 3600 * 24 ? "h" : "min", (long)(rainfall / 10),
+                                      (long)(rainfall % 10), (long)(rate / 10), (long)(rate % 10));
+        }
+        break;
+    case COMMAND_STATS: {
+        const char* name;
+        uint32_t value;
+        if (statValue(line, &name, &value)) {
+            length = (size_t)snprintf(text, size, "stat %s %lu\r\n", name, (unsigned long)value);
+        }
+        break;
+    }
+    case COMMAND_TIPSTATS: {
+        const char* scope;
+        const char* name;
+        uint32_t value;
+        if (tipStatValue(line, &scope, &name, &value)) {
+            length = (size_t)snprintf(text, size, "tipstat %s_%s %lu\r\n", scope, name, (unsigned long)value);
+        }
+        break;
+    }
+    case COMMAND_HELP:
+        if (commandUsage(line) != NULL) {
+            length = (size_t)snprintf(text, size, "%s\r\n", commandUsage(line));
+        }
+        break;
+    default:
+        response.active = false;
+        return (size_t)snprintf(text, size, "error %s\r\n", commandErrorText(command->error));
+    }
+
+    if (length == 0) {
+        response.active = false;
+        length = (size_t)snprintf(text, size, "ok\r\n");
+    }
+    return length < size ? length : size - 1;
 }
 
 /**
@@ -169,10 +986,24 @@ void printAccumulatedRainfall() {
  * @return Cadena de caracteres con la fecha y hora actual en formato "%Y-%m-%d %H:%M:%S"
  */
 const char* DateTimeNow() {
-    time_t seconds = time(NULL);
-    static char bufferTime[80];
-    strftime(bufferTime, sizeof(bufferTime), TIME_FORMAT, localtime(&seconds));
-    return bufferTime;
+    return DateTimeAt(time(NULL));
+}
+
+/**
+ * @brief Formatea un instante dado
+ *
+ * @param seconds Instante en segundos desde la época
+ * @return Cadena de caracteres con la fecha y hora en formato "%Y-%m-%d %H:%M:%S"
+ */
+const char* DateTimeAt(time_t seconds) {
+    static timeFormat_t dateTime;
+    static bool initialized = false;
+
+    if (!initialized) {
+        timeFormatInit(&dateTime);
+        initialized = true;
+    }
+    return timeFormatUpdate(&dateTime, (uint32_t)seconds);
 }
 
 /* === Public function implementation ========================================================== */
@@ -181,71 +1012,340 @@ const char* DateTimeNow() {
  * @brief Inicializa los sensores
  * 
  * Configura el modo del botón de detección de lluvia y apaga los LEDs.
+ * Restaura el estado del punto de control de la memoria de respaldo; sin un
+ * punto de control válido recupera el conteo de la flash. El RTC solo vuelve
+ * a TIME_INI si no conservó una fecha válida.
  */
 void initializeSensors() {
-    void initializeDebounce();
+#if ACQUISITION_MODE == ACQUISITION_POLLING
+    initializeDebounce();
     tickRain.mode(PullDown);
+    delayInit(&analyzeDelay, DELAY_BETWEEN_TICK);
+#elif ACQUISITION_MODE == ACQUISITION_TIMER
+    pulseCounterInit(PULSE_COUNTER_PIN, PULSE_COUNTER_QUIET_US);
+#else
+    tipCaptureInit(SWITCH_TICK_RAIN, gauge_t::debounceTime);
+#endif
     alarmLed = OFF;
     tickLed = OFF;
-    set_time(TIME_INI); ///< Configurar la fecha y hora inicial
-    //delayInit(&analyzeDelay, DELAY_BETWEEN_TICK);
+    loggerInit(&pc);
+#if LOGGER_WIRE_MODE != LOGGER_WIRE_COMPACT
+    loggerSetSource(respondLine);
+#endif
+    commandParserInit(&commandParser);
+    timeFormatInit(&responseTime);
+    PROBE_INIT();
+    tipLogReady = tipLogInit(&tipLog, &tipLogDevice) == 0;
+
+    volatile uint32_t* backup = checkpointBackupMemory();
+    assert(checkpointRegionWords(sizeof(saved)) <= CHECKPOINT_BACKUP_WORDS);
+    checkpointInit(&checkpoint, backup, sizeof(saved), CHECKPOINT_TAG);
+    bool restored = checkpointRestore(&checkpoint, &saved);
+
+    if (!rtc_isenabled() || time(NULL) < TIME_INI) {
+        set_time(TIME_INI); ///< Configurar la fecha y hora inicial
+    }
+    bootTime = (uint32_t)time(NULL);
+    // Un RTC anterior al último guardado no es el que lo escribió: las ventanas no se continúan
+    resumed = restored && bootTime >= saved.savedAt;
+
+    if (restored) {
+        rainfallCount = saved.rainfallCount;
+        gauge.restore((uint32_t)rainfallCount, saved.periodDepth);
+    } else {
+        if (tipLogReady) {
+            rainfallCount = recoverRainfallCount();
+        }
+        gauge.restore((uint32_t)rainfallCount);  // Del registro de ticks solo se conoce el valor nominal
+    }
+    epochMsBase = (uint64_t)bootTime * 1000;
+    epochTickBase = HAL_GetTick();
+    intensityInit(&rainIntensity, bootTime);
+    rollupInit(&rainRollup, bootTime);
+    schedulerInit(&schedule, bootTime);
+    bool rulesValid = alarmEngineInit(&alarms, alarmRules, sizeof(alarmRules) / sizeof(alarmRules[0]),
+                                      bootTime, onAlarm, NULL);
+    assert(rulesValid);
+    (void)rulesValid;
+    tipStatsInit(&periodTipStats);
+    tipStatsInit(&totalTipStats);
+    tipMonitorInit(&tipMonitor, bootTime);
+    int status = schedulerAdd(&schedule, &alarmJob, ALARM_ADVANCE_SECONDS, 0, alarmDue, NULL);
+    assert(status == 0);
+    (void)status;
+
+    if (resumed) {
+        restoreWindows();
+    } else {
+        memset(&saved, 0, sizeof(saved));
+        saved.minute = bootTime / 60;
+        saved.lastReport = bootTime;
+    }
+    saveCheckpoint(bootTime);
 }
 
 /**
  * @brief Verifica si está lloviendo
  * 
+ * En modo interrupción extrae de la cola un lote de hasta TIP_CAPTURE_BATCH_SIZE
+ * ticks, que luego procesa actOnRainfall(); en modo temporizador los decodifica
+ * de las capturas que dejó la DMA.
+ *
  * @return true si el botón de detección de lluvia está activado, false en caso contrario
  */
 bool isRaining() {
+#if ACQUISITION_MODE == ACQUISITION_POLLING
     updateDebounce();
     return readKey();
+#elif ACQUISITION_MODE == ACQUISITION_TIMER
+    pendingTipCount = pulseCounterDrain(pendingTips, TIP_CAPTURE_BATCH_SIZE);
+    return pendingTipCount > 0;
+#else
+    pendingTipCount = tipCaptureDrain(pendingTips, TIP_CAPTURE_BATCH_SIZE);
+    return pendingTipCount > 0;
+#endif
 }
 
 /**
  * @brief Actúa en base a la detección de lluvia
  * 
- * Enciende los LEDs de alarma y tick, y analiza la lluvia detectada.
+ * Enciende el LED de tick y analiza la lluvia detectada. El LED de alarma lo
+ * manejan las reglas de alarma (ver onAlarm()).
  */
 void actOnRainfall() {
-    alarmLed = ON;
+#if ACQUISITION_MODE == ACQUISITION_POLLING
     tickLed = ON;
     analyzeRainfall();
+#else
+    actOnTips(pendingTips, pendingTipCount);
+    pendingTipCount = 0;
+#endif
+}
+
+/**
+ * @brief Actúa sobre un lote de ticks capturados por interrupción o por el temporizador
+ *
+ * Enciende el LED de tick, analiza cada tick y suma los rebotes que
+ * descartó la captura. Lo usan
+ * actOnRainfall() y la etapa de agregación del pipeline, que recibe los
+ * ticks por su propia cola.
+ *
+ * @param tips Ticks en orden de llegada
+ * @param count Cantidad de ticks
+ */
+void actOnTips(const tipEvent_t* tips, size_t count) {
+    assert(tips != NULL || count == 0);
+
+    tickLed = ON;
+    for (size_t i = 0; i < count; i++) {
+        analyzeTip(&tips[i]);
+    }
+    sampleRejections();
 }
 
 /**
  * @brief Reporta la lluvia acumulada
  * 
- * Imprime la cantidad de lluvia acumulada y resetea el contador de lluvia.
+ * Imprime la cantidad de lluvia acumulada y resetea el contador de lluvia;
+ * cada STATUS_REPORT_INTERVAL reportes agrega los contadores de estado.
+ * Suma las estadísticas de los ticks del período a las totales, así que los
+ * rebotes sin ticks también llegan al monitor de anomalías. También mantiene
+ * extendido el reloj en ms de epochMsAt().
  */
 void reportRainfall() {
+    static int reportsSinceStatus = STATUS_REPORT_INTERVAL;
+
+    epochMsAt(HAL_GetTick());
     printAccumulatedRainfall();
+    if (++reportsSinceStatus >= STATUS_REPORT_INTERVAL) {
+        printStatus();
+        reportsSinceStatus = 0;
+    }
     rainfallCount = RAINFALL_COUNT_INI;
+    gauge.startPeriod();
+    sampleRejections();
+    WINDOWS_LOCK();
+    tipStatsMerge(&totalTipStats, &periodTipStats);
+    tipStatsInit(&periodTipStats);
+    WINDOWS_UNLOCK();
+    saved.lastReport = (uint32_t)time(NULL);
+    saveCheckpoint(saved.lastReport);
 }
 
 
 /**
- * @brief Verifica si ha pasado el tiempo especificado en minutos
- * 
- * @param minutes Cantidad de minutos a verificar
- * @return true si ha pasado el tiempo especificado, false en caso contrario
+ * @brief Escribe en la flash los registros encolados por la etapa de agregación
+ *
+ * Solo tiene trabajo en modo pipeline, donde la llama la etapa de E/S; en los
+ * demás modos los registros se escriben al producirse.
+ *
+ * @return true si escribió algún registro
+ */
+bool serviceStorage() {
+#if MAIN_LOOP_MODE == MAIN_LOOP_PIPELINE
+    tipLogRecord_t record;
+    bool stored = false;
+
+    while (storageQueue.pop(&record)) {
+        commitRecord(&record);
+        stored = true;
+    }
+    return stored;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Copia los contadores de la cola de almacenamiento
+ *
+ * @param stats Puntero a la estructura destino
+ */
+void getStorageStats(storageStats_t* stats) {
+    assert(stats != NULL);
+
+#if MAIN_LOOP_MODE == MAIN_LOOP_PIPELINE
+    stats->pending = storageQueue.size();
+    stats->highWater = storageQueue.highWater();
+    stats->stalls = storageStalls;
+#else
+    stats->pending = 0;
+    stats->highWater = 0;
+    stats->stalls = 0;
+#endif
+}
+
+/**
+ * @brief Obtiene la lluvia caída en una ventana deslizante que termina ahora
+ *
+ * Las ventanas cuentan ticks: la lluvia es la nominal (MM_PER_TICK por
+ * tick), sin la corrección por intensidad del reporte periódico.
+ *
+ * @param window Ventana (1, 5, 15 o 60 minutos, o 24 horas)
+ * @return Lluvia nominal en décimas de mm
+ */
+int32_t getRainfallInWindow(intensityWindow_t window) {
+    WINDOWS_LOCK();
+    uint32_t tips = intensityTips(&rainIntensity, window, (uint32_t)time(NULL));
+    WINDOWS_UNLOCK();
+    return (int32_t)tips * MM_PER_TICK;
+}
+
+/**
+ * @brief Obtiene la intensidad media de lluvia en una ventana deslizante que termina ahora
+ *
+ * @param window Ventana (1, 5, 15 o 60 minutos, o 24 horas)
+ * @return Intensidad nominal en décimas de mm por hora
  */
-bool hasTimePassedMinutesRTC(int waiting_seconds) {
-    static time_t lastTime = 0;
-    time_t currentTime;
+int32_t getRainfallRate(intensityWindow_t window) {
+    int64_t rainfall = getRainfallInWindow(window);
+    return (int32_t)(rainfall * 3600 / intensityWindowSeconds(window));
+}
 
-    // Obtener el tiempo actual del RTC
-    currentTime = rtc_read();
+/**
+ * @brief Obtiene la lluvia caída en un rango arbitrario de instantes
+ *
+ * La resolución es de un minuto dentro de los últimos dos días y se degrada a
+ * horas, días y meses para rangos que comienzan antes. Los acumulados
+ * cuentan ticks: la lluvia es la nominal, sin la corrección por intensidad
+ * del reporte periódico.
+ *
+ * @param from Comienzo del rango
+ * @param to Fin (excluido) del rango
+ * @param covered Rango efectivamente sumado y cubetas usadas (puede ser NULL)
+ * @return Lluvia nominal en décimas de mm
+ */
+int32_t getRainfallBetween(time_t from, time_t to, rollupResult_t* covered) {
+    rollupResult_t result;
 
-    // Calcular la diferencia de tiempo en segundos
-    time_t timeDifference = currentTime - lastTime;
+    WINDOWS_LOCK();
+    rollupAdvance(&rainRollup, (uint32_t)time(NULL));
+    rollupQuery(&rainRollup, (uint32_t)from, (uint32_t)to, &result);
+    WINDOWS_UNLOCK();
+    if (covered != NULL) {
+        *covered = result;
+    }
+    return (int32_t)result.tips * MM_PER_TICK;
+}
 
-    // Verificar si ha pasado el tiempo especificado
-    if (timeDifference >= waiting_seconds) {
-        lastTime = currentTime;
-        return true;
+/**
+ * @brief Atiende los comandos recibidos por la UART
+ *
+ * Sin una respuesta en curso toma el próximo comando completo y prepara su
+ * respuesta, que loggerDrain() transmite de a una línea intercalada con los
+ * registros. Con INSTRUMENTATION_ENABLED, PROBE_DUMP_KEY al comienzo de una
+ * línea vacía el registro de eventos y vuelca los histogramas de las sondas,
+ * y PROBE_RESET_KEY los vacía. No bloquea salvo durante ese volcado.
+ *
+ * @return true si comenzó una respuesta
+ */
+bool serviceCommands() {
+    bool started = false;
+
+    if (!response.active && receiveCommand()) {
+        commandReceived = false;
+        startResponse(&receivedCommand);
+        started = true;
     }
+    receiveCommand();  // Deja listo el próximo mientras se transmite la respuesta
+    return started;
+}
 
-    return false;
+/**
+ * @brief Programa el reporte de la lluvia acumulada alineado al reloj de pared
+ *
+ * Con un intervalo de 60 s el reporte corre cada :00 de minuto, sin derivar
+ * con la demora de cada vuelta del bucle. Si el arranque continuó un período
+ * cuyo vencimiento pasó durante el reinicio, lo reporta en el acto.
+ *
+ * @param intervalSeconds Período del reporte en segundos
+ */
+void scheduleReports(int intervalSeconds) {
+    assert(intervalSeconds > 0);
+
+    int status = schedulerAdd(&schedule, &reportJob, (uint32_t)intervalSeconds, 0, reportDue, NULL);
+    assert(status == 0);
+    (void)status;
+    scheduleTick = HAL_GetTick();
+
+    uint32_t now = (uint32_t)time(NULL);
+    if (resumed && now / (uint32_t)intervalSeconds > saved.lastReport / (uint32_t)intervalSeconds) {
+        reportRainfall();
+    }
+}
+
+/**
+ * @brief Indica si llegó la próxima consulta del planificador
+ *
+ * Solo compara HAL_GetTick() con el vencimiento calculado por runSchedule();
+ * no lee el RTC.
+ *
+ * @return true si hay que llamar a runSchedule()
+ */
+bool isScheduleDue() {
+    return (int32_t)(HAL_GetTick() - scheduleTick) >= 0;
+}
+
+/**
+ * @brief Corre las tareas vencidas y calcula la próxima consulta
+ *
+ * La espera se acota a SCHEDULE_MAX_WAIT_MS para notar a tiempo los saltos
+ * del RTC con set_time().
+ *
+ * @return ms hasta la próxima consulta
+ */
+uint32_t runSchedule() {
+    uint32_t now = (uint32_t)time(NULL);
+
+    schedulerRun(&schedule, now);
+
+    uint32_t next = schedulerNextDeadline(&schedule);
+    uint32_t waitMs = SCHEDULE_MAX_WAIT_MS;
+    if (next != SCHEDULER_NEVER && next - now < SCHEDULE_MAX_WAIT_MS / 1000) {
+        waitMs = (next - now) * 1000;
+    }
+    scheduleTick = HAL_GetTick() + waitMs;
+    return waitMs;
 }
 
 
@@ -33,6 +33,9 @@
 
 #include "mbed.h"
 #include "debounce.h"
+#include "intensity.h"
+#include "rollup.h"
+#include "tipcapture.h"
 
 /* === Cabecera C++ ============================================================================ */
 
@@ -48,10 +51,32 @@ extern "C" {
 #define DELAY_BETWEEN_TICK 500  ///< 500 ms
 #define SWITCH_TICK_RAIN BUTTON1  ///< Botón para detectar lluvia
 
-#define MM_PER_TICK 2  ///< 2 décimas de mm de agua por tick
+#define MM_PER_TICK 2  ///< 2 décimas de mm de agua por tick (valor nominal, sin corrección)
+#define GAUGE_CALIBRATION gaugeBucket02mm_t  ///< Cubeta y curva de corrección (ver modules/gauge)
+#define GAUGE_DEBOUNCE EdgeDebounce<DEBOUNCE_TIME>  ///< Política de antirrebote de los ticks
 #define RAINFALL_COUNT_INI 0  ///< Contador de lluvia inicial
 #define LAST_MINUTE_INI -1  ///< Último minuto inicial
+#ifndef DEBOUNCE_TIME
 #define DEBOUNCE_TIME 80 ///< tiempo del antirrebote
+#endif
+#define STATUS_REPORT_INTERVAL 15  ///< Reportes entre mensajes de estado
+#define SCHEDULE_MAX_WAIT_MS 60000  ///< Máximo entre lecturas del RTC del planificador, en ms
+#define ALARM_ADVANCE_SECONDS 60  ///< Período del avance de las reglas de alarma sin ticks (junto al reporte)
+
+// Registro persistente en la flash interna (sectores 17 a 23, banco 2, fuera del programa)
+#define TIP_LOG_FLASH_ADDRESS 0x08120000  ///< Dirección del primer sector del registro
+#define TIP_LOG_FLASH_SIZE (7 * 128 * 1024)  ///< Bytes reservados para el registro
+#define TIP_LOG_RECOVERY_SECTORS 2  ///< Sectores recientes leídos al arrancar para recuperar el conteo
+#define STORAGE_QUEUE_SIZE 64  ///< Registros en espera de la etapa de E/S en modo pipeline (potencia de 2)
+#define STORAGE_STALL_MS 1  ///< Espera entre reintentos con la cola de almacenamiento llena
+
+// Modos de adquisición de ticks
+#define ACQUISITION_POLLING 0  ///< Muestreo desde el bucle con la FSM de antirrebote
+#define ACQUISITION_INTERRUPT 1  ///< Captura por interrupción con cola de eventos
+#define ACQUISITION_TIMER 2  ///< Captura de flancos por TIM2 y DMA en PULSE_COUNTER_PIN (ver modules/pulsecounter)
+#ifndef ACQUISITION_MODE
+#define ACQUISITION_MODE ACQUISITION_INTERRUPT  ///< Modo de adquisición en uso
+#endif
 
 // Mensajes y formatos
 #define MSG_RAIN_DETECTED " - Rain detected\r\n"  ///< Mensaje de lluvia detectada
@@ -62,6 +87,15 @@ extern "C" {
 
 /* === Public data type declarations =========================================================== */
 
+/**
+ * @brief Contadores de la cola de almacenamiento (solo en modo pipeline; si no, en cero).
+ */
+typedef struct {
+    uint32_t pending;  ///< Registros esperando a serviceStorage()
+    uint32_t highWater;  ///< Máxima ocupación de la cola
+    uint32_t stalls;  ///< Esperas del productor con la cola llena
+} storageStats_t;
+
 /* === Public variable declarations ============================================================ */
 void initializeDebounce();
 void updateDebounce();
@@ -77,12 +111,29 @@ extern BufferedSerial pc;  ///< Comunicación serial
 // Sensores
 void initializeSensors();
 bool isRaining();
-bool hasTimePassedMinutesRTC(int minutes);
 
 // Actuación
 void actOnRainfall();
+void actOnTips(const tipEvent_t* tips, size_t count);
 void reportRainfall();
 
+// Almacenamiento
+bool serviceStorage();
+void getStorageStats(storageStats_t* stats);
+
+// Planificación
+void scheduleReports(int intervalSeconds);
+bool isScheduleDue();
+uint32_t runSchedule();
+
+// Consultas y diagnóstico
+bool serviceCommands();
+
+// Análisis de Datos
+int32_t getRainfallInWindow(intensityWindow_t window);
+int32_t getRainfallRate(intensityWindow_t window);
+int32_t getRainfallBetween(time_t from, time_t to, rollupResult_t* covered);
+
 /* === End of documentation ==================================================================== */
 
 #ifdef __cplusplus
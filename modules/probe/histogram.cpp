@@ -0,0 +1,129 @@
+/*
+ * Nombre del archivo: histogram.cpp
+ * Descripción: Histogramas log-lineales de memoria fija para latencias y profundidades.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Implementación del histograma log-lineal.
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <assert.h>
+#include <string.h>
+
+#include "histogram.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define HISTOGRAM_SUB_MASK (HISTOGRAM_SUB_BUCKETS - 1)
+
+/* === Public function implementation ========================================================== */
+
+void histogramInit(histogram_t* histogram) {
+    assert(histogram != NULL);
+
+    memset(histogram, 0, sizeof(*histogram));
+    histogram->min = UINT32_MAX;
+}
+
+uint32_t histogramBucketOf(uint32_t value) {
+    if (value < HISTOGRAM_SUB_BUCKETS) {
+        return value;
+    }
+    // Potencia de 2 del valor y los HISTOGRAM_SUB_BITS bits que le siguen
+    uint32_t shift = (uint32_t)(31 - __builtin_clz(value)) - HISTOGRAM_SUB_BITS;
+    return ((shift + 1) << HISTOGRAM_SUB_BITS) + ((value >> shift) & HISTOGRAM_SUB_MASK);
+}
+
+uint32_t histogramBucketLow(uint32_t bucket) {
+    assert(bucket < HISTOGRAM_BUCKETS);
+
+    if (bucket < HISTOGRAM_SUB_BUCKETS) {
+        return bucket;
+    }
+    uint32_t shift = (bucket >> HISTOGRAM_SUB_BITS) - 1;
+    return (HISTOGRAM_SUB_BUCKETS + (bucket & HISTOGRAM_SUB_MASK)) << shift;
+}
+
+uint32_t histogramBucketHigh(uint32_t bucket) {
+    assert(bucket < HISTOGRAM_BUCKETS);
+
+    return bucket + 1 < HISTOGRAM_BUCKETS ? histogramBucketLow(bucket + 1) - 1 : UINT32_MAX;
+}
+
+void histogramRecord(histogram_t* histogram, uint32_t value) {
+    histogram->counts[histogramBucketOf(value)]++;
+    histogram->count++;
+    histogram->sum += value;
+    if (value < histogram->min) {
+        histogram->min = value;
+    }
+    if (value > histogram->max) {
+        histogram->max = value;
+    }
+}
+
+void histogramMerge(histogram_t* into, const histogram_t* from) {
+    assert(into != NULL && from != NULL);
+
+    for (uint32_t bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) {
+        into->counts[bucket] += from->counts[bucket];
+    }
+    into->count += from->count;
+    into->sum += from->sum;
+    if (from->min < into->min) {
+        into->min = from->min;
+    }
+    if (from->max > into->max) {
+        into->max = from->max;
+    }
+}
+
+uint32_t histogramQuantile(const histogram_t* histogram, uint32_t permille) {
+    assert(histogram != NULL);
+    assert(permille <= 1000);
+
+    if (histogram->count == 0) {
+        return 0;
+    }
+
+    // Posición (desde 1) del registro del cuantil, redondeada hacia arriba
+    uint64_t rank = ((uint64_t)histogram->count * permille + 999) / 1000;
+    if (rank == 0) {
+        return histogram->min;
+    }
+
+    uint64_t seen = 0;
+    for (uint32_t bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) {
+        seen += histogram->counts[bucket];
+        if (seen >= rank) {
+            uint32_t value = histogramBucketHigh(bucket);
+            if (value > histogram->max) {
+                value = histogram->max;
+            }
+            return value < histogram->min ? histogram->min : value;
+        }
+    }
+    return histogram->max;
+}
+
+/* === End of documentation ==================================================================== */
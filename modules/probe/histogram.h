@@ -0,0 +1,139 @@
+/*
+ * Nombre del archivo: histogram.h
+ * Descripción: Histogramas log-lineales de memoria fija para latencias y profundidades.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+/** @file
+ ** @brief Histograma log-lineal de valores de 32 bits.
+ **
+ ** Los valores menores que HISTOGRAM_SUB_BUCKETS tienen una cubeta cada uno;
+ ** a partir de ahí cada potencia de 2 se divide en HISTOGRAM_SUB_BUCKETS
+ ** cubetas iguales, así que el error relativo es a lo sumo
+ ** 1 / HISTOGRAM_SUB_BUCKETS en todo el rango (como HdrHistogram). La memoria
+ ** es fija y registrar un valor es un CLZ, dos desplazamientos y un incremento.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#define HISTOGRAM_SUB_BITS 3  ///< log2 de las cubetas por potencia de 2
+#define HISTOGRAM_SUB_BUCKETS (1u << HISTOGRAM_SUB_BITS)  ///< Cubetas por potencia de 2
+#define HISTOGRAM_BUCKETS ((32 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS)  ///< Cubetas en total
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Histograma de memoria fija.
+ */
+typedef struct {
+    uint32_t counts[HISTOGRAM_BUCKETS];  ///< Valores por cubeta
+    uint32_t count;  ///< Valores registrados
+    uint32_t min;  ///< Menor valor registrado
+    uint32_t max;  ///< Mayor valor registrado
+    uint64_t sum;  ///< Suma de los valores, para la media
+} histogram_t;
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Vacía el histograma.
+ *
+ * @param histogram Histograma a inicializar.
+ */
+void histogramInit(histogram_t* histogram);
+
+/**
+ * @brief Registra un valor.
+ *
+ * @param histogram Histograma destino.
+ * @param value Valor a registrar.
+ */
+void histogramRecord(histogram_t* histogram, uint32_t value);
+
+/**
+ * @brief Suma a un histograma los valores registrados en otro.
+ *
+ * Las cubetas son las mismas en todos los histogramas, así que el resultado
+ * es idéntico al de registrar ambos grupos de valores en uno solo.
+ *
+ * @param into Histograma destino.
+ * @param from Histograma a sumar.
+ */
+void histogramMerge(histogram_t* into, const histogram_t* from);
+
+/**
+ * @brief Obtiene la cubeta en la que cae un valor.
+ *
+ * @param value Valor.
+ * @return Índice de la cubeta, menor que HISTOGRAM_BUCKETS.
+ */
+uint32_t histogramBucketOf(uint32_t value);
+
+/**
+ * @brief Obtiene el menor valor que cae en una cubeta.
+ *
+ * @param bucket Índice de la cubeta, menor que HISTOGRAM_BUCKETS.
+ * @return Límite inferior de la cubeta.
+ */
+uint32_t histogramBucketLow(uint32_t bucket);
+
+/**
+ * @brief Obtiene el mayor valor que cae en una cubeta.
+ *
+ * @param bucket Índice de la cubeta, menor que HISTOGRAM_BUCKETS.
+ * @return Límite superior (incluido) de la cubeta.
+ */
+uint32_t histogramBucketHigh(uint32_t bucket);
+
+/**
+ * @brief Estima el valor bajo el cual queda una fracción de los registros.
+ *
+ * Devuelve el límite superior de la cubeta que contiene el cuantil, acotado
+ * por el mínimo y el máximo registrados; sobreestima a lo sumo en
+ * 1 / HISTOGRAM_SUB_BUCKETS.
+ *
+ * @param histogram Histograma a consultar.
+ * @param permille Cuantil en milésimas (500 = mediana, 990 = p99, 1000 = máximo).
+ * @return Valor del cuantil, o 0 si el histograma está vacío.
+ */
+uint32_t histogramQuantile(const histogram_t* histogram, uint32_t permille);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HISTOGRAM_H */
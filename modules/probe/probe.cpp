@@ -0,0 +1,173 @@
+/*
+ * Nombre del archivo: probe.cpp
+ * Descripción: Sondas de latencia del camino crítico con contador de ciclos.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Implementación de las sondas de latencia.
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include "mbed.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+#include "probe.h"
+
+#if INSTRUMENTATION_ENABLED
+
+/* === Macros definitions ====================================================================== */
+
+#define PROBE_LINE_MAX 128  ///< Largo máximo de una línea del volcado
+
+/* === Private variable declarations =========================================================== */
+
+static histogram_t probeHistograms[PROBE_COUNT];
+
+static const char* const probeNames[PROBE_COUNT] = {
+    "edge_to_record",
+    "loop_iteration",
+    "log_queue_depth",
+    "uart_write",
+    "edge_to_acquisition",
+};
+
+/* === Private function declarations =========================================================== */
+
+static void writeAll(BufferedSerial* port, const char* text, size_t length);
+
+/* === Private function implementation ========================================================= */
+
+/**
+ * @brief Escribe todo el texto con el puerto en modo bloqueante.
+ */
+static void writeAll(BufferedSerial* port, const char* text, size_t length) {
+    while (length > 0) {
+        ssize_t written = port->write(text, length);
+        if (written <= 0) {
+            continue;
+        }
+        text += written;
+        length -= (size_t)written;
+    }
+}
+
+/* === Public function implementation ========================================================== */
+
+void probeInit() {
+#if !defined(__linux__)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    probeReset();
+}
+
+void probeRecord(probeId_t id, uint32_t value) {
+    histogramRecord(&probeHistograms[id], value);
+}
+
+void probeReset() {
+    for (int id = 0; id < PROBE_COUNT; id++) {
+        histogramInit(&probeHistograms[id]);
+    }
+}
+
+const histogram_t* probeHistogram(probeId_t id) {
+    assert(id < PROBE_COUNT);
+
+    return &probeHistograms[id];
+}
+
+const char* probeName(probeId_t id) {
+    assert(id < PROBE_COUNT);
+
+    return probeNames[id];
+}
+
+size_t probeFormat(probeId_t id, char* text, size_t size) {
+    assert(id < PROBE_COUNT);
+    assert(text != NULL && size > 0);
+
+    const histogram_t* histogram = &probeHistograms[id];
+    int length = snprintf(text, size, "probe %s %s n=%lu min=%lu p50=%lu p90=%lu p99=%lu max=%lu mean=%lu",
+                          probeNames[id], id == PROBE_LOG_QUEUE_DEPTH ? "rec" : PROBE_TIME_UNIT,
+                          (unsigned long)histogram->count,
+                          (unsigned long)(histogram->count ? histogram->min : 0),
+                          (unsigned long)histogramQuantile(histogram, 500),
+                          (unsigned long)histogramQuantile(histogram, 900),
+                          (unsigned long)histogramQuantile(histogram, 990),
+                          (unsigned long)histogram->max,
+                          (unsigned long)(histogram->count ? histogram->sum / histogram->count : 0));
+    if (length < 0) {
+        text[0] = '\0';
+        return 0;
+    }
+    return (size_t)length < size ? (size_t)length : size - 1;
+}
+
+bool probeDumpRequested(BufferedSerial* port) {
+    assert(port != NULL);
+
+    bool requested = false;
+    char byte;
+    while (port->readable() && port->read(&byte, 1) == 1) {
+        if (byte == PROBE_DUMP_KEY) {
+            requested = true;
+        } else if (byte == PROBE_RESET_KEY) {
+            probeReset();
+        }
+    }
+    return requested;
+}
+
+void probeDump(BufferedSerial* port) {
+    assert(port != NULL);
+
+    char line[PROBE_LINE_MAX];
+
+    port->set_blocking(true);
+    for (int id = 0; id < PROBE_COUNT; id++) {
+        size_t length = probeFormat((probeId_t)id, line, sizeof(line) - 2);
+        line[length++] = '\r';
+        line[length++] = '\n';
+        writeAll(port, line, length);
+
+        // Cubetas no vacías como "límite_inferior:cantidad", para rearmar el histograma en el PC
+        const histogram_t* histogram = &probeHistograms[id];
+        writeAll(port, "  buckets", 9);
+        for (uint32_t bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) {
+            if (histogram->counts[bucket] != 0) {
+                int pair = snprintf(line, sizeof(line), " %lu:%lu", (unsigned long)histogramBucketLow(bucket),
+                                    (unsigned long)histogram->counts[bucket]);
+                writeAll(port, line, (size_t)pair);
+            }
+        }
+        writeAll(port, "\r\n", 2);
+    }
+    port->set_blocking(false);
+}
+
+#endif /* INSTRUMENTATION_ENABLED */
+
+/* === End of documentation ==================================================================== */
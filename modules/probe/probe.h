@@ -0,0 +1,201 @@
+/*
+ * Nombre del archivo: probe.h
+ * Descripción: Sondas de latencia del camino crítico con contador de ciclos.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef PROBE_H
+#define PROBE_H
+
+/** @file
+ ** @brief Sondas de latencia del camino crítico.
+ **
+ ** Cada sonda vuelca sus muestras en un histograma log-lineal de memoria fija
+ ** (histogram.h): latencia del flanco al registro, duración de cada vuelta del
+ ** bucle (o de cada evento despachado), profundidad de la cola del registro
+ ** al encolar y tiempo dentro de las escrituras a la UART. Los tiempos se
+ ** miden en ciclos con el contador DWT->CYCCNT del Cortex-M, o en ns con
+ ** clock_gettime() al compilar para Linux (host/).
+ **
+ ** Con INSTRUMENTATION_ENABLED en 0 (por defecto) las macros PROBE_* no
+ ** generan código ni ocupan memoria. Activadas, una sonda es una lectura del
+ ** contador y un histogramRecord(), unas pocas decenas de ciclos.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include "mbed.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#if defined(__linux__)
+#include <time.h>
+#endif
+
+#include "histogram.h"
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef INSTRUMENTATION_ENABLED
+#define INSTRUMENTATION_ENABLED 0  ///< 1 compila las sondas del camino crítico
+#endif
+
+#define PROBE_DUMP_KEY '?'  ///< Byte recibido por la UART que pide el volcado de los histogramas
+#define PROBE_RESET_KEY '!'  ///< Byte recibido por la UART que vacía los histogramas
+
+#if defined(__linux__)
+#define PROBE_TIME_UNIT "ns"  ///< Unidad de los tiempos medidos
+#else
+#define PROBE_TIME_UNIT "cyc"  ///< Unidad de los tiempos medidos
+#endif
+
+#if INSTRUMENTATION_ENABLED
+#define PROBE_INIT() probeInit()
+#define PROBE_START(name) probeTime_t name = probeNow()
+#define PROBE_STOP(id, name) probeRecord((id), probeNow() - (name))
+#define PROBE_VALUE(id, value) probeRecord((id), (uint32_t)(value))
+#else
+#define PROBE_INIT() ((void)0)
+#define PROBE_START(name)
+#define PROBE_STOP(id, name) ((void)0)
+#define PROBE_VALUE(id, value) ((void)0)
+#endif
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Sondas disponibles.
+ */
+typedef enum {
+    PROBE_EDGE_TO_RECORD,  ///< Del flanco aceptado por la ISR al registro encolado (modo interrupción)
+    PROBE_LOOP_ITERATION,  ///< Vuelta del bucle de sondeo o evento despachado
+    PROBE_LOG_QUEUE_DEPTH,  ///< Registros en la cola del registro tras encolar
+    PROBE_UART_WRITE,  ///< Tiempo dentro de BufferedSerial::write()
+    PROBE_EDGE_TO_ACQUISITION,  ///< Del flanco aceptado por la ISR a la cola de la agregación (modo pipeline)
+    PROBE_COUNT,
+} probeId_t;
+
+/**
+ * @brief Marca de tiempo de una sonda, en ciclos o ns (PROBE_TIME_UNIT).
+ *
+ * Es un contador de 32 bits que da la vuelta; solo las diferencias tienen
+ * sentido (unos 23 s a 180 MHz, 4 s en ns).
+ */
+typedef uint32_t probeTime_t;
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Lee el contador de las sondas.
+ *
+ * @return Instante actual en PROBE_TIME_UNIT.
+ */
+static inline probeTime_t probeNow(void) {
+#if defined(__linux__)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (probeTime_t)((uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec);
+#else
+    return DWT->CYCCNT;
+#endif
+}
+
+/**
+ * @brief Habilita el contador de ciclos y vacía los histogramas.
+ */
+void probeInit(void);
+
+/**
+ * @brief Registra una muestra de una sonda.
+ *
+ * @param id Sonda.
+ * @param value Muestra: una diferencia de probeNow() o una profundidad.
+ */
+void probeRecord(probeId_t id, uint32_t value);
+
+/**
+ * @brief Vacía los histogramas de todas las sondas.
+ */
+void probeReset(void);
+
+/**
+ * @brief Obtiene el histograma de una sonda.
+ *
+ * @param id Sonda.
+ * @return Histograma de la sonda.
+ */
+const histogram_t* probeHistogram(probeId_t id);
+
+/**
+ * @brief Obtiene el nombre de una sonda.
+ *
+ * @param id Sonda.
+ * @return Nombre sin espacios.
+ */
+const char* probeName(probeId_t id);
+
+/**
+ * @brief Resume una sonda en una línea de texto.
+ *
+ * Formato: "probe <nombre> <unidad> n=.. min=.. p50=.. p90=.. p99=.. max=.. mean=..".
+ *
+ * @param id Sonda.
+ * @param text Buffer destino.
+ * @param size Tamaño del buffer destino.
+ * @return Largo de la línea (sin terminador), truncada a size - 1.
+ */
+size_t probeFormat(probeId_t id, char* text, size_t size);
+
+/**
+ * @brief Lee los bytes recibidos por la UART buscando pedidos de las sondas.
+ *
+ * PROBE_RESET_KEY vacía los histogramas en el acto; el volcado queda a cargo
+ * de quien llama, que debe vaciar antes la salida en curso.
+ *
+ * @param port Puerto serie.
+ * @return true si se recibió PROBE_DUMP_KEY.
+ */
+bool probeDumpRequested(BufferedSerial* port);
+
+/**
+ * @brief Escribe el resumen y las cubetas no vacías de cada sonda.
+ *
+ * Usa escrituras bloqueantes (es un diagnóstico a pedido) y deja el puerto
+ * en modo no bloqueante, como lo usa el registro de eventos.
+ *
+ * @param port Puerto serie.
+ */
+void probeDump(BufferedSerial* port);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROBE_H */
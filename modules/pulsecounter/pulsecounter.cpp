@@ -0,0 +1,235 @@
+/*
+ * Nombre del archivo: pulsecounter.cpp
+ * Descripción: Conteo de ticks con un temporizador en captura de entrada y DMA.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Implementación del conteo de ticks por captura de entrada.
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include "mbed.h"
+#include "stm32f4xx_hal.h"
+#if defined(__linux__)
+#include "hostsim.h"
+#endif
+
+#include <assert.h>
+
+#include "pulsecounter.h"
+#include "probe.h"
+
+/* === Macros definitions ====================================================================== */
+
+#if defined(__linux__)
+#define PROBE_TICKS_PER_US 1000u  ///< probeNow() cuenta ns en el PC
+#else
+#define PROBE_TICKS_PER_US (SystemCoreClock / 1000000u)  ///< probeNow() cuenta ciclos
+#define PULSE_COUNTER_DMA DMA1_Stream5  ///< Único stream con la petición TIM2_CH1 (canal 3)
+#define PULSE_COUNTER_DMA_CHANNEL 3u
+#endif
+
+/* === Private variable declarations =========================================================== */
+
+static uint32_t captureRing[PULSE_COUNTER_RING_SIZE];  ///< Lo escribe la DMA
+static size_t readIndex = 0;  ///< Próxima captura a decodificar
+static pulseDecoder_t decoder;
+static PinName inputPin = NC;
+static pulseCounterStats_t counterStats;
+
+/* === Private function declarations =========================================================== */
+
+static void startCapture(void);
+static size_t captureWriteIndex(void);
+static uint32_t captureNowUs(void);
+static bool readInputLevel(void);
+
+/* === Private function implementation ========================================================= */
+
+/**
+ * @brief Configura la entrada, el temporizador y la DMA, y arranca la captura.
+ */
+static void startCapture() {
+#if defined(__linux__)
+    hostCaptureStart(inputPin, captureRing, PULSE_COUNTER_RING_SIZE, PULSE_COUNTER_FILTER_US);
+#else
+    GPIO_InitTypeDef gpio = {};
+
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    __HAL_RCC_TIM2_CLK_ENABLE();
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    gpio.Pin = GPIO_PIN_0;
+    gpio.Mode = GPIO_MODE_AF_PP;
+    gpio.Pull = GPIO_PULLDOWN;
+    gpio.Speed = GPIO_SPEED_FREQ_LOW;
+    gpio.Alternate = GPIO_AF1_TIM2;
+    HAL_GPIO_Init(GPIOA, &gpio);
+
+    // Los temporizadores de APB1 corren al doble de PCLK1 si el bus está dividido
+    uint32_t timerClock = HAL_RCC_GetPCLK1Freq();
+    if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_HCLK_DIV1) {
+        timerClock *= 2;
+    }
+
+    // Base de tiempo de 1 MHz en los 32 bits de TIM2; fDTS = fCK_INT / 4 para el filtro
+    TIM2->CR1 = TIM_CR1_CKD_1;
+    TIM2->PSC = timerClock / 1000000u - 1;
+    TIM2->ARR = 0xFFFFFFFFu;
+    TIM2->CCMR1 = TIM_CCMR1_CC1S_0 | TIM_CCMR1_IC1F;  // TI1, filtro de 8 muestras a fDTS / 32
+    TIM2->CCER = TIM_CCER_CC1E | TIM_CCER_CC1P | TIM_CCER_CC1NP;  // Ambos flancos
+    TIM2->DIER = TIM_DIER_CC1DE;
+    TIM2->EGR = TIM_EGR_UG;  // Carga el prescaler
+
+    PULSE_COUNTER_DMA->CR = 0;
+    while (PULSE_COUNTER_DMA->CR & DMA_SxCR_EN) {
+    }
+    DMA1->HIFCR = DMA_HIFCR_CTCIF5 | DMA_HIFCR_CHTIF5 | DMA_HIFCR_CTEIF5 | DMA_HIFCR_CDMEIF5 | DMA_HIFCR_CFEIF5;
+    PULSE_COUNTER_DMA->PAR = (uint32_t)&TIM2->CCR1;
+    PULSE_COUNTER_DMA->M0AR = (uint32_t)captureRing;
+    PULSE_COUNTER_DMA->NDTR = PULSE_COUNTER_RING_SIZE;
+    PULSE_COUNTER_DMA->CR = (PULSE_COUNTER_DMA_CHANNEL << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_PL_1 | DMA_SxCR_MSIZE_1 |
+                            DMA_SxCR_PSIZE_1 | DMA_SxCR_MINC | DMA_SxCR_CIRC;  // Periférico a memoria, 32 bits
+    PULSE_COUNTER_DMA->CR |= DMA_SxCR_EN;
+    TIM2->CR1 |= TIM_CR1_CEN;
+#endif
+}
+
+/**
+ * @brief Posición de la próxima captura que escribirá la DMA.
+ */
+static size_t captureWriteIndex() {
+#if defined(__linux__)
+    return hostCaptureIndex();
+#else
+    // NDTR vuelve a PULSE_COUNTER_RING_SIZE al completar la vuelta
+    return (PULSE_COUNTER_RING_SIZE - PULSE_COUNTER_DMA->NDTR) % PULSE_COUNTER_RING_SIZE;
+#endif
+}
+
+/**
+ * @brief Valor actual de la base de tiempo de las capturas, en us.
+ */
+static uint32_t captureNowUs() {
+#if defined(__linux__)
+    return (uint32_t)hostClockNowUs();
+#else
+    return TIM2->CNT;
+#endif
+}
+
+/**
+ * @brief Nivel actual de la entrada (el registro de entrada se lee también en modo alternativo).
+ */
+static bool readInputLevel() {
+#if defined(__linux__)
+    return hostPinRead(inputPin) != 0;
+#else
+    return (GPIOA->IDR & GPIO_PIN_0) != 0;
+#endif
+}
+
+/* === Public function implementation ========================================================== */
+
+void pulseDecoderInit(pulseDecoder_t* decoder, uint32_t quietUs, bool level) {
+    assert(decoder != NULL);
+
+    decoder->quietUs = quietUs;
+    decoder->lastEdgeUs = 0;
+    decoder->level = level;
+    decoder->edgeSeen = false;
+}
+
+int pulseDecoderPush(pulseDecoder_t* decoder, uint32_t edgeUs) {
+    assert(decoder != NULL);
+
+    bool quiet = !decoder->edgeSeen || edgeUs - decoder->lastEdgeUs >= decoder->quietUs;
+
+    decoder->lastEdgeUs = edgeUs;
+    decoder->edgeSeen = true;
+    decoder->level = !decoder->level;
+
+    if (!decoder->level) {
+        return 0;
+    }
+    return quiet ? 1 : -1;
+}
+
+void pulseCounterInit(PinName pin, uint32_t quietUs) {
+    assert(pin == PULSE_COUNTER_PIN);
+
+    inputPin = pin;
+    readIndex = 0;
+    for (size_t i = 0; i < PULSE_COUNTER_RING_SIZE; i++) {
+        captureRing[i] = 0;
+    }
+    startCapture();
+    pulseDecoderInit(&decoder, quietUs, readInputLevel());
+}
+
+size_t pulseCounterDrain(tipEvent_t* events, size_t maxEvents) {
+    assert(events != NULL);
+    assert(inputPin != NC);
+
+    size_t writeIndex = captureWriteIndex();
+    size_t previous = (readIndex + PULSE_COUNTER_RING_SIZE - 1) % PULSE_COUNTER_RING_SIZE;
+
+    // La última captura leída sigue en su lugar salvo que la DMA haya dado la vuelta
+    if (captureRing[previous] != (decoder.edgeSeen ? decoder.lastEdgeUs : 0)) {
+        // Se pierde la paridad de los flancos: se retoma desde la captura más reciente y el nivel actual
+        counterStats.overruns++;
+        readIndex = writeIndex;
+        decoder.lastEdgeUs = captureRing[(writeIndex + PULSE_COUNTER_RING_SIZE - 1) % PULSE_COUNTER_RING_SIZE];
+        decoder.level = readInputLevel();
+        decoder.edgeSeen = true;
+    }
+
+    uint32_t nowUs = captureNowUs();
+    tick_t nowTick = HAL_GetTick();
+    size_t count = 0;
+    while (readIndex != writeIndex && count < maxEvents) {
+        uint32_t edgeUs = captureRing[readIndex];
+        readIndex = (readIndex + 1) % PULSE_COUNTER_RING_SIZE;
+        counterStats.edges++;
+
+        int result = pulseDecoderPush(&decoder, edgeUs);
+        if (result < 0) {
+            counterStats.bounces++;
+        } else if (result > 0) {
+            tipEvent_t* event = &events[count++];
+            event->timestamp = nowTick - (nowUs - edgeUs) / 1000;
+            event->sequence = counterStats.accepted++;
+#if INSTRUMENTATION_ENABLED
+            event->edgeTime = probeNow() - (nowUs - edgeUs) * PROBE_TICKS_PER_US;
+#endif
+        }
+    }
+    return count;
+}
+
+void pulseCounterGetStats(pulseCounterStats_t* stats) {
+    assert(stats != NULL);
+
+    *stats = counterStats;
+}
+
+/* === End of documentation ==================================================================== */
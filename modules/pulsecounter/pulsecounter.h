@@ -0,0 +1,148 @@
+/*
+ * Nombre del archivo: pulsecounter.h
+ * Descripción: Conteo de ticks con un temporizador en captura de entrada y DMA.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef PULSECOUNTER_H
+#define PULSECOUNTER_H
+
+/** @file
+ ** @brief Conteo de ticks con un temporizador en captura de entrada.
+ **
+ ** TIM2 corre libre a 1 MHz y captura ambos flancos de su canal 1 (PA0) a
+ ** través del filtro digital de entrada; la DMA copia cada captura a un
+ ** buffer circular sin intervención de la CPU. El firmware solo lee cada
+ ** tanto cuántas capturas nuevas hay (la diferencia del contador de la DMA) y
+ ** sus instantes, y aplica a esos instantes el mismo antirrebote por silencio
+ ** que la ISR de tipcapture, pero con resolución de microsegundos: así no
+ ** depende de cuándo se atienda una interrupción y admite ráfagas de decenas
+ ** de ticks por segundo.
+ **
+ ** El filtro del temporizador descarta pulsos de unos pocos microsegundos
+ ** (ruido inducido); los rebotes del contacto, de milisegundos, los descarta
+ ** el decodificador.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include "mbed.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tipcapture.h" /* tipEvent_t */
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#define PULSE_COUNTER_PIN PA_0  ///< TIM2_CH1 (CN10), única entrada admitida
+#define PULSE_COUNTER_RING_SIZE 256  ///< Capturas en el buffer circular de la DMA
+#define PULSE_COUNTER_FILTER_US 12  ///< Filtro IC1F = 0xF con fDTS = 90 MHz / 4: 8 muestras a fDTS / 32
+#define PULSE_COUNTER_QUIET_US 5000  ///< Silencio previo mínimo para aceptar un flanco de subida como tick
+#define PULSE_COUNTER_POLL_MS 50  ///< Período de lectura de las capturas en los bucles dirigidos por eventos
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Decodificador de flancos capturados.
+ *
+ * Los flancos filtrados alternan de nivel, así que basta con conocer el nivel
+ * inicial para saber cuáles son de subida.
+ */
+typedef struct {
+    uint32_t quietUs;  ///< Silencio previo mínimo para aceptar un tick
+    uint32_t lastEdgeUs;  ///< Instante del último flanco
+    bool level;  ///< Nivel tras el último flanco
+    bool edgeSeen;  ///< Ya hubo algún flanco
+} pulseDecoder_t;
+
+/**
+ * @brief Contadores de diagnóstico del contador de pulsos.
+ */
+typedef struct {
+    uint32_t edges;  ///< Flancos capturados
+    uint32_t accepted;  ///< Ticks aceptados
+    uint32_t bounces;  ///< Flancos de subida descartados por el antirrebote
+    uint32_t overruns;  ///< Vueltas del buffer circular sin leer (capturas perdidas)
+} pulseCounterStats_t;
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Inicializa el decodificador.
+ *
+ * @param decoder Decodificador.
+ * @param quietUs Silencio previo mínimo en us para aceptar un flanco de subida.
+ * @param level Nivel actual de la entrada.
+ */
+void pulseDecoderInit(pulseDecoder_t* decoder, uint32_t quietUs, bool level);
+
+/**
+ * @brief Entrega el instante del siguiente flanco capturado.
+ *
+ * @param decoder Decodificador.
+ * @param edgeUs Instante del flanco en us (contador de 32 bits que da la vuelta).
+ * @return 1 si el flanco es un tick aceptado, 0 si no, -1 si es un rebote descartado.
+ */
+int pulseDecoderPush(pulseDecoder_t* decoder, uint32_t edgeUs);
+
+/**
+ * @brief Configura TIM2, su filtro de entrada y la DMA circular, y arranca la captura.
+ *
+ * @param pin Entrada del pluviómetro; debe ser PULSE_COUNTER_PIN.
+ * @param quietUs Silencio previo mínimo en us para aceptar un tick.
+ */
+void pulseCounterInit(PinName pin, uint32_t quietUs);
+
+/**
+ * @brief Decodifica las capturas nuevas y entrega hasta maxEvents ticks, en orden.
+ *
+ * El instante de cada tick se convierte a la escala de HAL_GetTick(). Debe
+ * llamarse al menos una vez cada PULSE_COUNTER_RING_SIZE flancos; si el
+ * buffer dio la vuelta se cuenta un desborde y se descartan las capturas.
+ *
+ * @param events Arreglo destino.
+ * @param maxEvents Capacidad del arreglo destino.
+ * @return Cantidad de ticks entregados.
+ */
+size_t pulseCounterDrain(tipEvent_t* events, size_t maxEvents);
+
+/**
+ * @brief Copia los contadores de diagnóstico.
+ *
+ * @param stats Puntero a la estructura destino.
+ */
+void pulseCounterGetStats(pulseCounterStats_t* stats);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PULSECOUNTER_H */
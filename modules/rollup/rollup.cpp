@@ -0,0 +1,301 @@
+/*
+ * Nombre del archivo: rollup.cpp
+ * Descripción: Acumulados de lluvia por minuto, hora, día y mes con memoria acotada.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Implementación de los acumulados en varias resoluciones.
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <assert.h>
+#include <string.h>
+
+#include "timefmt.h"
+#include "rollup.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define MINUTES_PER_HOUR 60
+#define MINUTES_PER_DAY 1440
+
+// Cada nivel debe retener al menos una unidad del siguiente y no menos tiempo que el anterior
+static_assert(ROLLUP_MINUTE_SLOTS >= MINUTES_PER_HOUR, "los minutos deben cubrir una hora");
+static_assert(ROLLUP_HOUR_SLOTS >= 24 && ROLLUP_HOUR_SLOTS * MINUTES_PER_HOUR >= ROLLUP_MINUTE_SLOTS,
+              "las horas deben cubrir un día y no menos que los minutos");
+static_assert(ROLLUP_DAY_SLOTS >= 31 && ROLLUP_DAY_SLOTS * 24 >= ROLLUP_HOUR_SLOTS,
+              "los días deben cubrir un mes y no menos que las horas");
+static_assert(ROLLUP_MONTH_SLOTS * 28 >= ROLLUP_DAY_SLOTS, "los meses deben cubrir no menos que los días");
+
+/* === Private variable declarations =========================================================== */
+
+static const uint32_t slotCount[ROLLUP_LEVELS] = {
+    ROLLUP_MINUTE_SLOTS, ROLLUP_HOUR_SLOTS, ROLLUP_DAY_SLOTS, ROLLUP_MONTH_SLOTS,
+};
+
+/* === Private function implementation ========================================================= */
+
+/**
+ * @brief Mes absoluto (año * 12 + mes - 1) de un día desde la época.
+ */
+static uint32_t monthOfDay(uint32_t day) {
+    timeCivil_t date;
+    timeCivilFromDays((int32_t)day, &date);
+    return (uint32_t)date.year * 12 + date.month - 1;
+}
+
+/**
+ * @brief Unidad del nivel que contiene un minuto absoluto.
+ */
+static uint32_t unitOf(int level, uint32_t minute) {
+    switch (level) {
+    case ROLLUP_MINUTE:
+        return minute;
+    case ROLLUP_HOUR:
+        return minute / MINUTES_PER_HOUR;
+    case ROLLUP_DAY:
+        return minute / MINUTES_PER_DAY;
+    default:
+        return monthOfDay(minute / MINUTES_PER_DAY);
+    }
+}
+
+/**
+ * @brief Primer minuto absoluto de una unidad del nivel.
+ */
+static uint32_t unitStart(int level, uint32_t unit) {
+    switch (level) {
+    case ROLLUP_MINUTE:
+        return unit;
+    case ROLLUP_HOUR:
+        return unit * MINUTES_PER_HOUR;
+    case ROLLUP_DAY:
+        return unit * MINUTES_PER_DAY;
+    default: {
+        timeCivil_t date = {(int32_t)(unit / 12), (uint8_t)(unit % 12 + 1), 1};
+        return (uint32_t)timeDaysFromCivil(&date) * MINUTES_PER_DAY;
+    }
+    }
+}
+
+static uint32_t getSlot(const rollup_t* rollup, int level, uint32_t unit) {
+    uint32_t index = unit % slotCount[level];
+    switch (level) {
+    case ROLLUP_MINUTE:
+        return rollup->minutes[index];
+    case ROLLUP_HOUR:
+        return rollup->hours[index];
+    case ROLLUP_DAY:
+        return rollup->days[index];
+    default:
+        return rollup->months[index];
+    }
+}
+
+static void addSlot(rollup_t* rollup, int level, uint32_t unit, uint32_t tips) {
+    uint32_t index = unit % slotCount[level];
+    switch (level) {
+    case ROLLUP_MINUTE:
+        rollup->minutes[index] += (uint16_t)tips;
+        break;
+    case ROLLUP_HOUR:
+        rollup->hours[index] += (uint16_t)tips;
+        break;
+    case ROLLUP_DAY:
+        rollup->days[index] += (uint16_t)tips;
+        break;
+    default:
+        rollup->months[index] += tips;
+        break;
+    }
+}
+
+static void clearSlot(rollup_t* rollup, int level, uint32_t unit) {
+    uint32_t index = unit % slotCount[level];
+    switch (level) {
+    case ROLLUP_MINUTE:
+        rollup->minutes[index] = 0;
+        break;
+    case ROLLUP_HOUR:
+        rollup->hours[index] = 0;
+        break;
+    case ROLLUP_DAY:
+        rollup->days[index] = 0;
+        break;
+    default:
+        rollup->months[index] = 0;
+        break;
+    }
+}
+
+/**
+ * @brief Indica si la unidad todavía tiene cubeta en el nivel.
+ */
+static bool retained(const rollup_t* rollup, int level, uint32_t unit) {
+    return unit <= rollup->current[level] && rollup->current[level] - unit < slotCount[level];
+}
+
+/**
+ * @brief Primer minuto de la unidad más antigua retenida en el nivel.
+ */
+static uint32_t oldestMinute(const rollup_t* rollup, int level) {
+    uint32_t current = rollup->current[level];
+    uint32_t oldest = current >= slotCount[level] - 1 ? current - (slotCount[level] - 1) : 0;
+    return unitStart(level, oldest);
+}
+
+/**
+ * @brief Suma [from, to) (en minutos) con las unidades cerradas más gruesas que caben y
+ *        resuelve los bordes en los niveles finos.
+ */
+static uint32_t sumRange(const rollup_t* rollup, int level, uint32_t from, uint32_t to, uint32_t* buckets) {
+    if (from >= to) {
+        return 0;
+    }
+
+    uint32_t sum = 0;
+    if (level == ROLLUP_MINUTE) {
+        for (uint32_t minute = from; minute < to; minute++) {
+            sum += getSlot(rollup, ROLLUP_MINUTE, minute);
+        }
+        *buckets += to - from;
+        return sum;
+    }
+
+    // Unidades completas dentro del rango y ya cerradas
+    uint32_t first = unitOf(level, from);
+    if (unitStart(level, first) != from) {
+        first++;
+    }
+    uint32_t last = unitOf(level, to);
+    if (last > rollup->current[level]) {
+        last = rollup->current[level];
+    }
+    if (first >= last) {
+        return sumRange(rollup, level - 1, from, to, buckets);
+    }
+
+    for (uint32_t unit = first; unit < last; unit++) {
+        sum += getSlot(rollup, level, unit);
+    }
+    *buckets += last - first;
+    return sum + sumRange(rollup, level - 1, from, unitStart(level, first), buckets) +
+           sumRange(rollup, level - 1, unitStart(level, last), to, buckets);
+}
+
+/* === Public function implementation ========================================================== */
+
+void rollupInit(rollup_t* rollup, uint32_t now) {
+    assert(rollup != NULL);
+
+    memset(rollup, 0, sizeof(*rollup));
+    for (int level = 0; level < ROLLUP_LEVELS; level++) {
+        rollup->current[level] = unitOf(level, now / 60);
+    }
+}
+
+void rollupAdvance(rollup_t* rollup, uint32_t now) {
+    assert(rollup != NULL);
+
+    uint32_t minute = now / 60;
+    for (int level = 0; level < ROLLUP_LEVELS; level++) {
+        uint32_t unit = unitOf(level, minute);
+        uint32_t current = rollup->current[level];
+        if (unit <= current) {
+            break;  // Si este nivel no cerró su unidad, los más gruesos tampoco
+        }
+
+        // La unidad que cierra pasa a la unidad en curso del nivel siguiente
+        if (level + 1 < ROLLUP_LEVELS) {
+            addSlot(rollup, level + 1, rollup->current[level + 1], getSlot(rollup, level, current));
+        }
+
+        if (unit - current >= slotCount[level]) {
+            for (uint32_t index = 0; index < slotCount[level]; index++) {
+                clearSlot(rollup, level, index);
+            }
+        } else {
+            for (uint32_t fresh = current + 1; fresh <= unit; fresh++) {
+                clearSlot(rollup, level, fresh);
+            }
+        }
+        rollup->current[level] = unit;
+    }
+}
+
+void rollupAddTips(rollup_t* rollup, uint32_t timestamp, uint32_t tips) {
+    assert(rollup != NULL);
+
+    rollupAdvance(rollup, timestamp);
+
+    uint32_t minute = timestamp / 60;
+    for (int level = 0; level < ROLLUP_LEVELS; level++) {
+        uint32_t unit = unitOf(level, minute);
+
+        // En los niveles gruesos solo si la unidad fina ya cerró (si no, llegará al cerrarse)
+        bool cascaded = level == ROLLUP_MINUTE || unitOf(level - 1, minute) < rollup->current[level - 1];
+        if (cascaded && retained(rollup, level, unit)) {
+            addSlot(rollup, level, unit, tips);
+        }
+    }
+}
+
+void rollupQuery(rollup_t* rollup, uint32_t from, uint32_t to, rollupResult_t* result) {
+    assert(rollup != NULL);
+    assert(result != NULL);
+
+    uint32_t fromMinute = from / 60;
+    uint32_t toMinute = to / 60 + (to % 60 != 0 ? 1 : 0);
+    if (toMinute > rollup->current[ROLLUP_MINUTE] + 1) {
+        toMinute = rollup->current[ROLLUP_MINUTE] + 1;
+    }
+
+    // El nivel más fino que aún retiene el comienzo fija la resolución de ambos bordes
+    int level = ROLLUP_MINUTE;
+    while (level < ROLLUP_MONTH && fromMinute < oldestMinute(rollup, level)) {
+        level++;
+    }
+    if (fromMinute < oldestMinute(rollup, ROLLUP_MONTH)) {
+        fromMinute = oldestMinute(rollup, ROLLUP_MONTH);
+    } else {
+        fromMinute = unitStart(level, unitOf(level, fromMinute));
+    }
+    if (toMinute > 0 && toMinute <= rollup->current[ROLLUP_MINUTE]) {
+        uint32_t toUnit = unitOf(level, toMinute - 1);
+        toMinute = unitStart(level, toUnit + 1);
+        if (toMinute > rollup->current[ROLLUP_MINUTE] + 1) {
+            toMinute = rollup->current[ROLLUP_MINUTE] + 1;
+        }
+    }
+
+    result->tips = 0;
+    result->buckets = 0;
+    if (fromMinute < toMinute) {
+        result->tips = sumRange(rollup, ROLLUP_MONTH, fromMinute, toMinute, &result->buckets);
+    } else {
+        toMinute = fromMinute;
+    }
+    result->from = fromMinute * 60;
+    result->to = toMinute * 60;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,144 @@
+/*
+ * Nombre del archivo: rollup.h
+ * Descripción: Acumulados de lluvia por minuto, hora, día y mes con memoria acotada.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef ROLLUP_H
+#define ROLLUP_H
+
+/** @file
+ ** @brief Acumulados de lluvia en varias resoluciones.
+ **
+ ** Cuatro anillos de tamaño fijo guardan los ticks por minuto, hora, día y
+ ** mes (calendario UTC). Los ticks solo se suman al minuto; al cerrarse cada
+ ** minuto su total pasa a la hora, al cerrarse la hora al día y al cerrarse
+ ** el día al mes. Cada nivel conserva sus últimas ROLLUP_*_SLOTS unidades.
+ **
+ ** Una consulta sobre un rango usa primero los meses completos que caben en
+ ** él, luego los días de los bordes, luego las horas y por último los
+ ** minutos, así que suma a lo sumo unas decenas de cubetas por nivel en lugar
+ ** de un valor por tick. Si el comienzo es más antiguo que lo que retiene el
+ ** nivel fino, ambos bordes se amplían a unidades del nivel más fino que aún
+ ** lo retiene (y se recortan si ya no hay datos); el resultado informa el
+ ** rango exacto al que corresponde el total.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdint.h>
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef ROLLUP_MINUTE_SLOTS
+#define ROLLUP_MINUTE_SLOTS (2 * 1440)  ///< Minutos retenidos (2 días)
+#endif
+#ifndef ROLLUP_HOUR_SLOTS
+#define ROLLUP_HOUR_SLOTS (62 * 24)  ///< Horas retenidas (2 meses)
+#endif
+#ifndef ROLLUP_DAY_SLOTS
+#define ROLLUP_DAY_SLOTS 731  ///< Días retenidos (2 años)
+#endif
+#ifndef ROLLUP_MONTH_SLOTS
+#define ROLLUP_MONTH_SLOTS 120  ///< Meses retenidos (10 años)
+#endif
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Niveles de resolución.
+ */
+typedef enum {
+    ROLLUP_MINUTE,
+    ROLLUP_HOUR,
+    ROLLUP_DAY,
+    ROLLUP_MONTH,
+    ROLLUP_LEVELS,
+} rollupLevel_t;
+
+/**
+ * @brief Acumulados de todos los niveles.
+ *
+ * La cubeta de la unidad en curso de cada nivel contiene solo sus unidades
+ * finas ya cerradas; la unidad en curso del minuto contiene los ticks.
+ */
+typedef struct {
+    uint16_t minutes[ROLLUP_MINUTE_SLOTS];
+    uint16_t hours[ROLLUP_HOUR_SLOTS];
+    uint16_t days[ROLLUP_DAY_SLOTS];
+    uint32_t months[ROLLUP_MONTH_SLOTS];
+    uint32_t current[ROLLUP_LEVELS];  ///< Unidad en curso de cada nivel (minuto, hora, día y mes absolutos)
+} rollup_t;
+
+/**
+ * @brief Resultado de una consulta.
+ */
+typedef struct {
+    uint32_t tips;  ///< Ticks en [from, to)
+    uint32_t from;  ///< Comienzo del rango cubierto, en segundos desde la época
+    uint32_t to;  ///< Fin (excluido) del rango cubierto
+    uint32_t buckets;  ///< Cubetas sumadas
+} rollupResult_t;
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Inicializa los acumulados vacíos.
+ *
+ * @param rollup Estado.
+ * @param now Instante actual en segundos desde la época.
+ */
+void rollupInit(rollup_t* rollup, uint32_t now);
+
+/**
+ * @brief Suma ticks en un instante; uno anterior al actual se suma en las cubetas que aún existan.
+ */
+void rollupAddTips(rollup_t* rollup, uint32_t timestamp, uint32_t tips);
+
+/**
+ * @brief Avanza el tiempo, cerrando y trasladando las unidades que terminaron.
+ */
+void rollupAdvance(rollup_t* rollup, uint32_t now);
+
+/**
+ * @brief Ticks en el rango [from, to), con resolución de un minuto.
+ *
+ * @param rollup Estado.
+ * @param from Comienzo en segundos desde la época (se redondea al minuto inferior).
+ * @param to Fin excluido (se redondea al minuto superior y se limita al minuto en curso).
+ *           Ambos bordes se amplían a la resolución disponible para el comienzo.
+ * @param result Total y rango efectivamente cubierto.
+ */
+void rollupQuery(rollup_t* rollup, uint32_t from, uint32_t to, rollupResult_t* result);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROLLUP_H */
@@ -0,0 +1,185 @@
+/*
+ * Nombre del archivo: scheduler.cpp
+ * Descripción: Tareas periódicas alineadas al reloj de pared en un montículo de vencimientos.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Implementación del planificador de tareas periódicas.
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <assert.h>
+#include <stddef.h>
+
+#include "scheduler.h"
+
+/* === Private function declarations =========================================================== */
+
+static uint32_t nextBoundary(const schedulerJob_t* job, uint32_t now);
+static void siftUp(scheduler_t* scheduler, uint32_t index);
+static void siftDown(scheduler_t* scheduler, uint32_t index);
+static void realign(scheduler_t* scheduler, uint32_t now);
+
+/* === Private function implementation ========================================================= */
+
+/**
+ * @brief Primer instante posterior a now alineado al período y la fase de la tarea.
+ */
+static uint32_t nextBoundary(const schedulerJob_t* job, uint32_t now) {
+    // Se suma un período antes de restar la fase para no pasar por debajo de 0 cuando now < phase
+    uint64_t periods = ((uint64_t)now + job->period - job->phase) / job->period;
+    return (uint32_t)(periods * job->period + job->phase);
+}
+
+/**
+ * @brief Sube un elemento del montículo hasta su lugar.
+ */
+static void siftUp(scheduler_t* scheduler, uint32_t index) {
+    schedulerJob_t* job = scheduler->heap[index];
+
+    while (index > 0) {
+        uint32_t parent = (index - 1) / 2;
+        if (scheduler->heap[parent]->deadline <= job->deadline) {
+            break;
+        }
+        scheduler->heap[index] = scheduler->heap[parent];
+        index = parent;
+    }
+    scheduler->heap[index] = job;
+}
+
+/**
+ * @brief Baja un elemento del montículo hasta su lugar.
+ */
+static void siftDown(scheduler_t* scheduler, uint32_t index) {
+    schedulerJob_t* job = scheduler->heap[index];
+
+    while (true) {
+        uint32_t child = 2 * index + 1;
+        if (child >= scheduler->count) {
+            break;
+        }
+        if (child + 1 < scheduler->count && scheduler->heap[child + 1]->deadline < scheduler->heap[child]->deadline) {
+            child++;
+        }
+        if (job->deadline <= scheduler->heap[child]->deadline) {
+            break;
+        }
+        scheduler->heap[index] = scheduler->heap[child];
+        index = child;
+    }
+    scheduler->heap[index] = job;
+}
+
+/**
+ * @brief Recalcula todos los vencimientos tras un retroceso del reloj.
+ */
+static void realign(scheduler_t* scheduler, uint32_t now) {
+    for (uint32_t i = 0; i < scheduler->count; i++) {
+        scheduler->heap[i]->deadline = nextBoundary(scheduler->heap[i], now);
+    }
+    for (uint32_t i = scheduler->count / 2; i-- > 0;) {
+        siftDown(scheduler, i);
+    }
+}
+
+/* === Public function implementation ========================================================== */
+
+void schedulerInit(scheduler_t* scheduler, uint32_t now) {
+    assert(scheduler != NULL);
+
+    scheduler->count = 0;
+    scheduler->now = now;
+}
+
+int schedulerAdd(scheduler_t* scheduler, schedulerJob_t* job, uint32_t period, uint32_t phase,
+                 schedulerHandler_t handler, void* context) {
+    assert(scheduler != NULL && job != NULL && handler != NULL);
+    assert(period > 0 && phase < period);
+
+    if (scheduler->count >= SCHEDULER_MAX_JOBS) {
+        return -1;
+    }
+
+    job->period = period;
+    job->phase = phase;
+    job->handler = handler;
+    job->context = context;
+    job->runs = 0;
+    job->missed = 0;
+    job->deadline = nextBoundary(job, scheduler->now);
+
+    scheduler->heap[scheduler->count] = job;
+    siftUp(scheduler, scheduler->count++);
+    return 0;
+}
+
+void schedulerRemove(scheduler_t* scheduler, schedulerJob_t* job) {
+    assert(scheduler != NULL && job != NULL);
+
+    for (uint32_t i = 0; i < scheduler->count; i++) {
+        if (scheduler->heap[i] == job) {
+            scheduler->heap[i] = scheduler->heap[--scheduler->count];
+            if (i < scheduler->count) {
+                siftDown(scheduler, i);
+                siftUp(scheduler, i);
+            }
+            return;
+        }
+    }
+    assert(false);  // La tarea no estaba registrada
+}
+
+uint32_t schedulerNextDeadline(const scheduler_t* scheduler) {
+    assert(scheduler != NULL);
+
+    return scheduler->count > 0 ? scheduler->heap[0]->deadline : SCHEDULER_NEVER;
+}
+
+uint32_t schedulerRun(scheduler_t* scheduler, uint32_t now) {
+    assert(scheduler != NULL);
+
+    uint32_t ran = 0;
+
+    if (now < scheduler->now) {
+        realign(scheduler, now);
+    }
+    scheduler->now = now;
+
+    while (scheduler->count > 0 && scheduler->heap[0]->deadline <= now) {
+        schedulerJob_t* job = scheduler->heap[0];
+
+        // Un atraso de varios períodos se atiende una vez, con el último vencimiento alcanzado
+        uint32_t missed = (now - job->deadline) / job->period;
+        uint32_t deadline = job->deadline + missed * job->period;
+        job->deadline = deadline + job->period;
+        job->runs++;
+        job->missed += missed;
+        siftDown(scheduler, 0);
+
+        job->handler(deadline, missed, job->context);
+        ran++;
+    }
+    return ran;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,153 @@
+/*
+ * Nombre del archivo: scheduler.h
+ * Descripción: Tareas periódicas alineadas al reloj de pared en un montículo de vencimientos.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+/** @file
+ ** @brief Planificador de tareas periódicas alineadas al reloj de pared.
+ **
+ ** Cada tarea vence en los múltiplos de su período desplazados por su fase
+ ** (cada :00 de minuto, en punto de cada hora, a medianoche), no a intervalos
+ ** contados desde la última consulta, así que no deriva. Las tareas están en
+ ** un montículo binario ordenado por vencimiento: schedulerNextDeadline() es
+ ** O(1) y quien llama solo necesita despertar en ese instante.
+ **
+ ** Si el reloj avanza más de un período entre consultas (una demora larga o
+ ** un set_time() hacia adelante), la tarea corre una sola vez con el último
+ ** vencimiento alcanzado e informa cuántos se saltearon. Si el reloj
+ ** retrocede, los vencimientos se recalculan desde el nuevo instante.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdint.h>
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#define SCHEDULER_MAX_JOBS 8  ///< Tareas simultáneas
+#define SCHEDULER_NEVER UINT32_MAX  ///< Vencimiento de un planificador sin tareas
+
+#define SCHEDULER_MINUTE 60u  ///< Período de una tarea por minuto, en segundos
+#define SCHEDULER_HOUR 3600u  ///< Período de una tarea por hora, en segundos
+#define SCHEDULER_DAY 86400u  ///< Período de una tarea diaria, en segundos
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Función de una tarea.
+ *
+ * @param deadline Vencimiento atendido: el último alcanzado si hubo atraso.
+ * @param missed Vencimientos anteriores salteados por atraso.
+ * @param context Contexto registrado con la tarea.
+ */
+typedef void (*schedulerHandler_t)(uint32_t deadline, uint32_t missed, void* context);
+
+/**
+ * @brief Tarea periódica. La memoria es de quien la registra y debe vivir mientras esté registrada.
+ */
+typedef struct {
+    uint32_t period;  ///< Período en segundos
+    uint32_t phase;  ///< Desplazamiento de los vencimientos respecto de la época, menor que period
+    uint32_t deadline;  ///< Próximo vencimiento, en segundos desde la época
+    schedulerHandler_t handler;
+    void* context;
+    uint32_t runs;  ///< Veces que corrió
+    uint32_t missed;  ///< Vencimientos salteados en total
+} schedulerJob_t;
+
+/**
+ * @brief Planificador.
+ */
+typedef struct {
+    schedulerJob_t* heap[SCHEDULER_MAX_JOBS];  ///< Montículo de mínimos por vencimiento
+    uint32_t count;  ///< Tareas registradas
+    uint32_t now;  ///< Último instante consultado
+} scheduler_t;
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Inicializa un planificador sin tareas.
+ *
+ * @param scheduler Planificador.
+ * @param now Instante actual en segundos desde la época.
+ */
+void schedulerInit(scheduler_t* scheduler, uint32_t now);
+
+/**
+ * @brief Registra una tarea que vence en los instantes t con t % period == phase.
+ *
+ * El primer vencimiento es el primero posterior al último instante consultado.
+ * Para medianoche local con TIME_FORMAT_UTC_OFFSET se usa
+ * phase = (SCHEDULER_DAY - TIME_FORMAT_UTC_OFFSET % SCHEDULER_DAY) % SCHEDULER_DAY.
+ *
+ * @param scheduler Planificador.
+ * @param job Tarea a registrar, no registrada.
+ * @param period Período en segundos, mayor que 0.
+ * @param phase Desplazamiento en segundos, menor que period.
+ * @param handler Función de la tarea.
+ * @param context Contexto para la función.
+ * @return 0 si se registró, -1 si no hay lugar.
+ */
+int schedulerAdd(scheduler_t* scheduler, schedulerJob_t* job, uint32_t period, uint32_t phase,
+                 schedulerHandler_t handler, void* context);
+
+/**
+ * @brief Quita una tarea registrada. Puede llamarse desde la función de una tarea.
+ *
+ * @param scheduler Planificador.
+ * @param job Tarea a quitar.
+ */
+void schedulerRemove(scheduler_t* scheduler, schedulerJob_t* job);
+
+/**
+ * @brief Próximo vencimiento de todas las tareas.
+ *
+ * @return Instante en segundos desde la época, o SCHEDULER_NEVER sin tareas.
+ */
+uint32_t schedulerNextDeadline(const scheduler_t* scheduler);
+
+/**
+ * @brief Corre las tareas vencidas en now, en orden de vencimiento, una vez cada una.
+ *
+ * @param scheduler Planificador.
+ * @param now Instante actual en segundos desde la época.
+ * @return Tareas que corrieron.
+ */
+uint32_t schedulerRun(scheduler_t* scheduler, uint32_t now);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCHEDULER_H */
@@ -0,0 +1,430 @@
+/*
+ * Nombre del archivo: tiplog.cpp
+ * Descripción: Registro persistente de ticks en flash, circular y con recuperación tras cortes.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Implementación del registro persistente de ticks.
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include "mbed.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "crc32.h"
+#include "tiplog.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define ERASED_BYTE 0xFF
+#define HEADER_SIZE 16  ///< magic, secuencia, tamaño de página, tamaño de registro, CRC
+#define CRC_OFFSET 12  ///< Posición del CRC en registros y cabeceras
+
+static_assert(TIP_LOG_PAGE_SIZE % TIP_LOG_RECORD_SIZE == 0, "la página debe contener registros enteros");
+static_assert(TIP_LOG_PAGE_SIZE >= HEADER_SIZE, "la cabecera ocupa la primera página del sector");
+
+/* === Private variable declarations =========================================================== */
+
+static uint8_t blankPage[TIP_LOG_PAGE_SIZE];  ///< Página borrada, para dispositivos que no borran a 0xFF
+
+/* === Private function implementation ========================================================= */
+
+static void putU32(uint8_t* bytes, uint32_t value) {
+    bytes[0] = (uint8_t)value;
+    bytes[1] = (uint8_t)(value >> 8);
+    bytes[2] = (uint8_t)(value >> 16);
+    bytes[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t getU32(const uint8_t* bytes) {
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static bool isErased(const uint8_t* bytes, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (bytes[i] != ERASED_BYTE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bd_addr_t sectorAddress(const tipLog_t* log, uint32_t sector) {
+    return (bd_addr_t)sector * log->sectorSize;
+}
+
+/**
+ * @brief Lee un bloque contando la lectura para la recuperación.
+ */
+static int readCounted(tipLog_t* log, void* buffer, bd_addr_t address, bd_size_t size) {
+    log->stats.recoveryReads++;
+    return log->device->read(buffer, address, size);
+}
+
+/**
+ * @brief Lee la cabecera de un sector.
+ *
+ * @return true si es válida; en ese caso deja su secuencia en sequence.
+ */
+static bool readHeader(tipLog_t* log, uint32_t sector, uint32_t* sequence) {
+    uint8_t header[HEADER_SIZE];
+
+    if (readCounted(log, header, sectorAddress(log, sector), HEADER_SIZE) != 0) {
+        return false;
+    }
+    if (getU32(&header[0]) != TIP_LOG_MAGIC || getU32(&header[CRC_OFFSET]) != crc32(header, CRC_OFFSET) ||
+        header[8] != (uint8_t)TIP_LOG_PAGE_SIZE || header[9] != (uint8_t)(TIP_LOG_PAGE_SIZE >> 8)) {
+        return false;
+    }
+    *sequence = getU32(&header[4]);
+    return true;
+}
+
+/**
+ * @brief Indica si la cabecera del sector es válida y tiene la secuencia esperada.
+ */
+static bool hasSequence(tipLog_t* log, uint32_t sector, uint32_t expected) {
+    uint32_t sequence;
+    return readHeader(log, sector, &sequence) && sequence == expected;
+}
+
+/**
+ * @brief Borra un sector y programa su cabecera.
+ */
+static int openSector(tipLog_t* log, uint32_t sector, uint32_t sequence) {
+    bd_addr_t address = sectorAddress(log, sector);
+    int error = log->device->erase(address, log->sectorSize);
+    if (error != 0) {
+        return error;
+    }
+    log->stats.sectorsErased++;
+
+    if (log->device->get_erase_value() != ERASED_BYTE) {
+        for (uint32_t offset = 0; offset < log->sectorSize; offset += TIP_LOG_PAGE_SIZE) {
+            error = log->device->program(blankPage, address + offset, TIP_LOG_PAGE_SIZE);
+            if (error != 0) {
+                return error;
+            }
+        }
+    }
+
+    // La cabecera ocupa una página propia para no reprogramar nunca una página escrita
+    uint8_t header[TIP_LOG_PAGE_SIZE];
+    memset(header, ERASED_BYTE, sizeof(header));
+    putU32(&header[0], TIP_LOG_MAGIC);
+    putU32(&header[4], sequence);
+    header[8] = (uint8_t)TIP_LOG_PAGE_SIZE;
+    header[9] = (uint8_t)(TIP_LOG_PAGE_SIZE >> 8);
+    header[10] = TIP_LOG_RECORD_SIZE;
+    header[11] = 0;
+    putU32(&header[CRC_OFFSET], crc32(header, CRC_OFFSET));
+    return log->device->program(header, address, TIP_LOG_PAGE_SIZE);
+}
+
+/**
+ * @brief Pasa la escritura al sector siguiente, borrando el más antiguo si el anillo está lleno.
+ */
+static int advanceSector(tipLog_t* log) {
+    uint32_t next = (log->headSector + 1) % log->sectorCount;
+
+    log->headSector = next;
+    log->headSequence++;
+    log->writeOffset = TIP_LOG_PAGE_SIZE;
+    if (log->usedSectors < log->sectorCount) {
+        log->usedSectors++;
+    }
+    return openSector(log, next, log->headSequence);
+}
+
+/**
+ * @brief Programa la página en armado y la deja vacía.
+ */
+static int writePage(tipLog_t* log) {
+    int error = 0;
+
+    if (log->writeOffset >= log->sectorSize) {
+        error = advanceSector(log);
+    }
+    if (error == 0) {
+        error = log->device->program(log->page, sectorAddress(log, log->headSector) + log->writeOffset,
+                                     TIP_LOG_PAGE_SIZE);
+    }
+
+    // Aun si falla, la página se da por usada: nunca se reprograma
+    log->writeOffset += TIP_LOG_PAGE_SIZE;
+    log->pageFill = 0;
+    memset(log->page, ERASED_BYTE, sizeof(log->page));
+    if (error == 0) {
+        log->stats.pagesWritten++;
+    }
+    return error;
+}
+
+/**
+ * @brief Indica si una página del sector en escritura ya fue programada (aunque sea en parte).
+ */
+static bool pageProgrammed(tipLog_t* log, uint32_t page) {
+    uint8_t record[TIP_LOG_RECORD_SIZE];
+    bd_addr_t address = sectorAddress(log, log->headSector) + (bd_addr_t)page * TIP_LOG_PAGE_SIZE;
+
+    return readCounted(log, record, address, sizeof(record)) != 0 || !isErased(record, sizeof(record));
+}
+
+/**
+ * @brief Indica si una página del sector en escritura está completamente borrada.
+ */
+static bool pageBlank(tipLog_t* log, uint32_t page) {
+    uint8_t record[TIP_LOG_RECORD_SIZE];
+    bd_addr_t address = sectorAddress(log, log->headSector) + (bd_addr_t)page * TIP_LOG_PAGE_SIZE;
+
+    for (uint32_t offset = 0; offset < TIP_LOG_PAGE_SIZE; offset += TIP_LOG_RECORD_SIZE) {
+        if (readCounted(log, record, address + offset, sizeof(record)) != 0 || !isErased(record, sizeof(record))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Ubica el sector en escritura y cuántos sectores tienen datos.
+ *
+ * Los sectores se escriben en orden con secuencias consecutivas, así que
+ * desde el sector 0 se cumple seq[i] == seq[0] + i hasta el sector en
+ * escritura y deja de cumplirse después (sectores más viejos, borrados o
+ * cortados a medias): el límite se encuentra por búsqueda binaria.
+ *
+ * @return false si el dispositivo no contiene un registro.
+ */
+static bool findHead(tipLog_t* log) {
+    uint32_t last = log->sectorCount - 1;
+    uint32_t first;
+
+    if (!readHeader(log, 0, &first)) {
+        // El sector 0 solo es inválido en un dispositivo nuevo o si se estaba
+        // reciclando, y en ese caso el último sector es el más reciente
+        uint32_t sequence;
+        if (!readHeader(log, last, &sequence)) {
+            return false;
+        }
+        log->headSector = last;
+        log->headSequence = sequence;
+        log->usedSectors = last;
+        return true;
+    }
+
+    uint32_t low = 0;  // Cumple la condición
+    uint32_t high = log->sectorCount;  // Primer sector que no la cumple (o el final)
+    while (high - low > 1) {
+        uint32_t middle = low + (high - low) / 2;
+        if (hasSequence(log, middle, first + middle)) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    log->headSector = low;
+    log->headSequence = first + low;
+
+    // Si el anillo dio la vuelta, los sectores siguientes tienen las secuencias anteriores
+    if (low == last) {
+        log->usedSectors = log->sectorCount;
+    } else if (hasSequence(log, low + 1, log->headSequence + 1 - log->sectorCount)) {
+        log->usedSectors = log->sectorCount;
+    } else if (low + 2 <= last && hasSequence(log, low + 2, log->headSequence + 2 - log->sectorCount)) {
+        log->usedSectors = log->sectorCount - 1;  // El siguiente se estaba reciclando
+    } else {
+        log->usedSectors = low + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Ubica la primera página libre del sector en escritura.
+ */
+static void findWriteOffset(tipLog_t* log) {
+    uint32_t pages = log->sectorSize / TIP_LOG_PAGE_SIZE;
+    uint32_t low = 0;  // La cabecera siempre está programada
+    uint32_t high = pages;
+
+    while (high - low > 1) {
+        uint32_t middle = low + (high - low) / 2;
+        if (pageProgrammed(log, middle)) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+
+    // Una página cortada puede haber dejado restos después de su primer registro
+    while (high < pages && !pageBlank(log, high)) {
+        high++;
+    }
+    log->writeOffset = high * TIP_LOG_PAGE_SIZE;
+}
+
+/**
+ * @brief Decodifica un registro del dispositivo.
+ *
+ * @return 1 si es válido, 0 si está borrado, -1 si está corrupto.
+ */
+static int decodeRecord(const uint8_t* bytes, tipLogRecord_t* record) {
+    if (isErased(bytes, TIP_LOG_RECORD_SIZE)) {
+        return 0;
+    }
+    if (getU32(&bytes[CRC_OFFSET]) != crc32(bytes, CRC_OFFSET)) {
+        return -1;
+    }
+    record->type = bytes[0];
+    record->timestamp = getU32(&bytes[4]);
+    record->value = (int32_t)getU32(&bytes[8]);
+    return 1;
+}
+
+/* === Public function implementation ========================================================== */
+
+int tipLogInit(tipLog_t* log, BlockDevice* device) {
+    assert(log != NULL);
+    assert(device != NULL);
+
+    memset(log, 0, sizeof(*log));
+    memset(log->page, ERASED_BYTE, sizeof(log->page));
+    memset(blankPage, ERASED_BYTE, sizeof(blankPage));
+    log->device = device;
+
+    int error = device->init();
+    if (error != 0) {
+        return error;
+    }
+    assert(TIP_LOG_RECORD_SIZE % device->get_read_size() == 0);
+    assert(TIP_LOG_PAGE_SIZE % device->get_program_size() == 0);
+    assert(device->get_erase_size() % TIP_LOG_PAGE_SIZE == 0);
+
+    log->sectorSize = (uint32_t)device->get_erase_size();
+    log->sectorCount = (uint32_t)(device->size() / device->get_erase_size());
+    assert(log->sectorCount >= 3);
+
+    if (!findHead(log)) {
+        // Dispositivo vacío o ajeno: se empieza en el sector 0
+        log->headSector = 0;
+        log->headSequence = 1;
+        log->usedSectors = 1;
+        log->writeOffset = TIP_LOG_PAGE_SIZE;
+        return openSector(log, 0, log->headSequence);
+    }
+    findWriteOffset(log);
+    return 0;
+}
+
+int tipLogAppend(tipLog_t* log, const tipLogRecord_t* record) {
+    assert(log != NULL && log->device != NULL);
+    assert(record != NULL);
+    assert(record->type != ERASED_BYTE);
+
+    uint8_t* bytes = &log->page[log->pageFill];
+    bytes[0] = record->type;
+    bytes[1] = 0;
+    bytes[2] = 0;
+    bytes[3] = 0;
+    putU32(&bytes[4], record->timestamp);
+    putU32(&bytes[8], (uint32_t)record->value);
+    putU32(&bytes[CRC_OFFSET], crc32(bytes, CRC_OFFSET));
+    log->pageFill += TIP_LOG_RECORD_SIZE;
+    log->stats.appended++;
+
+    return log->pageFill == TIP_LOG_PAGE_SIZE ? writePage(log) : 0;
+}
+
+int tipLogFlush(tipLog_t* log) {
+    assert(log != NULL && log->device != NULL);
+
+    return log->pageFill > 0 ? writePage(log) : 0;
+}
+
+void tipLogRewind(const tipLog_t* log, tipLogCursor_t* cursor) {
+    tipLogRewindRecent(log, cursor, log->usedSectors);
+}
+
+void tipLogRewindRecent(const tipLog_t* log, tipLogCursor_t* cursor, uint32_t sectors) {
+    assert(log != NULL && cursor != NULL);
+
+    if (sectors == 0) {
+        sectors = 1;
+    }
+    if (sectors > log->usedSectors) {
+        sectors = log->usedSectors;
+    }
+    cursor->sector = (log->headSector + log->sectorCount - (sectors - 1)) % log->sectorCount;
+    cursor->sectorsLeft = sectors - 1;
+    cursor->offset = TIP_LOG_PAGE_SIZE;
+}
+
+bool tipLogNext(tipLog_t* log, tipLogCursor_t* cursor, tipLogRecord_t* record) {
+    assert(log != NULL && cursor != NULL && record != NULL);
+
+    while (true) {
+        bool atHead = cursor->sectorsLeft == 0;
+
+        if (atHead && cursor->offset >= log->writeOffset) {
+            // Registros aún en la página en armado
+            uint32_t index = cursor->offset - log->writeOffset;
+            if (index >= log->pageFill) {
+                return false;
+            }
+            cursor->offset += TIP_LOG_RECORD_SIZE;
+            return decodeRecord(&log->page[index], record) == 1;
+        }
+        if (cursor->offset >= log->sectorSize) {
+            cursor->sector = (cursor->sector + 1) % log->sectorCount;
+            cursor->sectorsLeft--;
+            cursor->offset = TIP_LOG_PAGE_SIZE;
+            continue;
+        }
+
+        uint8_t bytes[TIP_LOG_RECORD_SIZE];
+        if (log->device->read(bytes, sectorAddress(log, cursor->sector) + cursor->offset, sizeof(bytes)) != 0) {
+            return false;
+        }
+        switch (decodeRecord(bytes, record)) {
+        case 1:
+            cursor->offset += TIP_LOG_RECORD_SIZE;
+            return true;
+        case 0:
+            // Resto de una página forzada con tipLogFlush(): se salta a la siguiente
+            cursor->offset = (cursor->offset / TIP_LOG_PAGE_SIZE + 1) * TIP_LOG_PAGE_SIZE;
+            break;
+        default:
+            log->stats.corruptRecords++;
+            cursor->offset += TIP_LOG_RECORD_SIZE;
+            break;
+        }
+    }
+}
+
+void tipLogGetStats(const tipLog_t* log, tipLogStats_t* stats) {
+    assert(log != NULL && stats != NULL);
+
+    *stats = log->stats;
+}
+
+/* === End of documentation ==================================================================== */
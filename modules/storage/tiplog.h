@@ -0,0 +1,182 @@
+/*
+ * Nombre del archivo: tiplog.h
+ * Descripción: Registro persistente de ticks en flash, circular y con recuperación tras cortes.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef TIPLOG_H
+#define TIPLOG_H
+
+/** @file
+ ** @brief Registro persistente de ticks y totales sobre un BlockDevice.
+ **
+ ** El dispositivo se usa como un anillo de sectores (unidades de borrado)
+ ** escritos en orden. Cada sector comienza con una página de cabecera con un
+ ** número de secuencia creciente, y el resto son páginas de registros de
+ ** TIP_LOG_RECORD_SIZE bytes con CRC-32. Los registros se acumulan en RAM y
+ ** se programan de a una página completa; tipLogFlush() fuerza la página en
+ ** curso. Al llenarse el anillo se borra el sector más antiguo, de modo que
+ ** todos los sectores se borran la misma cantidad de veces (nivelación de
+ ** desgaste) y nunca se reprograma una página ya escrita.
+ **
+ ** Tras un corte de energía tipLogInit() ubica el sector en escritura con una
+ ** búsqueda binaria sobre las cabeceras (O(log sectores) lecturas) y la
+ ** primera página libre con otra sobre las páginas de ese sector. Las páginas
+ ** cortadas a medias se descartan por CRC.
+ **
+ ** El dispositivo debe leer de a TIP_LOG_RECORD_SIZE bytes o menos; para una
+ ** tarjeta SD conviene envolverla en un BufferedBlockDevice.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include "mbed.h"
+#include "BlockDevice.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef TIP_LOG_PAGE_SIZE
+#define TIP_LOG_PAGE_SIZE 256  ///< Bytes programados por escritura (múltiplo de la unidad de programación)
+#endif
+
+#define TIP_LOG_RECORD_SIZE 16  ///< Bytes de un registro en el dispositivo
+#define TIP_LOG_MAGIC 0x31474C54UL  ///< "TLG1" en la cabecera de cada sector
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Tipos de registro.
+ */
+typedef enum {
+    TIP_LOG_TIP = 1,  ///< Un tick; value = ticks acumulados desde el último reporte
+    TIP_LOG_TOTAL = 2,  ///< Reporte periódico; value = lluvia en décimas de mm
+} tipLogType_t;
+
+/**
+ * @brief Registro tal como lo ve la aplicación.
+ */
+typedef struct {
+    uint8_t type;  ///< tipLogType_t
+    uint32_t timestamp;  ///< Segundos desde la época
+    int32_t value;  ///< Valor según el tipo
+} tipLogRecord_t;
+
+/**
+ * @brief Contadores del registro.
+ */
+typedef struct {
+    uint32_t appended;  ///< Registros agregados
+    uint32_t pagesWritten;  ///< Páginas programadas
+    uint32_t sectorsErased;  ///< Sectores borrados
+    uint32_t recoveryReads;  ///< Lecturas hechas por la última recuperación
+    uint32_t corruptRecords;  ///< Registros con CRC inválido encontrados al leer
+} tipLogStats_t;
+
+/**
+ * @brief Estado del registro.
+ */
+typedef struct {
+    BlockDevice* device;
+    uint32_t sectorSize;  ///< Bytes por sector
+    uint32_t sectorCount;  ///< Sectores del anillo
+    uint32_t headSector;  ///< Sector en escritura
+    uint32_t headSequence;  ///< Secuencia del sector en escritura
+    uint32_t usedSectors;  ///< Sectores con datos, contando el de escritura
+    uint32_t writeOffset;  ///< Desplazamiento de la próxima página dentro del sector
+    uint32_t pageFill;  ///< Bytes ocupados de page
+    uint8_t page[TIP_LOG_PAGE_SIZE];  ///< Página en armado
+    tipLogStats_t stats;
+} tipLog_t;
+
+/**
+ * @brief Posición de lectura, del registro más antiguo al más nuevo.
+ */
+typedef struct {
+    uint32_t sector;  ///< Sector en lectura
+    uint32_t sectorsLeft;  ///< Sectores por leer después de sector
+    uint32_t offset;  ///< Desplazamiento dentro del sector
+} tipLogCursor_t;
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Abre el registro, recuperando la posición de escritura o formateando un dispositivo vacío.
+ *
+ * @param log Estado del registro.
+ * @param device Dispositivo ya construido; se inicializa aquí.
+ * @return 0 o el código de error del dispositivo.
+ */
+int tipLogInit(tipLog_t* log, BlockDevice* device);
+
+/**
+ * @brief Agrega un registro. Programa una página cuando se completa.
+ *
+ * @return 0 o el código de error del dispositivo.
+ */
+int tipLogAppend(tipLog_t* log, const tipLogRecord_t* record);
+
+/**
+ * @brief Programa la página en curso aunque no esté completa.
+ *
+ * El resto de la página queda sin uso; el próximo registro empieza en una página nueva.
+ *
+ * @return 0 o el código de error del dispositivo.
+ */
+int tipLogFlush(tipLog_t* log);
+
+/**
+ * @brief Ubica un cursor en el registro más antiguo.
+ */
+void tipLogRewind(const tipLog_t* log, tipLogCursor_t* cursor);
+
+/**
+ * @brief Ubica un cursor al comienzo de los últimos sectors sectores (acotado, para la recuperación).
+ */
+void tipLogRewindRecent(const tipLog_t* log, tipLogCursor_t* cursor, uint32_t sectors);
+
+/**
+ * @brief Lee el siguiente registro válido, incluidos los aún no programados.
+ *
+ * @return true si entregó un registro, false al final del registro.
+ */
+bool tipLogNext(tipLog_t* log, tipLogCursor_t* cursor, tipLogRecord_t* record);
+
+/**
+ * @brief Copia los contadores del registro.
+ */
+void tipLogGetStats(const tipLog_t* log, tipLogStats_t* stats);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIPLOG_H */
@@ -0,0 +1,257 @@
+/*
+ * Nombre del archivo: telemetry.cpp
+ * Descripción: Protocolo de telemetría en tramas COBS con secuencia y CRC-32.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Implementación del armado y la decodificación de tramas.
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <assert.h>
+#include <string.h>
+
+#include "crc32.h"
+#include "telemetry.h"
+
+/* === Private function implementation ========================================================= */
+
+static void putU32(uint8_t* data, uint32_t value) {
+    data[0] = (uint8_t)value;
+    data[1] = (uint8_t)(value >> 8);
+    data[2] = (uint8_t)(value >> 16);
+    data[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t getU32(const uint8_t* data) {
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+/**
+ * @brief Comienza una trama vacía con la secuencia actual.
+ */
+static void startFrame(telemetryFramer_t* framer) {
+    framer->raw[0] = TELEMETRY_VERSION;
+    putU32(&framer->raw[1], framer->sequence);
+    framer->length = TELEMETRY_HEADER_SIZE;
+    framer->messages = 0;
+    tipEncoderInit(&framer->encoder);
+}
+
+/**
+ * @brief Codifica con COBS: ningún byte de la salida es 0.
+ *
+ * @return Bytes escritos (a lo sumo length + length / 254 + 1).
+ */
+static size_t cobsEncode(const uint8_t* data, size_t length, uint8_t* out) {
+    size_t code = 0;  // Posición del byte de código del bloque en curso
+    size_t written = 1;
+    uint8_t run = 1;
+
+    for (size_t i = 0; i < length; i++) {
+        if (data[i] != 0) {
+            out[written++] = data[i];
+            run++;
+        }
+        if (data[i] == 0 || run == 0xFF) {
+            out[code] = run;
+            code = written++;
+            run = 1;
+        }
+    }
+    out[code] = run;
+    return written;
+}
+
+/**
+ * @brief Decodifica COBS sobre el mismo buffer.
+ *
+ * @return Bytes decodificados, o 0 si la codificación es inválida.
+ */
+static size_t cobsDecode(uint8_t* data, size_t length) {
+    size_t read = 0;
+    size_t written = 0;
+
+    while (read < length) {
+        uint8_t code = data[read++];
+        if (code == 0 || read + code - 1 > length) {
+            return 0;
+        }
+        for (uint8_t i = 1; i < code; i++) {
+            data[written++] = data[read++];
+        }
+        if (code < 0xFF && read < length) {
+            data[written++] = 0;
+        }
+    }
+    return written;
+}
+
+/**
+ * @brief Valida una trama completa y entrega sus mensajes.
+ */
+static void deliverFrame(telemetryDecoder_t* decoder, telemetryHandler_t handler, void* context) {
+    size_t length = cobsDecode(decoder->buffer, decoder->length);
+    if (length < 1 + TELEMETRY_CRC_SIZE ||
+        crc32(decoder->buffer, length - TELEMETRY_CRC_SIZE) != getU32(&decoder->buffer[length - TELEMETRY_CRC_SIZE])) {
+        decoder->stats.crcErrors++;
+        return;
+    }
+    if (decoder->buffer[0] == TELEMETRY_TEXT) {
+        decoder->stats.texts++;
+        if (decoder->textHandler != NULL) {
+            decoder->textHandler(decoder->textContext, (const char*)&decoder->buffer[1],
+                                 length - 1 - TELEMETRY_CRC_SIZE);
+        }
+        return;
+    }
+    if (length < TELEMETRY_HEADER_SIZE + TELEMETRY_CRC_SIZE || decoder->buffer[0] != TELEMETRY_VERSION) {
+        decoder->stats.crcErrors++;
+        return;
+    }
+
+    uint32_t sequence = getU32(&decoder->buffer[1]);
+    if (decoder->synced && sequence != decoder->nextSequence) {
+        if (sequence == 0 || sequence - decoder->nextSequence >= 0x80000000UL) {
+            decoder->stats.restarts++;
+        } else {
+            decoder->stats.lostFrames += sequence - decoder->nextSequence;
+        }
+    }
+    decoder->synced = true;
+    decoder->nextSequence = sequence + 1;
+    decoder->stats.frames++;
+
+    tipDecoder_t messages;
+    tipDecoderInit(&messages);
+    for (size_t i = TELEMETRY_HEADER_SIZE; i < length - TELEMETRY_CRC_SIZE; i++) {
+        tipCodecItem_t message;
+        if (tipDecoderPush(&messages, decoder->buffer[i], &message)) {
+            decoder->stats.messages++;
+            handler(context, sequence, &message);
+        }
+    }
+}
+
+/* === Public function implementation ========================================================== */
+
+void telemetryFramerInit(telemetryFramer_t* framer) {
+    assert(framer != NULL);
+
+    framer->sequence = 0;
+    startFrame(framer);
+}
+
+bool telemetryFramerHasRoom(const telemetryFramer_t* framer) {
+    assert(framer != NULL);
+
+    return framer->length + TIP_CODEC_ITEM_MAX <= TELEMETRY_HEADER_SIZE + TELEMETRY_PAYLOAD_MAX;
+}
+
+bool telemetryFramerIsEmpty(const telemetryFramer_t* framer) {
+    assert(framer != NULL);
+
+    return framer->messages == 0;
+}
+
+void telemetryFramerAddTip(telemetryFramer_t* framer, uint64_t timestamp) {
+    assert(telemetryFramerHasRoom(framer));
+
+    framer->length += tipEncodeTip(&framer->encoder, timestamp, &framer->raw[framer->length]);
+    framer->messages++;
+}
+
+void telemetryFramerAddMark(telemetryFramer_t* framer, uint8_t type, uint64_t timestamp, int32_t value) {
+    assert(telemetryFramerHasRoom(framer));
+
+    framer->length += tipEncodeMark(&framer->encoder, type, timestamp, value, &framer->raw[framer->length]);
+    framer->messages++;
+}
+
+size_t telemetryFramerFinish(telemetryFramer_t* framer, uint8_t* out) {
+    assert(framer != NULL);
+    assert(out != NULL);
+
+    putU32(&framer->raw[framer->length], crc32(framer->raw, framer->length));
+    size_t length = cobsEncode(framer->raw, framer->length + TELEMETRY_CRC_SIZE, out);
+    out[length++] = 0;
+
+    framer->sequence++;
+    startFrame(framer);
+    return length;
+}
+
+size_t telemetryFrameText(const char* text, size_t length, uint8_t* out) {
+    assert(text != NULL || length == 0);
+    assert(length <= TELEMETRY_TEXT_MAX);
+    assert(out != NULL);
+
+    uint8_t raw[TELEMETRY_RAW_MAX];
+    raw[0] = TELEMETRY_TEXT;
+    memcpy(&raw[1], text, length);
+    putU32(&raw[1 + length], crc32(raw, 1 + length));
+    size_t written = cobsEncode(raw, 1 + length + TELEMETRY_CRC_SIZE, out);
+    out[written++] = 0;
+    return written;
+}
+
+void telemetryDecoderInit(telemetryDecoder_t* decoder) {
+    assert(decoder != NULL);
+
+    memset(decoder, 0, sizeof(*decoder));
+}
+
+void telemetryDecoderSetTextHandler(telemetryDecoder_t* decoder, telemetryTextHandler_t handler, void* context) {
+    assert(decoder != NULL);
+
+    decoder->textHandler = handler;
+    decoder->textContext = context;
+}
+
+void telemetryDecoderPush(telemetryDecoder_t* decoder, const uint8_t* data, size_t length,
+                          telemetryHandler_t handler, void* context) {
+    assert(decoder != NULL);
+    assert(data != NULL || length == 0);
+    assert(handler != NULL);
+
+    for (size_t i = 0; i < length; i++) {
+        if (data[i] != 0) {
+            if (decoder->length < sizeof(decoder->buffer)) {
+                decoder->buffer[decoder->length++] = data[i];
+            } else {
+                decoder->overflow = true;
+            }
+            continue;
+        }
+
+        // Delimitador: fin de trama (dos seguidos no cuentan como error)
+        if (decoder->overflow) {
+            decoder->stats.crcErrors++;
+        } else if (decoder->length > 0) {
+            deliverFrame(decoder, handler, context);
+        }
+        decoder->length = 0;
+        decoder->overflow = false;
+    }
+}
+
+/* === End of documentation ==================================================================== */
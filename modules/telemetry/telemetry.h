@@ -0,0 +1,228 @@
+/*
+ * Nombre del archivo: telemetry.h
+ * Descripción: Protocolo de telemetría en tramas COBS con secuencia y CRC-32.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+/** @file
+ ** @brief Protocolo de telemetría en tramas.
+ **
+ ** Cada trama agrupa varios mensajes (ticks, totales del período y estado)
+ ** y viaja codificada con COBS y terminada en un byte 0, de modo que el
+ ** receptor se resincroniza en el siguiente 0 tras cualquier error. Antes
+ ** de COBS la trama es:
+ **
+ **   versión (1) | secuencia (4, LE) | mensajes | CRC-32 (4, LE)
+ **
+ ** Los mensajes son un flujo de modules/codec que comienza de nuevo en cada
+ ** trama: el primer tick de la trama lleva su instante completo y los demás
+ ** la diferencia de diferencias; totales y estado son marcas cuyo tipo es el
+ ** tipo de mensaje. La secuencia crece de a uno por trama desde el arranque,
+ ** así que el receptor detecta tramas perdidas y reinicios del equipo.
+ **
+ ** Las líneas de texto (las respuestas a los comandos) viajan en tramas
+ ** propias, con el mismo COBS y el mismo delimitador:
+ **
+ **   TELEMETRY_TEXT (1) | texto | CRC-32 (4, LE)
+ **
+ ** No llevan secuencia, así que no alteran la cuenta de tramas perdidas; el
+ ** decodificador las entrega a la función de telemetryDecoderSetTextHandler()
+ ** o, sin ella, solo las cuenta.
+ **
+ ** El armado y la decodificación son código puro, sin periféricos ni
+ ** memoria dinámica: el firmware arma tramas y el PC usa el mismo
+ ** decodificador.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tipcodec.h"
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#define TELEMETRY_VERSION 1  ///< Versión del formato de trama
+#define TELEMETRY_HEADER_SIZE 5  ///< Versión y secuencia
+#define TELEMETRY_CRC_SIZE 4  ///< CRC-32 al final de la trama
+#ifndef TELEMETRY_PAYLOAD_MAX
+#define TELEMETRY_PAYLOAD_MAX 96  ///< Bytes de mensajes por trama (máximo del lote)
+#endif
+#define TELEMETRY_RAW_MAX (TELEMETRY_HEADER_SIZE + TELEMETRY_PAYLOAD_MAX + TELEMETRY_CRC_SIZE)
+#define TELEMETRY_FRAME_MAX (TELEMETRY_RAW_MAX + TELEMETRY_RAW_MAX / 254 + 2)  ///< Con COBS y delimitador
+#define TELEMETRY_TEXT 0x54  ///< Primer byte de una trama de texto ('T'), en lugar de la versión
+#define TELEMETRY_TEXT_MAX (TELEMETRY_RAW_MAX - 1 - TELEMETRY_CRC_SIZE)  ///< Largo máximo del texto de una trama
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Armado de una trama.
+ */
+typedef struct {
+    uint8_t raw[TELEMETRY_RAW_MAX];  ///< Trama sin codificar
+    size_t length;  ///< Bytes usados de raw
+    uint32_t sequence;  ///< Secuencia de la trama en armado
+    uint32_t messages;  ///< Mensajes en la trama en armado
+    tipEncoder_t encoder;  ///< Flujo de la trama en armado
+} telemetryFramer_t;
+
+/**
+ * @brief Contadores del decodificador.
+ */
+typedef struct {
+    uint32_t frames;  ///< Tramas válidas
+    uint32_t messages;  ///< Mensajes entregados
+    uint32_t crcErrors;  ///< Tramas descartadas por CRC, versión o largo
+    uint32_t lostFrames;  ///< Tramas que faltan según la secuencia
+    uint32_t restarts;  ///< Secuencias reiniciadas (reinicio del equipo)
+    uint32_t texts;  ///< Tramas de texto válidas
+} telemetryStats_t;
+
+/**
+ * @brief Función que recibe cada mensaje decodificado.
+ *
+ * @param context Puntero entregado a telemetryDecoderPush().
+ * @param sequence Secuencia de la trama que lo contenía.
+ * @param message Mensaje (tick o marca, ver tipCodecItem_t).
+ */
+typedef void (*telemetryHandler_t)(void* context, uint32_t sequence, const tipCodecItem_t* message);
+
+/**
+ * @brief Función que recibe el texto de cada trama de texto válida.
+ *
+ * @param context Puntero entregado a telemetryDecoderSetTextHandler().
+ * @param text Texto de la trama, sin terminador.
+ * @param length Largo del texto.
+ */
+typedef void (*telemetryTextHandler_t)(void* context, const char* text, size_t length);
+
+/**
+ * @brief Decodificador de la línea.
+ */
+typedef struct {
+    uint8_t buffer[TELEMETRY_FRAME_MAX];  ///< Trama recibida hasta el delimitador
+    size_t length;
+    bool overflow;  ///< La trama en curso no cabe: se descarta al llegar el delimitador
+    bool synced;  ///< Ya se recibió una trama válida
+    uint32_t nextSequence;  ///< Secuencia esperada
+    telemetryTextHandler_t textHandler;  ///< Destino de las tramas de texto (NULL = solo se cuentan)
+    void* textContext;
+    telemetryStats_t stats;
+} telemetryDecoder_t;
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Prepara la primera trama, con secuencia 0.
+ */
+void telemetryFramerInit(telemetryFramer_t* framer);
+
+/**
+ * @brief Indica si entra otro mensaje de hasta TIP_CODEC_ITEM_MAX bytes.
+ */
+bool telemetryFramerHasRoom(const telemetryFramer_t* framer);
+
+/**
+ * @brief Indica si la trama en armado no tiene mensajes.
+ */
+bool telemetryFramerIsEmpty(const telemetryFramer_t* framer);
+
+/**
+ * @brief Agrega un tick a la trama.
+ *
+ * @param framer Trama en armado, con lugar (telemetryFramerHasRoom()).
+ * @param timestamp Instante del tick en ms desde la época.
+ */
+void telemetryFramerAddTip(telemetryFramer_t* framer, uint64_t timestamp);
+
+/**
+ * @brief Agrega un total, un aviso o un dato de estado a la trama.
+ *
+ * @param framer Trama en armado, con lugar (telemetryFramerHasRoom()).
+ * @param type Tipo de mensaje (0 a 127, distinto de los ticks).
+ * @param timestamp Instante en ms desde la época.
+ * @param value Valor del mensaje.
+ */
+void telemetryFramerAddMark(telemetryFramer_t* framer, uint8_t type, uint64_t timestamp, int32_t value);
+
+/**
+ * @brief Cierra la trama, la codifica con COBS y prepara la siguiente.
+ *
+ * @param framer Trama en armado.
+ * @param out Destino de al menos TELEMETRY_FRAME_MAX bytes.
+ * @return Bytes escritos, incluido el delimitador final.
+ */
+size_t telemetryFramerFinish(telemetryFramer_t* framer, uint8_t* out);
+
+/**
+ * @brief Arma una trama de texto; no usa ni altera la secuencia de las tramas de datos.
+ *
+ * @param text Texto a enviar.
+ * @param length Largo del texto, hasta TELEMETRY_TEXT_MAX.
+ * @param out Destino de al menos TELEMETRY_FRAME_MAX bytes.
+ * @return Bytes escritos, incluido el delimitador final.
+ */
+size_t telemetryFrameText(const char* text, size_t length, uint8_t* out);
+
+/**
+ * @brief Inicializa el decodificador.
+ */
+void telemetryDecoderInit(telemetryDecoder_t* decoder);
+
+/**
+ * @brief Registra la función que recibe las tramas de texto (NULL la quita).
+ *
+ * @param decoder Estado del decodificador.
+ * @param handler Función para cada trama de texto.
+ * @param context Puntero que se pasa a handler.
+ */
+void telemetryDecoderSetTextHandler(telemetryDecoder_t* decoder, telemetryTextHandler_t handler, void* context);
+
+/**
+ * @brief Entrega bytes recibidos; por cada trama de datos válida completa llama a handler con cada mensaje.
+ *
+ * @param decoder Estado del decodificador.
+ * @param data Bytes recibidos.
+ * @param length Cantidad de bytes.
+ * @param handler Función para cada mensaje.
+ * @param context Puntero que se pasa a handler.
+ */
+void telemetryDecoderPush(telemetryDecoder_t* decoder, const uint8_t* data, size_t length,
+                          telemetryHandler_t handler, void* context);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TELEMETRY_H */
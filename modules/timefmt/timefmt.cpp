@@ -0,0 +1,213 @@
+/*
+ * Nombre del archivo: timefmt.cpp
+ * Descripción: Formateador incremental de fechas y horas sin libc.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Implementación del formateador incremental de marcas de tiempo.
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <assert.h>
+
+#include "timefmt.h"
+
+/* === Macros definitions ====================================================================== */
+
+// Posición de cada campo en "YYYY-MM-DD HH:MM:SS"
+#define YEAR_OFFSET 0
+#define MONTH_OFFSET 5
+#define DAY_OFFSET 8
+#define HOUR_OFFSET 11
+#define MINUTE_OFFSET 14
+#define SECOND_OFFSET 17
+
+#define DAYS_PER_ERA 146097  ///< Días de un ciclo gregoriano de 400 años
+#define EPOCH_SHIFT 719468  ///< Días entre 0000-03-01 y 1970-01-01
+
+/* === Private function implementation ========================================================= */
+
+/**
+ * @brief Escribe un valor de 0 a 99 con dos dígitos.
+ */
+static void putTwoDigits(char* text, uint8_t value) {
+    text[0] = (char)('0' + value / 10);
+    text[1] = (char)('0' + value % 10);
+}
+
+/**
+ * @brief Escribe un año de cuatro dígitos.
+ */
+static void putYear(char* text, int32_t year) {
+    uint32_t value = (uint32_t)year % 10000;
+    putTwoDigits(text, (uint8_t)(value / 100));
+    putTwoDigits(text + 2, (uint8_t)(value % 100));
+}
+
+/**
+ * @brief Reescribe los campos de la fecha que difieren de date.
+ */
+static void setDate(timeFormat_t* format, const timeCivil_t* date) {
+    if (date->year != format->date.year) {
+        putYear(&format->text[YEAR_OFFSET], date->year);
+    }
+    if (date->month != format->date.month) {
+        putTwoDigits(&format->text[MONTH_OFFSET], date->month);
+    }
+    if (date->day != format->date.day) {
+        putTwoDigits(&format->text[DAY_OFFSET], date->day);
+    }
+    format->date = *date;
+}
+
+/**
+ * @brief Reescribe los campos de la hora que difieren de los dados.
+ */
+static void setTimeOfDay(timeFormat_t* format, uint8_t hour, uint8_t minute, uint8_t second) {
+    if (hour != format->hour) {
+        putTwoDigits(&format->text[HOUR_OFFSET], hour);
+        format->hour = hour;
+    }
+    if (minute != format->minute) {
+        putTwoDigits(&format->text[MINUTE_OFFSET], minute);
+        format->minute = minute;
+    }
+    if (second != format->second) {
+        putTwoDigits(&format->text[SECOND_OFFSET], second);
+        format->second = second;
+    }
+}
+
+/* === Public function implementation ========================================================== */
+
+void timeFormatInit(timeFormat_t* format) {
+    assert(format != NULL);
+
+    static const char pattern[] = "0000-00-00 00:00:00";
+    for (size_t i = 0; i < sizeof(pattern); i++) {
+        format->text[i] = pattern[i];
+    }
+    format->seconds = 0;
+    format->dayStart = 0;
+    format->date.year = 0;
+    format->date.month = 0;
+    format->date.day = 0;
+    format->hour = 0;
+    format->minute = 0;
+    format->second = 0;
+    format->valid = false;
+}
+
+const char* timeFormatUpdate(timeFormat_t* format, uint32_t seconds) {
+    assert(format != NULL);
+
+    uint32_t local = seconds + (uint32_t)(int32_t)TIME_FORMAT_UTC_OFFSET;
+
+    if (format->valid && local >= format->seconds && local - format->seconds < 60) {
+        // Avance corto: acarreo de segundos a minutos y horas sin dividir
+        uint8_t second = (uint8_t)(format->second + (local - format->seconds));
+        uint8_t minute = format->minute;
+        uint8_t hour = format->hour;
+        if (second >= 60) {
+            second -= 60;
+            if (++minute == 60) {
+                minute = 0;
+                hour++;
+            }
+        }
+        if (hour < 24) {
+            setTimeOfDay(format, hour, minute, second);
+            format->seconds = local;
+            return format->text;
+        }
+    }
+
+    if (!format->valid || local < format->dayStart || local - format->dayStart >= SECONDS_PER_DAY) {
+        // Otro día: se recalcula la fecha completa
+        uint32_t days = local / SECONDS_PER_DAY;
+        timeCivil_t date;
+        timeCivilFromDays((int32_t)days, &date);
+        setDate(format, &date);
+        format->dayStart = days * SECONDS_PER_DAY;
+    }
+
+    uint32_t timeOfDay = local - format->dayStart;
+    setTimeOfDay(format, (uint8_t)(timeOfDay / 3600), (uint8_t)(timeOfDay / 60 % 60), (uint8_t)(timeOfDay % 60));
+    format->seconds = local;
+    format->valid = true;
+    return format->text;
+}
+
+size_t timeFormatCopy(timeFormat_t* format, uint32_t seconds, size_t length, char* text) {
+    assert(length == TIME_FORMAT_SECONDS_LENGTH || length == TIME_FORMAT_MINUTES_LENGTH);
+    assert(text != NULL);
+
+    const char* source = timeFormatUpdate(format, seconds);
+    for (size_t i = 0; i < length; i++) {
+        text[i] = source[i];
+    }
+    text[length] = '\0';
+    return length;
+}
+
+void timeCivilFromDays(int32_t days, timeCivil_t* date) {
+    assert(date != NULL);
+
+    // Años que empiezan el 1 de marzo: el 29 de febrero queda al final del año
+    int32_t z = days + EPOCH_SHIFT;
+    int32_t era = (z >= 0 ? z : z - (DAYS_PER_ERA - 1)) / DAYS_PER_ERA;
+    uint32_t dayOfEra = (uint32_t)(z - era * DAYS_PER_ERA);
+    uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    uint32_t shiftedMonth = (5 * dayOfYear + 2) / 153;
+    uint8_t month = (uint8_t)(shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9);
+
+    date->year = (int32_t)yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+    date->month = month;
+    date->day = (uint8_t)(dayOfYear - (153 * shiftedMonth + 2) / 5 + 1);
+}
+
+int32_t timeDaysFromCivil(const timeCivil_t* date) {
+    assert(date != NULL);
+    assert(date->month >= 1 && date->month <= 12);
+
+    int32_t year = date->year - (date->month <= 2 ? 1 : 0);
+    int32_t era = (year >= 0 ? year : year - 399) / 400;
+    uint32_t yearOfEra = (uint32_t)(year - era * 400);
+    uint32_t dayOfYear = (153 * (date->month > 2 ? date->month - 3u : date->month + 9u) + 2) / 5 + date->day - 1;
+    uint32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+    return era * DAYS_PER_ERA + (int32_t)dayOfEra - EPOCH_SHIFT;
+}
+
+bool timeIsLeapYear(int32_t year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+uint8_t timeDaysInMonth(int32_t year, uint8_t month) {
+    static const uint8_t days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+    assert(month >= 1 && month <= 12);
+    return (month == 2 && timeIsLeapYear(year)) ? 29 : days[month - 1];
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,154 @@
+/*
+ * Nombre del archivo: timefmt.h
+ * Descripción: Formateador incremental de fechas y horas sin libc.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef TIMEFMT_H
+#define TIMEFMT_H
+
+/** @file
+ ** @brief Formateador incremental de marcas de tiempo.
+ **
+ ** Mantiene la fecha desglosada y el texto "YYYY-MM-DD HH:MM:SS" de la última
+ ** llamada y, ante un nuevo instante, reescribe solo los dígitos de los campos
+ ** que cambiaron: un avance de pocos segundos toca dos dígitos, y la fecha se
+ ** recalcula (en O(1), sin tablas por año) solo al cruzar la medianoche. No
+ ** usa localtime(), strftime() ni stdio, y cada instancia tiene su propio
+ ** buffer, por lo que es reentrante entre instancias.
+ **
+ ** Las horas son UTC desplazadas por TIME_FORMAT_UTC_OFFSET, igual que
+ ** localtime() en Mbed, que no maneja zonas horarias.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef TIME_FORMAT_UTC_OFFSET
+#define TIME_FORMAT_UTC_OFFSET 0  ///< Desplazamiento de la hora local respecto de UTC, en segundos
+#endif
+
+#define TIME_FORMAT_SECONDS_LENGTH 19  ///< Largo de "YYYY-MM-DD HH:MM:SS" (TIME_FORMAT)
+#define TIME_FORMAT_MINUTES_LENGTH 16  ///< Largo de "YYYY-MM-DD HH:MM" (DATE_FORMAT)
+#define SECONDS_PER_DAY 86400UL  ///< Segundos de un día civil
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Fecha civil del calendario gregoriano proléptico.
+ */
+typedef struct {
+    int32_t year;  ///< Año
+    uint8_t month;  ///< Mes, 1 a 12
+    uint8_t day;  ///< Día del mes, 1 a 31
+} timeCivil_t;
+
+/**
+ * @brief Estado del formateador: último instante, campos desglosados y texto.
+ */
+typedef struct {
+    uint32_t seconds;  ///< Último instante formateado (local)
+    uint32_t dayStart;  ///< Comienzo del día de seconds
+    timeCivil_t date;  ///< Fecha de seconds
+    uint8_t hour;  ///< Hora, 0 a 23
+    uint8_t minute;  ///< Minuto, 0 a 59
+    uint8_t second;  ///< Segundo, 0 a 59
+    bool valid;  ///< Ya se formateó algún instante
+    char text[TIME_FORMAT_SECONDS_LENGTH + 1];  ///< "YYYY-MM-DD HH:MM:SS" terminado en nulo
+} timeFormat_t;
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Inicializa un formateador vacío.
+ *
+ * @param format Puntero al formateador.
+ */
+void timeFormatInit(timeFormat_t* format);
+
+/**
+ * @brief Actualiza el texto al instante dado.
+ *
+ * @param format Puntero al formateador.
+ * @param seconds Instante en segundos desde la época (UTC).
+ * @return Texto "YYYY-MM-DD HH:MM:SS"; los primeros TIME_FORMAT_MINUTES_LENGTH
+ *         caracteres son el formato DATE_FORMAT. Válido hasta la próxima llamada.
+ */
+const char* timeFormatUpdate(timeFormat_t* format, uint32_t seconds);
+
+/**
+ * @brief Copia el instante formateado con el largo pedido.
+ *
+ * @param format Puntero al formateador.
+ * @param seconds Instante en segundos desde la época (UTC).
+ * @param length TIME_FORMAT_SECONDS_LENGTH o TIME_FORMAT_MINUTES_LENGTH.
+ * @param text Buffer destino de al menos length + 1 bytes; queda terminado en nulo.
+ * @return length.
+ */
+size_t timeFormatCopy(timeFormat_t* format, uint32_t seconds, size_t length, char* text);
+
+/**
+ * @brief Convierte días desde 1970-01-01 a fecha civil.
+ *
+ * @param days Días desde la época (negativos antes de 1970).
+ * @param date Fecha de salida.
+ */
+void timeCivilFromDays(int32_t days, timeCivil_t* date);
+
+/**
+ * @brief Convierte una fecha civil a días desde 1970-01-01.
+ *
+ * @param date Fecha a convertir.
+ * @return Días desde la época.
+ */
+int32_t timeDaysFromCivil(const timeCivil_t* date);
+
+/**
+ * @brief Indica si un año es bisiesto.
+ */
+bool timeIsLeapYear(int32_t year);
+
+/**
+ * @brief Días del mes indicado.
+ *
+ * @param year Año.
+ * @param month Mes, 1 a 12.
+ */
+uint8_t timeDaysInMonth(int32_t year, uint8_t month);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIMEFMT_H */
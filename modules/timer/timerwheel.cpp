@@ -0,0 +1,211 @@
+/**
+ * @file timerwheel.c
+ * @brief Rueda de temporizadores jerárquica con arranque, cancelación y vencimiento en O(1).
+ */
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "timerwheel.h"
+
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_SPAN(level) ((tick_t)1 << (TIMER_WHEEL_BITS * (level)))  /**< Ticks por ranura del nivel */
+#define TIMER_WHEEL_RANGE ((tick_t)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))  /**< Alcance de la rueda */
+#define TIMER_WHEEL_EXPIRING TIMER_WHEEL_LEVELS  /**< Nivel ficticio de la lista en proceso */
+
+static_assert(TIMER_WHEEL_SLOTS <= 64, "el mapa de ocupación es de 64 bits");
+static_assert(TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS < 32, "el alcance debe caber en tick_t");
+
+/**
+ * @brief Encola un temporizador según la distancia a su vencimiento.
+ *
+ * La distancia se mide desde el próximo tick a procesar. Los ya vencidos van
+ * a la ranura de ese tick; los que exceden el alcance se dejan en la última
+ * ranura del nivel superior y se reubican en cada cascada.
+ */
+static void enqueue(timerWheel_t *wheel, wheelTimer_t *timer)
+{
+    tick_t base = wheel->current + 1;
+    tick_t expires = timer->expires;
+    int32_t delta = (int32_t)(expires - base);
+    uint32_t level = 0;
+
+    if (delta < 0) {
+        expires = base;
+    } else if ((tick_t)delta >= TIMER_WHEEL_RANGE) {
+        expires = base + TIMER_WHEEL_RANGE - 1;
+        level = TIMER_WHEEL_LEVELS - 1;
+    } else {
+        while (level < TIMER_WHEEL_LEVELS - 1 && (tick_t)delta >= TIMER_WHEEL_SPAN(level + 1)) {
+            level++;
+        }
+    }
+
+    uint32_t slot = (expires >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+    wheelTimer_t **head = &wheel->slots[level][slot];
+
+    timer->next = *head;
+    if (*head != NULL) {
+        (*head)->pprev = &timer->next;
+    }
+    *head = timer;
+    timer->pprev = head;
+    timer->level = (uint8_t)level;
+    timer->slot = (uint8_t)slot;
+    timer->pending = true;
+
+    wheel->occupied[level] |= (uint64_t)1 << slot;
+    wheel->count++;
+}
+
+/**
+ * @brief Quita un temporizador de su ranura.
+ */
+static void dequeue(timerWheel_t *wheel, wheelTimer_t *timer)
+{
+    *timer->pprev = timer->next;
+    if (timer->next != NULL) {
+        timer->next->pprev = timer->pprev;
+    }
+    if (timer->level != TIMER_WHEEL_EXPIRING && wheel->slots[timer->level][timer->slot] == NULL) {
+        wheel->occupied[timer->level] &= ~((uint64_t)1 << timer->slot);
+    }
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->pending = false;
+    wheel->count--;
+}
+
+/**
+ * @brief Reparte en los niveles inferiores la ranura de un nivel superior.
+ *
+ * @return Índice de la ranura repartida (0 indica que también toca el nivel siguiente).
+ */
+static uint32_t cascade(timerWheel_t *wheel, uint32_t level, tick_t tick)
+{
+    uint32_t slot = (tick >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+    wheelTimer_t *timer;
+
+    while ((timer = wheel->slots[level][slot]) != NULL) {
+        dequeue(wheel, timer);
+        enqueue(wheel, timer);
+    }
+    return slot;
+}
+
+void timerWheelInit(timerWheel_t *wheel, tick_t now)
+{
+    assert(wheel != NULL);
+
+    for (uint32_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        for (uint32_t slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+            wheel->slots[level][slot] = NULL;
+        }
+        wheel->occupied[level] = 0;
+    }
+    wheel->expiring = NULL;
+    wheel->current = now;
+    wheel->count = 0;
+}
+
+void wheelTimerInit(wheelTimer_t *timer, wheelTimerCallback_t callback, void *context)
+{
+    assert(timer != NULL);
+
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->expires = 0;
+    timer->period = 0;
+    timer->callback = callback;
+    timer->context = context;
+    timer->level = 0;
+    timer->slot = 0;
+    timer->pending = false;
+    timer->expired = false;
+}
+
+void timerWheelStart(timerWheel_t *wheel, wheelTimer_t *timer, tick_t delay, tick_t period)
+{
+    assert(wheel != NULL);
+    assert(timer != NULL);
+
+    if (timer->pending) {
+        dequeue(wheel, timer);
+    }
+    // Lo más pronto que puede vencer es el próximo tick; de ahí cuenta también el período
+    timer->expires = wheel->current + (delay != 0 ? delay : 1);
+    timer->period = period;
+    timer->expired = false;
+    enqueue(wheel, timer);
+}
+
+void timerWheelCancel(timerWheel_t *wheel, wheelTimer_t *timer)
+{
+    assert(wheel != NULL);
+    assert(timer != NULL);
+
+    if (timer->pending) {
+        dequeue(wheel, timer);
+    }
+}
+
+uint32_t timerWheelAdvance(timerWheel_t *wheel, tick_t now)
+{
+    uint32_t fired = 0;
+
+    assert(wheel != NULL);
+
+    while ((int32_t)(now - wheel->current) > 0) {
+        if (wheel->count == 0) {
+            wheel->current = now;
+            break;
+        }
+
+        // Salta las ranuras vacías del nivel 0 hasta la próxima ocupada o la próxima cascada
+        uint32_t index = (wheel->current + 1) & TIMER_WHEEL_MASK;
+        if (index != 0) {
+            uint64_t ahead = wheel->occupied[0] >> index;
+            tick_t skip = ahead != 0 ? (tick_t)__builtin_ctzll(ahead) : TIMER_WHEEL_SLOTS - index;
+            if (skip >= now - wheel->current) {
+                wheel->current = now;
+                break;
+            }
+            wheel->current += skip;
+        }
+
+        tick_t tick = wheel->current + 1;
+        index = tick & TIMER_WHEEL_MASK;
+        if (index == 0) {
+            for (uint32_t level = 1; level < TIMER_WHEEL_LEVELS && cascade(wheel, level, tick) == 0; level++) {
+            }
+        }
+
+        // Se separa la ranura antes de procesar: lo que se encole ahora ya cuenta desde tick
+        wheel->expiring = wheel->slots[0][index];
+        wheel->slots[0][index] = NULL;
+        wheel->occupied[0] &= ~((uint64_t)1 << index);
+        if (wheel->expiring != NULL) {
+            wheel->expiring->pprev = &wheel->expiring;
+        }
+        for (wheelTimer_t *timer = wheel->expiring; timer != NULL; timer = timer->next) {
+            timer->level = TIMER_WHEEL_EXPIRING;
+        }
+        wheel->current = tick;
+
+        wheelTimer_t *timer;
+        while ((timer = wheel->expiring) != NULL) {
+            dequeue(wheel, timer);
+            timer->expired = true;
+            if (timer->period != 0) {
+                timer->expires += timer->period;
+                enqueue(wheel, timer);
+            }
+            fired++;
+            if (timer->callback != NULL) {
+                timer->callback(timer, timer->context);
+            }
+        }
+    }
+
+    return fired;
+}
@@ -0,0 +1,99 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <stdint.h>   /**< Para incluir los tipos uint32_t */
+#include <stdbool.h>  /**< Para incluir los tipos bool (booleanos) */
+
+#define TIMER_WHEEL_LEVELS 4  /**< Niveles de la rueda jerárquica */
+#define TIMER_WHEEL_BITS 6    /**< Bits de tick que resuelve cada nivel */
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)  /**< Ranuras por nivel */
+
+typedef uint32_t tick_t;  /**< Definición de tipo para los ticks */
+typedef bool bool_t;      /**< Definición de tipo para los valores booleanos */
+
+typedef struct wheelTimer wheelTimer_t;
+
+/**
+ * @brief Función invocada al vencer un temporizador.
+ *
+ * Puede arrancar o cancelar cualquier temporizador, incluido el propio.
+ */
+typedef void (*wheelTimerCallback_t)(wheelTimer_t *timer, void *context);
+
+/**
+ * @brief Temporizador de la rueda. Todo su estado es propio: nada se comparte entre instancias.
+ */
+struct wheelTimer {
+    wheelTimer_t *next;              /**< Siguiente de la ranura */
+    wheelTimer_t **pprev;            /**< Enlace que apunta a este nodo (baja en O(1)) */
+    tick_t expires;                  /**< Tick absoluto de vencimiento */
+    tick_t period;                   /**< Periodo en ticks (0 = una sola vez) */
+    wheelTimerCallback_t callback;   /**< Función de vencimiento (NULL = solo bandera) */
+    void *context;                   /**< Argumento de la función de vencimiento */
+    uint8_t level;                   /**< Nivel donde está encolado */
+    uint8_t slot;                    /**< Ranura donde está encolado */
+    bool_t pending;                  /**< Está en la rueda */
+    bool_t expired;                  /**< Venció desde el último arranque */
+};
+
+/**
+ * @brief Rueda de temporizadores jerárquica.
+ *
+ * Cada nivel tiene TIMER_WHEEL_SLOTS ranuras; el nivel n agrupa los
+ * vencimientos por bloques de TIMER_WHEEL_SLOTS^n ticks y se reparte en el
+ * nivel inferior (cascada) cuando el tiempo llega al bloque. Los mapas de
+ * ocupación permiten saltar de una vez los tramos sin temporizadores.
+ */
+typedef struct {
+    wheelTimer_t *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];  /**< Listas por ranura */
+    wheelTimer_t *expiring;                 /**< Ranura del tick en proceso */
+    uint64_t occupied[TIMER_WHEEL_LEVELS];  /**< Bit n = ranura n no vacía */
+    tick_t current;                         /**< Último tick procesado */
+    uint32_t count;                         /**< Temporizadores en la rueda */
+} timerWheel_t;
+
+/**
+ * @brief Inicializa una rueda vacía.
+ *
+ * @param wheel Puntero a la rueda.
+ * @param now Tick actual.
+ */
+void timerWheelInit(timerWheel_t *wheel, tick_t now);
+
+/**
+ * @brief Inicializa un temporizador detenido.
+ *
+ * @param timer Puntero al temporizador.
+ * @param callback Función de vencimiento, o NULL para usar solo la bandera expired.
+ * @param context Argumento de la función de vencimiento.
+ */
+void wheelTimerInit(wheelTimer_t *timer, wheelTimerCallback_t callback, void *context);
+
+/**
+ * @brief Arranca (o rearranca) un temporizador en O(1).
+ *
+ * @param wheel Puntero a la rueda.
+ * @param timer Puntero al temporizador.
+ * @param delay Ticks hasta el vencimiento, contados desde el último tick procesado (0 = el próximo).
+ * @param period Periodo de repetición en ticks, o 0 para un solo disparo.
+ */
+void timerWheelStart(timerWheel_t *wheel, wheelTimer_t *timer, tick_t delay, tick_t period);
+
+/**
+ * @brief Detiene un temporizador en O(1). No hace nada si no está corriendo.
+ *
+ * @param wheel Puntero a la rueda.
+ * @param timer Puntero al temporizador.
+ */
+void timerWheelCancel(timerWheel_t *wheel, wheelTimer_t *timer);
+
+/**
+ * @brief Procesa los ticks hasta now y dispara los temporizadores vencidos.
+ *
+ * @param wheel Puntero a la rueda.
+ * @param now Tick actual (por ejemplo HAL_GetTick()).
+ * @return Cantidad de temporizadores vencidos.
+ */
+uint32_t timerWheelAdvance(timerWheel_t *wheel, tick_t now);
+
+#endif // TIMERWHEEL_H
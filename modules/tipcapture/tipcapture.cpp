@@ -0,0 +1,159 @@
+/*
+ * Nombre del archivo: tipcapture.cpp
+ * Descripción: Captura de ticks del pluviómetro por interrupción con cola de eventos sin bloqueo.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Implementación de la captura de ticks por interrupción.
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include "mbed.h"
+#include "stm32f4xx_hal.h"
+
+#include <assert.h>
+#include <atomic>
+
+#include "tipcapture.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define TIP_CAPTURE_QUEUE_MASK (TIP_CAPTURE_QUEUE_SIZE - 1)
+
+static_assert((TIP_CAPTURE_QUEUE_SIZE & TIP_CAPTURE_QUEUE_MASK) == 0,
+              "TIP_CAPTURE_QUEUE_SIZE debe ser potencia de 2");
+
+/* === Private variable declarations =========================================================== */
+
+/*
+ * Cola circular de un productor (ISR) y un consumidor (bucle principal).
+ * Los índices avanzan libremente y se enmascaran al acceder; solo el productor
+ * escribe head y solo el consumidor escribe tail, por lo que basta con
+ * ordenar las escrituras con acquire/release.
+ */
+static tipEvent_t tipQueue[TIP_CAPTURE_QUEUE_SIZE];
+static std::atomic<uint32_t> tipHead(0);
+static std::atomic<uint32_t> tipTail(0);
+
+static tick_t debounceTicks;
+static tick_t lastEdgeTime;
+static bool_t edgeSeen = false;
+static volatile tipCaptureStats_t captureStats;
+static volatile tipCaptureNotify_t notifyTip = NULL;
+
+/* === Private function declarations =========================================================== */
+
+static void onRisingEdge(void);
+static void onFallingEdge(void);
+
+/* === Private function implementation ========================================================= */
+
+/**
+ * @brief ISR del flanco de subida del sensor.
+ */
+static void onRisingEdge() {
+    tipCaptureOnEdge(HAL_GetTick(), true);
+}
+
+/**
+ * @brief ISR del flanco de bajada del sensor.
+ */
+static void onFallingEdge() {
+    tipCaptureOnEdge(HAL_GetTick(), false);
+}
+
+/* === Public function implementation ========================================================== */
+
+void tipCaptureInit(PinName pin, tick_t debounceTime) {
+    static InterruptIn tipInput(pin, PullDown);
+
+    debounceTicks = debounceTime;
+    edgeSeen = false;
+    tipInput.rise(callback(onRisingEdge));
+    tipInput.fall(callback(onFallingEdge));
+}
+
+void tipCaptureSetNotify(tipCaptureNotify_t notify) {
+    notifyTip = notify;
+}
+
+void tipCaptureOnEdge(tick_t timestamp, bool_t rising) {
+    bool_t quiet = !edgeSeen || (tick_t)(timestamp - lastEdgeTime) >= debounceTicks;
+
+    lastEdgeTime = timestamp;
+    edgeSeen = true;
+
+    if (!rising) {
+        return;
+    }
+    if (!quiet) {
+        captureStats.bounces++;
+        return;
+    }
+
+    uint32_t head = tipHead.load(std::memory_order_relaxed);
+    uint32_t tail = tipTail.load(std::memory_order_acquire);
+
+    if (head - tail >= TIP_CAPTURE_QUEUE_SIZE) {
+        captureStats.overflows++;
+        return;
+    }
+
+    tipEvent_t* event = &tipQueue[head & TIP_CAPTURE_QUEUE_MASK];
+    event->timestamp = timestamp;
+    event->sequence = captureStats.accepted++;
+#if INSTRUMENTATION_ENABLED
+    event->edgeTime = probeNow();
+#endif
+    tipHead.store(head + 1, std::memory_order_release);
+
+    tipCaptureNotify_t notify = notifyTip;
+    if (notify != NULL) {
+        notify();
+    }
+}
+
+size_t tipCaptureDrain(tipEvent_t* events, size_t maxEvents) {
+    assert(events != NULL);
+
+    uint32_t tail = tipTail.load(std::memory_order_relaxed);
+    uint32_t head = tipHead.load(std::memory_order_acquire);
+    size_t count = 0;
+
+    while (tail != head && count < maxEvents) {
+        events[count++] = tipQueue[tail & TIP_CAPTURE_QUEUE_MASK];
+        tail++;
+    }
+
+    tipTail.store(tail, std::memory_order_release);
+    return count;
+}
+
+void tipCaptureGetStats(tipCaptureStats_t* stats) {
+    assert(stats != NULL);
+
+    stats->accepted = captureStats.accepted;
+    stats->bounces = captureStats.bounces;
+    stats->overflows = captureStats.overflows;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,142 @@
+/*
+ * Nombre del archivo: tipcapture.h
+ * Descripción: Captura de ticks del pluviómetro por interrupción con cola de eventos sin bloqueo.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef TIPCAPTURE_H
+#define TIPCAPTURE_H
+
+/** @file
+ ** @brief Captura de ticks por interrupción.
+ **
+ ** La ISR del flanco estampa el tiempo de cada tick, aplica el antirrebote
+ ** comparando marcas de tiempo y deposita el evento en una cola circular
+ ** de un productor y un consumidor (ISR -> bucle principal) sin bloqueos.
+ ** El bucle principal vacía la cola por lotes con tipCaptureDrain().
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include "mbed.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "delay.h" /* tick_t y bool_t */
+#include "probe.h"
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#define TIP_CAPTURE_QUEUE_SIZE 32  ///< Capacidad de la cola de eventos (potencia de 2)
+#define TIP_CAPTURE_BATCH_SIZE 8   ///< Eventos que el bucle principal procesa por pasada
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Evento de tick aceptado por el antirrebote.
+ */
+typedef struct {
+    tick_t timestamp;   ///< Instante del flanco en ms (HAL_GetTick)
+    uint32_t sequence;  ///< Número correlativo del tick aceptado
+#if INSTRUMENTATION_ENABLED
+    probeTime_t edgeTime;  ///< probeNow() en la ISR, para PROBE_EDGE_TO_RECORD
+#endif
+} tipEvent_t;
+
+/**
+ * @brief Contadores de diagnóstico de la captura.
+ */
+typedef struct {
+    uint32_t accepted;   ///< Ticks aceptados y encolados
+    uint32_t bounces;    ///< Flancos descartados por el antirrebote
+    uint32_t overflows;  ///< Ticks perdidos por cola llena
+} tipCaptureStats_t;
+
+/**
+ * @brief Función invocada desde la ISR cada vez que se encola un tick.
+ */
+typedef void (*tipCaptureNotify_t)(void);
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Inicializa la captura y asocia la interrupción al pin indicado.
+ *
+ * @param pin Pin de entrada del pluviómetro.
+ * @param debounceTime Tiempo mínimo en ms sin flancos antes de aceptar un tick.
+ */
+void tipCaptureInit(PinName pin, tick_t debounceTime);
+
+/**
+ * @brief Registra la función a invocar desde la ISR al encolar un tick.
+ *
+ * Permite despertar a un bucle dirigido por eventos en lugar de sondear la
+ * cola. La función se ejecuta en contexto de interrupción.
+ *
+ * @param notify Función de aviso, o NULL para desactivar el aviso.
+ */
+void tipCaptureSetNotify(tipCaptureNotify_t notify);
+
+/**
+ * @brief Procesa un flanco del sensor. Es el cuerpo de la ISR.
+ *
+ * Un flanco de subida se acepta como tick solo si el flanco anterior (de subida
+ * o de bajada) ocurrió hace al menos el tiempo de antirrebote; así se descartan
+ * los rebotes tanto al cerrar como al abrir el contacto. Puede llamarse desde
+ * una fuente simulada de flancos para ejecutar la captura fuera del hardware.
+ *
+ * @param timestamp Instante del flanco en ms.
+ * @param rising true si el flanco es de subida.
+ */
+void tipCaptureOnEdge(tick_t timestamp, bool_t rising);
+
+/**
+ * @brief Extrae hasta maxEvents eventos de la cola, en orden de llegada.
+ *
+ * Debe llamarse desde un único consumidor (el bucle principal).
+ *
+ * @param events Arreglo destino.
+ * @param maxEvents Capacidad del arreglo destino.
+ * @return Cantidad de eventos extraídos.
+ */
+size_t tipCaptureDrain(tipEvent_t* events, size_t maxEvents);
+
+/**
+ * @brief Copia los contadores de diagnóstico de la captura.
+ *
+ * @param stats Puntero a la estructura destino.
+ */
+void tipCaptureGetStats(tipCaptureStats_t* stats);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIPCAPTURE_H */
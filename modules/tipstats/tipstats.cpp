@@ -0,0 +1,156 @@
+/*
+ * Nombre del archivo: tipstats.cpp
+ * Descripción: Estadísticas de memoria fija de los intervalos entre ticks y de los rebotes.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Implementación de las estadísticas de los intervalos entre ticks.
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <assert.h>
+#include <string.h>
+
+#include "tipstats.h"
+
+/* === Private function implementation ========================================================= */
+
+/**
+ * @brief Pasa el monitor a la ventana de un instante; un instante anterior queda en la ventana en curso.
+ */
+static void advanceWindow(tipMonitor_t* monitor, uint32_t now) {
+    uint32_t window = now / TIP_STATS_WINDOW_SECONDS;
+
+    if (window <= monitor->window) {
+        return;
+    }
+    monitor->previous = window == monitor->window + 1 ? monitor->current : 0;
+    monitor->current = 0;
+    monitor->window = window;
+    monitor->tips = 0;
+    monitor->shortIntervals = 0;
+    monitor->rejections = 0;
+}
+
+/**
+ * @brief Evalúa las condiciones de la ventana en curso y devuelve las banderas nuevas.
+ */
+static uint8_t raiseFlags(tipMonitor_t* monitor) {
+    uint8_t flags = 0;
+
+    if (monitor->rejections > (uint64_t)monitor->tips * TIP_STATS_BOUNCES_PER_TIP + TIP_STATS_BOUNCE_SLACK) {
+        flags |= TIP_ANOMALY_BOUNCE_FLOOD;
+    }
+    if (monitor->shortIntervals >= TIP_STATS_CHATTER_TIPS) {
+        flags |= TIP_ANOMALY_CHATTER;
+    }
+
+    uint8_t raised = flags & (uint8_t)~(monitor->current | monitor->previous);
+    monitor->current |= flags;
+    return raised;
+}
+
+/* === Public function implementation ========================================================== */
+
+void tipStatsInit(tipStats_t* stats) {
+    assert(stats != NULL);
+
+    memset(stats, 0, sizeof(*stats));
+    histogramInit(&stats->intervals);
+}
+
+void tipStatsAddInterval(tipStats_t* stats, uint32_t intervalMs) {
+    histogramRecord(&stats->intervals, intervalMs);
+
+    // Welford: la media y los desvíos se actualizan sin guardar los intervalos
+    double delta = (double)intervalMs - stats->mean;
+    stats->mean += delta / stats->intervals.count;
+    stats->m2 += delta * ((double)intervalMs - stats->mean);
+}
+
+void tipStatsAddRejections(tipStats_t* stats, uint32_t count) {
+    stats->rejections += count;
+}
+
+void tipStatsMerge(tipStats_t* into, const tipStats_t* from) {
+    assert(into != NULL && from != NULL);
+
+    double intoCount = into->intervals.count;
+    double fromCount = from->intervals.count;
+    if (fromCount > 0) {
+        double total = intoCount + fromCount;
+        double delta = from->mean - into->mean;
+        into->mean += delta * fromCount / total;
+        into->m2 += from->m2 + delta * delta * intoCount * fromCount / total;
+    }
+    histogramMerge(&into->intervals, &from->intervals);
+    into->rejections += from->rejections;
+    into->anomalies |= from->anomalies;
+}
+
+double tipStatsVariance(const tipStats_t* stats) {
+    assert(stats != NULL);
+
+    return stats->intervals.count > 1 ? stats->m2 / (stats->intervals.count - 1) : 0.0;
+}
+
+uint32_t tipStatsQuantile(const tipStats_t* stats, uint32_t permille) {
+    assert(stats != NULL);
+
+    return histogramQuantile(&stats->intervals, permille);
+}
+
+void tipMonitorInit(tipMonitor_t* monitor, uint32_t now) {
+    assert(monitor != NULL);
+
+    memset(monitor, 0, sizeof(*monitor));
+    monitor->window = now / TIP_STATS_WINDOW_SECONDS;
+}
+
+uint8_t tipMonitorAddInterval(tipMonitor_t* monitor, uint32_t now, uint32_t intervalMs) {
+    assert(monitor != NULL);
+
+    advanceWindow(monitor, now);
+    monitor->tips++;
+    monitor->shortIntervals += intervalMs < TIP_STATS_SHORT_MS ? 1 : 0;
+    return raiseFlags(monitor);
+}
+
+uint8_t tipMonitorAddRejections(tipMonitor_t* monitor, uint32_t now, uint32_t count) {
+    assert(monitor != NULL);
+
+    advanceWindow(monitor, now);
+    monitor->rejections += count;
+    return raiseFlags(monitor);
+}
+
+uint8_t tipMonitorFlags(const tipMonitor_t* monitor, uint32_t now) {
+    assert(monitor != NULL);
+
+    uint32_t window = now / TIP_STATS_WINDOW_SECONDS;
+    if (window <= monitor->window) {
+        return monitor->current | monitor->previous;
+    }
+    return window == monitor->window + 1 ? monitor->current : 0;
+}
+
+/* === End of documentation ==================================================================== */
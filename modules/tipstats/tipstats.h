@@ -0,0 +1,212 @@
+/*
+ * Nombre del archivo: tipstats.h
+ * Descripción: Estadísticas de memoria fija de los intervalos entre ticks y de los rebotes.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+#ifndef TIPSTATS_H
+#define TIPSTATS_H
+
+/** @file
+ ** @brief Estadísticas de los intervalos entre ticks y de los rebotes descartados.
+ **
+ ** Los intervalos entre ticks aceptados se acumulan en un histograma
+ ** log-lineal de modules/probe (cantidad, mínimo, máximo y cuantiles con
+ ** error relativo menor a 1 / HISTOGRAM_SUB_BUCKETS) y en la media y la suma
+ ** de cuadrados de los desvíos por el método de Welford. Registrar un
+ ** intervalo cuesta lo mismo sin importar cuántos se registraron, la memoria
+ ** es fija (sin memoria dinámica) y dos estadísticas se combinan sin pérdida:
+ ** las de varios períodos o de varios pluviómetros dan el mismo histograma
+ ** que si se hubieran registrado juntas.
+ **
+ ** El monitor cuenta en ventanas de TIP_STATS_WINDOW_SECONDS los ticks, los
+ ** intervalos más cortos que el vuelco más rápido del balancín y los flancos
+ ** que el antirrebote descartó (intervalos menores que DEBOUNCE_TIME), y
+ ** levanta una bandera de anomalía cuando alguno se dispara.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "histogram.h"
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef TIP_STATS_WINDOW_SECONDS
+#define TIP_STATS_WINDOW_SECONDS 60  ///< Ventana del monitor de anomalías
+#endif
+#ifndef TIP_STATS_BOUNCES_PER_TIP
+#define TIP_STATS_BOUNCES_PER_TIP 8  ///< Rebotes por tick que se consideran normales
+#endif
+#ifndef TIP_STATS_BOUNCE_SLACK
+#define TIP_STATS_BOUNCE_SLACK 16  ///< Rebotes por ventana admitidos además de los de cada tick
+#endif
+#ifndef TIP_STATS_SHORT_MS
+#define TIP_STATS_SHORT_MS 250  ///< Intervalo menor que el vuelco más rápido del balancín
+#endif
+#ifndef TIP_STATS_CHATTER_TIPS
+#define TIP_STATS_CHATTER_TIPS 5  ///< Intervalos cortos por ventana que indican un contacto que rebota
+#endif
+
+/* === Public data type declarations =========================================================== */
+
+/**
+ * @brief Banderas de anomalía.
+ */
+typedef enum {
+    TIP_ANOMALY_BOUNCE_FLOOD = 0x01,  ///< Más de TIP_STATS_BOUNCES_PER_TIP rebotes por tick (más el margen)
+    TIP_ANOMALY_CHATTER = 0x02,  ///< TIP_STATS_CHATTER_TIPS intervalos aceptados menores que TIP_STATS_SHORT_MS
+} tipAnomaly_t;
+
+/**
+ * @brief Estadísticas de un período o de un pluviómetro.
+ */
+typedef struct {
+    histogram_t intervals;  ///< Intervalos entre ticks aceptados, en ms
+    double mean;  ///< Media de los intervalos
+    double m2;  ///< Suma de los cuadrados de los desvíos respecto de la media
+    uint32_t rejections;  ///< Flancos o ticks descartados por el antirrebote
+    uint8_t anomalies;  ///< Banderas tipAnomaly_t levantadas
+} tipStats_t;
+
+/**
+ * @brief Monitor de anomalías por ventanas fijas.
+ */
+typedef struct {
+    uint32_t window;  ///< Ventana en curso, desde la época
+    uint32_t tips;  ///< Intervalos registrados en la ventana
+    uint32_t shortIntervals;  ///< Intervalos menores que TIP_STATS_SHORT_MS en la ventana
+    uint32_t rejections;  ///< Descartes del antirrebote en la ventana
+    uint8_t current;  ///< Banderas de la ventana en curso
+    uint8_t previous;  ///< Banderas de la ventana inmediata anterior
+} tipMonitor_t;
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Vacía las estadísticas.
+ *
+ * @param stats Estadísticas a inicializar.
+ */
+void tipStatsInit(tipStats_t* stats);
+
+/**
+ * @brief Registra el intervalo entre dos ticks aceptados.
+ *
+ * @param stats Estadísticas destino.
+ * @param intervalMs Intervalo en ms.
+ */
+void tipStatsAddInterval(tipStats_t* stats, uint32_t intervalMs);
+
+/**
+ * @brief Suma descartes del antirrebote.
+ *
+ * @param stats Estadísticas destino.
+ * @param count Descartes a sumar.
+ */
+void tipStatsAddRejections(tipStats_t* stats, uint32_t count);
+
+/**
+ * @brief Suma a unas estadísticas las de otro período o de otro pluviómetro.
+ *
+ * La media y la suma de cuadrados se combinan con la fórmula de Chan y el
+ * histograma con histogramMerge(), así que el resultado no depende de cómo
+ * se repartieron los intervalos.
+ *
+ * @param into Estadísticas destino.
+ * @param from Estadísticas a sumar.
+ */
+void tipStatsMerge(tipStats_t* into, const tipStats_t* from);
+
+/**
+ * @brief Obtiene la varianza muestral de los intervalos.
+ *
+ * @param stats Estadísticas a consultar.
+ * @return Varianza en ms², o 0 con menos de dos intervalos.
+ */
+double tipStatsVariance(const tipStats_t* stats);
+
+/**
+ * @brief Estima un cuantil de los intervalos (ver histogramQuantile()).
+ *
+ * @param stats Estadísticas a consultar.
+ * @param permille Cuantil en milésimas (500 = mediana, 990 = p99).
+ * @return Intervalo en ms, o 0 sin intervalos.
+ */
+uint32_t tipStatsQuantile(const tipStats_t* stats, uint32_t permille);
+
+/**
+ * @brief Inicializa el monitor de anomalías.
+ *
+ * @param monitor Monitor a inicializar.
+ * @param now Instante actual en segundos desde la época.
+ */
+void tipMonitorInit(tipMonitor_t* monitor, uint32_t now);
+
+/**
+ * @brief Registra en el monitor el intervalo de un tick aceptado.
+ *
+ * Un instante anterior a la ventana en curso (un tick procesado tarde) se
+ * cuenta en la ventana en curso.
+ *
+ * @param monitor Monitor.
+ * @param now Instante del tick en segundos desde la época.
+ * @param intervalMs Intervalo desde el tick anterior, en ms.
+ * @return Banderas que se levantaron con este tick y no estaban levantadas
+ *         en la ventana en curso ni en la anterior.
+ */
+uint8_t tipMonitorAddInterval(tipMonitor_t* monitor, uint32_t now, uint32_t intervalMs);
+
+/**
+ * @brief Registra en el monitor descartes del antirrebote.
+ *
+ * @param monitor Monitor.
+ * @param now Instante de la lectura de los descartes.
+ * @param count Descartes desde la lectura anterior.
+ * @return Banderas que se levantaron, como tipMonitorAddInterval().
+ */
+uint8_t tipMonitorAddRejections(tipMonitor_t* monitor, uint32_t now, uint32_t count);
+
+/**
+ * @brief Obtiene las banderas levantadas en la ventana en curso o en la anterior.
+ *
+ * @param monitor Monitor a consultar.
+ * @param now Instante actual en segundos desde la época.
+ * @return Banderas tipAnomaly_t.
+ */
+uint8_t tipMonitorFlags(const tipMonitor_t* monitor, uint32_t now);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIPSTATS_H */
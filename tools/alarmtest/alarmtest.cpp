@@ -0,0 +1,557 @@
+/*
+ * Nombre del archivo: alarmtest.cpp
+ * Descripción: Verificación y banco de las reglas de alarma frente a un recálculo directo.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Verificación y banco de modules/alarm.
+ **
+ ** Arma 100 reglas (ventanas de 5 min a 1 día y rachas de períodos húmedos)
+ ** a partir de líneas de configuración, las evalúa con el motor incremental
+ ** sobre una traza de ticks y, después de cada tick y de cada avance del
+ ** reloj, compara el estado de cada regla con un recálculo directo sobre
+ ** todos los ticks con la misma semántica de cubetas y períodos. Luego mide
+ ** el costo por tick del motor frente al recálculo de cada regla en cada tick.
+ ** Cada tick suma su lluvia corregida por intensidad en um, como en el
+ ** firmware, con la calibración de GAUGE_CALIBRATION.
+ **
+ ** Uso:
+ **   alarmtest [--days n] [--seed n] [--late pct]   traza sintética de tormentas
+ **   alarmtest --trace archivo                      líneas de printRain(), una por tick
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pluviometer.h"
+#include "gauge.h"
+#include "timefmt.h"
+#include "logformat.h"
+#include "alarm.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define ADVANCE_SECONDS 10  ///< Avance del reloj sin ticks entre verificaciones
+#define LATE_MAX_SECONDS 300  ///< Demora máxima de un tick procesado tarde
+#define ENGINE_BENCH_SECONDS 0.5  ///< Tiempo mínimo del banco del motor
+#define NAIVE_BUDGET_SECONDS 2.0  ///< Tiempo máximo del banco del recálculo directo
+#define TIP_UM (MM_PER_TICK * 100)  ///< Vuelco nominal en um
+
+/* === Private data type declarations ========================================================== */
+
+typedef Pluviometer<GAUGE_CALIBRATION, GAUGE_DEBOUNCE> gauge_t;
+
+/**
+ * @brief Tick de la traza.
+ */
+typedef struct {
+    uint32_t arrival;  ///< Instante en que se procesa
+    uint32_t time;  ///< Instante del tick (anterior si llega tarde)
+    uint32_t depth;  ///< Lluvia corregida del tick en um
+} tip_t;
+
+/**
+ * @brief Recálculo directo: todos los ticks en orden de proceso.
+ */
+typedef struct {
+    std::vector<tip_t> tips;
+    uint32_t now;
+} reference_t;
+
+/**
+ * @brief Estado de las reglas según los avisos del motor.
+ */
+typedef struct {
+    std::vector<bool> active;
+    uint64_t raised;
+    uint64_t cleared;
+    uint64_t errors;
+} notices_t;
+
+/* === Private variable declarations =========================================================== */
+
+static std::vector<alarmRule_t> rules;  ///< Reglas leídas de la configuración
+static bool reported = false;  ///< Ya se mostró el primer desacuerdo
+
+/* === Private function implementation ========================================================= */
+
+/**
+ * @brief Lluvia corregida de un tick en um, según el intervalo desde el anterior (0 = sin anterior).
+ */
+static uint32_t tipDepth(uint64_t intervalMs) {
+    return (uint32_t)(((uint64_t)TIP_UM * gauge_t::correction(intervalMs)) >> GAUGE_FACTOR_SHIFT);
+}
+
+/**
+ * @brief Lluvia en la ventana: cubetas como en modules/alarm, recorriendo los ticks desde el último.
+ */
+static uint32_t referenceAmount(const reference_t* reference, uint32_t seconds) {
+    uint32_t bucketSeconds = (seconds + ALARM_BUCKETS - 1) / ALARM_BUCKETS;
+    uint32_t bucketCount = (seconds + bucketSeconds - 1) / bucketSeconds;
+    uint32_t current = reference->now / bucketSeconds;
+    uint32_t sum = 0;
+
+    for (size_t i = reference->tips.size(); i-- > 0;) {
+        const tip_t* tip = &reference->tips[i];
+        if (current - tip->arrival / bucketSeconds >= bucketCount) {
+            break;  // Los anteriores se procesaron (y ocurrieron) antes de la ventana
+        }
+        if (current - tip->time / bucketSeconds < bucketCount) {
+            sum += tip->depth;
+        }
+    }
+    return sum;
+}
+
+/**
+ * @brief Períodos húmedos seguidos, contando el actual si ya es húmedo.
+ *
+ * Un tick cuenta en su período solo si se procesó dentro de él.
+ */
+static uint32_t referenceWetRun(const reference_t* reference, uint32_t seconds, uint32_t wetThreshold) {
+    uint32_t current = reference->now / seconds;
+    uint32_t period = current;
+    uint32_t rain = 0;
+    uint32_t run = 0;
+    bool currentWet = false;
+
+    for (size_t i = reference->tips.size(); i-- > 0;) {
+        const tip_t* tip = &reference->tips[i];
+        uint32_t tipPeriod = tip->time / seconds;
+        if (tipPeriod != tip->arrival / seconds) {
+            continue;
+        }
+        while (tipPeriod < period) {
+            bool wet = rain >= wetThreshold;
+            if (period == current) {
+                currentWet = wet;
+            } else if (wet) {
+                run++;
+            } else {
+                return run + (currentWet ? 1 : 0);
+            }
+            period--;
+            rain = 0;
+        }
+        rain += tip->depth;
+    }
+    if (rain >= wetThreshold) {
+        if (period == current) {
+            currentWet = true;
+        } else {
+            run++;
+        }
+    }
+    return run + (currentWet ? 1 : 0);
+}
+
+/**
+ * @brief Estado de una regla según el recálculo directo.
+ */
+static bool referenceActive(const reference_t* reference, const alarmRule_t* rule) {
+    if (rule->kind == ALARM_RULE_AMOUNT) {
+        return referenceAmount(reference, rule->seconds) > rule->limit;
+    }
+    return referenceWetRun(reference, rule->seconds, rule->wetThreshold) >= rule->limit;
+}
+
+static void onNotice(void* context, const alarmRule_t* rule, bool raised, uint32_t timestamp) {
+    notices_t* notices = (notices_t*)context;
+    (void)timestamp;
+    size_t index = (size_t)(rule - rules.data());
+    if (notices->active[index] == raised) {
+        notices->errors++;
+    }
+    notices->active[index] = raised;
+    (raised ? notices->raised : notices->cleared)++;
+}
+
+/**
+ * @brief Arma la configuración de 100 reglas en texto y la lee con alarmParseRule().
+ *
+ * @return false si alguna línea válida se rechaza o alguna inválida se acepta.
+ */
+static bool buildRules() {
+    static const uint32_t windows[] = {300, 600, 900, 1800, 3600, 3 * 3600, 6 * 3600, 24 * 3600};
+    static const uint32_t wetRuns[][2] = {{3600, TIP_UM}, {3600, 5 * TIP_UM}, {600, TIP_UM}, {3 * 3600, 10 * TIP_UM}};
+    static const char* invalid[] = {"amount 1 0 5", "wet 1 3600 0 3", "wet 1 3600 2 0", "amount 300 60 5",
+                                    "amount 1 60", "amount 1 60 5 7", "rain 1 60 5", "amount 1 6x0 5",
+                                    "amount 1 60 -5", "wet 1 3600 2"};
+    std::vector<std::string> config;
+    char line[64];
+    unsigned id = 1;
+
+    // Límites entre lluvias comunes y extremas para cada ventana (en um), crecientes como (ventana)^0.6
+    for (uint32_t window : windows) {
+        double scale = 500.0 * pow((double)window / 300.0, 0.6);
+        for (unsigned k = 1; k <= 11; k++) {
+            snprintf(line, sizeof(line), "amount %u %u %u", id++, (unsigned)window, (unsigned)(scale * k + 0.5));
+            config.push_back(line);
+        }
+    }
+    static const uint32_t runs[] = {2, 3, 6};
+    for (const auto& wet : wetRuns) {
+        for (uint32_t run : runs) {
+            snprintf(line, sizeof(line), "wet %u %u %u %u\r\n", id++, (unsigned)wet[0], (unsigned)wet[1], (unsigned)run);
+            config.push_back(line);
+        }
+    }
+
+    bool ok = true;
+    for (const std::string& text : config) {
+        alarmRule_t rule;
+        if (!alarmParseRule(text.data(), text.size(), &rule)) {
+            fprintf(stderr, "regla rechazada: %s\n", text.c_str());
+            ok = false;
+        }
+        rules.push_back(rule);
+    }
+    for (const char* text : invalid) {
+        alarmRule_t rule;
+        if (alarmParseRule(text, strlen(text), &rule)) {
+            fprintf(stderr, "regla inválida aceptada: %s\n", text);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+/**
+ * @brief Tormentas separadas por períodos secos, con ráfagas convectivas.
+ *
+ * Un porcentaje de los ticks se procesa tarde, hasta LATE_MAX_SECONDS después.
+ */
+static std::vector<tip_t> syntheticTrace(uint32_t days, uint64_t seed, double latePercent) {
+    std::mt19937_64 rng(seed);
+    std::exponential_distribution<double> dryHours(1.0 / 18.0);
+    std::uniform_real_distribution<double> stormHours(0.2, 10.0);
+    std::lognormal_distribution<double> intensity(1.5, 1.0);  // mm/h
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::uniform_int_distribution<uint32_t> delay(1, LATE_MAX_SECONDS);
+    std::vector<tip_t> tips;
+    double end = (double)TIME_INI + (double)days * SECONDS_PER_DAY;
+    double t = TIME_INI;
+
+    while (true) {
+        t += dryHours(rng) * 3600.0;
+        double stormEnd = t + stormHours(rng) * 3600.0;
+        double mmPerHour = std::min(intensity(rng), 150.0);
+        double burstStart = unit(rng) < 0.2 ? t + unit(rng) * (stormEnd - t) : stormEnd;
+        double burstEnd = burstStart + 600.0 + unit(rng) * 1200.0;
+        while (t < stormEnd && t < end) {
+            double rate = mmPerHour * (t >= burstStart && t < burstEnd ? 5.0 : 1.0) * 10.0 / MM_PER_TICK / 3600.0;
+            double gap = std::exponential_distribution<double>(rate)(rng);
+            t += gap;
+            tip_t tip = {(uint32_t)t, (uint32_t)t, tipDepth((uint64_t)(gap * 1000.0))};
+            if (unit(rng) * 100.0 < latePercent) {
+                tip.arrival += delay(rng);
+            }
+            tips.push_back(tip);
+        }
+        if (t >= end) {
+            break;
+        }
+    }
+    std::stable_sort(tips.begin(), tips.end(), [](const tip_t& a, const tip_t& b) { return a.arrival < b.arrival; });
+    return tips;
+}
+
+/**
+ * @brief Lee los ticks de la salida de texto del pluviómetro.
+ */
+static bool traceFromText(const char* path, std::vector<tip_t>* tips) {
+    FILE* input = fopen(path, "r");
+    if (input == NULL) {
+        perror(path);
+        return false;
+    }
+    char line[256];
+    uint32_t last = 0;
+    uint32_t previous = 0;
+    while (fgets(line, sizeof(line), input) != NULL) {
+        logRecord_t record;
+        if (logParseText(line, strlen(line), &record) && record.id == LOG_EVENT_RAIN_DETECTED) {
+            // El texto tiene resolución de 1 s: la corrección se estima con el intervalo en segundos
+            uint64_t interval = previous != 0 && record.timestamp > previous ? (record.timestamp - previous) * 1000ull : 0;
+            previous = record.timestamp;
+            // Un reloj que retrocede se trata como un tick procesado tarde
+            last = std::max(last, record.timestamp);
+            tips->push_back({last, record.timestamp, tipDepth(interval)});
+        }
+    }
+    fclose(input);
+    return true;
+}
+
+/**
+ * @brief Compara el valor de cada seguidor y el estado de cada regla con el recálculo directo y con los avisos.
+ *
+ * @return Seguidores y reglas en desacuerdo.
+ */
+static uint64_t compare(const alarmEngine_t* engine, const reference_t* reference, const notices_t* notices) {
+    uint64_t mismatches = 0;
+    uint32_t values[ALARM_TRACKERS_MAX];
+    uint32_t active = 0;
+
+    for (size_t t = 0; t < engine->trackerCount; t++) {
+        const alarmTracker_t* tracker = &engine->trackers[t];
+        values[t] = tracker->kind == ALARM_RULE_AMOUNT
+                        ? referenceAmount(reference, tracker->seconds)
+                        : referenceWetRun(reference, tracker->seconds, tracker->wetThreshold);
+        if (tracker->value != values[t]) {
+            if (!reported) {
+                reported = true;
+                fprintf(stderr, "seguidor de %u s en %u: motor %u, directo %u\n", (unsigned)tracker->seconds,
+                        (unsigned)reference->now, (unsigned)tracker->value, (unsigned)values[t]);
+            }
+            mismatches++;
+        }
+    }
+    for (size_t i = 0; i < rules.size(); i++) {
+        const alarmRule_t* rule = &rules[i];
+        uint32_t value = values[engine->tracker[i]];
+        bool expected = rule->kind == ALARM_RULE_AMOUNT ? value > rule->limit : value >= rule->limit;
+        bool actual = alarmEngineRuleActive(engine, i);
+        active += actual ? 1 : 0;
+        if (actual != expected || actual != notices->active[i]) {
+            if (!reported) {
+                reported = true;
+                fprintf(stderr, "regla %u en %u: motor %d, directo %d, avisos %d\n", (unsigned)rule->id,
+                        (unsigned)reference->now, actual, expected, (int)notices->active[i]);
+            }
+            mismatches++;
+        }
+    }
+    return mismatches + (active != alarmEngineActiveCount(engine) ? 1 : 0);
+}
+
+/**
+ * @brief Recorre la traza con el motor y el recálculo directo, comparando en cada paso.
+ *
+ * El reloj avanza cada ADVANCE_SECONDS, salvo en uno de cada dos tramos secos
+ * de más de una hora, donde salta directo al próximo tick (como un equipo que
+ * no avanza las reglas sin lluvia).
+ */
+static uint64_t verify(const std::vector<tip_t>& tips, notices_t* notices, uint64_t* checks) {
+    alarmEngine_t engine;
+    reference_t reference;
+    uint64_t mismatches = 0;
+    uint32_t start = tips.front().arrival - tips.front().arrival % ADVANCE_SECONDS;
+    // Al final se deja pasar el día más largo para que se desactiven todas
+    uint32_t end = tips.back().arrival + 2 * SECONDS_PER_DAY;
+    bool jump = false;
+
+    notices->active.assign(rules.size(), false);
+    if (!alarmEngineInit(&engine, rules.data(), rules.size(), start, onNotice, notices)) {
+        fprintf(stderr, "el motor rechazó las reglas\n");
+        return 1;
+    }
+    reference.now = start;
+    size_t next = 0;
+    for (uint32_t now = start; now <= end; now += ADVANCE_SECONDS) {
+        while (next < tips.size() && tips[next].arrival < now) {
+            const tip_t* tip = &tips[next++];
+            reference.now = std::max(reference.now, tip->arrival);
+            reference.tips.push_back(*tip);
+            alarmEngineAdvance(&engine, tip->arrival);
+            alarmEngineAddRain(&engine, tip->time, tip->depth);
+            mismatches += compare(&engine, &reference, notices);
+            (*checks)++;
+            if (next < tips.size() && tips[next].arrival - tip->arrival > 3600 && (jump = !jump)) {
+                now = tips[next].arrival - tips[next].arrival % ADVANCE_SECONDS;
+            }
+        }
+        reference.now = std::max(reference.now, now);
+        alarmEngineAdvance(&engine, now);
+        mismatches += compare(&engine, &reference, notices);
+        (*checks)++;
+        if (next == tips.size() && alarmEngineActiveCount(&engine) == 0 && now > tips.back().arrival + SECONDS_PER_DAY) {
+            break;
+        }
+    }
+    if (alarmEngineActiveCount(&engine) != 0) {
+        fprintf(stderr, "quedaron %u reglas activas al final\n", (unsigned)alarmEngineActiveCount(&engine));
+        mismatches++;
+    }
+    return mismatches;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Mide el motor y el recálculo directo regla por regla sobre la traza.
+ *
+ * La traza del motor se repite hasta juntar ENGINE_BENCH_SECONDS; el
+ * recálculo directo se corta a los NAIVE_BUDGET_SECONDS.
+ */
+static void bench(const std::vector<tip_t>& tips) {
+    alarmEngine_t engine;
+    notices_t notices;
+    uint64_t engineTips = 0;
+    uint64_t touched = 0;
+    uint64_t advances = 0;
+    double engineSeconds = 0.0;
+    double advanceSeconds = 0.0;
+
+    while (engineSeconds < ENGINE_BENCH_SECONDS) {
+        notices.active.assign(rules.size(), false);
+        alarmEngineInit(&engine, rules.data(), rules.size(), tips.front().arrival, onNotice, &notices);
+        auto begin = std::chrono::steady_clock::now();
+        for (const tip_t& tip : tips) {
+            alarmEngineAdvance(&engine, tip.arrival);
+            alarmEngineAddRain(&engine, tip.time, tip.depth);
+        }
+        engineSeconds += secondsSince(begin);
+        engineTips += tips.size();
+        touched += engine.touched;
+
+        // Avances sin ticks, cada ADVANCE_SECONDS durante la traza
+        alarmEngineInit(&engine, rules.data(), rules.size(), tips.front().arrival, onNotice, &notices);
+        begin = std::chrono::steady_clock::now();
+        for (uint32_t now = tips.front().arrival; now < tips.back().arrival; now += ADVANCE_SECONDS) {
+            alarmEngineAdvance(&engine, now);
+            advances++;
+        }
+        advanceSeconds += secondsSince(begin);
+    }
+
+    // Recálculo directo: en cada tick, cada regla vuelve a sumar su ventana o su racha
+    reference_t reference;
+    reference.now = tips.front().arrival;
+    reference.tips.reserve(tips.size());
+    uint64_t naiveTips = 0;
+    uint64_t naiveActive = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (const tip_t& tip : tips) {
+        reference.now = std::max(reference.now, tip.arrival);
+        reference.tips.push_back(tip);
+        for (const alarmRule_t& rule : rules) {
+            naiveActive += referenceActive(&reference, &rule) ? 1 : 0;
+        }
+        if (++naiveTips % 256 == 0 && secondsSince(begin) > NAIVE_BUDGET_SECONDS) {
+            break;
+        }
+    }
+    double naiveSeconds = secondsSince(begin);
+
+    printf("reglas            : %zu en %zu seguidores\n", rules.size(), engine.trackerCount);
+    printf("motor             : %.0f ns por tick, %.2f reglas tocadas por tick, %.0f ns por avance\n",
+           engineSeconds * 1e9 / (double)engineTips, (double)touched / (double)engineTips,
+           advanceSeconds * 1e9 / (double)advances);
+    printf("recálculo directo : %.0f ns por tick (%llu ticks, %.2f reglas activas por tick)\n",
+           naiveSeconds * 1e9 / (double)naiveTips, (unsigned long long)naiveTips,
+           (double)naiveActive / (double)naiveTips);
+}
+
+static int usage(const char* program) {
+    fprintf(stderr,
+            "uso: %s [--days n] [--seed n] [--late porcentaje]\n"
+            "     %s --trace archivo\n",
+            program, program);
+    return 2;
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char* argv[]) {
+    uint32_t days = 30;
+    uint64_t seed = 1;
+    double latePercent = 5.0;
+    const char* trace = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--days") == 0 && i + 1 < argc) {
+            days = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--late") == 0 && i + 1 < argc) {
+            latePercent = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace = argv[++i];
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (days == 0 || days > 3650) {
+        return usage(argv[0]);
+    }
+
+    if (!buildRules()) {
+        return 1;
+    }
+    // Más ventanas distintas que ALARM_TRACKERS_MAX no entran en un motor
+    std::vector<alarmRule_t> tooMany;
+    for (uint32_t i = 0; i <= ALARM_TRACKERS_MAX; i++) {
+        tooMany.push_back({ALARM_RULE_AMOUNT, (uint8_t)i, 60 * (i + 1), 0, 1000});
+    }
+    alarmEngine_t probe;
+    if (alarmEngineInit(&probe, tooMany.data(), tooMany.size(), TIME_INI, NULL, NULL)) {
+        fprintf(stderr, "el motor aceptó %zu ventanas distintas\n", tooMany.size());
+        return 1;
+    }
+
+    std::vector<tip_t> tips;
+    if (trace != NULL) {
+        if (!traceFromText(trace, &tips)) {
+            return 1;
+        }
+    } else {
+        tips = syntheticTrace(days, seed, latePercent);
+    }
+    if (tips.empty()) {
+        fprintf(stderr, "la traza no tiene ticks\n");
+        return 1;
+    }
+
+    notices_t notices;
+    notices.raised = notices.cleared = notices.errors = 0;
+    uint64_t checks = 0;
+    auto begin = std::chrono::steady_clock::now();
+    uint64_t mismatches = verify(tips, &notices, &checks);
+    double verifySeconds = secondsSince(begin);
+
+    uint64_t depth = 0;
+    for (const tip_t& tip : tips) {
+        depth += tip.depth;
+    }
+    printf("ticks             : %zu (%.1f mm nominales, %.1f mm corregidos)\n", tips.size(),
+           (double)tips.size() * MM_PER_TICK / 10.0, (double)depth / 1000.0);
+    printf("verificaciones    : %llu en %.1f s\n", (unsigned long long)checks, verifySeconds);
+    printf("avisos            : %llu activaciones, %llu desactivaciones\n", (unsigned long long)notices.raised,
+           (unsigned long long)notices.cleared);
+    bench(tips);
+    printf("errores           : %llu\n", (unsigned long long)(mismatches + notices.errors));
+    return mismatches + notices.errors == 0 ? 0 : 1;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,703 @@
+/*
+ * Nombre del archivo: archive.cpp
+ * Descripción: Archivo columnar de ticks en segmentos mapeados en memoria con índice de tiempo.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+/** @file
+ ** @brief Archivo columnar de ticks por pluviómetro, mapeado en memoria.
+ **
+ ** Cada pluviómetro tiene una columna de instantes de tick (segundos desde la
+ ** época, no decrecientes) y una de lluvia por tick en décimas de mm, las
+ ** unidades de MM_PER_TICK. Las columnas se guardan en segmentos de solo
+ ** agregado, archivos "gauge-<n>-<k>.seg" de capacidad fija que se mapean con
+ ** mmap(). Cada bloque de ARCHIVE_BLOCK_EVENTS ticks tiene en el índice
+ ** disperso su primer instante y la lluvia acumulada antes de él, así que el
+ ** total de un rango busca en el índice y solo recorre los dos bloques de los
+ ** bordes.
+ **
+ ** Uso:
+ **   archive import directorio pluviómetro [texto]    líneas de printRain(), sin archivo la entrada estándar
+ **   archive import-records directorio eventos.bin    registros de tools/gateway
+ **   archive total directorio pluviómetro|all desde hasta
+ **   archive stats directorio
+ **   archive bench directorio [--events N] [--gauges N] [--queries N] [--seed N]
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "pluviometer.h"
+#include "timefmt.h"
+#include "logformat.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define ARCHIVE_MAGIC 0x41564C50u  ///< "PLVA" en little endian
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_BLOCK_EVENTS 4096  ///< Ticks por bloque del índice disperso
+#define ARCHIVE_SEGMENT_EVENTS (1u << 24)  ///< Capacidad predeterminada de un segmento
+#define ARCHIVE_PATH_MAX 512
+#define ARCHIVE_RECORD_SIZE 16  ///< Registro de tools/gateway
+
+#define SECONDS_PER_YEAR (365 * SECONDS_PER_DAY)
+
+/* === Private data type declarations ========================================================== */
+
+/**
+ * @brief Cabecera de un segmento; ocupa los primeros 64 bytes del archivo.
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t gauge;
+    uint32_t blockEvents;  ///< ARCHIVE_BLOCK_EVENTS al crearlo
+    uint32_t capacity;  ///< Ticks que admite
+    uint32_t count;  ///< Ticks escritos; se actualiza después de los datos y del índice
+    uint32_t firstTime;
+    uint32_t lastTime;
+    uint64_t total;  ///< Lluvia de todos los ticks, en décimas de mm
+    uint8_t padding[24];
+} segmentHeader_t;
+
+static_assert(sizeof(segmentHeader_t) == 64, "la cabecera ocupa 64 bytes");
+
+/**
+ * @brief Segmento mapeado.
+ */
+typedef struct {
+    int fd;
+    size_t size;
+    uint8_t* base;
+    segmentHeader_t* header;
+    uint32_t* timestamps;  ///< Columna de instantes
+    uint8_t* amounts;  ///< Columna de lluvia por tick, en décimas de mm
+    uint32_t* blockFirst;  ///< Primer instante de cada bloque
+    uint64_t* blockPrefix;  ///< Lluvia de los ticks anteriores a cada bloque
+} segment_t;
+
+/**
+ * @brief Columna de un pluviómetro: sus segmentos en orden.
+ */
+typedef struct {
+    uint32_t gauge;
+    std::vector<segment_t> segments;
+    uint64_t outOfOrder;  ///< Ticks rechazados por ser anteriores al último
+} column_t;
+
+/**
+ * @brief Total de un rango.
+ */
+typedef struct {
+    uint64_t tenths;
+    uint64_t tips;
+} rangeTotal_t;
+
+/* === Private variable declarations =========================================================== */
+
+static uint32_t segmentEvents = ARCHIVE_SEGMENT_EVENTS;  ///< Capacidad de los segmentos nuevos
+
+/* === Private function implementation ========================================================= */
+
+static uint32_t getU32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * @brief Ubica las columnas y el índice dentro del mapeo según la capacidad.
+ */
+static size_t segmentLayout(segment_t* segment, uint32_t capacity) {
+    size_t blocks = (capacity + ARCHIVE_BLOCK_EVENTS - 1) / ARCHIVE_BLOCK_EVENTS;
+    size_t timestamps = sizeof(segmentHeader_t);
+    size_t amounts = timestamps + (size_t)capacity * sizeof(uint32_t);
+    size_t blockFirst = alignUp(amounts + capacity, sizeof(uint64_t));
+    size_t blockPrefix = blockFirst + alignUp(blocks * sizeof(uint32_t), sizeof(uint64_t));
+    size_t size = blockPrefix + blocks * sizeof(uint64_t);
+
+    if (segment->base != NULL) {
+        segment->header = (segmentHeader_t*)segment->base;
+        segment->timestamps = (uint32_t*)(segment->base + timestamps);
+        segment->amounts = segment->base + amounts;
+        segment->blockFirst = (uint32_t*)(segment->base + blockFirst);
+        segment->blockPrefix = (uint64_t*)(segment->base + blockPrefix);
+    }
+    return size;
+}
+
+static void segmentPath(char* path, const char* directory, uint32_t gauge, size_t index) {
+    snprintf(path, ARCHIVE_PATH_MAX, "%s/gauge-%u-%zu.seg", directory, (unsigned)gauge, index);
+}
+
+/**
+ * @brief Mapea un segmento existente.
+ *
+ * @return false si no existe o no es un segmento válido.
+ */
+static bool segmentOpen(segment_t* segment, const char* path, bool writable) {
+    struct stat info;
+    segment->fd = open(path, (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+    if (segment->fd < 0 || fstat(segment->fd, &info) != 0 || (size_t)info.st_size < sizeof(segmentHeader_t)) {
+        if (segment->fd >= 0) {
+            close(segment->fd);
+        }
+        return false;
+    }
+
+    segment->size = (size_t)info.st_size;
+    segment->base = (uint8_t*)mmap(NULL, segment->size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED,
+                                   segment->fd, 0);
+    if (segment->base == MAP_FAILED) {
+        close(segment->fd);
+        return false;
+    }
+    const segmentHeader_t* header = (const segmentHeader_t*)segment->base;
+    if (header->magic != ARCHIVE_MAGIC || header->version != ARCHIVE_VERSION ||
+        header->blockEvents != ARCHIVE_BLOCK_EVENTS || header->count > header->capacity ||
+        segmentLayout(segment, header->capacity) != segment->size) {
+        fprintf(stderr, "%s: no es un segmento válido\n", path);
+        munmap(segment->base, segment->size);
+        close(segment->fd);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Crea un segmento vacío del tamaño completo (un archivo disperso) y lo mapea.
+ */
+static bool segmentCreate(segment_t* segment, const char* path, uint32_t gauge) {
+    segment_t layout = {};
+    size_t size = segmentLayout(&layout, segmentEvents);
+    int fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0 || ftruncate(fd, (off_t)size) != 0) {
+        perror(path);
+        return false;
+    }
+
+    segmentHeader_t header = {};
+    header.magic = ARCHIVE_MAGIC;
+    header.version = ARCHIVE_VERSION;
+    header.gauge = gauge;
+    header.blockEvents = ARCHIVE_BLOCK_EVENTS;
+    header.capacity = segmentEvents;
+    bool written = pwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header);
+    close(fd);
+    return written && segmentOpen(segment, path, true);
+}
+
+static void segmentClose(segment_t* segment, bool writable) {
+    if (writable) {
+        msync(segment->base, segment->size, MS_SYNC);
+    }
+    munmap(segment->base, segment->size);
+    close(segment->fd);
+}
+
+/**
+ * @brief Abre la columna de un pluviómetro con todos sus segmentos.
+ */
+static void columnOpen(column_t* column, const char* directory, uint32_t gauge, bool writable) {
+    char path[ARCHIVE_PATH_MAX];
+    segment_t segment = {};
+
+    column->gauge = gauge;
+    column->outOfOrder = 0;
+    segmentPath(path, directory, gauge, column->segments.size());
+    while (segmentOpen(&segment, path, writable)) {
+        column->segments.push_back(segment);
+        segmentPath(path, directory, gauge, column->segments.size());
+    }
+}
+
+static void columnClose(column_t* column, bool writable) {
+    for (segment_t& segment : column->segments) {
+        segmentClose(&segment, writable);
+    }
+    column->segments.clear();
+}
+
+/**
+ * @brief Agrega un tick al final de la columna.
+ *
+ * Los datos y el índice se escriben antes que la cuenta de la cabecera, de
+ * modo que un lector o un corte nunca ven un tick a medio escribir.
+ *
+ * @return false si el tick es anterior al último o no se pudo crear un segmento.
+ */
+static bool columnAppend(column_t* column, const char* directory, uint32_t timestamp, uint8_t amount) {
+    segment_t* segment = column->segments.empty() ? NULL : &column->segments.back();
+
+    if (segment != NULL && segment->header->count > 0 && timestamp < segment->header->lastTime) {
+        column->outOfOrder++;
+        return false;
+    }
+    if (segment == NULL || segment->header->count == segment->header->capacity) {
+        char path[ARCHIVE_PATH_MAX];
+        segment_t created = {};
+        segmentPath(path, directory, column->gauge, column->segments.size());
+        if (!segmentCreate(&created, path, column->gauge)) {
+            return false;
+        }
+        column->segments.push_back(created);
+        segment = &column->segments.back();
+    }
+
+    segmentHeader_t* header = segment->header;
+    uint32_t index = header->count;
+    if (index % ARCHIVE_BLOCK_EVENTS == 0) {
+        segment->blockFirst[index / ARCHIVE_BLOCK_EVENTS] = timestamp;
+        segment->blockPrefix[index / ARCHIVE_BLOCK_EVENTS] = header->total;
+    }
+    segment->timestamps[index] = timestamp;
+    segment->amounts[index] = amount;
+    header->firstTime = index == 0 ? timestamp : header->firstTime;
+    header->lastTime = timestamp;
+    header->total += amount;
+    __atomic_store_n(&header->count, index + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * @brief Posición del primer tick con instante >= t.
+ *
+ * Busca el bloque en el índice disperso y luego dentro del bloque.
+ */
+static uint32_t segmentLowerBound(const segment_t* segment, uint32_t count, uint32_t t) {
+    uint32_t blocks = (count + ARCHIVE_BLOCK_EVENTS - 1) / ARCHIVE_BLOCK_EVENTS;
+    const uint32_t* next = std::lower_bound(segment->blockFirst, segment->blockFirst + blocks, t);
+    if (next == segment->blockFirst) {
+        return 0;
+    }
+
+    // El primero >= t está en el bloque anterior o es el comienzo de next
+    uint32_t block = (uint32_t)(next - segment->blockFirst) - 1;
+    const uint32_t* begin = segment->timestamps + (size_t)block * ARCHIVE_BLOCK_EVENTS;
+    const uint32_t* end = segment->timestamps + std::min(count, (block + 1) * ARCHIVE_BLOCK_EVENTS);
+    return (uint32_t)(std::lower_bound(begin, end, t) - segment->timestamps);
+}
+
+/**
+ * @brief Lluvia de los ticks anteriores a position.
+ *
+ * Parte del acumulado del bloque y recorre solo el tramo más corto hasta uno de sus bordes.
+ */
+static uint64_t segmentSumBefore(const segment_t* segment, uint32_t count, uint64_t total, uint32_t position) {
+    uint32_t block = position / ARCHIVE_BLOCK_EVENTS;
+    uint32_t start = block * ARCHIVE_BLOCK_EVENTS;
+    uint32_t end = std::min(count, start + ARCHIVE_BLOCK_EVENTS);
+    uint64_t sum = 0;
+
+    if (position == count) {
+        return total;
+    }
+    if (position - start <= end - position) {
+        for (uint32_t i = start; i < position; i++) {
+            sum += segment->amounts[i];
+        }
+        return segment->blockPrefix[block] + sum;
+    }
+    for (uint32_t i = position; i < end; i++) {
+        sum += segment->amounts[i];
+    }
+    uint64_t after = end == count ? total : segment->blockPrefix[block + 1];
+    return after - sum;
+}
+
+/**
+ * @brief Total de los ticks con instante en [from, to).
+ */
+static rangeTotal_t columnTotal(const column_t* column, uint32_t from, uint32_t to) {
+    rangeTotal_t result = {0, 0};
+
+    for (const segment_t& segment : column->segments) {
+        const segmentHeader_t* header = segment.header;
+        uint32_t count = __atomic_load_n(&header->count, __ATOMIC_ACQUIRE);
+        if (count == 0 || from >= to || header->lastTime < from || header->firstTime >= to) {
+            continue;
+        }
+        if (header->firstTime >= from && header->lastTime < to) {
+            // Segmento completo: sin búsquedas
+            result.tenths += header->total;
+            result.tips += count;
+            continue;
+        }
+        uint32_t first = segmentLowerBound(&segment, count, from);
+        uint32_t last = segmentLowerBound(&segment, count, to);
+        result.tenths += segmentSumBefore(&segment, count, header->total, last) -
+                         segmentSumBefore(&segment, count, header->total, first);
+        result.tips += last - first;
+    }
+    return result;
+}
+
+/**
+ * @brief Recorrido directo de las columnas, para verificar y comparar.
+ */
+static rangeTotal_t columnScan(const column_t* column, uint32_t from, uint32_t to) {
+    rangeTotal_t result = {0, 0};
+
+    for (const segment_t& segment : column->segments) {
+        for (uint32_t i = 0; i < segment.header->count; i++) {
+            if (segment.timestamps[i] >= from && segment.timestamps[i] < to) {
+                result.tenths += segment.amounts[i];
+                result.tips++;
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Pluviómetros presentes en el directorio, en orden.
+ */
+static std::vector<uint32_t> listGauges(const char* directory) {
+    std::vector<uint32_t> gauges;
+    DIR* dir = opendir(directory);
+    struct dirent* entry;
+
+    while (dir != NULL && (entry = readdir(dir)) != NULL) {
+        unsigned gauge;
+        char tail[8];
+        if (sscanf(entry->d_name, "gauge-%u-0.se%1s", &gauge, tail) == 2 && strcmp(tail, "g") == 0) {
+            gauges.push_back(gauge);
+        }
+    }
+    if (dir != NULL) {
+        closedir(dir);
+    }
+    std::sort(gauges.begin(), gauges.end());
+    return gauges;
+}
+
+static void printTotal(const char* label, uint32_t from, uint32_t to, rangeTotal_t total) {
+    printf("%s %lu %lu %llu.%llu mm %llu ticks\n", label, (unsigned long)from, (unsigned long)to,
+           (unsigned long long)(total.tenths / 10), (unsigned long long)(total.tenths % 10),
+           (unsigned long long)total.tips);
+}
+
+/**
+ * @brief Importa las líneas de tick de la salida de texto de un pluviómetro.
+ */
+static int importText(const char* directory, uint32_t gauge, FILE* input) {
+    column_t column;
+    char line[LOG_TEXT_MAX * 2];
+    uint64_t imported = 0;
+    uint64_t ignored = 0;
+
+    columnOpen(&column, directory, gauge, true);
+    while (fgets(line, sizeof(line), input) != NULL) {
+        logRecord_t record;
+        if (logParseText(line, strlen(line), &record) && record.id == LOG_EVENT_RAIN_DETECTED) {
+            imported += columnAppend(&column, directory, record.timestamp, MM_PER_TICK) ? 1 : 0;
+        } else {
+            ignored++;
+        }
+    }
+    printf("pluviómetro %u: %llu ticks importados, %llu fuera de orden, %llu otras líneas\n", (unsigned)gauge,
+           (unsigned long long)imported, (unsigned long long)column.outOfOrder, (unsigned long long)ignored);
+    columnClose(&column, true);
+    return 0;
+}
+
+/**
+ * @brief Importa los ticks de los registros guardados por tools/gateway.
+ */
+static int importRecords(const char* directory, FILE* input) {
+    std::vector<column_t> columns;
+    uint8_t record[ARCHIVE_RECORD_SIZE];
+    uint64_t imported = 0;
+
+    while (fread(record, ARCHIVE_RECORD_SIZE, 1, input) == 1) {
+        uint32_t gauge = getU32(&record[0]);
+        if (record[12] != LOG_EVENT_RAIN_DETECTED) {
+            continue;
+        }
+        while (columns.size() <= gauge) {
+            columns.emplace_back();
+            columnOpen(&columns.back(), directory, (uint32_t)(columns.size() - 1), true);
+        }
+        imported += columnAppend(&columns[gauge], directory, getU32(&record[4]), MM_PER_TICK) ? 1 : 0;
+    }
+
+    uint64_t outOfOrder = 0;
+    for (column_t& column : columns) {
+        outOfOrder += column.outOfOrder;
+        columnClose(&column, true);
+    }
+    printf("%llu ticks importados, %llu fuera de orden\n", (unsigned long long)imported,
+           (unsigned long long)outOfOrder);
+    return 0;
+}
+
+static int total(const char* directory, const char* gaugeName, uint32_t from, uint32_t to) {
+    std::vector<uint32_t> gauges;
+    if (strcmp(gaugeName, "all") == 0) {
+        gauges = listGauges(directory);
+    } else {
+        gauges.push_back((uint32_t)strtoul(gaugeName, NULL, 10));
+    }
+
+    rangeTotal_t sum = {0, 0};
+    for (uint32_t gauge : gauges) {
+        column_t column;
+        columnOpen(&column, directory, gauge, false);
+        rangeTotal_t result = columnTotal(&column, from, to);
+        sum.tenths += result.tenths;
+        sum.tips += result.tips;
+        columnClose(&column, false);
+    }
+    printTotal("total", from, to, sum);
+    return 0;
+}
+
+static int stats(const char* directory) {
+    for (uint32_t gauge : listGauges(directory)) {
+        column_t column;
+        uint64_t count = 0;
+        uint64_t tenths = 0;
+        columnOpen(&column, directory, gauge, false);
+        if (column.segments.empty()) {
+            continue;
+        }
+        for (const segment_t& segment : column.segments) {
+            count += segment.header->count;
+            tenths += segment.header->total;
+        }
+        printf("pluviómetro %u: %zu segmentos, %llu ticks, %lu a %lu, %llu.%llu mm\n", (unsigned)gauge,
+               column.segments.size(), (unsigned long long)count,
+               (unsigned long)column.segments.front().header->firstTime,
+               (unsigned long)column.segments.back().header->lastTime, (unsigned long long)(tenths / 10),
+               (unsigned long long)(tenths % 10));
+        columnClose(&column, false);
+    }
+    return 0;
+}
+
+static double percentile(std::vector<double>& sorted, double fraction) {
+    size_t index = (size_t)(fraction * (double)(sorted.size() - 1));
+    return sorted[index];
+}
+
+static void printLatencies(const char* label, std::vector<double>& latencies) {
+    std::sort(latencies.begin(), latencies.end());
+    printf("%s: p50 %.2f us, p99 %.2f us, max %.2f us (%zu consultas)\n", label, percentile(latencies, 0.5),
+           percentile(latencies, 0.99), latencies.back(), latencies.size());
+}
+
+/**
+ * @brief Genera ticks sintéticos en varios pluviómetros y mide las consultas de rango.
+ *
+ * Los ticks llegan en tormentas separadas por días secos, con la lluvia por
+ * tick entre 1 y 3 veces MM_PER_TICK (una corrección como la de modules/gauge).
+ */
+static int bench(const char* directory, uint64_t events, uint32_t gaugeCount, uint32_t queries, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<column_t> columns(gaugeCount);
+    uint64_t perGauge = events / gaugeCount;
+
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+        perror(directory);
+        return 1;
+    }
+    if (!listGauges(directory).empty()) {
+        fprintf(stderr, "%s: el banco necesita un directorio vacío\n", directory);
+        return 1;
+    }
+
+    // Carga: ~150 s entre ticks en promedio para que 10^7 ticks por pluviómetro quepan en 32 bits
+    auto start = std::chrono::steady_clock::now();
+    std::uniform_int_distribution<uint32_t> stormTips(20, 2000);
+    std::uniform_int_distribution<uint32_t> tipGap(1, 120);
+    std::uniform_int_distribution<uint32_t> dryGap(3600, 2 * SECONDS_PER_DAY);
+    std::uniform_int_distribution<int> amount(MM_PER_TICK, 3 * MM_PER_TICK);
+    uint32_t lastTime = TIME_INI;
+    uint64_t failures = 0;
+    for (uint32_t gauge = 0; gauge < gaugeCount; gauge++) {
+        column_t* column = &columns[gauge];
+        uint32_t now = TIME_INI;
+        uint64_t written = 0;
+        columnOpen(column, directory, gauge, true);
+        while (written < perGauge) {
+            // Una tormenta y el período seco siguiente duran menos de 5 días
+            if (now > UINT32_MAX - 5 * SECONDS_PER_DAY) {
+                fprintf(stderr, "pluviómetro %u: demasiados ticks para instantes de 32 bits\n", (unsigned)gauge);
+                return 1;
+            }
+            for (uint32_t tips = stormTips(rng); tips > 0 && written < perGauge; tips--) {
+                now += tipGap(rng);
+                failures += columnAppend(column, directory, now, (uint8_t)amount(rng)) ? 0 : 1;
+                written++;
+            }
+            now += dryGap(rng);
+        }
+        lastTime = std::max(lastTime, now);
+    }
+    double load = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Rangos al azar de hasta un año en un pluviómetro, verificados contra el recorrido directo en una muestra
+    std::uniform_int_distribution<uint32_t> gaugeDraw(0, gaugeCount - 1);
+    std::uniform_int_distribution<uint32_t> startDraw(TIME_INI, lastTime);
+    std::uniform_int_distribution<uint32_t> lengthDraw(1, SECONDS_PER_YEAR);
+    std::vector<double> rangeLatency;
+    uint64_t checksum = 0;
+    double scanSeconds = 0.0;
+    uint32_t scans = 0;
+    for (uint32_t i = 0; i < queries; i++) {
+        const column_t* column = &columns[gaugeDraw(rng)];
+        uint32_t from = startDraw(rng);
+        uint32_t to = from + std::min(lengthDraw(rng), UINT32_MAX - from);
+        auto queryStart = std::chrono::steady_clock::now();
+        rangeTotal_t result = columnTotal(column, from, to);
+        rangeLatency.push_back(
+            std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - queryStart).count());
+        checksum += result.tenths;
+        if (i % (queries / 200 + 1) == 0) {
+            auto scanStart = std::chrono::steady_clock::now();
+            rangeTotal_t expected = columnScan(column, from, to);
+            scanSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - scanStart).count();
+            scans++;
+            failures += expected.tenths != result.tenths || expected.tips != result.tips ? 1 : 0;
+        }
+    }
+
+    // Total de la cuenca: un año calendario en todos los pluviómetros
+    std::vector<double> basinLatency;
+    for (uint32_t i = 0; i < std::max(queries / 100, 10u); i++) {
+        uint32_t from = startDraw(rng);
+        uint32_t to = from + std::min((uint32_t)SECONDS_PER_YEAR, UINT32_MAX - from);
+        auto queryStart = std::chrono::steady_clock::now();
+        for (const column_t& column : columns) {
+            checksum += columnTotal(&column, from, to).tenths;
+        }
+        basinLatency.push_back(
+            std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - queryStart).count());
+    }
+
+    uint64_t bytes = 0;
+    for (column_t& column : columns) {
+        for (const segment_t& segment : column.segments) {
+            bytes += (uint64_t)segment.header->count * (sizeof(uint32_t) + 1);
+        }
+    }
+    printf("carga             : %llu ticks en %u pluviómetros, %.1f s (%.1f M ticks/s), %.2f GB de columnas\n",
+           (unsigned long long)(perGauge * gaugeCount), (unsigned)gaugeCount, load,
+           perGauge * gaugeCount / load / 1e6, bytes / 1e9);
+    printLatencies("rango (1 pluv.)   ", rangeLatency);
+    printLatencies("año de la cuenca  ", basinLatency);
+    printf("recorrido directo : %.1f ms por consulta de rango (%u verificadas)\n", scanSeconds * 1e3 / scans,
+           (unsigned)scans);
+    printf("suma de control   : %llu\n", (unsigned long long)checksum);
+    printf("errores           : %llu\n", (unsigned long long)failures);
+
+    for (column_t& column : columns) {
+        columnClose(&column, false);
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+static int usage(const char* program) {
+    fprintf(stderr,
+            "uso: %s import directorio pluviómetro [texto]\n"
+            "     %s import-records directorio eventos.bin\n"
+            "     %s total directorio pluviómetro|all desde hasta\n"
+            "     %s stats directorio\n"
+            "     %s bench directorio [--events n] [--gauges n] [--queries n] [--seed n] [--segment-events n]\n",
+            program, program, program, program, program);
+    return 2;
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        return usage(argv[0]);
+    }
+    const char* command = argv[1];
+    const char* directory = argv[2];
+
+    if (strcmp(command, "import") == 0 && (argc == 4 || argc == 5)) {
+        FILE* input = argc == 5 ? fopen(argv[4], "r") : stdin;
+        if (input == NULL || (mkdir(directory, 0755) != 0 && errno != EEXIST)) {
+            perror(input == NULL ? argv[4] : directory);
+            return 1;
+        }
+        return importText(directory, (uint32_t)strtoul(argv[3], NULL, 10), input);
+    }
+    if (strcmp(command, "import-records") == 0 && argc == 4) {
+        FILE* input = fopen(argv[3], "rb");
+        if (input == NULL || (mkdir(directory, 0755) != 0 && errno != EEXIST)) {
+            perror(input == NULL ? argv[3] : directory);
+            return 1;
+        }
+        return importRecords(directory, input);
+    }
+    if (strcmp(command, "total") == 0 && argc == 6) {
+        return total(directory, argv[3], (uint32_t)strtoul(argv[4], NULL, 10), (uint32_t)strtoul(argv[5], NULL, 10));
+    }
+    if (strcmp(command, "stats") == 0 && argc == 3) {
+        return stats(directory);
+    }
+    if (strcmp(command, "bench") == 0) {
+        uint64_t events = 100000000;
+        uint32_t gauges = 100;
+        uint32_t queries = 100000;
+        uint64_t seed = 1;
+        for (int i = 3; i < argc; i++) {
+            if (strcmp(argv[i], "--events") == 0 && i + 1 < argc) {
+                events = strtoull(argv[++i], NULL, 10);
+            } else if (strcmp(argv[i], "--gauges") == 0 && i + 1 < argc) {
+                gauges = (uint32_t)strtoul(argv[++i], NULL, 10);
+            } else if (strcmp(argv[i], "--queries") == 0 && i + 1 < argc) {
+                queries = (uint32_t)strtoul(argv[++i], NULL, 10);
+            } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+                seed = strtoull(argv[++i], NULL, 10);
+            } else if (strcmp(argv[i], "--segment-events") == 0 && i + 1 < argc) {
+                segmentEvents = (uint32_t)strtoul(argv[++i], NULL, 10);
+            } else {
+                return usage(argv[0]);
+            }
+        }
+        if (gauges == 0 || queries == 0 || events < gauges || segmentEvents == 0) {
+            return usage(argv[0]);
+        }
+        return bench(directory, events, gauges, queries, seed);
+    }
+    return usage(argv[0]);
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,612 @@
+/*
+ * Nombre del archivo: bench.cpp
+ * Descripción: Banco de rendimiento de los caminos críticos del firmware con comparación contra una base.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Banco de rendimiento de los módulos del firmware en PC.
+ **
+ ** Cada caso se repite hasta durar al menos --min-time ms y se queda con la
+ ** mejor de --repeat corridas. Por operación informa ns, reservas de memoria
+ ** (malloc, calloc, realloc y operator new) y bytes entregados a la UART
+ ** simulada. Con --json los resultados se guardan como JSON, un caso por
+ ** línea; con --baseline se comparan contra un archivo guardado antes y el
+ ** programa termina con 1 si algún caso empeoró más que --threshold por
+ ** ciento en tiempo o bytes, o si reserva memoria donde antes no lo hacía.
+ **
+ ** Uso:
+ **   bench [--filter texto] [--min-time ms] [--repeat n] [--json archivo]
+ **         [--baseline archivo] [--threshold pct]
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include "mbed.h"
+#include "arm_book_lib.h"
+#include "hostsim.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "delay.h"
+#include "debounce.h"
+#include "multidebounce.h"
+#include "timerwheel.h"
+#include "logger.h"
+#include "pluviometer.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define US_PER_MS 1000ULL
+#define US_PER_S 1000000ULL
+#define REPORT_INTERVAL_US (60 * US_PER_S)  ///< RAINFALL_CHECK_INTERVAL de main.cpp
+#define ACTIVE_WINDOW_US (2 * (DEBOUNCE_TIME + DELAY_BETWEEN_TICK) * US_PER_MS)
+#define FSM_COPIES_MAX 32     ///< Copias de la FSM en el caso más grande
+#define WHEEL_TIMERS 10000    ///< Temporizadores concurrentes de timerwheel_10k
+
+/* === Private data type declarations ========================================================== */
+
+/**
+ * @brief Cuerpo de un caso: ejecuta iterations operaciones y retorna las realizadas.
+ */
+typedef uint64_t (*benchBody_t)(uint64_t iterations);
+
+/**
+ * @brief Preparación de un caso, fuera de la medición.
+ */
+typedef void (*benchSetup_t)(uint64_t iterations);
+
+typedef struct {
+    const char* name;
+    benchBody_t body;
+    benchSetup_t setup;  ///< Puede ser NULL
+} benchCase_t;
+
+typedef struct {
+    std::string name;
+    uint64_t ops;
+    double nsPerOp;
+    double allocsPerOp;
+    double bytesPerOp;
+} benchResult_t;
+
+/* === Private variable declarations =========================================================== */
+
+static uint64_t allocations = 0;  ///< Reservas de memoria desde el arranque
+static volatile uint32_t sink = 0;  ///< Evita que el compilador descarte los resultados
+
+/* Las demoras quedan enlazadas en la rueda de modules/delay: deben vivir todo el programa */
+static delay_t readDelay;
+static delay_t debounceDelay;
+static delay_t fsmDelays[FSM_COPIES_MAX];  ///< Una demora por copia de la FSM
+
+static timerWheel_t benchWheel;
+static wheelTimer_t wheelTimers[WHEEL_TIMERS];
+
+static std::vector<uint64_t> edgeTimes;  ///< Flancos de la tormenta en curso, en us
+static std::vector<int> edgeLevels;
+static size_t nextEdge = 0;
+
+/* === Public function declarations ============================================================ */
+
+const char* DateTimeNow(void);  // Definida en pluviometer.cpp, sin declaración pública
+
+/* === Private function implementation ========================================================= */
+
+/*
+ * Reemplaza las funciones de reserva de la biblioteca C para contarlas;
+ * operator new las usa, así que también queda contado.
+ */
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+
+extern "C" void* malloc(size_t size) __THROW {
+    allocations++;
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) __THROW {
+    allocations++;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size) __THROW {
+    allocations++;
+    return __libc_realloc(pointer, size);
+}
+
+static uint64_t stimulusNext() {
+    return nextEdge < edgeTimes.size() ? edgeTimes[nextEdge] : HOST_TIME_NEVER;
+}
+
+static void stimulusFire() {
+    hostPinWrite(SWITCH_TICK_RAIN, edgeLevels[nextEdge]);
+    nextEdge++;
+}
+
+static const hostStimulus_t stimulus = {stimulusNext, stimulusFire};
+
+/**
+ * @brief delayRead() con el reloj avanzando 1 ms por llamada sobre una demora de DEBOUNCE_TIME.
+ */
+static uint64_t benchDelayRead(uint64_t iterations) {
+    uint32_t expired = 0;
+
+    for (uint64_t i = 0; i < iterations; i++) {
+        hostClockAdvanceTo(hostClockNowUs() + US_PER_MS);
+        expired += delayRead(&readDelay);
+    }
+    sink = sink + expired;
+    return iterations;
+}
+
+/**
+ * @brief debounceFSM_update() muestreando cada 1 ms un botón que cambia cada 200 ms con rebotes.
+ */
+static uint64_t benchDebounceFsm(uint64_t iterations) {
+    uint32_t presses = 0;
+
+    for (uint64_t i = 0; i < iterations; i++) {
+        uint32_t phase = (uint32_t)(i % 200);
+        hostPinWrite(BUTTON1, phase < 100 ? (phase < 6 ? (int)(phase & 1) : 1) : 0);
+        hostClockAdvanceTo(hostClockNowUs() + US_PER_MS);
+        debounceFSM_update(&debounceDelay);
+        presses += readKey();
+    }
+    sink = sink + presses;
+    return iterations;
+}
+
+/**
+ * @brief copies llamadas a debounceFSM_update() por muestra, cada una con su demora.
+ *
+ * Es lo que cuesta antirrebotar copies entradas con la FSM actual; el estado
+ * de la FSM es global, pero el costo por llamada no depende de eso. Una
+ * operación es una muestra de todas las entradas, igual que en
+ * multidebounce_update_*.
+ */
+static uint64_t benchDebounceFsmCopies(uint64_t iterations, uint32_t copies) {
+    uint32_t presses = 0;
+
+    for (uint64_t i = 0; i < iterations; i++) {
+        uint32_t phase = (uint32_t)(i % 200);
+        hostPinWrite(BUTTON1, phase < 100 ? (phase < 6 ? (int)(phase & 1) : 1) : 0);
+        hostClockAdvanceTo(hostClockNowUs() + US_PER_MS);
+        for (uint32_t copy = 0; copy < copies; copy++) {
+            debounceFSM_update(&fsmDelays[copy]);
+        }
+        presses += readKey();
+    }
+    sink = sink + presses;
+    return iterations;
+}
+
+static uint64_t benchDebounceFsm8(uint64_t iterations) {
+    return benchDebounceFsmCopies(iterations, 8);
+}
+
+static uint64_t benchDebounceFsm32(uint64_t iterations) {
+    return benchDebounceFsmCopies(iterations, 32);
+}
+
+/**
+ * @brief multiDebounceUpdate() con 1, 8 o 32 canales que cambian con rebotes.
+ */
+static uint64_t benchMultiDebounce(uint64_t iterations, uint32_t mask) {
+    multiDebounce_t debounce;
+    uint32_t tips = 0;
+    uint32_t noise = 1;
+
+    multiDebounceInit(&debounce, mask, 0);
+    for (uint64_t i = 0; i < iterations; i++) {
+        noise = noise * 1664525u + 1013904223u;
+        uint32_t level = (i / 50) & 1 ? mask : 0;
+        tips += __builtin_popcount(multiDebounceUpdate(&debounce, level ^ (noise & mask & 0x01010101u)));
+    }
+    sink = sink + tips;
+    return iterations;
+}
+
+static uint64_t benchMultiDebounce1(uint64_t iterations) {
+    return benchMultiDebounce(iterations, 0x1u);
+}
+
+static uint64_t benchMultiDebounce8(uint64_t iterations) {
+    return benchMultiDebounce(iterations, 0xFFu);
+}
+
+static uint64_t benchMultiDebounce32(uint64_t iterations) {
+    return benchMultiDebounce(iterations, 0xFFFFFFFFu);
+}
+
+/**
+ * @brief Arranca WHEEL_TIMERS temporizadores periódicos con vencimientos repartidos en los cuatro niveles.
+ */
+static void setupWheel(uint64_t iterations) {
+    std::mt19937 rng(WHEEL_TIMERS);
+    std::uniform_int_distribution<tick_t> periods(1, 300000);
+
+    timerWheelInit(&benchWheel, 0);
+    for (uint32_t i = 0; i < WHEEL_TIMERS; i++) {
+        tick_t period = periods(rng);
+        wheelTimerInit(&wheelTimers[i], NULL, NULL);
+        timerWheelStart(&benchWheel, &wheelTimers[i], rng() % period, period);
+    }
+}
+
+/**
+ * @brief Rueda con WHEEL_TIMERS temporizadores: por operación un rearranque, una cancelación y un tick.
+ *
+ * Los vencimientos y las cascadas de los periódicos entran en el costo del tick.
+ */
+static uint64_t benchTimerWheel(uint64_t iterations) {
+    uint32_t fired = 0;
+    uint32_t noise = 1;
+
+    for (uint64_t i = 0; i < iterations; i++) {
+        noise = noise * 1664525u + 1013904223u;
+        wheelTimer_t* timer = &wheelTimers[noise % WHEEL_TIMERS];
+        timerWheelStart(&benchWheel, timer, (noise >> 8) % 300000, timer->period);
+        timerWheelCancel(&benchWheel, &wheelTimers[(noise >> 4) % WHEEL_TIMERS]);
+        fired += timerWheelAdvance(&benchWheel, benchWheel.current + 1);
+    }
+    sink = sink + fired + benchWheel.count;
+    return iterations;
+}
+
+/**
+ * @brief DateTimeNow() con el RTC avanzando un segundo por llamada.
+ */
+static uint64_t benchDateTimeNow(uint64_t iterations) {
+    uint32_t digits = 0;
+
+    for (uint64_t i = 0; i < iterations; i++) {
+        hostClockAdvanceTo(hostClockNowUs() + US_PER_S);
+        digits += (uint8_t)DateTimeNow()[18];
+    }
+    sink = sink + digits;
+    return iterations;
+}
+
+/**
+ * @brief Conversión a texto del registro de printAccumulatedRainfall().
+ */
+static uint64_t benchFormatAccumulated(uint64_t iterations) {
+    logRecord_t record;
+    char text[LOG_TEXT_MAX];
+    size_t length = 0;
+
+    record.id = LOG_EVENT_ACCUMULATED_RAINFALL;
+    record.timestamp = TIME_INI;
+    for (uint64_t i = 0; i < iterations; i++) {
+        record.timestamp += 60;
+        record.arg = (int32_t)(i % 1000);
+        length += logFormatText(&record, text);
+    }
+    sink = sink + (uint32_t)length;
+    return iterations;
+}
+
+/**
+ * @brief reportRainfall() completo y su transmisión por la UART.
+ */
+static uint64_t benchReportRainfall(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+        hostClockAdvanceTo(hostClockNowUs() + REPORT_INTERVAL_US);
+        reportRainfall();
+        loggerFlush();
+    }
+    return iterations;
+}
+
+/**
+ * @brief Genera los flancos de una tormenta sintética de iterations ticks.
+ *
+ * Los ticks llegan cada 1 a 10 s con 0 a 3 rebotes por flanco.
+ */
+static void setupStorm(uint64_t iterations) {
+    std::mt19937_64 rng(iterations);
+    std::uniform_int_distribution<uint64_t> gapUs(1 * US_PER_S, 10 * US_PER_S);
+    std::uniform_int_distribution<uint64_t> bounceUs(100, 3 * US_PER_MS);
+    std::uniform_int_distribution<int> bounces(0, 3);
+
+    uint64_t t = hostClockNowUs() + US_PER_S;
+    edgeTimes.clear();
+    edgeLevels.clear();
+    for (uint64_t i = 0; i < iterations; i++) {
+        t += gapUs(rng);
+        for (int level = 1; level >= 0; level--) {
+            edgeTimes.push_back(t);
+            edgeLevels.push_back(level);
+            for (int b = bounces(rng); b > 0; b--) {
+                t += bounceUs(rng);
+                edgeTimes.push_back(t);
+                edgeLevels.push_back(!level);
+                t += bounceUs(rng);
+                edgeTimes.push_back(t);
+                edgeLevels.push_back(level);
+            }
+            t += 100 * US_PER_MS;
+        }
+    }
+    nextEdge = 0;
+}
+
+/**
+ * @brief Tormenta de setupStorm() a través del bucle de main.cpp; una operación es un tick.
+ *
+ * El reporte corre en cada :00 de minuto con el planificador, como en el firmware.
+ */
+static uint64_t benchStorm(uint64_t iterations) {
+    uint64_t endUs = edgeTimes.empty() ? hostClockNowUs() : edgeTimes.back() + ACTIVE_WINDOW_US;
+    uint64_t nextScheduleUs = hostClockNowUs();
+    uint64_t lastEdgeUs = 0;
+
+    hostSetStimulus(&stimulus);
+    while (hostClockNowUs() < endUs) {
+        if (isRaining()) {
+            actOnRainfall();
+        } else {
+            tickLed = OFF;
+        }
+        if (isScheduleDue()) {
+            nextScheduleUs = hostClockNowUs() + runSchedule() * US_PER_MS;
+        }
+        loggerDrain();
+
+        // Fuera de la actividad del sensor se salta al próximo flanco o reporte, como tools/replay
+        uint64_t now = hostClockNowUs();
+        uint64_t target = now + US_PER_MS;
+        if (nextEdge > 0) {
+            lastEdgeUs = edgeTimes[nextEdge - 1];
+        }
+        if (now >= lastEdgeUs + ACTIVE_WINDOW_US) {
+            uint64_t next = stimulusNext() < nextScheduleUs ? stimulusNext() : nextScheduleUs;
+            target = next > target ? next : target;
+        }
+        hostClockAdvanceTo(target < endUs ? target : endUs);
+    }
+    loggerFlush();
+    hostSetStimulus(NULL);
+    return iterations;
+}
+
+static const benchCase_t benchCases[] = {
+    {"delay_read", benchDelayRead, NULL},
+    {"debounce_fsm_update", benchDebounceFsm, NULL},
+    {"debounce_fsm_x8", benchDebounceFsm8, NULL},
+    {"debounce_fsm_x32", benchDebounceFsm32, NULL},
+    {"multidebounce_update_1ch", benchMultiDebounce1, NULL},
+    {"multidebounce_update_8ch", benchMultiDebounce8, NULL},
+    {"multidebounce_update_32ch", benchMultiDebounce32, NULL},
+    {"timerwheel_10k", benchTimerWheel, setupWheel},
+    {"datetime_now", benchDateTimeNow, NULL},
+    {"format_accumulated_rainfall", benchFormatAccumulated, NULL},
+    {"report_rainfall", benchReportRainfall, NULL},
+    {"storm_per_tip", benchStorm, setupStorm},
+};
+
+/**
+ * @brief Ejecuta un caso hasta que dure al menos minNs y se queda con la mejor corrida.
+ */
+static benchResult_t runCase(const benchCase_t* bench, double minNs, int repeat) {
+    benchResult_t best = {bench->name, 0, INFINITY, 0.0, 0.0};
+    uint64_t iterations = 1;
+
+    for (int round = 0; round < repeat; round++) {
+        while (true) {
+            if (bench->setup != NULL) {
+                bench->setup(iterations);
+            }
+            uint64_t allocationsBefore = allocations;
+            uint64_t bytesBefore = hostSerialBytesWritten();
+            auto start = std::chrono::steady_clock::now();
+            uint64_t ops = bench->body(iterations);
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+            if (ns < minNs && ops > 0) {
+                // Se estima cuántas iteraciones alcanzan el mínimo, con margen
+                double scale = ns > 0 ? 1.2 * minNs / ns : 100.0;
+                iterations = (uint64_t)(iterations * (scale > 100.0 ? 100.0 : scale)) + 1;
+                continue;
+            }
+            if (ops > 0 && ns / ops < best.nsPerOp) {
+                best.ops = ops;
+                best.nsPerOp = ns / ops;
+                best.allocsPerOp = (double)(allocations - allocationsBefore) / ops;
+                best.bytesPerOp = (double)(hostSerialBytesWritten() - bytesBefore) / ops;
+            }
+            break;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Guarda los resultados como JSON, un caso por línea.
+ */
+static bool writeJson(const char* path, const std::vector<benchResult_t>& results) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        perror(path);
+        return false;
+    }
+    fprintf(file, "{\n  \"unit\": \"ns\",\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        fprintf(file, "    {\"name\": \"%s\", \"ops\": %llu, \"ns_per_op\": %.3f, \"allocs_per_op\": %.3f, "
+                "\"bytes_per_op\": %.3f}%s\n",
+                results[i].name.c_str(), (unsigned long long)results[i].ops, results[i].nsPerOp,
+                results[i].allocsPerOp, results[i].bytesPerOp, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+    return true;
+}
+
+/**
+ * @brief Lee un archivo escrito por writeJson().
+ */
+static bool readJson(const char* path, std::vector<benchResult_t>& results) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        perror(path);
+        return false;
+    }
+
+    char line[512];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char name[128];
+        unsigned long long ops;
+        benchResult_t result;
+        const char* object = strstr(line, "{\"name\"");
+        if (object != NULL &&
+            sscanf(object, "{\"name\": \"%127[^\"]\", \"ops\": %llu, \"ns_per_op\": %lf, \"allocs_per_op\": %lf, "
+                   "\"bytes_per_op\": %lf", name, &ops, &result.nsPerOp, &result.allocsPerOp,
+                   &result.bytesPerOp) == 5) {
+            result.name = name;
+            result.ops = ops;
+            results.push_back(result);
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+/**
+ * @brief Compara con la base e imprime los cambios; retorna la cantidad de regresiones.
+ */
+static int compare(const std::vector<benchResult_t>& results, const std::vector<benchResult_t>& baseline,
+                   double threshold) {
+    int regressions = 0;
+
+    printf("\n%-28s %12s %12s %8s  %s\n", "caso", "base ns/op", "ns/op", "cambio", "veredicto");
+    for (const benchResult_t& result : results) {
+        const benchResult_t* base = NULL;
+        for (const benchResult_t& candidate : baseline) {
+            if (candidate.name == result.name) {
+                base = &candidate;
+            }
+        }
+        if (base == NULL) {
+            printf("%-28s %12s %12.2f %8s  nuevo\n", result.name.c_str(), "-", result.nsPerOp, "-");
+            continue;
+        }
+
+        double change = base->nsPerOp > 0 ? result.nsPerOp / base->nsPerOp - 1.0 : 0.0;
+        const char* verdict = "ok";
+        if (change > threshold) {
+            verdict = "REGRESION de tiempo";
+        } else if (result.allocsPerOp > base->allocsPerOp + 1e-3) {
+            verdict = "REGRESION de memoria";
+        } else if (result.bytesPerOp > base->bytesPerOp * (1.0 + threshold) + 1e-3) {
+            verdict = "REGRESION de bytes";
+        } else if (change < -threshold) {
+            verdict = "mejora";
+        }
+        if (strncmp(verdict, "REGRESION", 9) == 0) {
+            regressions++;
+        }
+        printf("%-28s %12.2f %12.2f %+7.1f%%  %s\n", result.name.c_str(), base->nsPerOp, result.nsPerOp,
+               change * 100.0, verdict);
+    }
+    return regressions;
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char* argv[]) {
+    const char* filter = NULL;
+    const char* jsonPath = NULL;
+    const char* baselinePath = NULL;
+    double minMs = 200.0;
+    double threshold = 0.15;
+    int repeat = 3;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            minMs = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            threshold = atof(argv[++i]) / 100.0;
+        } else {
+            fprintf(stderr, "uso: %s [--filter texto] [--min-time ms] [--repeat n] [--json archivo] "
+                    "[--baseline archivo] [--threshold pct]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (repeat < 1) {
+        repeat = 1;
+    }
+
+    std::vector<benchResult_t> baseline;
+    if (baselinePath != NULL && !readJson(baselinePath, baseline)) {
+        return 2;
+    }
+
+    hostSerialSetSink(NULL);
+    initializeSensors();
+    scheduleReports((int)(REPORT_INTERVAL_US / US_PER_S));
+    delayInit(&readDelay, DEBOUNCE_TIME);
+    delayInit(&debounceDelay, DEBOUNCE_TIME);
+    for (delay_t& delay : fsmDelays) {
+        delayInit(&delay, DEBOUNCE_TIME);
+    }
+    debounceFSM_init();
+
+    std::vector<benchResult_t> results;
+    printf("%-28s %12s %10s %12s %12s\n", "caso", "ops", "ns/op", "reservas/op", "bytes/op");
+    for (const benchCase_t& bench : benchCases) {
+        if (filter != NULL && strstr(bench.name, filter) == NULL) {
+            continue;
+        }
+        benchResult_t result = runCase(&bench, minMs * 1e6, repeat);
+        printf("%-28s %12llu %10.2f %12.3f %12.2f\n", result.name.c_str(), (unsigned long long)result.ops,
+               result.nsPerOp, result.allocsPerOp, result.bytesPerOp);
+        results.push_back(result);
+    }
+
+    if (jsonPath != NULL && !writeJson(jsonPath, results)) {
+        return 2;
+    }
+    if (baselinePath != NULL) {
+        int regressions = compare(results, baseline, threshold);
+        printf("regresiones       : %d (umbral %.0f %%)\n", regressions, threshold * 100.0);
+        return regressions == 0 ? 0 : 1;
+    }
+    return 0;
+}
+
+/* === End of documentation ==================================================================== */
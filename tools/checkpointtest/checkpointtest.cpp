@@ -0,0 +1,201 @@
+/*
+ * Nombre del archivo: checkpointtest.cpp
+ * Descripción: Prueba de cortes de energía de los puntos de control en PC.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+/** @file
+ ** @brief Prueba de cortes de energía de modules/checkpoint en PC.
+ **
+ ** Guarda contenidos numerados en la memoria de respaldo simulada y corta la
+ ** energía tras una cantidad aleatoria de escrituras de palabra (a mitad del
+ ** contenido o de la cabecera). Tras cada corte restaura y verifica que el
+ ** contenido recuperado sea exactamente el último guardado completo o el que
+ ** se estaba guardando, nunca una mezcla ni uno anterior. La memoria empieza
+ ** con basura, como la BKPSRAM sin batería.
+ **
+ ** Informa además las palabras escritas por guardado cuando cambian pocas
+ ** palabras (el caso de un tick) y el tiempo de restauración.
+ **
+ ** Uso:
+ **   checkpointtest [--cycles N] [--words N] [--seed N]
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include "mbed.h"
+#include "hostsim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "checkpoint.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define TEST_TAG 0x54455354  ///< Formato del contenido de prueba
+#define RESTORE_RUNS 10000  ///< Restauraciones para medir el tiempo
+
+/* === Private variable declarations =========================================================== */
+
+static uint32_t failures = 0;
+
+/* === Private function implementation ========================================================= */
+
+static void fail(uint32_t cycle, const char* message, uint32_t a, uint32_t b) {
+    if (failures++ < 10) {
+        fprintf(stderr, "ciclo %u: %s (%u, %u)\n", cycle, message, a, b);
+    }
+}
+
+/**
+ * @brief Prepara el próximo contenido: numera la palabra 0 y cambia algunas otras.
+ *
+ * Como un tick, casi siempre cambian pocas palabras; de vez en cuando cambian todas.
+ */
+static void nextPayload(std::vector<uint32_t>& payload, std::mt19937_64& rng) {
+    payload[0]++;
+    if (rng() % 16 == 0) {
+        for (size_t i = 1; i < payload.size(); i++) {
+            payload[i] = (uint32_t)rng();
+        }
+        return;
+    }
+    size_t changes = 1 + rng() % 3;
+    for (size_t i = 0; i < changes; i++) {
+        payload[1 + rng() % (payload.size() - 1)] = (uint32_t)rng();
+    }
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char* argv[]) {
+    uint32_t cycles = 20000;
+    uint32_t words = 46;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--cycles") == 0 && i + 1 < argc) {
+            cycles = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--words") == 0 && i + 1 < argc) {
+            words = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "uso: %s [--cycles n] [--words n] [--seed n]\n", argv[0]);
+            return 2;
+        }
+    }
+    size_t payloadSize = (size_t)words * sizeof(uint32_t);
+    if (words < 2 || checkpointRegionWords(payloadSize) > CHECKPOINT_BACKUP_WORDS) {
+        fprintf(stderr, "%s: el contenido debe tener entre 2 y %d palabras\n", argv[0],
+                CHECKPOINT_BACKUP_WORDS / 2 - CHECKPOINT_HEADER_WORDS);
+        return 2;
+    }
+
+    std::mt19937_64 rng(seed);
+    volatile uint32_t* memory = checkpointBackupMemory();
+    for (size_t i = 0; i < CHECKPOINT_BACKUP_WORDS; i++) {
+        hostBackupWrite(&memory[i], (uint32_t)rng());
+    }
+
+    std::vector<uint32_t> committed;  // Último contenido guardado por completo (vacío = ninguno)
+    std::vector<uint32_t> attempted;  // Contenido cortado a mitad del guardado
+    std::vector<uint32_t> payload(words, 0);
+    std::vector<uint32_t> restored(words, 0);
+    uint64_t saves = 0;
+    uint64_t smallSaves = 0;
+    uint64_t smallWrites = 0;
+    uint32_t emptyRestores = 0;
+    checkpoint_t checkpoint;
+
+    for (uint32_t cycle = 0; cycle < cycles; cycle++) {
+        hostBackupCutAfter(-1);
+        checkpointInit(&checkpoint, memory, payloadSize, TEST_TAG);
+        bool valid = checkpointRestore(&checkpoint, restored.data());
+
+        if (!valid) {
+            emptyRestores++;
+            if (!committed.empty()) {
+                fail(cycle, "se perdió el último guardado", committed[0], 0);
+            }
+            payload.assign(words, 0);
+        } else if (restored == committed) {
+            payload = committed;
+        } else if (restored == attempted) {
+            committed = attempted;  // El corte llegó después de la última escritura
+            payload = committed;
+        } else {
+            fail(cycle, "contenido restaurado inesperado", restored[0], committed.empty() ? 0 : committed[0]);
+            payload = restored;
+            committed = restored;
+        }
+
+        // Corte en cualquier escritura de los próximos guardados, incluso antes de la primera
+        std::uniform_int_distribution<int64_t> cutAt(0, 4 * (int64_t)(words + CHECKPOINT_HEADER_WORDS));
+        hostBackupCutAfter(cutAt(rng));
+
+        while (true) {
+            std::vector<uint32_t> previous = payload;
+            nextPayload(payload, rng);
+            size_t changed = 0;
+            for (size_t i = 0; i < words; i++) {
+                changed += payload[i] != previous[i];
+            }
+
+            uint64_t writesBefore = hostBackupWrites();
+            checkpointSave(&checkpoint, payload.data());
+            uint64_t landed = hostBackupWrites() - writesBefore;
+            saves++;
+            if (landed < checkpoint.lastWrites) {
+                attempted = payload;
+                break;
+            }
+            committed = payload;
+            if (changed <= 4) {
+                smallSaves++;
+                smallWrites += checkpoint.lastWrites;
+            }
+        }
+    }
+
+    hostBackupCutAfter(-1);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < RESTORE_RUNS; i++) {
+        checkpointInit(&checkpoint, memory, payloadSize, TEST_TAG);
+        checkpointRestore(&checkpoint, restored.data());
+    }
+    double restoreNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / RESTORE_RUNS;
+
+    printf("ciclos             : %u\n", cycles);
+    printf("guardados          : %llu\n", (unsigned long long)saves);
+    printf("sin punto válido   : %u\n", emptyRestores);
+    printf("escrituras/guardado: %.1f palabras con hasta 4 cambios (contenido de %u)\n",
+           smallSaves ? (double)smallWrites / smallSaves : 0.0, words);
+    printf("restauración       : %.0f ns\n", restoreNs);
+    printf("errores            : %u\n", failures);
+    return failures == 0 ? 0 : 1;
+}
+
+/* === End of documentation ==================================================================== */
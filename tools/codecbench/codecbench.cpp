@@ -0,0 +1,342 @@
+/*
+ * Nombre del archivo: codecbench.cpp
+ * Descripción: Prueba de ida y vuelta y medición del codificador de flujos de ticks.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Banco de pruebas de modules/codec en PC.
+ **
+ ** Primero codifica y decodifica flujos al azar (ticks con saltos hacia
+ ** adelante y hacia atrás, instantes extremos y marcas intercaladas) y
+ ** verifica que cada elemento vuelva idéntico; también entrega bytes al azar
+ ** al decodificador. Luego codifica tormentas sintéticas (o una traza en ms
+ ** por línea) e informa bytes por tick y ns por tick al codificar y
+ ** decodificar.
+ **
+ ** Uso:
+ **   codecbench [--streams N] [--days N] [--trace archivo] [--seed N]
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "tipcodec.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define START_MS 1593561600000ull  ///< TIME_INI de pluviometer.h en ms
+#define TEXT_LINE_BYTES 37  ///< "YYYY-MM-DD HH:MM:SS - Rain detected\r\n"
+#define WIRE_RECORD_BYTES 11  ///< LOG_WIRE_SIZE
+
+/* === Private data type declarations ========================================================== */
+
+typedef struct {
+    bool mark;
+    uint8_t kind;
+    uint64_t timestamp;
+    int32_t value;
+} element_t;
+
+/* === Private variable declarations =========================================================== */
+
+static uint64_t failures = 0;
+
+/* === Private function implementation ========================================================= */
+
+static void fail(const char* message, uint64_t stream, size_t index) {
+    if (failures++ < 10) {
+        fprintf(stderr, "flujo %llu, elemento %zu: %s\n", (unsigned long long)stream, index, message);
+    }
+}
+
+/**
+ * @brief Genera un flujo al azar con todos los casos que el formato debe soportar.
+ */
+static void randomStream(std::mt19937_64& rng, std::vector<element_t>& elements) {
+    size_t count = (size_t)(rng() % 200);
+    uint64_t t = (rng() % 4 == 0) ? (rng() % TIP_CODEC_TIMESTAMP_LIMIT) >> (rng() % 61) : START_MS + rng() % (1ull << 40);
+
+    elements.clear();
+    for (size_t i = 0; i < count; i++) {
+        switch (rng() % 8) {
+        case 0:
+            t = rng() % TIP_CODEC_TIMESTAMP_LIMIT;  // Cualquier instante admitido
+            break;
+        case 1:
+            t -= std::min(t, (uint64_t)(rng() % 100000));  // Hacia atrás
+            break;
+        case 2:
+            t = std::min<uint64_t>(t + rng() % (30ull * 86400000), TIP_CODEC_TIMESTAMP_LIMIT - 1);  // Silencio largo
+            break;
+        default:
+            t = std::min<uint64_t>(t + 500 + rng() % 60000, TIP_CODEC_TIMESTAMP_LIMIT - 1);  // Tormenta
+            break;
+        }
+        element_t element = {false, 0, t, 0};
+        if (rng() % 5 == 0) {
+            element.mark = true;
+            element.kind = (uint8_t)(rng() % 128);
+            element.timestamp = rng() % 3 == 0 ? rng() : t + rng() % 120000;
+            element.value = (int32_t)(uint32_t)rng();
+        }
+        elements.push_back(element);
+    }
+}
+
+/**
+ * @brief Codifica y decodifica flujos al azar comparando elemento a elemento.
+ */
+static void fuzz(uint64_t streams, std::mt19937_64& rng) {
+    std::vector<element_t> elements;
+    std::vector<uint8_t> bytes;
+    uint64_t items = 0;
+
+    for (uint64_t stream = 0; stream < streams; stream++) {
+        randomStream(rng, elements);
+
+        tipEncoder_t encoder;
+        tipEncoderInit(&encoder);
+        bytes.clear();
+        for (size_t i = 0; i < elements.size(); i++) {
+            uint8_t out[TIP_CODEC_ITEM_MAX];
+            const element_t& e = elements[i];
+            size_t length = e.mark ? tipEncodeMark(&encoder, e.kind, e.timestamp, e.value, out)
+                                   : tipEncodeTip(&encoder, e.timestamp, out);
+            if (length == 0 || length > TIP_CODEC_ITEM_MAX) {
+                fail("largo fuera de rango", stream, i);
+            }
+            bytes.insert(bytes.end(), out, out + length);
+        }
+
+        tipDecoder_t decoder;
+        tipDecoderInit(&decoder);
+        size_t next = 0;
+        for (size_t i = 0; i < bytes.size(); i++) {
+            tipCodecItem_t item;
+            if (!tipDecoderPush(&decoder, bytes[i], &item)) {
+                continue;
+            }
+            if (next >= elements.size()) {
+                fail("elemento de más", stream, next);
+                break;
+            }
+            const element_t& e = elements[next];
+            if (item.mark != e.mark || item.timestamp != e.timestamp ||
+                (e.mark && (item.kind != e.kind || item.value != e.value))) {
+                fail("elemento distinto", stream, next);
+            }
+            next++;
+        }
+        if (next != elements.size() || decoder.errors != 0) {
+            fail("faltan elementos", stream, next);
+        }
+        items += elements.size();
+    }
+
+    // Basura: no debe colgarse ni leer fuera de su estado
+    tipDecoder_t decoder;
+    tipDecoderInit(&decoder);
+    uint64_t garbageItems = 0;
+    for (uint64_t i = 0; i < streams * 64; i++) {
+        tipCodecItem_t item;
+        garbageItems += tipDecoderPush(&decoder, (uint8_t)rng(), &item) ? 1 : 0;
+    }
+
+    printf("ida y vuelta      : %llu flujos, %llu elementos\n", (unsigned long long)streams,
+           (unsigned long long)items);
+    printf("basura            : %llu bytes, %llu elementos, %lu varints inválidos\n",
+           (unsigned long long)streams * 64, (unsigned long long)garbageItems, (unsigned long)decoder.errors);
+}
+
+/**
+ * @brief Tormentas sintéticas como las de tools/replay, con instantes en ms.
+ */
+static void syntheticTrace(double days, std::mt19937_64& rng, std::vector<uint64_t>& tips) {
+    std::exponential_distribution<double> stormGap(1.0 / (2.5 * 86400.0));
+    std::uniform_real_distribution<double> stormHours(0.5, 8.0);
+    std::uniform_real_distribution<double> peakTipsPerSecond(10.0 / 3600.0, 400.0 / 3600.0);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    double horizon = days * 86400.0;
+    double t = stormGap(rng);
+    while (t < horizon) {
+        double duration = stormHours(rng) * 3600.0;
+        double peak = peakTipsPerSecond(rng);
+        double s = t;
+        while (true) {
+            s += -log(1.0 - unit(rng)) / peak;
+            if (s >= t + duration || s >= horizon) {
+                break;
+            }
+            double phase = (s - t) / duration;
+            double profile = phase < 0.5 ? 2.0 * phase : 2.0 * (1.0 - phase);
+            if (unit(rng) < profile) {
+                tips.push_back(START_MS + (uint64_t)(s * 1000.0));
+            }
+        }
+        t += duration + stormGap(rng);
+    }
+}
+
+/**
+ * @brief Lee una traza con un tick por línea en ms.
+ */
+static bool loadTrace(const char* path, std::vector<uint64_t>& tips) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        perror(path);
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        unsigned long long ms;
+        if (line[0] != '#' && sscanf(line, "%llu", &ms) == 1) {
+            tips.push_back(START_MS + ms);
+        }
+    }
+    fclose(file);
+    std::sort(tips.begin(), tips.end());
+    return true;
+}
+
+/**
+ * @brief Mide el flujo de una traza.
+ */
+static void measure(const std::vector<uint64_t>& tips) {
+    std::vector<uint8_t> bytes(tips.size() * TIP_CODEC_ITEM_MAX);
+    size_t histogram[TIP_CODEC_ITEM_MAX + 1] = {0};
+    size_t total = 0;
+    const int rounds = 20;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        tipEncoder_t encoder;
+        tipEncoderInit(&encoder);
+        total = 0;
+        for (size_t i = 0; i < tips.size(); i++) {
+            total += tipEncodeTip(&encoder, tips[i], &bytes[total]);
+        }
+    }
+    double encodeNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    tipEncoder_t encoder;
+    tipEncoderInit(&encoder);
+    uint8_t out[TIP_CODEC_ITEM_MAX];
+    size_t first = 0;
+    for (size_t i = 0; i < tips.size(); i++) {
+        size_t length = tipEncodeTip(&encoder, tips[i], out);
+        if (i == 0) {
+            first = length;
+        } else {
+            histogram[length]++;
+        }
+    }
+
+    uint64_t sink = 0;
+    size_t decoded = 0;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        tipDecoder_t decoder;
+        tipDecoderInit(&decoder);
+        decoded = 0;
+        for (size_t i = 0; i < total; i++) {
+            tipCodecItem_t item;
+            if (tipDecoderPush(&decoder, bytes[i], &item)) {
+                if (item.timestamp != tips[decoded]) {
+                    fail("tick de la traza distinto", 0, decoded);
+                }
+                sink += item.timestamp;
+                decoded++;
+            }
+        }
+    }
+    double decodeNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    if (decoded != tips.size()) {
+        fail("faltan ticks de la traza", 0, decoded);
+    }
+
+    double perTip = tips.size() > 1 ? (double)(total - first) / (double)(tips.size() - 1) : 0.0;
+    printf("ticks             : %zu (%zu bytes, el primero %zu)\n", tips.size(), total, first);
+    printf("bytes por tick    : %.2f (texto %d, binario %d)\n", perTip, TEXT_LINE_BYTES, WIRE_RECORD_BYTES);
+    printf("largos            :");
+    for (size_t length = 1; length <= TIP_CODEC_ITEM_MAX; length++) {
+        if (histogram[length] > 0) {
+            printf(" %zu B %.1f%%", length, 100.0 * histogram[length] / (double)(tips.size() - 1));
+        }
+    }
+    printf("\n");
+    printf("codificar         : %.1f ns por tick\n", encodeNs / rounds / (double)tips.size());
+    printf("decodificar       : %.1f ns por tick (suma de control %llu)\n", decodeNs / rounds / (double)tips.size(),
+           (unsigned long long)(sink & 0xFFFF));
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char* argv[]) {
+    uint64_t streams = 100000;
+    double days = 365.0;
+    const char* tracePath = NULL;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--streams") == 0 && i + 1 < argc) {
+            streams = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--days") == 0 && i + 1 < argc) {
+            days = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "uso: %s [--streams n] [--days n] [--trace archivo] [--seed n]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::mt19937_64 rng(seed);
+    fuzz(streams, rng);
+
+    std::vector<uint64_t> tips;
+    if (tracePath != NULL) {
+        if (!loadTrace(tracePath, tips)) {
+            return 1;
+        }
+    } else {
+        syntheticTrace(days, rng, tips);
+    }
+    if (!tips.empty()) {
+        measure(tips);
+    }
+
+    printf("errores           : %llu\n", (unsigned long long)failures);
+    return failures == 0 ? 0 : 1;
+}
+
+/* === End of documentation ==================================================================== */
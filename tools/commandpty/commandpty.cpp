@@ -0,0 +1,538 @@
+/*
+ * Nombre del archivo: commandpty.cpp
+ * Descripción: Latencia de los comandos por la UART sobre una pseudoterminal durante una tormenta.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+/** @file
+ ** @brief Prueba de los comandos de consulta sobre una pseudoterminal.
+ **
+ ** Conecta el puerto serie simulado del firmware al lado maestro de una
+ ** pseudoterminal y hace correr el bucle de eventos al ritmo del reloj real
+ ** mientras una tormenta sintética genera ticks con rebotes. Un cliente en
+ ** otro hilo abre el lado esclavo como lo haría un programa de terminal,
+ ** envía comandos ("stats", "tipstats", "rate", "total", "tips", "help" y uno
+ ** inválido) y mide el tiempo real hasta la última línea de cada respuesta.
+ ** Verifica el formato de las respuestas y que no se pierda ningún tick.
+ **
+ ** Compilado con otro LOGGER_WIRE_MODE el cliente decodifica la línea como
+ ** tools/logdecode mientras intercala los comandos: en modo binario las
+ ** respuestas son el texto fuera de los registros, en modo en tramas llegan
+ ** en tramas de texto y en modo compacto los comandos se rechazan. En todos
+ ** verifica que ningún registro ni trama se pierda o corrompa.
+ **
+ ** Con --interactive no lanza el cliente: imprime el nombre del lado esclavo
+ ** para conectarle una terminal (por ejemplo "screen /dev/pts/N").
+ **
+ ** Uso:
+ **   commandpty [--seconds N] [--rate TICKS_POR_S] [--seed N] [--interactive]
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include "mbed.h"
+#include "hostsim.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pluviometer.h"
+#include "eventloop.h"
+#include "logger.h"
+#include "command.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define US_PER_MS 1000ULL
+#define US_PER_S 1000000ULL
+#define MIN_TIP_INTERVAL_US (300 * US_PER_MS)  ///< Tiempo mínimo de vuelco del balancín
+#define RESPONSE_TIMEOUT_MS 5000  ///< Espera máxima por la última línea de una respuesta
+#define STAT_LINES 13  ///< Líneas "stat" de la respuesta a "stats"
+#define TIP_STAT_LINES 20  ///< Líneas "tipstat" de la respuesta a "tipstats"
+#define REPORT_INTERVAL 60  ///< Intervalo del reporte periódico en segundos, como en main.cpp
+
+#if MAIN_LOOP_MODE != MAIN_LOOP_EVENTS || ACQUISITION_MODE == ACQUISITION_POLLING
+#error "commandpty hace correr el bucle de eventos con captura por interrupción o temporizador"
+#endif
+
+/* === Private data type declarations ========================================================== */
+
+typedef struct {
+    uint64_t us;
+    int level;
+} edge_t;
+
+/**
+ * @brief Comando de prueba y la respuesta esperada.
+ */
+typedef struct {
+    const char* name;  ///< Nombre para el informe
+    const char* prefix;  ///< Comienzo de las líneas de la respuesta
+    uint32_t minLines;  ///< Líneas de respuesta esperadas antes de "ok"
+    uint32_t maxLines;
+    bool error;  ///< Se espera "error ..." en lugar de "ok"
+} probeCommand_t;
+
+/* === Private variable declarations =========================================================== */
+
+static const probeCommand_t probeCommands[] = {
+    {"stats", "stat ", STAT_LINES, STAT_LINES, false},
+    {"tipstats", "tipstat ", TIP_STAT_LINES, TIP_STAT_LINES, false},
+    {"rate", "rate ", INTENSITY_WINDOW_COUNT, INTENSITY_WINDOW_COUNT, false},
+    {"total", "total ", 1, 1, false},
+    {"tips 20", "tip ", 0, 20, false},
+    {"help", "", 6, 6, false},
+    {"bogus 1", "", 0, 0, true},
+};
+
+#define PROBE_COMMAND_COUNT (sizeof(probeCommands) / sizeof(probeCommands[0]))
+
+static std::vector<edge_t> edges;
+static size_t nextEdge = 0;
+static uint64_t endUs = 0;
+
+static int masterFd = -1;
+static uint64_t ptyDropped = 0;  ///< Bytes de salida que la pseudoterminal no aceptó
+static std::chrono::steady_clock::time_point wallStart;
+static std::atomic<bool> simulationDone(false);
+
+/* Decodificadores de la línea, usados solo por el cliente */
+static logDecoder_t binaryDecoder;
+static tipDecoder_t compactDecoder;
+static telemetryDecoder_t frameDecoder;
+
+/* === Private function implementation ========================================================= */
+
+static uint64_t stimulusNext() {
+    return nextEdge < edges.size() ? edges[nextEdge].us : HOST_TIME_NEVER;
+}
+
+static void stimulusFire() {
+    hostPinWrite(
+#if ACQUISITION_MODE == ACQUISITION_TIMER
+        PULSE_COUNTER_PIN,
+#else
+        SWITCH_TICK_RAIN,
+#endif
+        edges[nextEdge].level);
+    nextEdge++;
+}
+
+static const hostStimulus_t stimulus = {stimulusNext, stimulusFire};
+
+/**
+ * @brief Genera los flancos de un tick: cierre con rebotes, contacto sostenido y apertura con rebotes.
+ */
+static void addTipEdges(uint64_t tipUs, std::mt19937_64& rng) {
+    std::uniform_int_distribution<int> bounceCount(0, 4);
+    std::uniform_int_distribution<uint64_t> bounceUs(200, 2000);
+    std::uniform_int_distribution<uint64_t> holdUs(40 * US_PER_MS, 120 * US_PER_MS);
+
+    uint64_t t = tipUs;
+    edges.push_back({t, 1});
+    for (int i = bounceCount(rng); i > 0; i--) {
+        t += bounceUs(rng);
+        edges.push_back({t, 0});
+        t += bounceUs(rng);
+        edges.push_back({t, 1});
+    }
+    t += holdUs(rng);
+    edges.push_back({t, 0});
+    for (int i = bounceCount(rng); i > 0; i--) {
+        t += bounceUs(rng);
+        edges.push_back({t, 1});
+        t += bounceUs(rng);
+        edges.push_back({t, 0});
+    }
+}
+
+/**
+ * @brief Salida serie del firmware: al lado maestro, sin bloquear la simulación.
+ */
+static void serialSink(const char* data, size_t length) {
+    ssize_t written = write(masterFd, data, length);
+    if (written < (ssize_t)length) {
+        ptyDropped += length - (written > 0 ? (size_t)written : 0);
+    }
+}
+
+/**
+ * @brief Instante del reloj virtual que corresponde a un instante real.
+ */
+static uint64_t virtualAt(std::chrono::steady_clock::time_point wall) {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(wall - wallStart).count();
+}
+
+/**
+ * @brief Espera del bucle de eventos: avanza al ritmo real hasta el próximo evento o flanco,
+ *        o hasta que lleguen bytes por la pseudoterminal.
+ */
+static bool idle(uint64_t nextDue) {
+    uint64_t now = hostClockNowUs();
+    if (now >= endUs) {
+        return false;
+    }
+    uint64_t target = std::min(std::min(nextDue, stimulusNext()), endUs);
+    target = target > now ? target : now + 1;
+
+    auto deadline = wallStart + std::chrono::microseconds(target);
+    while (true) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        struct pollfd input = {masterFd, POLLIN, 0};
+        if (poll(&input, 1, remaining.count() > 0 ? (int)remaining.count() + 1 : 0) > 0 && (input.revents & POLLIN)) {
+            char buffer[256];
+            ssize_t length = read(masterFd, buffer, sizeof(buffer));
+            if (length > 0) {
+                uint64_t arrival = virtualAt(std::chrono::steady_clock::now());
+                hostClockAdvanceTo(std::min(std::max(arrival, now), target));
+                hostSerialInject(buffer, (size_t)length);
+                return true;
+            }
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            hostClockAdvanceTo(target);
+            return true;
+        }
+    }
+}
+
+#if LOGGER_WIRE_MODE != LOGGER_WIRE_TEXT
+/**
+ * @brief Agrega la línea de texto de un registro decodificado.
+ */
+static void appendRecord(std::string& text, const logRecord_t* record) {
+    char line[LOG_TEXT_MAX];
+    text.append(line, logFormatText(record, line));
+}
+#endif
+
+#if LOGGER_WIRE_MODE == LOGGER_WIRE_FRAMED
+static void appendMessage(void* context, uint32_t sequence, const tipCodecItem_t* message) {
+    logRecord_t record;
+    logCompactRecord(message, &record);
+    appendRecord(*(std::string*)context, &record);
+}
+
+static void appendText(void* context, const char* text, size_t length) {
+    ((std::string*)context)->append(text, length);
+}
+#endif
+
+/**
+ * @brief Convierte los bytes de la línea en las líneas de texto equivalentes.
+ *
+ * Los registros pasan por logFormatText(), como en tools/logdecode, y las
+ * respuestas a los comandos se copian tal cual.
+ */
+static void decodeWire(const char* data, size_t length, std::string& text) {
+#if LOGGER_WIRE_MODE == LOGGER_WIRE_FRAMED
+    telemetryDecoderSetTextHandler(&frameDecoder, appendText, &text);
+    telemetryDecoderPush(&frameDecoder, (const uint8_t*)data, length, appendMessage, &text);
+#else
+    for (size_t i = 0; i < length; i++) {
+        logRecord_t record;
+        uint8_t byte = (uint8_t)data[i];
+#if LOGGER_WIRE_MODE == LOGGER_WIRE_BINARY
+        // Fuera de un registro todo byte es texto de una respuesta: nunca coincide con el sincronismo
+        if (binaryDecoder.length == 0 && byte != LOG_WIRE_SYNC) {
+            text.push_back((char)byte);
+        } else if (logDecoderPush(&binaryDecoder, byte, &record)) {
+            appendRecord(text, &record);
+        }
+#elif LOGGER_WIRE_MODE == LOGGER_WIRE_COMPACT
+        tipCodecItem_t item;
+        if (tipDecoderPush(&compactDecoder, byte, &item)) {
+            logCompactRecord(&item, &record);
+            appendRecord(text, &record);
+        }
+#else
+        (void)record;
+        text.push_back((char)byte);
+#endif
+    }
+#endif
+}
+
+/**
+ * @brief Lee una línea completa del lado esclavo, sin el fin de línea.
+ *
+ * @return false si venció el plazo.
+ */
+static bool readLine(int fd, std::string& pending, std::string& line, std::chrono::steady_clock::time_point deadline) {
+    while (true) {
+        size_t end = pending.find('\n');
+        if (end != std::string::npos) {
+            line = pending.substr(0, end);
+            pending.erase(0, end + 1);
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            return true;
+        }
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) {
+            return false;
+        }
+        struct pollfd input = {fd, POLLIN, 0};
+        if (poll(&input, 1, (int)remaining.count()) > 0 && (input.revents & POLLIN)) {
+            char buffer[256];
+            ssize_t length = read(fd, buffer, sizeof(buffer));
+            if (length > 0) {
+                decodeWire(buffer, (size_t)length, pending);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Percentil de una muestra ordenada.
+ */
+static double percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = (size_t)ceil(fraction * (double)sorted.size());
+    return sorted[index > 0 ? index - 1 : 0];
+}
+
+/**
+ * @brief Cliente de terminal: envía comandos, mide la latencia y verifica las respuestas.
+ */
+static void runClient(int fd, uint64_t seed, uint64_t* detectedTips, std::vector<double>* latencies, uint32_t* failures) {
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<int> pauseMs(50, 250);
+    std::string pending;
+    std::string line;
+    size_t index = 0;
+
+    while (!simulationDone.load()) {
+        const probeCommand_t* command = &probeCommands[index % PROBE_COMMAND_COUNT];
+        char text[COMMAND_LINE_MAX];
+        if (strcmp(command->name, "total") == 0) {
+            snprintf(text, sizeof(text), "total %lu %lu\r", (unsigned long)TIME_INI, (unsigned long)TIME_INI + 3600);
+        } else {
+            snprintf(text, sizeof(text), "%s\r", command->name);
+        }
+
+        auto sent = std::chrono::steady_clock::now();
+        if (write(fd, text, strlen(text)) != (ssize_t)strlen(text)) {
+            (*failures)++;
+            break;
+        }
+
+#if LOGGER_WIRE_MODE == LOGGER_WIRE_COMPACT
+        // Sin respuestas: solo importa que el flujo siga entero con los comandos en la entrada
+        (void)sent;
+        index++;
+#else
+        uint32_t lines = 0;
+        bool finished = false;
+        auto deadline = sent + std::chrono::milliseconds(RESPONSE_TIMEOUT_MS);
+        while (!finished && readLine(fd, pending, line, deadline)) {
+            if (line.find(" - Rain detected") != std::string::npos) {
+                (*detectedTips)++;
+            } else if (line.find(" - Accumulated rainfall") != std::string::npos) {
+                continue;
+            } else if (line == "ok" || line.compare(0, 6, "error ") == 0) {
+                bool error = line != "ok";
+                if (error != command->error || lines < command->minLines || lines > command->maxLines) {
+                    fprintf(stderr, "%s: respuesta inesperada (%u líneas, \"%s\")\n", command->name, lines, line.c_str());
+                    (*failures)++;
+                }
+                latencies[index % PROBE_COMMAND_COUNT].push_back(
+                    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sent).count());
+                finished = true;
+            } else if (line.compare(0, strlen(command->prefix), command->prefix) == 0) {
+                lines++;
+            }
+        }
+        if (!finished) {
+            if (!simulationDone.load()) {
+                fprintf(stderr, "%s: sin respuesta\n", command->name);
+                (*failures)++;
+            }
+            break;
+        }
+        index++;
+#endif
+
+        // Entre comandos se siguen contando los ticks del registro
+        auto resume = std::chrono::steady_clock::now() + std::chrono::milliseconds(pauseMs(rng));
+        while (readLine(fd, pending, line, resume)) {
+            if (line.find(" - Rain detected") != std::string::npos) {
+                (*detectedTips)++;
+            } else if (line == "ok" || line.compare(0, 6, "error ") == 0) {
+                fprintf(stderr, "respuesta fuera de turno: \"%s\"\n", line.c_str());
+                (*failures)++;
+            }
+        }
+    }
+
+    // Lo que quedó en la línea al terminar
+    auto drained = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+    while (readLine(fd, pending, line, drained)) {
+        if (line.find(" - Rain detected") != std::string::npos) {
+            (*detectedTips)++;
+        }
+    }
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char* argv[]) {
+    double seconds = 30.0;
+    double rate = 2.0;
+    uint64_t seed = 1;
+    bool interactive = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            rate = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--interactive") == 0) {
+            interactive = true;
+        } else {
+            fprintf(stderr, "uso: %s [--seconds n] [--rate ticks_por_s] [--seed n] [--interactive]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (seconds <= 0.0 || rate <= 0.0) {
+        fprintf(stderr, "%s: --seconds y --rate deben ser positivos\n", argv[0]);
+        return 2;
+    }
+
+    setenv("TZ", "UTC0", 1);
+    tzset();
+
+    // Tormenta: llegadas de Poisson a la tasa pedida, sin ticks más cercanos que el vuelco mínimo
+    std::mt19937_64 rng(seed);
+    std::exponential_distribution<double> gap(rate);
+    uint64_t trueTips = 0;
+    uint64_t tipUs = US_PER_S;
+    endUs = (uint64_t)(seconds * US_PER_S);
+    while (true) {
+        tipUs += std::max((uint64_t)(gap(rng) * US_PER_S), (uint64_t)MIN_TIP_INTERVAL_US);
+        if (tipUs + US_PER_S >= endUs) {
+            break;
+        }
+        addTipEdges(tipUs, rng);
+        trueTips++;
+    }
+
+    masterFd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (masterFd < 0 || grantpt(masterFd) != 0 || unlockpt(masterFd) != 0) {
+        perror("posix_openpt");
+        return 1;
+    }
+    const char* slaveName = ptsname(masterFd);
+    int slaveFd = open(slaveName, O_RDWR | O_NOCTTY);
+    struct termios raw;
+    if (slaveFd < 0 || tcgetattr(slaveFd, &raw) != 0) {
+        perror(slaveName);
+        return 1;
+    }
+    cfmakeraw(&raw);
+    tcsetattr(slaveFd, TCSANOW, &raw);
+    fcntl(masterFd, F_SETFL, fcntl(masterFd, F_GETFL) | O_NONBLOCK);
+
+    logDecoderInit(&binaryDecoder);
+    tipDecoderInit(&compactDecoder);
+    telemetryDecoderInit(&frameDecoder);
+    hostSerialSetSink(serialSink);
+    hostSetStimulus(&stimulus);
+    initializeSensors();
+    scheduleReports(REPORT_INTERVAL);
+
+    uint64_t detectedTips = 0;
+    uint32_t failures = 0;
+    std::vector<double> latencies[PROBE_COMMAND_COUNT];
+    std::thread client;
+    if (interactive) {
+        printf("terminal: %s (%.0f s)\n", slaveName, seconds);
+        fflush(stdout);
+    } else {
+        client = std::thread(runClient, slaveFd, seed + 1, &detectedTips, latencies, &failures);
+    }
+
+    wallStart = std::chrono::steady_clock::now();
+    hostSetIdle(idle);
+    eventLoopRun();
+    simulationDone.store(true);
+    if (client.joinable()) {
+        client.join();
+    }
+    close(slaveFd);
+    close(masterFd);
+
+    loggerStats_t logStats;
+    loggerGetStats(&logStats);
+    printf("duración           : %.1f s, %.1f ticks/s\n", seconds, trueTips / seconds);
+    printf("registros          : %lu encolados, %lu descartados, %llu bytes perdidos en la pty\n",
+           (unsigned long)logStats.enqueued, (unsigned long)logStats.dropped, (unsigned long long)ptyDropped);
+    if (interactive) {
+        return 0;
+    }
+
+    printf("ticks verdaderos   : %llu\n", (unsigned long long)trueTips);
+    printf("ticks detectados   : %llu (%+lld)\n", (unsigned long long)detectedTips,
+           (long long)detectedTips - (long long)trueTips);
+    printf("latencia (ms)      : p50 / p99 / max hasta la última línea de la respuesta\n");
+    for (size_t i = 0; i < PROBE_COMMAND_COUNT; i++) {
+        std::vector<double>& sorted = latencies[i];
+        std::sort(sorted.begin(), sorted.end());
+        printf("  %-17s: %6.1f / %6.1f / %6.1f (n=%zu)\n", probeCommands[i].name, percentile(sorted, 0.5),
+               percentile(sorted, 0.99), sorted.empty() ? 0.0 : sorted.back(), sorted.size());
+    }
+#if LOGGER_WIRE_MODE == LOGGER_WIRE_BINARY
+    printf("línea binaria      : %lu bytes descartados\n", (unsigned long)binaryDecoder.errors);
+    failures += binaryDecoder.errors > 0;
+#elif LOGGER_WIRE_MODE == LOGGER_WIRE_COMPACT
+    printf("línea compacta     : %lu elementos inválidos, comandos rechazados\n", (unsigned long)compactDecoder.errors);
+    failures += compactDecoder.errors > 0;
+#elif LOGGER_WIRE_MODE == LOGGER_WIRE_FRAMED
+    printf("tramas             : %lu de datos, %lu de texto, %lu con error, %lu perdidas\n",
+           (unsigned long)frameDecoder.stats.frames, (unsigned long)frameDecoder.stats.texts,
+           (unsigned long)frameDecoder.stats.crcErrors, (unsigned long)frameDecoder.stats.lostFrames);
+    failures += frameDecoder.stats.crcErrors > 0 || frameDecoder.stats.lostFrames > 0;
+#endif
+    if (detectedTips != trueTips) {
+        failures++;
+    }
+    printf("errores            : %u\n", failures);
+    return failures == 0 ? 0 : 1;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,705 @@
+/*
+ * Nombre del archivo: gateway.cpp
+ * Descripción: Servicio de ingesta de muchos pluviómetros por puertos serie multiplexados con epoll.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+/** @file
+ ** @brief Servicio de ingesta de la salida de texto de muchos pluviómetros.
+ **
+ ** Atiende cientos de puertos serie (o pseudoterminales) desde un solo hilo
+ ** con epoll. Cada puerto tiene un buffer fijo donde read() deja los bytes y
+ ** las líneas se reconocen ahí mismo con logParseText(), la inversa de
+ ** logFormatText() del firmware: sin copias ni memoria dinámica por línea.
+ ** Los eventos reconocidos se acumulan en lotes de registros binarios de
+ ** GATEWAY_RECORD_SIZE bytes que se agregan al archivo de salida con una sola
+ ** escritura por lote. Las líneas que no son registros (respuestas a
+ ** comandos, basura) se cuentan y se descartan. Por puerto se llevan las
+ ** estadísticas de los intervalos entre ticks de modules/tipstats (con la
+ ** resolución de 1 s del texto), que al final se combinan entre todos los
+ ** pluviómetros.
+ **
+ ** Con --simulate crea pseudoterminales alimentadas por pluviómetros
+ ** simulados (la salida de logFormatText() con ruido, cortada en trozos al
+ ** azar), las atiende y verifica por pluviómetro lo recibido y lo guardado.
+ ** Con --bench mide el reconocimiento de líneas en un solo núcleo.
+ **
+ ** Uso:
+ **   gateway [--out archivo] puerto...
+ **   gateway --simulate [--gauges N] [--lines N] [--seed N]
+ **   gateway --bench [--lines N]
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pluviometer.h"
+#include "timefmt.h"
+#include "logformat.h"
+#include "tipstats.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define GATEWAY_BUFFER_SIZE 4096  ///< Buffer de recepción por puerto; una línea más larga se descarta
+#define GATEWAY_EPOLL_EVENTS 256  ///< Puertos listos que se atienden por llamada a epoll_wait()
+#define GATEWAY_RECORD_SIZE 16  ///< Registro guardado: pluviómetro, instante, argumento, evento
+#define GATEWAY_BATCH_RECORDS 4096  ///< Registros por escritura al archivo de salida
+#define GATEWAY_FLUSH_MS 200  ///< Antigüedad máxima de un lote incompleto
+#define GATEWAY_IDLE_MS 5000  ///< Espera sin datos tras la cual --simulate se da por terminado
+
+#define SIMULATION_FEEDERS 4  ///< Hilos que alimentan las pseudoterminales
+#define SIMULATION_CHUNK_MAX 512  ///< Trozo máximo por escritura de un pluviómetro simulado
+#define SIMULATION_NOISE_EVERY 50  ///< Una línea de ruido cada tantas en promedio
+
+/* === Private data type declarations ========================================================== */
+
+/**
+ * @brief Puerto atendido y sus contadores.
+ */
+typedef struct {
+    int fd;
+    uint32_t gauge;  ///< Número de pluviómetro en los registros guardados
+    const char* name;
+    size_t length;  ///< Bytes en buffer
+    bool skipping;  ///< Descartando una línea demasiado larga hasta el próximo '\n'
+    uint64_t lines;  ///< Líneas completas recibidas
+    uint64_t events;  ///< Líneas reconocidas como registros
+    uint64_t tips;
+    int64_t rainfallTenths;  ///< Suma de la lluvia acumulada informada, en décimas de mm
+    uint64_t overlong;  ///< Líneas descartadas por no caber en el buffer
+    uint32_t lastTip;  ///< Instante del último tick (0: ninguno)
+    tipStats_t tipStats;  ///< Intervalos entre ticks en ms y anomalías informadas
+    char buffer[GATEWAY_BUFFER_SIZE];
+} endpoint_t;
+
+/**
+ * @brief Lo que un pluviómetro simulado envía y lo que se espera recibir de él.
+ */
+typedef struct {
+    std::string text;
+    size_t sent;
+    uint64_t lines;
+    uint64_t events;
+    uint64_t tips;
+    int64_t rainfallTenths;
+    uint64_t overlong;
+    uint8_t anomalies;
+} simulatedGauge_t;
+
+/* === Private variable declarations =========================================================== */
+
+static int outputFd = -1;  ///< Archivo de salida (-1: los lotes se descartan)
+static uint8_t batch[GATEWAY_BATCH_RECORDS * GATEWAY_RECORD_SIZE];
+static size_t batchCount = 0;
+static std::chrono::steady_clock::time_point batchStarted;
+static uint64_t storedRecords = 0;
+static uint64_t storedBatches = 0;
+static uint64_t totalLines = 0;  ///< Líneas completas y descartadas por largo, de todos los puertos
+static volatile sig_atomic_t stopRequested = 0;
+
+/* === Private function implementation ========================================================= */
+
+static void putU32(uint8_t* out, uint32_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t getU32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static void onSignal(int signal) {
+    stopRequested = 1;
+}
+
+/**
+ * @brief Escribe el lote en curso en el archivo de salida.
+ */
+static bool flushBatch() {
+    size_t size = batchCount * GATEWAY_RECORD_SIZE;
+    size_t done = 0;
+
+    while (outputFd >= 0 && done < size) {
+        ssize_t written = write(outputFd, &batch[done], size - done);
+        if (written < 0 && errno != EINTR) {
+            perror("gateway: salida");
+            return false;
+        }
+        done += written > 0 ? (size_t)written : 0;
+    }
+    storedRecords += batchCount;
+    storedBatches += batchCount > 0 ? 1 : 0;
+    batchCount = 0;
+    return true;
+}
+
+/**
+ * @brief Agrega un registro al lote; lo escribe si se llenó.
+ *
+ * Formato little endian: pluviómetro, instante y argumento de 32 bits, evento y 3 bytes en 0.
+ */
+static void storeRecord(uint32_t gauge, const logRecord_t* record) {
+    uint8_t* out = &batch[batchCount * GATEWAY_RECORD_SIZE];
+
+    if (batchCount == 0) {
+        batchStarted = std::chrono::steady_clock::now();
+    }
+    putU32(&out[0], gauge);
+    putU32(&out[4], record->timestamp);
+    putU32(&out[8], (uint32_t)record->arg);
+    out[12] = record->id;
+    out[13] = out[14] = out[15] = 0;
+    if (++batchCount == GATEWAY_BATCH_RECORDS) {
+        flushBatch();
+    }
+}
+
+/**
+ * @brief Reconoce una línea completa, en su lugar dentro del buffer del puerto.
+ */
+static void parseLine(endpoint_t* endpoint, const char* line, size_t length) {
+    logRecord_t record;
+
+    endpoint->lines++;
+    if (!logParseText(line, length, &record)) {
+        return;
+    }
+    endpoint->events++;
+    if (record.id == LOG_EVENT_RAIN_DETECTED) {
+        endpoint->tips++;
+        if (endpoint->lastTip != 0 && record.timestamp >= endpoint->lastTip) {
+            uint64_t intervalMs = (uint64_t)(record.timestamp - endpoint->lastTip) * 1000;
+            tipStatsAddInterval(&endpoint->tipStats, intervalMs < UINT32_MAX ? (uint32_t)intervalMs : UINT32_MAX);
+        }
+        endpoint->lastTip = record.timestamp;
+    } else if (record.id == LOG_EVENT_ACCUMULATED_RAINFALL) {
+        endpoint->rainfallTenths += record.arg;
+    } else if (record.id == LOG_EVENT_TIP_ANOMALY) {
+        endpoint->tipStats.anomalies |= (uint8_t)record.arg;
+    }
+    storeRecord(endpoint->gauge, &record);
+}
+
+/**
+ * @brief Procesa las líneas completas del buffer y deja al comienzo la incompleta.
+ */
+static void parseBuffered(endpoint_t* endpoint) {
+    const char* start = endpoint->buffer;
+    const char* end = endpoint->buffer + endpoint->length;
+    const char* newline;
+
+    while ((newline = (const char*)memchr(start, '\n', (size_t)(end - start))) != NULL) {
+        if (endpoint->skipping) {
+            endpoint->skipping = false;
+        } else {
+            parseLine(endpoint, start, (size_t)(newline - start));
+        }
+        start = newline + 1;
+    }
+
+    size_t rest = (size_t)(end - start);
+    if (rest == GATEWAY_BUFFER_SIZE) {
+        // Buffer lleno sin fin de línea: se descarta hasta el próximo '\n'
+        endpoint->overlong += endpoint->skipping ? 0 : 1;
+        endpoint->skipping = true;
+        rest = 0;
+    }
+    memmove(endpoint->buffer, start, rest);
+    endpoint->length = rest;
+}
+
+/**
+ * @brief Lee todo lo disponible en un puerto.
+ *
+ * @return false si el puerto se cerró o falló.
+ */
+static bool serviceEndpoint(endpoint_t* endpoint) {
+    while (true) {
+        ssize_t length = read(endpoint->fd, &endpoint->buffer[endpoint->length], GATEWAY_BUFFER_SIZE - endpoint->length);
+        if (length > 0) {
+            uint64_t before = endpoint->lines + endpoint->overlong;
+            endpoint->length += (size_t)length;
+            parseBuffered(endpoint);
+            totalLines += endpoint->lines + endpoint->overlong - before;
+        } else if (length < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+    }
+}
+
+/**
+ * @brief Abre un puerto en modo crudo y no bloqueante.
+ */
+static bool openEndpoint(endpoint_t* endpoint, const char* name, uint32_t gauge) {
+    memset(endpoint, 0, offsetof(endpoint_t, buffer));
+    tipStatsInit(&endpoint->tipStats);
+    endpoint->name = name;
+    endpoint->gauge = gauge;
+    endpoint->fd = open(name, O_RDONLY | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (endpoint->fd < 0) {
+        perror(name);
+        return false;
+    }
+
+    struct termios settings;
+    if (tcgetattr(endpoint->fd, &settings) == 0) {
+        cfmakeraw(&settings);
+        cfsetispeed(&settings, B9600);  // BAUD_RATE del firmware
+        cfsetospeed(&settings, B9600);
+        settings.c_cflag |= CLOCAL | CREAD;
+        tcsetattr(endpoint->fd, TCSANOW, &settings);
+    }
+    return true;
+}
+
+/**
+ * @brief Atiende los puertos hasta una señal, hasta que se cierren todos o hasta recibir stopAfterLines.
+ *
+ * @param stopAfterLines Líneas totales tras las que termina (0: sin límite).
+ * @return false si --simulate quedó GATEWAY_IDLE_MS sin datos antes de completar.
+ */
+static bool runGateway(std::vector<endpoint_t>& endpoints, uint64_t stopAfterLines) {
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    size_t open = 0;
+    if (epollFd < 0) {
+        perror("epoll_create1");
+        return false;
+    }
+    for (endpoint_t& endpoint : endpoints) {
+        struct epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.ptr = &endpoint;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, endpoint.fd, &event) == 0) {
+            open++;
+        } else {
+            perror(endpoint.name);
+        }
+    }
+
+    struct epoll_event ready[GATEWAY_EPOLL_EVENTS];
+    auto lastData = std::chrono::steady_clock::now();
+    bool completed = true;
+    while (!stopRequested && open > 0 && (stopAfterLines == 0 || totalLines < stopAfterLines)) {
+        int count = epoll_wait(epollFd, ready, GATEWAY_EPOLL_EVENTS, GATEWAY_FLUSH_MS);
+        auto now = std::chrono::steady_clock::now();
+        if (count < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < count; i++) {
+            endpoint_t* endpoint = (endpoint_t*)ready[i].data.ptr;
+            if (!serviceEndpoint(endpoint)) {
+                fprintf(stderr, "%s: cerrado\n", endpoint->name);
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, endpoint->fd, NULL);
+                open--;
+            }
+        }
+        if (count > 0) {
+            lastData = now;
+        } else if (stopAfterLines != 0 && now - lastData > std::chrono::milliseconds(GATEWAY_IDLE_MS)) {
+            completed = false;
+            break;
+        }
+        if (batchCount > 0 && now - batchStarted >= std::chrono::milliseconds(GATEWAY_FLUSH_MS)) {
+            flushBatch();
+        }
+    }
+    flushBatch();
+    close(epollFd);
+    return completed;
+}
+
+/**
+ * @brief Sube el límite de descriptores abiertos al máximo permitido.
+ */
+static void raiseFileLimit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+/**
+ * @brief Agrega al texto de un pluviómetro simulado una línea con el formato del firmware.
+ */
+static void emitRecord(simulatedGauge_t* gauge, uint8_t id, uint32_t timestamp, int32_t arg) {
+    logRecord_t record = {id, timestamp, arg};
+    char text[LOG_TEXT_MAX];
+    gauge->text.append(text, logFormatText(&record, text));
+    gauge->lines++;
+    gauge->events++;
+    gauge->tips += id == LOG_EVENT_RAIN_DETECTED ? 1 : 0;
+    gauge->rainfallTenths += id == LOG_EVENT_ACCUMULATED_RAINFALL ? arg : 0;
+    gauge->anomalies |= id == LOG_EVENT_TIP_ANOMALY ? (uint8_t)arg : 0;
+}
+
+/**
+ * @brief Genera la salida de un pluviómetro: ticks, reportes por minuto, descartes, anomalías y ruido.
+ */
+static void generateGauge(simulatedGauge_t* gauge, uint64_t lines, std::mt19937_64& rng) {
+    static const char* const noise[] = {
+        "ok\r\n",
+        "stat uptime 86400\r\n",
+        "rate 60min 1.2 mm 1.2 mm/h\r\n",
+        "2024-13-01 10:00:00 - Rain detected\r\n",
+        "2024-02-30 10:00 - Accumulated rainfall: 1.0 mm\n",
+        "2024-07-01 10:00:00 - Rain detected twice\r\n",
+        "\x13\xff garbage\r\n",
+        "\r\n",
+    };
+    std::uniform_int_distribution<uint32_t> start(0, 365 * SECONDS_PER_DAY);
+    std::uniform_int_distribution<uint32_t> gap(1, 40);
+    std::uniform_int_distribution<int> noiseDraw(0, SIMULATION_NOISE_EVERY * 10 - 1);
+
+    uint32_t now = TIME_INI + start(rng);
+    uint32_t reportDue = now - now % 60 + 60;
+    int32_t periodTips = 0;
+    while (gauge->lines < lines) {
+        int draw = noiseDraw(rng);
+        if (draw < (int)(sizeof(noise) / sizeof(noise[0]))) {
+            gauge->text += noise[draw];
+            gauge->lines++;
+        } else if (draw == SIMULATION_NOISE_EVERY * 10 - 1) {
+            gauge->text.append(GATEWAY_BUFFER_SIZE + 100, 'x');
+            gauge->text += "\r\n";
+            gauge->overlong++;
+        } else if (draw == SIMULATION_NOISE_EVERY * 10 - 2) {
+            emitRecord(gauge, LOG_EVENT_DROPPED, now, 3);
+        } else if (draw == SIMULATION_NOISE_EVERY * 10 - 3) {
+            emitRecord(gauge, LOG_EVENT_TIP_ANOMALY, now, TIP_ANOMALY_BOUNCE_FLOOD);
+        }
+
+        now += gap(rng);
+        if (now >= reportDue) {
+            emitRecord(gauge, LOG_EVENT_ACCUMULATED_RAINFALL, reportDue, periodTips * MM_PER_TICK);
+            periodTips = 0;
+            reportDue += 60;
+        }
+        emitRecord(gauge, LOG_EVENT_RAIN_DETECTED, now, 0);
+        periodTips++;
+    }
+}
+
+/**
+ * @brief Alimenta las pseudoterminales de un grupo de pluviómetros en trozos al azar.
+ */
+static void runFeeder(std::vector<simulatedGauge_t>* gauges, std::vector<int>* masters, size_t first, size_t step,
+                      uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<size_t> chunk(1, SIMULATION_CHUNK_MAX);
+    bool pending = true;
+
+    while (pending) {
+        pending = false;
+        for (size_t i = first; i < gauges->size(); i += step) {
+            simulatedGauge_t* gauge = &(*gauges)[i];
+            size_t length = std::min(chunk(rng), gauge->text.size() - gauge->sent);
+            if (length == 0) {
+                continue;
+            }
+            ssize_t written = write((*masters)[i], &gauge->text[gauge->sent], length);
+            if (written < 0 && errno != EINTR) {
+                perror("feeder");
+                return;
+            }
+            gauge->sent += written > 0 ? (size_t)written : 0;
+            pending = true;
+        }
+    }
+}
+
+/**
+ * @brief Tiempo de CPU del hilo actual en segundos.
+ */
+static double threadSeconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Imprime las estadísticas de los intervalos entre ticks.
+ */
+static void printTipStats(const char* label, const tipStats_t* stats) {
+    printf("%-18s: n=%lu min=%lu p50=%lu p90=%lu p99=%lu max=%lu media=%.0f sd=%.0f ms, anomalías 0x%02x\n", label,
+           (unsigned long)stats->intervals.count, (unsigned long)(stats->intervals.count > 0 ? stats->intervals.min : 0),
+           (unsigned long)tipStatsQuantile(stats, 500), (unsigned long)tipStatsQuantile(stats, 900),
+           (unsigned long)tipStatsQuantile(stats, 990), (unsigned long)stats->intervals.max, stats->mean,
+           sqrt(tipStatsVariance(stats)), stats->anomalies);
+}
+
+/**
+ * @brief Pluviómetros simulados sobre pseudoterminales: verifica lo recibido y lo guardado.
+ *
+ * Los intervalos entre ticks simulados van de 1 a 40 s; los de todos los
+ * pluviómetros se combinan y se verifican contra lo enviado.
+ */
+static int simulate(size_t gaugeCount, uint64_t lines, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<simulatedGauge_t> gauges(gaugeCount);
+    std::vector<int> masters(gaugeCount);
+    std::vector<std::string> names(gaugeCount);
+    std::vector<endpoint_t> endpoints(gaugeCount);
+    uint64_t expectedLines = 0;
+    size_t bytes = 0;
+
+    for (size_t i = 0; i < gaugeCount; i++) {
+        generateGauge(&gauges[i], lines, rng);
+        expectedLines += gauges[i].lines + gauges[i].overlong;
+        bytes += gauges[i].text.size();
+
+        masters[i] = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+        if (masters[i] < 0 || grantpt(masters[i]) != 0 || unlockpt(masters[i]) != 0) {
+            perror("posix_openpt");
+            return 1;
+        }
+        names[i] = ptsname(masters[i]);
+        // El puerto queda en modo crudo antes de que el pluviómetro escriba: sin eco ni conversión de \r
+        if (!openEndpoint(&endpoints[i], names[i].c_str(), (uint32_t)i)) {
+            return 1;
+        }
+    }
+
+    FILE* storage = tmpfile();
+    outputFd = storage != NULL ? fileno(storage) : -1;
+
+    auto wallStart = std::chrono::steady_clock::now();
+    double cpuStart = threadSeconds();
+    std::vector<std::thread> feeders;
+    size_t feederCount = std::min((size_t)SIMULATION_FEEDERS, gaugeCount);
+    for (size_t i = 0; i < feederCount; i++) {
+        feeders.emplace_back(runFeeder, &gauges, &masters, i, feederCount, seed + 1 + i);
+    }
+    bool completed = runGateway(endpoints, expectedLines);
+    double cpu = threadSeconds() - cpuStart;
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    for (std::thread& feeder : feeders) {
+        feeder.join();
+    }
+
+    // Lo recibido por puerto frente a lo enviado
+    uint64_t failures = completed ? 0 : 1;
+    uint64_t events = 0;
+    uint64_t intervals = 0;
+    static tipStats_t allTipStats;
+    tipStatsInit(&allTipStats);
+    for (size_t i = 0; i < gaugeCount; i++) {
+        const endpoint_t* endpoint = &endpoints[i];
+        const simulatedGauge_t* gauge = &gauges[i];
+        if (endpoint->lines != gauge->lines || endpoint->events != gauge->events || endpoint->tips != gauge->tips ||
+            endpoint->rainfallTenths != gauge->rainfallTenths || endpoint->overlong != gauge->overlong ||
+            endpoint->tipStats.anomalies != gauge->anomalies) {
+            fprintf(stderr, "pluviómetro %zu: %llu/%llu líneas, %llu/%llu registros, %llu/%llu ticks\n", i,
+                    (unsigned long long)endpoint->lines, (unsigned long long)gauge->lines,
+                    (unsigned long long)endpoint->events, (unsigned long long)gauge->events,
+                    (unsigned long long)endpoint->tips, (unsigned long long)gauge->tips);
+            failures++;
+        }
+        events += gauge->events;
+        intervals += gauge->tips > 0 ? gauge->tips - 1 : 0;
+        tipStatsMerge(&allTipStats, &endpoint->tipStats);
+        close(endpoint->fd);
+        close(masters[i]);
+    }
+
+    // Lo guardado: la cantidad de registros y los ticks por pluviómetro
+    std::vector<uint64_t> storedTips(gaugeCount, 0);
+    uint64_t records = 0;
+    uint8_t record[GATEWAY_RECORD_SIZE];
+    rewind(storage);
+    while (storage != NULL && fread(record, GATEWAY_RECORD_SIZE, 1, storage) == 1) {
+        uint32_t gauge = getU32(&record[0]);
+        if (gauge < gaugeCount && record[12] == LOG_EVENT_RAIN_DETECTED) {
+            storedTips[gauge]++;
+        }
+        records++;
+    }
+    for (size_t i = 0; i < gaugeCount; i++) {
+        failures += storedTips[i] != gauges[i].tips ? 1 : 0;
+    }
+    failures += records != events ? 1 : 0;
+    failures += allTipStats.intervals.count != intervals ? 1 : 0;
+    failures += allTipStats.intervals.min < 1000 || allTipStats.intervals.max > 40000 ? 1 : 0;
+    if (storage != NULL) {
+        fclose(storage);
+    }
+
+    printf("pluviómetros      : %zu pseudoterminales, %d hilos de alimentación\n", gaugeCount, (int)feederCount);
+    printf("recibido          : %llu líneas (%.1f MB), %llu registros, %llu ruido\n", (unsigned long long)totalLines,
+           bytes / 1e6, (unsigned long long)events, (unsigned long long)(totalLines - events));
+    printf("guardado          : %llu registros en %llu lotes\n", (unsigned long long)storedRecords,
+           (unsigned long long)storedBatches);
+    printf("rendimiento       : %.2f M líneas/s reales, %.2f M líneas por s de CPU del servicio\n",
+           totalLines / wall / 1e6, totalLines / cpu / 1e6);
+    printTipStats("intervalos", &allTipStats);
+    printf("errores           : %llu\n", (unsigned long long)failures);
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * @brief Mide el reconocimiento de líneas en un solo núcleo, sin puertos.
+ *
+ * Copia el texto al buffer de un puerto en trozos del tamaño del buffer,
+ * como lo haría read(), y lo procesa con el mismo camino que el servicio.
+ */
+static int bench(uint64_t lines, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    simulatedGauge_t gauge = {};
+    generateGauge(&gauge, lines, rng);
+
+    static endpoint_t endpoint;
+    double best = 0.0;
+    uint64_t failures = 0;
+    for (int pass = 0; pass < 5; pass++) {
+        memset(&endpoint, 0, offsetof(endpoint_t, buffer));
+        tipStatsInit(&endpoint.tipStats);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t at = 0; at < gauge.text.size();) {
+            size_t length = std::min(GATEWAY_BUFFER_SIZE - endpoint.length, gauge.text.size() - at);
+            memcpy(&endpoint.buffer[endpoint.length], &gauge.text[at], length);
+            endpoint.length += length;
+            at += length;
+            parseBuffered(&endpoint);
+        }
+        flushBatch();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = std::max(best, (endpoint.lines + endpoint.overlong) / seconds);
+        failures += endpoint.events != gauge.events || endpoint.tips != gauge.tips ? 1 : 0;
+    }
+
+    printf("texto             : %llu líneas, %.1f MB\n", (unsigned long long)(gauge.lines + gauge.overlong),
+           gauge.text.size() / 1e6);
+    printf("reconocimiento    : %.2f M líneas/s en un núcleo (%.1f ns por línea)\n", best / 1e6, 1e9 / best);
+    printf("errores           : %llu\n", (unsigned long long)failures);
+    return failures == 0 ? 0 : 1;
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char* argv[]) {
+    bool simulation = false;
+    bool benchmark = false;
+    size_t gaugeCount = 200;
+    uint64_t lines = 5000;
+    uint64_t seed = 1;
+    const char* outputName = NULL;
+    std::vector<const char*> ports;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--simulate") == 0) {
+            simulation = true;
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            benchmark = true;
+        } else if (strcmp(argv[i], "--gauges") == 0 && i + 1 < argc) {
+            gaugeCount = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--lines") == 0 && i + 1 < argc) {
+            lines = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            outputName = argv[++i];
+        } else if (argv[i][0] != '-') {
+            ports.push_back(argv[i]);
+        } else {
+            ports.clear();
+            break;
+        }
+    }
+    if (benchmark) {
+        return bench(lines > 5000 ? lines : 1000000, seed);
+    }
+    raiseFileLimit();
+    if (simulation && gaugeCount > 0) {
+        return simulate(gaugeCount, lines, seed);
+    }
+    if (ports.empty()) {
+        fprintf(stderr,
+                "uso: %s [--out archivo] puerto...\n"
+                "     %s --simulate [--gauges n] [--lines n] [--seed n]\n"
+                "     %s --bench [--lines n]\n",
+                argv[0], argv[0], argv[0]);
+        return 2;
+    }
+
+    if (outputName != NULL) {
+        outputFd = open(outputName, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (outputFd < 0) {
+            perror(outputName);
+            return 1;
+        }
+    }
+    std::vector<endpoint_t> endpoints(ports.size());
+    for (size_t i = 0; i < ports.size(); i++) {
+        if (!openEndpoint(&endpoints[i], ports[i], (uint32_t)i)) {
+            return 1;
+        }
+        printf("%u: %s\n", (unsigned)i, ports[i]);
+    }
+
+    struct sigaction action = {};
+    action.sa_handler = onSignal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    runGateway(endpoints, 0);
+
+    static tipStats_t allTipStats;
+    tipStatsInit(&allTipStats);
+    for (const endpoint_t& endpoint : endpoints) {
+        printf("%u: %llu líneas, %llu registros, %llu ticks, %lld.%lld mm, %llu descartadas por largo\n",
+               (unsigned)endpoint.gauge, (unsigned long long)endpoint.lines, (unsigned long long)endpoint.events,
+               (unsigned long long)endpoint.tips, (long long)(endpoint.rainfallTenths / 10),
+               (long long)(endpoint.rainfallTenths % 10), (unsigned long long)endpoint.overlong);
+        printTipStats("  intervalos", &endpoint.tipStats);
+        tipStatsMerge(&allTipStats, &endpoint.tipStats);
+        close(endpoint.fd);
+    }
+    printTipStats("intervalos", &allTipStats);
+    printf("guardado          : %llu registros en %llu lotes\n", (unsigned long long)storedRecords,
+           (unsigned long long)storedBatches);
+    if (outputFd >= 0) {
+        close(outputFd);
+    }
+    return 0;
+}
+
+/* === End of documentation ==================================================================== */
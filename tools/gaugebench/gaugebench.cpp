@@ -0,0 +1,194 @@
+/*
+ * Nombre del archivo: gaugebench.cpp
+ * Descripción: Verificación de las tablas de corrección y costo por tick del pluviómetro calibrado.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Banco de pruebas de modules/gauge en PC.
+ **
+ ** Algunas propiedades de las tablas se comprueban al compilar con
+ ** static_assert. En ejecución compara cada tabla generada por constexpr con
+ ** la curva calculada en doble precisión, verifica que la corrección crezca
+ ** con la intensidad, que una lluvia pareja reciba el factor esperado y que
+ ** la política con intervalo mínimo descarte ticks. Al final mide el costo
+ ** por tick frente a la versión con macros (contar y multiplicar por
+ ** MM_PER_TICK al reportar).
+ **
+ ** Uso:
+ **   gaugebench [--tips N]
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "gauge.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define ONE (1u << GAUGE_FACTOR_SHIFT)
+
+// Comprobaciones en compilación: sin corrección a intensidad nula y monotonía en los extremos
+static_assert(gaugeMakeTable<BucketCalibration<200, 0>>().factor[GAUGE_TABLE_SIZE - 1] == ONE,
+              "una curva nula no corrige");
+static_assert(gaugeMakeTable<gaugeBucket02mm_t>().factor[0] >= ONE, "la corrección nunca resta lluvia");
+static_assert(gaugeMakeTable<gaugeBucket02mm_t>().factor[GAUGE_TABLE_SIZE - 1] >
+                  gaugeMakeTable<gaugeBucket02mm_t>().factor[0],
+              "la corrección crece con la intensidad");
+static_assert(Pluviometer<gaugeBucket05mm_t, EdgeDebounce<80>>::nominalRainfall(3) == 15, "3 vuelcos de 0,5 mm");
+
+/* === Private variable declarations =========================================================== */
+
+static uint64_t failures = 0;
+
+/* === Private function implementation ========================================================= */
+
+static void fail(const char* name, const char* message, long detail) {
+    if (failures++ < 10) {
+        fprintf(stderr, "%s: %s (%ld)\n", name, message, detail);
+    }
+}
+
+/**
+ * @brief Compara la tabla de una calibración con la curva en doble precisión.
+ */
+template <class Calibration>
+static void checkTable(const char* name) {
+    typedef Pluviometer<Calibration, EdgeDebounce<80>> gauge_t;
+    double worst = 0.0;
+
+    for (uint32_t i = 0; i < GAUGE_TABLE_SIZE; i++) {
+        double intensity = (i + 0.5) * GAUGE_TABLE_STEP;
+        double factor = 1.0 + Calibration::linearPpm * intensity / 1e6 +
+                        Calibration::quadraticPpb * intensity * intensity / 1e9;
+        double error = fabs(gauge_t::table.factor[i] - factor * ONE);
+        worst = error > worst ? error : worst;
+        if (error > 1.0) {
+            fail(name, "entrada lejos de la curva", (long)i);
+        }
+        if (i > 0 && gauge_t::table.factor[i] < gauge_t::table.factor[i - 1]) {
+            fail(name, "la tabla decrece", (long)i);
+        }
+    }
+
+    // Lluvia pareja de 60 mm/h: todos los ticks salvo el primero llevan el factor de ese tramo
+    const uint64_t interval = (uint64_t)Calibration::depthUm * 3600 / 60;
+    gauge_t gauge;
+    for (uint64_t t = 1; t <= 1000; t++) {
+        gauge.addTip(t * interval);
+    }
+    double expected = (gauge_t::table.factor[60 / GAUGE_TABLE_STEP] * 999.0 + gauge_t::table.factor[0]) / ONE *
+                      Calibration::depthUm / 100.0;
+    if (fabs(gauge.rainfall() - expected) > 0.5) {
+        fail(name, "lluvia pareja mal corregida", (long)gauge.rainfall());
+    }
+
+    printf("%-18s: %u um, factor %.4f a 0 mm/h y %.4f a 256 mm/h, error máximo %.2f LSB, "
+           "1000 ticks a 60 mm/h = %.1f mm (nominal %.1f)\n",
+           name, Calibration::depthUm, gauge_t::table.factor[0] / (double)ONE,
+           gauge_t::table.factor[GAUGE_TABLE_SIZE - 1] / (double)ONE, worst, gauge.rainfall() / 10.0,
+           gauge_t::nominalRainfall(1000) / 10.0);
+}
+
+/**
+ * @brief La política con intervalo mínimo descarta los ticks demasiado próximos.
+ */
+static void checkLockout() {
+    Pluviometer<gaugeBucket02mm_t, LockoutDebounce<80, 500>> gauge;
+    const uint64_t times[] = {1000, 1200, 1499, 1500, 1999, 2000, 9000};
+    const bool accepted[] = {true, false, false, true, false, true, true};
+
+    for (size_t i = 0; i < sizeof(times) / sizeof(times[0]); i++) {
+        if (gauge.addTip(times[i]) != accepted[i]) {
+            fail("LockoutDebounce", "decisión incorrecta", (long)times[i]);
+        }
+    }
+    if (gauge.tips() != 4) {
+        fail("LockoutDebounce", "ticks aceptados", (long)gauge.tips());
+    }
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char* argv[]) {
+    size_t count = 10000000;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--tips") == 0 && i + 1 < argc) {
+            count = strtoull(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "uso: %s [--tips n]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    checkTable<gaugeBucket01mm_t>("gaugeBucket01mm_t");
+    checkTable<gaugeBucket02mm_t>("gaugeBucket02mm_t");
+    checkTable<gaugeBucket05mm_t>("gaugeBucket05mm_t");
+    checkLockout();
+
+    // Intervalos de tormenta entre 1 s y 10 min
+    std::mt19937_64 rng(1);
+    std::vector<uint64_t> times(count);
+    uint64_t t = 1;
+    for (size_t i = 0; i < count; i++) {
+        t += 1000 + rng() % 600000;
+        times[i] = t;
+    }
+
+    // Versión con macros: contar ticks y multiplicar al reportar cada 60 ticks
+    volatile int32_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    int rainfallCount = 0;
+    for (size_t i = 0; i < count; i++) {
+        rainfallCount++;
+        if (rainfallCount == 60) {
+            sink = sink + rainfallCount * 2;
+            rainfallCount = 0;
+        }
+    }
+    double macroNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    Pluviometer<gaugeBucket02mm_t, EdgeDebounce<80>> gauge;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        gauge.addTip(times[i]);
+        if (gauge.tips() == 60) {
+            sink = sink + gauge.rainfall();
+            gauge.startPeriod();
+        }
+    }
+    double templateNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    printf("costo por tick    : macros %.2f ns, plantilla con corrección %.2f ns (suma de control %d)\n",
+           macroNs / count, templateNs / count, (int)sink);
+    printf("errores           : %llu\n", (unsigned long long)failures);
+    return failures == 0 ? 0 : 1;
+}
+
+/* === End of documentation ==================================================================== */
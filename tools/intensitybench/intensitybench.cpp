@@ -0,0 +1,185 @@
+/*
+ * Nombre del archivo: intensitybench.cpp
+ * Descripción: Verifica y mide el motor de intensidad de lluvia frente a una referencia por fuerza bruta.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Banco de pruebas de modules/intensity en PC.
+ **
+ ** Genera ticks con ráfagas, silencios largos y ticks procesados con demora,
+ ** y en cada consulta compara las cinco ventanas del motor con un recuento
+ ** directo sobre la lista completa de ticks. Luego mide el costo por tick y
+ ** por consulta de ambos.
+ **
+ ** Uso:
+ **   intensitybench [--steps N] [--seed N]
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include "mbed.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "pluviometer.h"
+#include "intensity.h"
+
+/* === Private variable declarations =========================================================== */
+
+static intensity_t engine;  ///< Estático por su tamaño
+static volatile uint32_t sink;  ///< Evita que el compilador descarte las consultas medidas
+
+/* === Private function implementation ========================================================= */
+
+/**
+ * @brief Recuento directo de los ticks de una ventana que termina en now.
+ */
+static uint32_t bruteForce(const std::deque<uint32_t>& tips, intensityWindow_t window, uint32_t now) {
+    uint32_t count = 0;
+    uint32_t span = intensityWindowSeconds(window);
+
+    for (uint32_t t : tips) {
+        if (window == INTENSITY_24_H) {
+            count += now / 60 - t / 60 < INTENSITY_MINUTES ? 1 : 0;
+        } else {
+            count += now - t < span ? 1 : 0;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Próximo paso del reloj: casi siempre segundos, a veces horas o días.
+ */
+static uint32_t nextGap(std::mt19937_64& rng) {
+    uint32_t kind = (uint32_t)(rng() % 1000);
+    if (kind < 900) {
+        return (uint32_t)(rng() % 4);
+    }
+    if (kind < 990) {
+        return (uint32_t)(rng() % 900);
+    }
+    return (uint32_t)(rng() % (3 * 86400));
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char* argv[]) {
+    uint64_t steps = 300000;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+            steps = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "uso: %s [--steps n] [--seed n]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // Exactitud contra el recuento directo
+    std::mt19937_64 rng(seed);
+    std::deque<uint32_t> tips;
+    uint32_t now = TIME_INI;
+    uint64_t queries = 0;
+    uint64_t failures = 0;
+
+    intensityInit(&engine, now);
+    for (uint64_t step = 0; step < steps; step++) {
+        now += nextGap(rng);
+        uint32_t burst = (uint32_t)(rng() % 3);
+        for (uint32_t i = 0; i < burst; i++) {
+            // Algunos ticks llegan con demora, como los que esperan en la cola de captura
+            uint32_t late = (rng() % 8) == 0 ? (uint32_t)(rng() % 120) : 0;
+            if ((rng() % 500) == 0) {
+                late = (uint32_t)(rng() % 7200);
+            }
+            uint32_t t = now - late;
+            intensityAddTips(&engine, t, 1);
+            tips.push_back(t);
+        }
+        while (!tips.empty() && now - tips.front() > 2 * 86400) {
+            tips.pop_front();
+        }
+
+        if ((rng() % 4) == 0) {
+            for (int window = 0; window < INTENSITY_WINDOW_COUNT; window++) {
+                uint32_t expected = bruteForce(tips, (intensityWindow_t)window, now);
+                uint32_t got = intensityTips(&engine, (intensityWindow_t)window, now);
+                if (got != expected && failures++ < 10) {
+                    fprintf(stderr, "paso %llu ventana %d: esperado %u, obtenido %u\n",
+                            (unsigned long long)step, window, expected, got);
+                }
+                queries++;
+            }
+        }
+    }
+    printf("consultas verificadas : %llu\n", (unsigned long long)queries);
+    printf("errores               : %llu\n", (unsigned long long)failures);
+
+    // Costo con una tormenta sostenida de un tick cada 1 a 10 s durante un día
+    std::vector<uint32_t> stream;
+    now = TIME_INI;
+    while (now < TIME_INI + 86400) {
+        now += 1 + (uint32_t)(rng() % 10);
+        stream.push_back(now);
+    }
+
+    intensityInit(&engine, TIME_INI);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t t : stream) {
+        intensityAddTips(&engine, t, 1);
+        for (int window = 0; window < INTENSITY_WINDOW_COUNT; window++) {
+            sink = sink + intensityTips(&engine, (intensityWindow_t)window, t);
+        }
+    }
+    double engineNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    tips.clear();
+    start = std::chrono::steady_clock::now();
+    for (uint32_t t : stream) {
+        tips.push_back(t);
+        while (t - tips.front() > 86400) {
+            tips.pop_front();
+        }
+        for (int window = 0; window < INTENSITY_WINDOW_COUNT; window++) {
+            sink = sink + bruteForce(tips, (intensityWindow_t)window, t);
+        }
+    }
+    double bruteNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    printf("ticks medidos         : %zu\n", stream.size());
+    printf("motor (tick + 5 cons.): %.1f ns\n", engineNs / stream.size());
+    printf("fuerza bruta          : %.1f ns\n", bruteNs / stream.size());
+    printf("memoria del motor     : %zu bytes\n", sizeof(intensity_t));
+    return failures == 0 ? 0 : 1;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,145 @@
+/*
+ * Nombre del archivo: logdecode.cpp
+ * Descripción: Convierte la salida binaria del registro de eventos a las líneas de texto históricas.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Decodificador de la línea binaria del registro de eventos.
+ **
+ ** Lee los bytes capturados del puerto serie con LOGGER_WIRE_MODE ==
+ ** LOGGER_WIRE_BINARY (o LOGGER_WIRE_COMPACT con --compact, o
+ ** LOGGER_WIRE_FRAMED con --framed) y escribe las mismas líneas que el
+ ** firmware produce en modo texto, usando logFormatText() del propio
+ ** firmware. El flujo compacto debe capturarse desde el arranque; las tramas
+ ** se resincronizan solas y sus contadores se informan al final. Las tramas de
+ ** texto (respuestas a comandos) se escriben tal como llegan.
+ **
+ ** Uso:
+ **   logdecode [--compact | --framed] [archivo]     sin archivo lee la entrada estándar
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <stdio.h>
+#include <string.h>
+
+#include "logformat.h"
+
+/* === Private function implementation ========================================================= */
+
+/**
+ * @brief Escribe la línea de texto de un mensaje de telemetría.
+ */
+static void printMessage(void* context, uint32_t sequence, const tipCodecItem_t* message) {
+    logRecord_t record;
+    char text[LOG_TEXT_MAX];
+    logCompactRecord(message, &record);
+    fwrite(text, 1, logFormatText(&record, text), stdout);
+}
+
+/**
+ * @brief Escribe el contenido de una trama de texto.
+ */
+static void printText(void* context, const char* text, size_t length) {
+    fwrite(text, 1, length, stdout);
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char* argv[]) {
+    FILE* input = stdin;
+    bool compact = false;
+    bool framed = false;
+    int arg = 1;
+
+    if (arg < argc && strcmp(argv[arg], "--compact") == 0) {
+        compact = true;
+        arg++;
+    } else if (arg < argc && strcmp(argv[arg], "--framed") == 0) {
+        framed = true;
+        arg++;
+    }
+    if (argc - arg > 1) {
+        fprintf(stderr, "uso: %s [--compact | --framed] [archivo]\n", argv[0]);
+        return 2;
+    }
+    if (arg < argc && strcmp(argv[arg], "-") != 0) {
+        input = fopen(argv[arg], "rb");
+        if (input == NULL) {
+            perror(argv[arg]);
+            return 1;
+        }
+    }
+
+    logDecoder_t decoder;
+    tipDecoder_t compactDecoder;
+    logDecoderInit(&decoder);
+    tipDecoderInit(&compactDecoder);
+    telemetryDecoder_t frameDecoder;
+    telemetryDecoderInit(&frameDecoder);
+    telemetryDecoderSetTextHandler(&frameDecoder, printText, NULL);
+
+    uint8_t buffer[4096];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), input)) > 0) {
+        if (framed) {
+            telemetryDecoderPush(&frameDecoder, buffer, count, printMessage, NULL);
+            continue;
+        }
+        for (size_t i = 0; i < count; i++) {
+            logRecord_t record;
+            tipCodecItem_t item;
+            bool complete;
+            if (compact) {
+                complete = tipDecoderPush(&compactDecoder, buffer[i], &item);
+                if (complete) {
+                    logCompactRecord(&item, &record);
+                }
+            } else {
+                complete = logDecoderPush(&decoder, buffer[i], &record);
+            }
+            if (complete) {
+                char text[LOG_TEXT_MAX];
+                fwrite(text, 1, logFormatText(&record, text), stdout);
+            }
+        }
+    }
+
+    if (input != stdin) {
+        fclose(input);
+    }
+    if (decoder.errors > 0) {
+        fprintf(stderr, "%s: %lu bytes descartados\n", argv[0], (unsigned long)decoder.errors);
+    }
+    if (compactDecoder.errors > 0) {
+        fprintf(stderr, "%s: %lu elementos inválidos\n", argv[0], (unsigned long)compactDecoder.errors);
+    }
+    if (framed) {
+        fprintf(stderr, "%s: %lu tramas, %lu mensajes, %lu de texto, %lu con error, %lu perdidas, %lu reinicios\n",
+                argv[0], (unsigned long)frameDecoder.stats.frames, (unsigned long)frameDecoder.stats.messages,
+                (unsigned long)frameDecoder.stats.texts,
+                (unsigned long)frameDecoder.stats.crcErrors, (unsigned long)frameDecoder.stats.lostFrames,
+                (unsigned long)frameDecoder.stats.restarts);
+    }
+    return 0;
+}
+
+/* === End of documentation ==================================================================== */
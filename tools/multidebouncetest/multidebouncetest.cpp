@@ -0,0 +1,323 @@
+/*
+ * Nombre del archivo: multidebouncetest.cpp
+ * Descripción: Pruebas del antirrebote de contadores verticales y costo frente a copias de la FSM.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Pruebas de multiDebounceUpdate() y costo por muestra frente a N copias de la FSM.
+ **
+ ** Verifica con secuencias fijas que un canal cambia al cuarto muestreo
+ ** distinto y no antes, que los rebotes de menos de 4 muestras se descartan
+ ** y reinician la cuenta, y que las máscaras rising/falling distinguen
+ ** canales que suben, bajan o están deshabilitados en la misma muestra.
+ ** Luego compara un millón de muestras al azar de 32 canales con un
+ ** contador por canal y verifica la lectura de un puerto entero. Al final
+ ** mide ns por muestra de 1, 8 y 32 canales frente a llamar
+ ** debounceFSM_update() una vez por canal.
+ **
+ ** Uso:
+ **   multidebouncetest [--samples N] [--seed N]
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include "mbed.h"
+#include "hostsim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <random>
+
+#include "delay.h"
+#include "debounce.h"
+#include "multidebounce.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define US_PER_MS 1000ULL
+#define BENCH_SAMPLES 2000000  ///< Muestras por medición
+#define FSM_DEBOUNCE_MS 80  ///< DEBOUNCE_TIME de pluviometer.h
+
+/* === Private data type declarations ========================================================== */
+
+/**
+ * @brief Antirrebote de un canal contado de a una muestra, como referencia.
+ */
+typedef struct {
+    uint8_t count;  ///< Muestras seguidas distintas del nivel
+    bool level;     ///< Nivel antirrebotado
+} channelReference_t;
+
+/* === Private variable declarations =========================================================== */
+
+static uint64_t failures = 0;
+static volatile uint32_t sink = 0;  ///< Evita que el compilador descarte los resultados
+
+/* Las demoras quedan enlazadas en la rueda de modules/delay: deben vivir todo el programa */
+static delay_t fsmDelays[MULTI_DEBOUNCE_CHANNELS];
+
+/* === Private function implementation ========================================================= */
+
+static void fail(const char* name, const char* message, long detail) {
+    if (failures++ < 10) {
+        fprintf(stderr, "%s: %s (%ld)\n", name, message, detail);
+    }
+}
+
+/**
+ * @brief Alimenta una secuencia de niveles a un canal y verifica la muestra en que cambia.
+ *
+ * @param levels Niveles crudos como texto de '0' y '1'.
+ * @param expected Índice de la muestra con el flanco antirrebotado, o -1 si no debe haberlo.
+ */
+static void checkSequence(const char* name, uint32_t channel, const char* levels, int expected) {
+    multiDebounce_t debounce;
+    uint32_t bit = (uint32_t)1 << channel;
+    int edge = -1;
+
+    multiDebounceInit(&debounce, bit, levels[0] == '1' ? bit : 0);
+    for (int i = 0; levels[i] != '\0'; i++) {
+        uint32_t before = multiDebounceState(&debounce);
+        uint32_t rising = multiDebounceUpdate(&debounce, levels[i] == '1' ? bit : 0);
+        if (multiDebounceState(&debounce) != before) {
+            if (edge != -1) {
+                fail(name, "más de un flanco", i);
+            }
+            edge = i;
+            bool up = (multiDebounceState(&debounce) & bit) != 0;
+            if (rising != (up ? bit : 0) || debounce.rising != (up ? bit : 0) || debounce.falling != (up ? 0 : bit)) {
+                fail(name, "máscaras rising/falling no coinciden con el flanco", i);
+            }
+        } else if (rising != 0 || debounce.rising != 0 || debounce.falling != 0) {
+            fail(name, "máscaras sin flanco", i);
+        }
+    }
+    if (edge != expected) {
+        fail(name, "flanco en otra muestra", edge);
+    }
+}
+
+/**
+ * @brief Cambio al cuarto muestreo distinto y rebotes cortos descartados, en el primer y último canal.
+ */
+static void checkFlip() {
+    for (uint32_t channel : {0u, 13u, 31u}) {
+        checkSequence("cambio", channel, "01111", 4);
+        checkSequence("cambio", channel, "0111", -1);
+        checkSequence("cambio", channel, "10000", 4);
+        checkSequence("cambio", channel, "1000", -1);
+        checkSequence("rebote", channel, "0101101110111", -1);
+        checkSequence("rebote", channel, "011101111", 8);
+        checkSequence("rebote", channel, "100010000", 8);
+        checkSequence("rebote", channel, "0111011101110111", -1);
+        checkSequence("rebote", channel, "0000111", -1);
+    }
+    printf("cambio            : al cuarto muestreo distinto; rebotes de 1 a 3 muestras descartados\n");
+}
+
+/**
+ * @brief En una misma muestra un canal sube, otro baja, otro rebota y otro está deshabilitado.
+ */
+static void checkMixed() {
+    multiDebounce_t debounce;
+    const uint32_t up = 1u << 0, down = 1u << 5, bouncing = 1u << 17, disabled = 1u << 30;
+
+    multiDebounceInit(&debounce, up | down | bouncing, down | disabled);
+    if (multiDebounceState(&debounce) != down) {
+        fail("mezcla", "el estado inicial incluye canales deshabilitados", (long)multiDebounceState(&debounce));
+    }
+    for (int i = 0; i < 4; i++) {
+        uint32_t sample = up | disabled | (i == 2 ? 0 : bouncing);
+        uint32_t rising = multiDebounceUpdate(&debounce, sample);
+        if (i < 3 && (rising != 0 || debounce.falling != 0)) {
+            fail("mezcla", "flanco antes de la cuarta muestra", i);
+        }
+        if (i == 3 && (rising != up || debounce.rising != up || debounce.falling != down)) {
+            fail("mezcla", "máscaras de la cuarta muestra", (long)debounce.falling);
+        }
+    }
+    if (multiDebounceState(&debounce) != up) {
+        fail("mezcla", "estado tras la cuarta muestra", (long)multiDebounceState(&debounce));
+    }
+    printf("mezcla            : sube, baja, rebota y deshabilitado en la misma muestra\n");
+}
+
+/**
+ * @brief Un millón de muestras al azar de 32 canales contra un contador por canal.
+ */
+static void checkAgainstReference(uint64_t samples, std::mt19937_64& rng) {
+    multiDebounce_t debounce;
+    channelReference_t reference[MULTI_DEBOUNCE_CHANNELS];
+    uint32_t raw = (uint32_t)rng();
+    uint32_t mask = (uint32_t)rng() | 0x1u;
+    uint64_t edges = 0;
+
+    multiDebounceInit(&debounce, mask, raw);
+    for (uint32_t channel = 0; channel < MULTI_DEBOUNCE_CHANNELS; channel++) {
+        reference[channel] = {0, ((raw & mask) >> channel & 1u) != 0};
+    }
+
+    for (uint64_t i = 0; i < samples; i++) {
+        // Cada canal cambia con probabilidad propia: unos rebotan, otros quedan firmes
+        for (uint32_t channel = 0; channel < MULTI_DEBOUNCE_CHANNELS; channel++) {
+            if (rng() % (channel % 8 + 2) == 0) {
+                raw ^= 1u << channel;
+            }
+        }
+
+        uint32_t rising = 0, falling = 0, state = 0;
+        for (uint32_t channel = 0; channel < MULTI_DEBOUNCE_CHANNELS; channel++) {
+            channelReference_t* expected = &reference[channel];
+            bool level = (raw >> channel & 1u) != 0;
+            if ((mask >> channel & 1u) == 0) {
+                continue;
+            }
+            if (level == expected->level) {
+                expected->count = 0;
+            } else if (++expected->count == MULTI_DEBOUNCE_SAMPLES) {
+                expected->count = 0;
+                expected->level = level;
+                (level ? rising : falling) |= 1u << channel;
+            }
+            state |= (uint32_t)expected->level << channel;
+        }
+
+        if (multiDebounceUpdate(&debounce, raw) != rising || debounce.falling != falling ||
+            multiDebounceState(&debounce) != state) {
+            fail("referencia", "distinto del contador por canal", (long)i);
+        }
+        edges += __builtin_popcount(rising | falling);
+    }
+    printf("referencia        : %llu muestras de 32 canales (máscara %08x), %llu flancos iguales\n",
+           (unsigned long long)samples, mask, (unsigned long long)edges);
+}
+
+/**
+ * @brief multiDebounceUpdatePort() con un tick en un pin del puerto y los demás quietos.
+ */
+static void checkPort() {
+    PortIn port(PortE, 0x00FF);
+    multiDebounce_t debounce;
+    uint32_t tips = 0;
+
+    multiDebounceInit(&debounce, 0x00FF, 0);
+    hostPinWrite((int)PortE * 16 + 3, 1);
+    hostPinWrite((int)PortE * 16 + 9, 1);  // Fuera de la máscara del puerto
+    for (int i = 0; i < MULTI_DEBOUNCE_SAMPLES; i++) {
+        tips |= multiDebounceUpdatePort(&debounce, &port);
+    }
+    if (tips != 1u << 3 || multiDebounceState(&debounce) != 1u << 3) {
+        fail("puerto", "tick del pin 3 no detectado solo", (long)tips);
+    }
+    printf("puerto            : lectura del puerto entero en una muestra\n");
+}
+
+/**
+ * @brief ns por muestra de multiDebounceUpdate() con los canales de mask.
+ */
+static double benchMulti(uint32_t mask) {
+    multiDebounce_t debounce;
+    uint32_t tips = 0;
+    uint32_t noise = 1;
+
+    multiDebounceInit(&debounce, mask, 0);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++) {
+        noise = noise * 1664525u + 1013904223u;
+        uint32_t level = (i / 50) & 1 ? mask : 0;
+        tips += __builtin_popcount(multiDebounceUpdate(&debounce, level ^ (noise & mask & 0x01010101u)));
+    }
+    auto stop = std::chrono::steady_clock::now();
+    sink = sink + tips;
+    return std::chrono::duration<double, std::nano>(stop - start).count() / BENCH_SAMPLES;
+}
+
+/**
+ * @brief ns por muestra de copies llamadas a debounceFSM_update(), cada una con su demora.
+ *
+ * El estado de la FSM es global, pero el costo por llamada no depende de eso.
+ */
+static double benchFsm(uint32_t copies) {
+    uint32_t presses = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCH_SAMPLES / copies; i++) {
+        uint32_t phase = i % 200;
+        hostPinWrite(BUTTON1, phase < 100 ? (phase < 6 ? (int)(phase & 1) : 1) : 0);
+        hostClockAdvanceTo(hostClockNowUs() + US_PER_MS);
+        for (uint32_t copy = 0; copy < copies; copy++) {
+            debounceFSM_update(&fsmDelays[copy]);
+        }
+        presses += readKey();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    sink = sink + presses;
+    return std::chrono::duration<double, std::nano>(stop - start).count() / (BENCH_SAMPLES / copies);
+}
+
+static void measureCosts() {
+    static const uint32_t channels[] = {1, 8, 32};
+
+    for (delay_t& delay : fsmDelays) {
+        delayInit(&delay, FSM_DEBOUNCE_MS);
+    }
+    debounceFSM_init();
+    printf("\n%-8s %16s %16s %10s\n", "canales", "verticales ns", "FSM x N ns", "relación");
+    for (uint32_t count : channels) {
+        uint32_t mask = count == 32 ? 0xFFFFFFFFu : (1u << count) - 1;
+        double multiNs = benchMulti(mask);
+        double fsmNs = benchFsm(count);
+        printf("%-8u %16.2f %16.2f %9.1fx\n", count, multiNs, fsmNs, fsmNs / multiNs);
+    }
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char* argv[]) {
+    uint64_t samples = 1000000;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            samples = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "uso: %s [--samples n] [--seed n]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::mt19937_64 rng(seed);
+    checkFlip();
+    checkMixed();
+    checkAgainstReference(samples, rng);
+    checkPort();
+    measureCosts();
+
+    printf("errores           : %llu\n", (unsigned long long)failures);
+    return failures == 0 ? 0 : 1;
+}
+
+/* === End of documentation ==================================================================== */
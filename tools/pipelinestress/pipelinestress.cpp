@@ -0,0 +1,297 @@
+/*
+ * Nombre del archivo: pipelinestress.cpp
+ * Descripción: Prueba de carga del pipeline de hilos con ráfagas sintéticas de ticks.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Prueba de carga de modules/pipeline en PC.
+ **
+ ** Corre el firmware con MAIN_LOOP_MODE == MAIN_LOOP_PIPELINE: las tres
+ ** etapas son std::thread reales (host/mbed.h) y este programa hace de ISR,
+ ** llamando a tipCaptureOnEdge() desde el hilo principal. El reloj virtual
+ ** sigue al real, así que la UART simulada transmite a BAUD_RATE de verdad.
+ **
+ ** La primera fase genera ráfagas de ticks a ritmo fijo (100 Hz por defecto)
+ ** y mide la latencia del flanco a la cola de la agregación con la sonda
+ ** edge_to_acquisition; falla si se pierde algún tick. La segunda genera
+ ** ticks sin pausa, sin dejar que la cola de la ISR se llene, y mide cuántos
+ ** ticks por segundo procesa el pipeline completo.
+ **
+ ** A 100 Hz los flancos quedan a 5 ms, menos que el antirrebote del equipo,
+ ** así que se compila con un DEBOUNCE_TIME menor. Uso:
+ **   pipelinestress [--rate HZ] [--bursts N] [--tips N] [--gap MS] [--flood N]
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include "mbed.h"
+#include "hostsim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <thread>
+
+#include "tipcapture.h"
+#include "pluviometer.h"
+#include "eventloop.h"
+#include "pipeline.h"
+#include "probe.h"
+
+#if MAIN_LOOP_MODE != MAIN_LOOP_PIPELINE || !INSTRUMENTATION_ENABLED
+#error "pipelinestress requiere -DMAIN_LOOP_MODE=2 -DINSTRUMENTATION_ENABLED=1"
+#endif
+
+/* === Macros definitions ====================================================================== */
+
+#define RAINFALL_CHECK_INTERVAL 60  ///< Igual que main.cpp
+#define CLOCK_STEP_US 1000  ///< Avance máximo del reloj virtual entre lecturas del real
+#define DRAIN_TIMEOUT_US 5000000  ///< Espera máxima a que el pipeline procese lo generado
+
+/* === Private data type declarations ========================================================== */
+
+typedef struct {
+    uint32_t rateHz;
+    uint32_t bursts;
+    uint32_t tipsPerBurst;
+    uint32_t gapMs;
+    uint32_t floodTips;
+} options_t;
+
+/* === Private variable declarations =========================================================== */
+
+static uint64_t serialBytes = 0;  ///< Solo lo escribe el hilo de E/S
+static std::chrono::steady_clock::time_point realStart;
+static uint64_t virtualStart = 0;
+
+/* === Private function implementation ========================================================= */
+
+static void serialSink(const char* data, size_t length) {
+    (void)data;
+    serialBytes += length;
+}
+
+/**
+ * @brief Microsegundos reales desde el arranque de la prueba.
+ */
+static uint64_t realUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - realStart).count();
+}
+
+/**
+ * @brief Espera hasta el instante real atUs llevando el reloj virtual detrás del real.
+ */
+static void followClockUntil(uint64_t atUs) {
+    uint64_t now;
+
+    while ((now = realUs()) < atUs) {
+        hostClockAdvanceTo(virtualStart + now);
+        uint64_t stepUs = atUs - now < CLOCK_STEP_US ? atUs - now : CLOCK_STEP_US;
+        std::this_thread::sleep_for(std::chrono::microseconds(stepUs));
+    }
+    hostClockAdvanceTo(virtualStart + atUs);
+}
+
+/**
+ * @brief Espera a que la agregación procese todos los ticks aceptados y la E/S vacíe la cola de almacenamiento.
+ *
+ * @param followReal true si el reloj virtual debe seguir al real mientras tanto.
+ * @return true si terminó antes de DRAIN_TIMEOUT_US.
+ */
+static bool waitIdle(bool followReal) {
+    uint64_t deadline = realUs() + DRAIN_TIMEOUT_US;
+
+    while (realUs() < deadline) {
+        tipCaptureStats_t capture;
+        pipelineStats_t stats;
+        storageStats_t storage;
+
+        tipCaptureGetStats(&capture);
+        pipelineGetStats(&stats);
+        getStorageStats(&storage);
+        if (stats.tipsAggregated == capture.accepted && storage.pending == 0) {
+            return true;
+        }
+        if (followReal) {
+            followClockUntil(realUs() + CLOCK_STEP_US);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Ráfagas a ritmo fijo en tiempo real.
+ *
+ * @return Cantidad de errores.
+ */
+static int runPaced(const options_t* options) {
+    uint64_t periodUs = 1000000ULL / options->rateHz;
+    uint64_t burstUs = options->tipsPerBurst * periodUs + (uint64_t)options->gapMs * 1000;
+    uint32_t generated = 0;
+    tipCaptureStats_t before;
+    tipCaptureStats_t after;
+    pipelineStats_t stats;
+    int errors = 0;
+
+    tipCaptureGetStats(&before);
+    probeReset();
+    uint64_t phaseStart = realUs();
+    for (uint32_t burst = 0; burst < options->bursts; burst++) {
+        for (uint32_t i = 0; i < options->tipsPerBurst; i++) {
+            uint64_t tipUs = phaseStart + burst * burstUs + i * periodUs;
+            followClockUntil(tipUs);
+            tipCaptureOnEdge(HAL_GetTick(), true);
+            followClockUntil(tipUs + periodUs / 2);
+            tipCaptureOnEdge(HAL_GetTick(), false);
+            generated++;
+        }
+        followClockUntil(phaseStart + (burst + 1) * burstUs);
+    }
+    if (!waitIdle(true)) {
+        fprintf(stderr, "ráfagas: el pipeline no terminó de procesar a tiempo\n");
+        errors++;
+    }
+    uint64_t phaseUs = realUs() - phaseStart;
+
+    tipCaptureGetStats(&after);
+    pipelineGetStats(&stats);
+    const histogram_t* latency = probeHistogram(PROBE_EDGE_TO_ACQUISITION);
+    uint32_t accepted = after.accepted - before.accepted;
+
+    printf("ráfagas           : %u x %u ticks a %u Hz en %.1f s, %u aceptados, %u rebotes, %u desbordes de la ISR\n",
+           options->bursts, options->tipsPerBurst, options->rateHz, phaseUs / 1e6, accepted,
+           after.bounces - before.bounces, after.overflows - before.overflows);
+    printf("latencia flanco-agregación: p50 %lu ns, p99 %lu ns, peor %lu ns (%u ms de HAL_GetTick)\n",
+           (unsigned long)histogramQuantile(latency, 500), (unsigned long)histogramQuantile(latency, 990),
+           (unsigned long)latency->max, stats.maxAcquisitionMs);
+    printf("colas             : ticks máx %u de %u (%u esperas), almacenamiento máx %u de %u (%u esperas)\n",
+           stats.tipQueueHighWater, PIPELINE_TIP_QUEUE_SIZE, stats.tipQueueStalls, stats.storageHighWater,
+           STORAGE_QUEUE_SIZE, stats.storageStalls);
+    printf("registro de eventos: %u descartados, %llu bytes por la UART a %d baudios\n", stats.logDropped,
+           (unsigned long long)serialBytes, BAUD_RATE);
+
+    if (accepted != generated || after.overflows != before.overflows) {
+        fprintf(stderr, "ráfagas: %u ticks generados y %u aceptados; revisar DEBOUNCE_TIME o las colas\n",
+                generated, accepted);
+        errors++;
+    }
+    if (stats.tipsAggregated != after.accepted) {
+        fprintf(stderr, "ráfagas: %u ticks aceptados y %u procesados\n", after.accepted, stats.tipsAggregated);
+        errors++;
+    }
+    return errors;
+}
+
+/**
+ * @brief Ticks sin pausa: rendimiento del pipeline completo.
+ *
+ * El reloj virtual avanza por tick lo justo para pasar el antirrebote, así
+ * que la UART simulada no limita; la generación solo espera si la cola de la
+ * ISR está por llenarse.
+ *
+ * @return Cantidad de errores.
+ */
+static int runFlood(const options_t* options) {
+    uint64_t stepUs = (uint64_t)(DEBOUNCE_TIME + 1) * 1000;
+    tipCaptureStats_t capture;
+    pipelineStats_t stats;
+    int errors = 0;
+
+    tipCaptureGetStats(&capture);
+    uint32_t acceptedBefore = capture.accepted;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < options->floodTips; i++) {
+        do {
+            tipCaptureGetStats(&capture);
+            pipelineGetStats(&stats);
+        } while (capture.accepted - stats.tipsAcquired >= TIP_CAPTURE_QUEUE_SIZE - 1 && (std::this_thread::yield(), true));
+
+        hostClockAdvanceTo(hostClockNowUs() + stepUs);
+        tipCaptureOnEdge(HAL_GetTick(), true);
+        hostClockAdvanceTo(hostClockNowUs() + stepUs);
+        tipCaptureOnEdge(HAL_GetTick(), false);
+    }
+    if (!waitIdle(false)) {
+        fprintf(stderr, "continuo: el pipeline no terminó de procesar a tiempo\n");
+        errors++;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    tipCaptureGetStats(&capture);
+    pipelineGetStats(&stats);
+    uint32_t accepted = capture.accepted - acceptedBefore;
+    printf("continuo          : %u ticks en %.3f s, %.0f ticks/s, %u despertares de la agregación\n", accepted,
+           seconds, accepted / seconds, stats.aggregationWakeups);
+    printf("colas             : ticks máx %u de %u, almacenamiento máx %u de %u (%u esperas)\n",
+           stats.tipQueueHighWater, PIPELINE_TIP_QUEUE_SIZE, stats.storageHighWater, STORAGE_QUEUE_SIZE,
+           stats.storageStalls);
+    return errors;
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char** argv) {
+    options_t options = {100, 3, 300, 1000, 20000};
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            options.rateHz = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--bursts") == 0 && i + 1 < argc) {
+            options.bursts = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--tips") == 0 && i + 1 < argc) {
+            options.tipsPerBurst = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--gap") == 0 && i + 1 < argc) {
+            options.gapMs = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--flood") == 0 && i + 1 < argc) {
+            options.floodTips = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "uso: %s [--rate HZ] [--bursts N] [--tips N] [--gap MS] [--flood N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (options.rateHz == 0 || 500000 / options.rateHz < (DEBOUNCE_TIME + 1) * 1000) {
+        fprintf(stderr, "a %u Hz los flancos quedan más cerca que DEBOUNCE_TIME (%d ms); compilar con un valor menor\n",
+                options.rateHz, DEBOUNCE_TIME);
+        return 2;
+    }
+
+    hostSerialSetSink(serialSink);
+    initializeSensors();
+    scheduleReports(RAINFALL_CHECK_INTERVAL);
+    realStart = std::chrono::steady_clock::now();
+    virtualStart = hostClockNowUs();
+    pipelineStart();
+
+    int errors = runPaced(&options);
+    if (options.floodTips > 0) {
+        errors += runFlood(&options);
+    }
+    pipelineStop();
+
+    printf("%s\n", errors == 0 ? "sin errores" : "CON ERRORES");
+    return errors == 0 ? 0 : 1;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,230 @@
+/*
+ * Nombre del archivo: powercut.cpp
+ * Descripción: Cortes de energía aleatorios sobre el registro persistente de ticks.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Prueba de cortes de energía de modules/storage en PC.
+ **
+ ** Escribe registros numerados en un tipLog sobre un HeapBlockDevice con
+ ** semántica de flash, envuelto en un FaultBlockDevice que corta la energía
+ ** en un byte aleatorio (a mitad de una página o de un borrado). Tras cada
+ ** corte reabre el registro y verifica que:
+ **  - los registros leídos son consecutivos, sin huecos, duplicados ni basura;
+ **  - el último registro confirmado (página programada) antes del corte sigue
+ **    ahí, salvo que el anillo ya haya reciclado su sector;
+ **  - la recuperación hizo O(log sectores + log páginas) lecturas.
+ ** Al final informa el desgaste de cada sector.
+ **
+ ** Uso:
+ **   powercut [--cycles N] [--sectors N] [--sector-size BYTES] [--seed N]
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include "mbed.h"
+#include "HeapBlockDevice.h"
+#include "FaultBlockDevice.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <random>
+
+#include "tiplog.h"
+
+/* === Private variable declarations =========================================================== */
+
+static uint32_t failures = 0;
+
+/* === Private function implementation ========================================================= */
+
+static void fail(uint32_t cycle, const char* message, uint32_t a, uint32_t b) {
+    if (failures++ < 10) {
+        fprintf(stderr, "ciclo %u: %s (%u, %u)\n", cycle, message, a, b);
+    }
+}
+
+/**
+ * @brief Secuencia del sector donde está un cursor.
+ */
+static uint32_t sectorSequence(const tipLog_t* log, uint32_t sector) {
+    return log->headSequence - (log->headSector + log->sectorCount - sector) % log->sectorCount;
+}
+
+/**
+ * @brief Lee el registro completo y comprueba que sea una serie consecutiva.
+ *
+ * @param durableSequence Secuencia del sector del último registro confirmado; a la
+ *        salida, la del sector del último registro leído.
+ * @return Último valor leído, o 0 si el registro está vacío.
+ */
+static uint32_t verifyLog(tipLog_t* log, uint32_t cycle, uint32_t durable, uint32_t* durableSequence,
+                          uint32_t appended, uint32_t* retained) {
+    tipLogCursor_t cursor;
+    tipLogRecord_t record;
+    uint32_t first = 0;
+    uint32_t last = 0;
+    uint32_t lastSequence = 0;
+    uint32_t count = 0;
+
+    tipLogRewind(log, &cursor);
+    while (tipLogNext(log, &cursor, &record)) {
+        uint32_t value = (uint32_t)record.value;
+        if (record.type != TIP_LOG_TIP || record.timestamp != value) {
+            fail(cycle, "registro alterado", value, record.timestamp);
+        }
+        if (count > 0 && value != last + 1) {
+            fail(cycle, "serie no consecutiva", last, value);
+        }
+        if (count == 0) {
+            first = value;
+        }
+        last = value;
+        lastSequence = sectorSequence(log, cursor.sector);
+        count++;
+    }
+
+    // El sector del registro confirmado sigue en el anillo si no pasaron usedSectors sectores
+    bool inRing = log->headSequence - *durableSequence < log->usedSectors;
+    if (durable > 0 && inRing && (count == 0 || last < durable || first > durable)) {
+        fail(cycle, "se perdió un registro confirmado", durable, last);
+    }
+    if (last > appended) {
+        fail(cycle, "registro nunca escrito", last, appended);
+    }
+    *retained = count;
+    *durableSequence = lastSequence;
+    return last;
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char* argv[]) {
+    uint32_t cycles = 2000;
+    uint32_t sectors = 8;
+    uint32_t sectorSize = 4096;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--cycles") == 0 && i + 1 < argc) {
+            cycles = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--sectors") == 0 && i + 1 < argc) {
+            sectors = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--sector-size") == 0 && i + 1 < argc) {
+            sectorSize = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "uso: %s [--cycles n] [--sectors n] [--sector-size bytes] [--seed n]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (sectors < 3 || sectorSize % TIP_LOG_PAGE_SIZE != 0 || sectorSize < 2 * TIP_LOG_PAGE_SIZE) {
+        fprintf(stderr, "%s: se necesitan 3 sectores o más, múltiplos de %d bytes\n", argv[0], TIP_LOG_PAGE_SIZE);
+        return 2;
+    }
+
+    std::mt19937_64 rng(seed);
+    srand((unsigned)seed);
+    HeapBlockDevice flash((bd_size_t)sectors * sectorSize, 1, 4, sectorSize);
+    FaultBlockDevice device(&flash);
+    tipLog_t log;
+
+    uint32_t pages = sectorSize / TIP_LOG_PAGE_SIZE;
+    uint32_t readBound = 3 + (uint32_t)ceil(log2(sectors)) + (uint32_t)ceil(log2(pages)) + 2 * TIP_LOG_PAGE_SIZE / TIP_LOG_RECORD_SIZE;
+    uint32_t maxReads = 0;
+    uint32_t minRetained = UINT32_MAX;
+    uint32_t durable = 0;  // Último valor confirmado en flash
+    uint32_t durableSequence = 0;  // Secuencia del sector que lo contiene
+    uint32_t appended = 0;  // Último valor agregado
+    uint64_t records = 0;
+
+    for (uint32_t cycle = 0; cycle < cycles; cycle++) {
+        device.powerOn();
+        if (tipLogInit(&log, &device) != 0) {
+            fail(cycle, "no abrió", 0, 0);
+            break;
+        }
+        tipLogStats_t stats;
+        tipLogGetStats(&log, &stats);
+        if (stats.recoveryReads > readBound) {
+            fail(cycle, "recuperación demasiado larga", stats.recoveryReads, readBound);
+        }
+        if (stats.recoveryReads > maxReads) {
+            maxReads = stats.recoveryReads;
+        }
+
+        uint32_t retained;
+        uint32_t last = verifyLog(&log, cycle, durable, &durableSequence, appended, &retained);
+        if (cycle > 2 * sectors && retained < minRetained) {
+            minRetained = retained;
+        }
+        // El firmware sigue numerando desde lo que recuperó
+        appended = last;
+        durable = last;
+
+        // Corte en cualquier punto de las próximas escrituras, incluso de un borrado
+        std::uniform_int_distribution<uint64_t> cutAt(0, 3ull * sectorSize);
+        device.armCut(cutAt(rng));
+
+        while (!device.powerLost()) {
+            tipLogRecord_t record;
+            record.type = TIP_LOG_TIP;
+            record.timestamp = appended + 1;
+            record.value = (int32_t)(appended + 1);
+
+            uint32_t pagesBefore = log.stats.pagesWritten;
+            int error = tipLogAppend(&log, &record);
+            if (error == 0) {
+                appended++;
+                records++;
+                if ((rng() % 24) == 0) {
+                    error = tipLogFlush(&log);
+                }
+            }
+            if (error == 0 && log.stats.pagesWritten != pagesBefore) {
+                durable = appended;  // La página programada contiene todo lo agregado
+                durableSequence = log.headSequence;
+            }
+        }
+    }
+
+    printf("ciclos             : %u\n", cycles);
+    printf("registros escritos : %llu\n", (unsigned long long)records);
+    printf("lecturas máximas   : %u (cota %u, %u sectores de %u páginas)\n", maxReads, readBound, sectors, pages);
+    printf("retenidos mínimos  : %u\n", minRetained == UINT32_MAX ? 0 : minRetained);
+
+    uint32_t minErases = UINT32_MAX;
+    uint32_t maxErases = 0;
+    for (size_t block = 0; block < device.blockCount(); block++) {
+        uint32_t erases = device.eraseCount(block);
+        minErases = erases < minErases ? erases : minErases;
+        maxErases = erases > maxErases ? erases : maxErases;
+    }
+    printf("borrados por sector: %u a %u\n", minErases, maxErases);
+    printf("errores            : %u\n", failures);
+    return failures == 0 ? 0 : 1;
+}
+
+/* === End of documentation ==================================================================== */
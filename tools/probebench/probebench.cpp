@@ -0,0 +1,240 @@
+/*
+ * Nombre del archivo: probebench.cpp
+ * Descripción: Verificación de los histogramas y costo de las sondas de latencia.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Banco de pruebas de modules/probe en PC.
+ **
+ ** Verifica que las cubetas del histograma cubran los 32 bits sin huecos ni
+ ** solapes y con error relativo acotado, compara los cuantiles con los
+ ** exactos de muestras log-normales, pide un volcado por el puerto serie
+ ** simulado y comprueba que las cubetas volcadas rearmen cada histograma.
+ ** Al final mide el costo de una sonda (dos lecturas del contador y un
+ ** registro) y de histogramRecord() solo.
+ **
+ ** Se compila con INSTRUMENTATION_ENABLED=1. Uso:
+ **   probebench [--samples N]
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include "mbed.h"
+#include "hostsim.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "probe.h"
+
+#if !INSTRUMENTATION_ENABLED
+#error "probebench requiere -DINSTRUMENTATION_ENABLED=1"
+#endif
+
+/* === Private variable declarations =========================================================== */
+
+static uint64_t failures = 0;
+static std::string serialOutput;  ///< Lo escrito en el puerto serie simulado
+
+/* === Private function implementation ========================================================= */
+
+static void fail(const char* name, const char* message, long detail) {
+    if (failures++ < 10) {
+        fprintf(stderr, "%s: %s (%ld)\n", name, message, detail);
+    }
+}
+
+static void serialSink(const char* data, size_t length) {
+    serialOutput.append(data, length);
+}
+
+/**
+ * @brief Las cubetas son contiguas, cubren todo el rango y su ancho relativo está acotado.
+ */
+static void checkBuckets() {
+    for (uint32_t bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) {
+        uint32_t low = histogramBucketLow(bucket);
+        uint32_t high = histogramBucketHigh(bucket);
+        if (low > high || histogramBucketOf(low) != bucket || histogramBucketOf(high) != bucket) {
+            fail("cubetas", "límites inconsistentes", (long)bucket);
+        }
+        if (bucket > 0 && low != histogramBucketHigh(bucket - 1) + 1) {
+            fail("cubetas", "hueco o solape", (long)bucket);
+        }
+        if (low >= HISTOGRAM_SUB_BUCKETS && (double)(high - low + 1) / low > 1.0 / HISTOGRAM_SUB_BUCKETS) {
+            fail("cubetas", "cubeta demasiado ancha", (long)bucket);
+        }
+    }
+    if (histogramBucketLow(0) != 0 || histogramBucketHigh(HISTOGRAM_BUCKETS - 1) != UINT32_MAX) {
+        fail("cubetas", "el rango no cubre 32 bits", 0);
+    }
+}
+
+/**
+ * @brief Compara los cuantiles del histograma con los exactos.
+ */
+static void checkQuantiles(size_t samples) {
+    std::mt19937_64 rng(1);
+    std::lognormal_distribution<double> latency(8.0, 1.5);
+    std::vector<uint32_t> values(samples);
+    histogram_t histogram;
+
+    histogramInit(&histogram);
+    for (size_t i = 0; i < samples; i++) {
+        values[i] = (uint32_t)std::min(latency(rng), 4e9);
+        histogramRecord(&histogram, values[i]);
+    }
+    std::sort(values.begin(), values.end());
+
+    const uint32_t permilles[] = {0, 10, 500, 900, 990, 999, 1000};
+    double worst = 0.0;
+    for (uint32_t permille : permilles) {
+        size_t rank = (size_t)(((uint64_t)samples * permille + 999) / 1000);
+        uint32_t exact = values[rank == 0 ? 0 : rank - 1];
+        uint32_t estimate = histogramQuantile(&histogram, permille);
+        double error = exact ? (double)(estimate - exact) / exact : 0.0;
+        worst = std::max(worst, error);
+        if (estimate < exact || error > 1.0 / HISTOGRAM_SUB_BUCKETS) {
+            fail("cuantiles", "fuera de la cota", (long)permille);
+        }
+    }
+    if (histogram.min != values.front() || histogram.max != values.back() || histogram.count != samples) {
+        fail("cuantiles", "mínimo, máximo o cantidad", 0);
+    }
+    printf("cuantiles         : %zu muestras, error relativo máximo %.2f %% (cota %.1f %%), %zu bytes por histograma\n",
+           samples, worst * 100.0, 100.0 / HISTOGRAM_SUB_BUCKETS, sizeof(histogram_t));
+}
+
+/**
+ * @brief Pide el volcado por el puerto serie y rearma cada histograma desde sus cubetas.
+ */
+static void checkDump() {
+    BufferedSerial port(USBTX, USBRX, 115200);
+    std::mt19937 rng(2);
+
+    port.set_blocking(false);
+    hostSerialSetSink(serialSink);
+    probeInit();
+    for (int i = 0; i < 10000; i++) {
+        probeRecord((probeId_t)(i % PROBE_COUNT), rng() >> (rng() % 32));
+    }
+
+    hostSerialInject("x?", 2);
+    if (!probeDumpRequested(&port)) {
+        fail("volcado", "pedido no reconocido", 0);
+    }
+    probeDump(&port);
+
+    // Cada sonda produce su línea de resumen y una de cubetas "bajo:cantidad"
+    size_t position = 0;
+    for (int id = 0; id < PROBE_COUNT; id++) {
+        size_t buckets = serialOutput.find("  buckets", position);
+        size_t end = serialOutput.find("\r\n", buckets);
+        if (buckets == std::string::npos || end == std::string::npos) {
+            fail("volcado", "falta la línea de cubetas", id);
+            return;
+        }
+        histogram_t rebuilt;
+        histogramInit(&rebuilt);
+        const char* cursor = serialOutput.c_str() + buckets + 9;
+        unsigned long low, count;
+        int used;
+        while (sscanf(cursor, " %lu:%lu%n", &low, &count, &used) == 2) {
+            rebuilt.counts[histogramBucketOf((uint32_t)low)] += (uint32_t)count;
+            rebuilt.count += (uint32_t)count;
+            cursor += used;
+        }
+        const histogram_t* original = probeHistogram((probeId_t)id);
+        if (rebuilt.count != original->count ||
+            memcmp(rebuilt.counts, original->counts, sizeof(rebuilt.counts)) != 0) {
+            fail("volcado", "cubetas distintas", id);
+        }
+        position = end;
+    }
+
+    hostSerialInject("!", 1);
+    probeDumpRequested(&port);
+    if (probeHistogram(PROBE_LOOP_ITERATION)->count != 0) {
+        fail("volcado", "PROBE_RESET_KEY no vació los histogramas", 0);
+    }
+    printf("volcado           : %zu bytes para %d sondas\n", serialOutput.size(), (int)PROBE_COUNT);
+    hostSerialSetSink(NULL);
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char* argv[]) {
+    size_t samples = 1000000;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            samples = strtoull(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "uso: %s [--samples n]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (samples == 0) {
+        samples = 1;
+    }
+
+    checkBuckets();
+    checkQuantiles(samples);
+    checkDump();
+
+    // Costo de una sonda completa frente al histograma solo
+    const size_t rounds = 10000000;
+    probeReset();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; i++) {
+        PROBE_START(probeStart);
+        PROBE_STOP(PROBE_LOOP_ITERATION, probeStart);
+    }
+    double probeNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    histogram_t histogram;
+    histogramInit(&histogram);
+    uint32_t value = 1;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; i++) {
+        value = value * 1664525u + 1013904223u;
+        histogramRecord(&histogram, value >> (value & 31));
+    }
+    double recordNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    char line[128];
+    probeFormat(PROBE_LOOP_ITERATION, line, sizeof(line));
+    printf("costo por sonda   : %.2f ns (dos clock_gettime y un registro), histogramRecord %.2f ns\n",
+           probeNs / rounds, recordNs / rounds);
+    printf("sonda vacía       : %s\n", line);
+    printf("errores           : %llu\n", (unsigned long long)failures);
+    return failures == 0 ? 0 : 1;
+}
+
+/* === End of documentation ==================================================================== */
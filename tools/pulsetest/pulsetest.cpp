@@ -0,0 +1,314 @@
+/*
+ * Nombre del archivo: pulsetest.cpp
+ * Descripción: Pruebas del contador de pulsos sobre el modelo de captura de hostsim.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Pruebas de modules/pulsecounter sobre el modelo de captura de hostsim.
+ **
+ ** Verifica el decodificador solo (antirrebote por silencio y vuelta del
+ ** contador de 32 bits), y después hace correr pulseCounterDrain() contra el
+ ** modelo de TIM2 y la DMA de host/: ticks a 20 por segundo con rebotes de
+ ** hasta 2 ms al cerrar y al abrir el contacto y pulsos de ruido más cortos
+ ** que el filtro, leyendo cada PULSE_COUNTER_POLL_MS con el contador de us
+ ** cruzando su vuelta. Exige que no se pierda ni se sobre-cuente ningún tick
+ ** y que cada instante caiga a 1 ms del verdadero. Al final deja de leer
+ ** hasta que la DMA da la vuelta y comprueba que el desborde se informe y
+ ** que el conteo se retome.
+ **
+ ** Uso:
+ **   pulsetest [--minutes N] [--seed N]
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include "mbed.h"
+#include "hostsim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <random>
+#include <vector>
+
+#include "pulsecounter.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define US_PER_MS 1000ULL
+#define TIP_RATE_HZ 20  ///< Ritmo de la prueba principal
+#define BOUNCE_MAX_US 2000  ///< Duración máxima de los rebotes al cerrar o abrir
+#define WRAP_START_US (0x100000000ULL - 30 * 1000000ULL)  ///< El contador de 32 bits da la vuelta a los 30 s
+
+/* === Private data type declarations ========================================================== */
+
+typedef struct {
+    uint64_t us;
+    int level;
+} edge_t;
+
+/* === Private variable declarations =========================================================== */
+
+static uint64_t failures = 0;
+static std::vector<edge_t> edges;
+static size_t nextEdge = 0;
+
+/* === Private function implementation ========================================================= */
+
+static void fail(const char* name, const char* message, long detail) {
+    if (failures++ < 10) {
+        fprintf(stderr, "%s: %s (%ld)\n", name, message, detail);
+    }
+}
+
+static uint64_t stimulusNext() {
+    return nextEdge < edges.size() ? edges[nextEdge].us : HOST_TIME_NEVER;
+}
+
+static void stimulusFire() {
+    hostPinWrite(PULSE_COUNTER_PIN, edges[nextEdge].level);
+    nextEdge++;
+}
+
+static const hostStimulus_t stimulus = {stimulusNext, stimulusFire};
+
+/**
+ * @brief Agrega un cambio de nivel; los instantes deben crecer.
+ */
+static void addEdge(uint64_t us, int level) {
+    if (!edges.empty() && us <= edges.back().us) {
+        us = edges.back().us + 1;
+    }
+    edges.push_back(edge_t{us, level});
+}
+
+/**
+ * @brief Rebotes tras un cambio a level: pulsos al nivel contrario que terminan en level.
+ */
+static void addBounce(uint64_t startUs, int level, std::mt19937_64& rng) {
+    std::uniform_int_distribution<int> pulses(0, 6);
+    std::uniform_int_distribution<uint64_t> widthUs(20, 150);
+    uint64_t us = startUs;
+
+    for (int i = pulses(rng); i > 0 && us + 300 < startUs + BOUNCE_MAX_US; i--) {
+        us += widthUs(rng);
+        addEdge(us, !level);
+        us += widthUs(rng);
+        addEdge(us, level);
+    }
+}
+
+/**
+ * @brief Pulso de ruido más corto que el filtro: no debe llegar a la captura.
+ */
+static void addGlitch(uint64_t us, int level, std::mt19937_64& rng) {
+    std::uniform_int_distribution<uint64_t> widthUs(1, PULSE_COUNTER_FILTER_US - 2);
+
+    addEdge(us, !level);
+    addEdge(us + widthUs(rng), level);
+}
+
+/**
+ * @brief Antirrebote por silencio y paridad de los flancos, sin periféricos.
+ */
+static void checkDecoder() {
+    pulseDecoder_t decoder;
+
+    pulseDecoderInit(&decoder, 5000, false);
+    if (pulseDecoderPush(&decoder, 1000) != 1) {
+        fail("decodificador", "el primer flanco de subida es un tick", 0);
+    }
+    if (pulseDecoderPush(&decoder, 1100) != 0 || pulseDecoderPush(&decoder, 1200) != -1) {
+        fail("decodificador", "rebote al cerrar", 0);
+    }
+    if (pulseDecoderPush(&decoder, 30000) != 0 || pulseDecoderPush(&decoder, 30500) != -1 ||
+        pulseDecoderPush(&decoder, 30600) != 0) {
+        fail("decodificador", "rebote al abrir", 0);
+    }
+    if (pulseDecoderPush(&decoder, 35599) != -1) {
+        fail("decodificador", "silencio más corto que el mínimo", 0);
+    }
+    pulseDecoderPush(&decoder, 36000);
+    if (pulseDecoderPush(&decoder, 41000) != 1) {
+        fail("decodificador", "silencio exacto", 0);
+    }
+
+    // Vuelta del contador de 32 bits entre dos flancos
+    pulseDecoderInit(&decoder, 5000, true);
+    pulseDecoderPush(&decoder, 0xFFFFF000u);
+    if (pulseDecoderPush(&decoder, 0x00001000u) != 1) {
+        fail("decodificador", "vuelta del contador", 0);
+    }
+}
+
+/**
+ * @brief Lee las capturas hasta agotarlas.
+ *
+ * @param tips Instantes de los ticks en ms de HAL_GetTick().
+ */
+static void drainAll(std::vector<tick_t>* tips) {
+    tipEvent_t batch[8];
+    size_t count;
+
+    while ((count = pulseCounterDrain(batch, 8)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            tips->push_back(batch[i].timestamp);
+        }
+    }
+}
+
+/**
+ * @brief Ticks a TIP_RATE_HZ con rebotes y ruido, leídos cada PULSE_COUNTER_POLL_MS.
+ */
+static void checkRate(uint32_t minutes, std::mt19937_64& rng) {
+    std::uniform_int_distribution<uint64_t> closedUs(8000, 25000);
+    std::uniform_int_distribution<int> glitchChance(0, 3);
+    std::vector<uint64_t> trueUs;
+    std::vector<tick_t> tips;
+    pulseCounterStats_t before;
+    pulseCounterStats_t after;
+
+    hostClockAdvanceTo(WRAP_START_US);
+    pulseCounterGetStats(&before);
+    pulseCounterInit(PULSE_COUNTER_PIN, PULSE_COUNTER_QUIET_US);
+
+    uint64_t startUs = hostClockNowUs() + 10 * US_PER_MS;
+    uint64_t periodUs = 1000000 / TIP_RATE_HZ;
+    uint64_t count = (uint64_t)minutes * 60 * TIP_RATE_HZ;
+    edges.clear();
+    nextEdge = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t closeUs = startUs + i * periodUs;
+        uint64_t openUs = closeUs + closedUs(rng);
+        addEdge(closeUs, 1);
+        trueUs.push_back(closeUs);
+        addBounce(closeUs, 1, rng);
+        if (glitchChance(rng) == 0) {
+            addGlitch(closeUs + BOUNCE_MAX_US + 2000, 1, rng);
+        }
+        addEdge(openUs, 0);
+        addBounce(openUs, 0, rng);
+        if (glitchChance(rng) == 0) {
+            addGlitch(openUs + BOUNCE_MAX_US + 2000, 0, rng);
+        }
+    }
+    hostSetStimulus(&stimulus);
+
+    uint64_t endUs = edges.back().us + 100 * US_PER_MS;
+    while (hostClockNowUs() < endUs) {
+        hostClockAdvanceTo(hostClockNowUs() + PULSE_COUNTER_POLL_MS * US_PER_MS);
+        drainAll(&tips);
+    }
+    pulseCounterGetStats(&after);
+
+    if (tips.size() != trueUs.size()) {
+        fail("20 ticks/s", "ticks contados distintos de los verdaderos", (long)tips.size() - (long)trueUs.size());
+    }
+    long worstMs = 0;
+    for (size_t i = 0; i < tips.size() && i < trueUs.size(); i++) {
+        // HAL_GetTick() es el reloj virtual en ms; el filtro retrasa la captura unos us
+        long errorMs = (long)(tick_t)(tips[i] - (tick_t)(trueUs[i] / US_PER_MS));
+        worstMs = labs(errorMs) > worstMs ? labs(errorMs) : worstMs;
+    }
+    if (worstMs > 1) {
+        fail("20 ticks/s", "instante de un tick a más de 1 ms", worstMs);
+    }
+    if (after.overruns != before.overruns) {
+        fail("20 ticks/s", "desbordes del buffer circular", (long)(after.overruns - before.overruns));
+    }
+
+    size_t glitchEdges = edges.size() - (size_t)(after.edges - before.edges);
+    printf("20 ticks/s        : %zu ticks en %u min, %zu contados, %u flancos capturados, %u rebotes, "
+           "%zu flancos de ruido filtrados, error máximo %ld ms\n",
+           trueUs.size(), minutes, tips.size(), after.edges - before.edges, after.bounces - before.bounces,
+           glitchEdges, worstMs);
+}
+
+/**
+ * @brief Sin leer durante más de PULSE_COUNTER_RING_SIZE flancos: se informa el desborde y se retoma.
+ */
+static void checkOverrun(std::mt19937_64& rng) {
+    std::vector<tick_t> tips;
+    pulseCounterStats_t before;
+    pulseCounterStats_t after;
+
+    pulseCounterGetStats(&before);
+    uint64_t periodUs = 1000000 / TIP_RATE_HZ;
+    uint64_t startUs = hostClockNowUs() + 10 * US_PER_MS;
+    uint64_t lost = PULSE_COUNTER_RING_SIZE;  // Dos flancos por tick: el buffer da la vuelta
+    uint64_t kept = 50;
+    edges.clear();
+    nextEdge = 0;
+    for (uint64_t i = 0; i < lost + kept; i++) {
+        uint64_t closeUs = startUs + i * periodUs;
+        addEdge(closeUs, 1);
+        addBounce(closeUs, 1, rng);
+        addEdge(closeUs + periodUs / 2, 0);
+    }
+
+    // Una sola lectura tras los ticks que desbordan el buffer, y luego lecturas normales
+    hostClockAdvanceTo(startUs + lost * periodUs - periodUs / 4);
+    drainAll(&tips);
+    uint64_t endUs = edges.back().us + 100 * US_PER_MS;
+    while (hostClockNowUs() < endUs) {
+        hostClockAdvanceTo(hostClockNowUs() + PULSE_COUNTER_POLL_MS * US_PER_MS);
+        drainAll(&tips);
+    }
+    pulseCounterGetStats(&after);
+
+    if (after.overruns == before.overruns) {
+        fail("desborde", "no se informó", 0);
+    }
+    if (tips.size() < kept - 1 || tips.size() > kept) {
+        fail("desborde", "no se retomó el conteo", (long)tips.size());
+    }
+    printf("desborde          : %u informado(s), %zu de %llu ticks posteriores contados\n",
+           after.overruns - before.overruns, tips.size(), (unsigned long long)kept);
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char** argv) {
+    uint32_t minutes = 30;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--minutes") == 0 && i + 1 < argc) {
+            minutes = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "uso: %s [--minutes N] [--seed N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::mt19937_64 rng(seed);
+    checkDecoder();
+    checkRate(minutes, rng);
+    checkOverrun(rng);
+
+    printf("errores           : %llu\n", (unsigned long long)failures);
+    return failures == 0 ? 0 : 1;
+}
+
+/* === End of documentation ==================================================================== */
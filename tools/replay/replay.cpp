@@ -0,0 +1,454 @@
+/*
+ * Nombre del archivo: replay.cpp
+ * Descripción: Reproduce trazas de ticks con rebotes sobre el firmware real en el simulador.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Reproductor de trazas de ticks.
+ **
+ ** Convierte una traza de ticks verdaderos (grabada o sintética) en flancos
+ ** con rebotes sobre la entrada del pluviómetro (SWITCH_TICK_RAIN, o
+ ** PULSE_COUNTER_PIN con ACQUISITION_TIMER) y hace correr el código real de
+ ** pluviometer.cpp sobre el reloj virtual de hostsim, tan rápido como lo
+ ** permita el PC. Al final compara los ticks detectados (líneas
+ ** MSG_RAIN_DETECTED en la salida serie) con los verdaderos y reporta el
+ ** costo de proceso por evento.
+ **
+ ** Uso:
+ **   replay --trace archivo      ms por línea, o líneas "YYYY-MM-DD HH:MM:SS ..."
+ **   replay --synthetic DIAS     tormentas sintéticas durante DIAS días
+ ** Opciones: --seed N, --loop-us N (periodo del bucle de sondeo),
+ **           --report-s N (RAINFALL_CHECK_INTERVAL), --no-bounce, --echo
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include "mbed.h"
+#include "arm_book_lib.h"
+#include "hostsim.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "pluviometer.h"
+#include "pulsecounter.h"
+#include "eventloop.h"
+#include "logger.h"
+#include "probe.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define US_PER_MS 1000ULL
+#define US_PER_S 1000000ULL
+#define MIN_TIP_INTERVAL_US (300 * US_PER_MS)  ///< Tiempo mínimo de vuelco del balancín
+#if ACQUISITION_MODE == ACQUISITION_TIMER
+#define TIP_INPUT_PIN PULSE_COUNTER_PIN  ///< Entrada de captura de TIM2
+#else
+#define TIP_INPUT_PIN SWITCH_TICK_RAIN
+#endif
+#define ACTIVE_WINDOW_US (2 * (DEBOUNCE_TIME + DELAY_BETWEEN_TICK) * US_PER_MS)
+
+#if MAIN_LOOP_MODE == MAIN_LOOP_EVENTS && ACQUISITION_MODE == ACQUISITION_POLLING
+#error "MAIN_LOOP_EVENTS requiere ACQUISITION_INTERRUPT o ACQUISITION_TIMER"
+#endif
+#if MAIN_LOOP_MODE == MAIN_LOOP_PIPELINE
+#error "replay avanza el reloj virtual en un solo hilo; el pipeline se prueba con tools/pipelinestress"
+#endif
+
+/* === Private data type declarations ========================================================== */
+
+typedef struct {
+    uint64_t us;
+    int level;
+} edge_t;
+
+/* === Private variable declarations =========================================================== */
+
+static std::vector<edge_t> edges;
+static size_t nextEdge = 0;
+static uint64_t lastEdgeUs = 0;
+static uint64_t endUs = 0;
+
+static uint64_t detectedTips = 0;
+static char lineBuffer[128];
+static size_t lineLength = 0;
+static bool echo = false;
+#if LOGGER_WIRE_MODE == LOGGER_WIRE_BINARY
+static logDecoder_t wireDecoder;
+#elif LOGGER_WIRE_MODE == LOGGER_WIRE_COMPACT
+static tipDecoder_t wireDecoder;
+#elif LOGGER_WIRE_MODE == LOGGER_WIRE_FRAMED
+static telemetryDecoder_t wireDecoder;
+#endif
+
+/* === Private function implementation ========================================================= */
+
+static uint64_t stimulusNext() {
+    return nextEdge < edges.size() ? edges[nextEdge].us : HOST_TIME_NEVER;
+}
+
+static void stimulusFire() {
+    hostPinWrite(TIP_INPUT_PIN, edges[nextEdge].level);
+    lastEdgeUs = edges[nextEdge].us;
+    nextEdge++;
+}
+
+static const hostStimulus_t stimulus = {stimulusNext, stimulusFire};
+
+/**
+ * @brief Cuenta las líneas de tick de un texto de salida.
+ */
+static void countLines(const char* data, size_t length) {
+    if (echo) {
+        fwrite(data, 1, length, stdout);
+    }
+    for (size_t i = 0; i < length; i++) {
+        if (data[i] == '\n') {
+            lineBuffer[lineLength] = '\0';
+            if (strstr(lineBuffer, " - Rain detected") != NULL) {
+                detectedTips++;
+            }
+            lineLength = 0;
+        } else if (lineLength < sizeof(lineBuffer) - 1) {
+            lineBuffer[lineLength++] = data[i];
+        }
+    }
+}
+
+#if LOGGER_WIRE_MODE == LOGGER_WIRE_FRAMED
+/**
+ * @brief Convierte un mensaje de telemetría en su línea de texto y la cuenta.
+ */
+static void countMessage(void* context, uint32_t sequence, const tipCodecItem_t* message) {
+    logRecord_t record;
+    char text[LOG_TEXT_MAX];
+    logCompactRecord(message, &record);
+    countLines(text, logFormatText(&record, text));
+}
+#endif
+
+/**
+ * @brief Recibe la salida serie; en los modos binarios la decodifica a texto antes de contar.
+ */
+static void serialSink(const char* data, size_t length) {
+#if LOGGER_WIRE_MODE == LOGGER_WIRE_BINARY
+    for (size_t i = 0; i < length; i++) {
+        logRecord_t record;
+        if (logDecoderPush(&wireDecoder, (uint8_t)data[i], &record)) {
+            char text[LOG_TEXT_MAX];
+            countLines(text, logFormatText(&record, text));
+        }
+    }
+#elif LOGGER_WIRE_MODE == LOGGER_WIRE_COMPACT
+    for (size_t i = 0; i < length; i++) {
+        tipCodecItem_t item;
+        if (tipDecoderPush(&wireDecoder, (uint8_t)data[i], &item)) {
+            logRecord_t record;
+            char text[LOG_TEXT_MAX];
+            logCompactRecord(&item, &record);
+            countLines(text, logFormatText(&record, text));
+        }
+    }
+#elif LOGGER_WIRE_MODE == LOGGER_WIRE_FRAMED
+    telemetryDecoderPush(&wireDecoder, (const uint8_t*)data, length, countMessage, NULL);
+#else
+    countLines(data, length);
+#endif
+}
+
+/**
+ * @brief Genera los flancos de un tick: cierre con rebotes, contacto sostenido y apertura con rebotes.
+ */
+static void addTipEdges(uint64_t tipUs, bool bounce, std::mt19937_64& rng) {
+    std::uniform_int_distribution<int> bounceCount(0, 4);
+    std::uniform_int_distribution<uint64_t> bounceUs(200, 2000);
+    std::uniform_int_distribution<uint64_t> holdUs(40 * US_PER_MS, 120 * US_PER_MS);
+
+    uint64_t t = tipUs;
+    edges.push_back({t, 1});
+    for (int i = bounce ? bounceCount(rng) : 0; i > 0; i--) {
+        t += bounceUs(rng);
+        edges.push_back({t, 0});
+        t += bounceUs(rng);
+        edges.push_back({t, 1});
+    }
+
+    t += holdUs(rng);
+    edges.push_back({t, 0});
+    for (int i = bounce ? bounceCount(rng) : 0; i > 0; i--) {
+        t += bounceUs(rng);
+        edges.push_back({t, 1});
+        t += bounceUs(rng);
+        edges.push_back({t, 0});
+    }
+}
+
+/**
+ * @brief Lee una traza: un tick por línea, en ms o con el formato TIME_FORMAT.
+ */
+static bool loadTrace(const char* path, std::vector<uint64_t>& tips) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        perror(path);
+        return false;
+    }
+
+    char line[256];
+    long long first = -1;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        struct tm fields = {};
+        long long ms;
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        if (strptime(line, TIME_FORMAT, &fields) != NULL) {
+            long long seconds = (long long)timegm(&fields);
+            if (first < 0) {
+                first = seconds;
+            }
+            tips.push_back((uint64_t)(seconds - first) * US_PER_S);
+        } else if (sscanf(line, "%lld", &ms) == 1 && ms >= 0) {
+            tips.push_back((uint64_t)ms * US_PER_MS);
+        }
+    }
+    fclose(file);
+
+    std::sort(tips.begin(), tips.end());
+    return true;
+}
+
+/**
+ * @brief Genera tormentas sintéticas: llegadas de Poisson, duración e intensidad aleatorias
+ *        y perfil triangular de intensidad dentro de cada tormenta.
+ */
+static void syntheticTrace(double days, std::mt19937_64& rng, std::vector<uint64_t>& tips) {
+    std::exponential_distribution<double> stormGap(1.0 / (2.5 * 86400.0));
+    std::uniform_real_distribution<double> stormHours(0.5, 8.0);
+    std::uniform_real_distribution<double> peakMmPerHour(2.0, 80.0);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    double horizon = days * 86400.0;
+    double t = stormGap(rng);
+    while (t < horizon) {
+        double duration = stormHours(rng) * 3600.0;
+        double peak = peakMmPerHour(rng) / (MM_PER_TICK / 10.0) / 3600.0;  // ticks/s
+        double s = t;
+        // Poisson no homogéneo por adelgazamiento sobre la intensidad máxima
+        while (true) {
+            s += -log(1.0 - unit(rng)) / peak;
+            if (s >= t + duration || s >= horizon) {
+                break;
+            }
+            double phase = (s - t) / duration;
+            double profile = phase < 0.5 ? 2.0 * phase : 2.0 * (1.0 - phase);
+            if (unit(rng) < profile) {
+                tips.push_back((uint64_t)(s * US_PER_S));
+            }
+        }
+        t += duration + stormGap(rng);
+    }
+}
+
+#if MAIN_LOOP_MODE == MAIN_LOOP_EVENTS
+/**
+ * @brief Espera del bucle de eventos: avanza hasta el próximo evento o flanco.
+ */
+static bool idle(uint64_t nextDue) {
+    uint64_t now = hostClockNowUs();
+    if (now >= endUs) {
+        return false;
+    }
+    uint64_t target = std::min(std::min(nextDue, stimulusNext()), endUs);
+    hostClockAdvanceTo(target > now ? target : now + 1);
+    return true;
+}
+#endif
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char* argv[]) {
+    const char* tracePath = NULL;
+    double syntheticDays = 0.0;
+    uint64_t seed = 1;
+    uint64_t loopUs = 1000;
+    int reportSeconds = 60;
+    bool bounce = true;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (strcmp(argv[i], "--synthetic") == 0 && i + 1 < argc) {
+            syntheticDays = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--loop-us") == 0 && i + 1 < argc) {
+            loopUs = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--report-s") == 0 && i + 1 < argc) {
+            reportSeconds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--no-bounce") == 0) {
+            bounce = false;
+        } else if (strcmp(argv[i], "--echo") == 0) {
+            echo = true;
+        } else {
+            fprintf(stderr, "uso: %s (--trace archivo | --synthetic dias) [--seed n] [--loop-us n]"
+                            " [--report-s n] [--no-bounce] [--echo]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (loopUs == 0 || reportSeconds <= 0 || (tracePath == NULL && syntheticDays <= 0.0)) {
+        fprintf(stderr, "%s: falta --trace o --synthetic\n", argv[0]);
+        return 2;
+    }
+
+    setenv("TZ", "UTC0", 1);
+    tzset();
+
+    std::mt19937_64 rng(seed);
+    std::vector<uint64_t> tips;
+    if (tracePath != NULL) {
+        if (!loadTrace(tracePath, tips)) {
+            return 1;
+        }
+    } else {
+        syntheticTrace(syntheticDays, rng, tips);
+    }
+
+    // Ticks más cercanos que el vuelco mínimo no son físicos: se descartan
+    uint64_t trueTips = 0;
+    uint64_t previous = 0;
+    for (size_t i = 0; i < tips.size(); i++) {
+        if (i > 0 && tips[i] - previous < MIN_TIP_INTERVAL_US) {
+            continue;
+        }
+        addTipEdges(tips[i] + US_PER_S, bounce, rng);
+        previous = tips[i];
+        trueTips++;
+    }
+    endUs = (edges.empty() ? 0 : edges.back().us) + 2 * US_PER_S;
+    if (syntheticDays > 0.0) {
+        endUs = std::max(endUs, (uint64_t)(syntheticDays * 86400.0 * US_PER_S));
+    }
+
+#if LOGGER_WIRE_MODE == LOGGER_WIRE_BINARY
+    logDecoderInit(&wireDecoder);
+#elif LOGGER_WIRE_MODE == LOGGER_WIRE_COMPACT
+    tipDecoderInit(&wireDecoder);
+#elif LOGGER_WIRE_MODE == LOGGER_WIRE_FRAMED
+    telemetryDecoderInit(&wireDecoder);
+#endif
+    hostSerialSetSink(serialSink);
+    hostSetStimulus(&stimulus);
+    initializeSensors();
+    scheduleReports(reportSeconds);
+
+    auto wallStart = std::chrono::steady_clock::now();
+    uint64_t tipNs = 0;
+    uint64_t iterations = 0;
+
+#if MAIN_LOOP_MODE == MAIN_LOOP_EVENTS
+    hostSetIdle(idle);
+    eventLoopRun();
+    hostEventStats_t eventStats;
+    hostEventGetStats(&eventStats);
+    iterations = eventStats.dispatched;
+    tipNs = eventStats.busyNs;
+#else
+    while (hostClockNowUs() < endUs) {
+        auto start = std::chrono::steady_clock::now();
+        PROBE_START(iterationStart);
+        bool raining = isRaining();
+        if (raining) {
+            actOnRainfall();
+        } else {
+            tickLed = OFF;
+        }
+        if (isScheduleDue()) {
+            runSchedule();
+        }
+        loggerDrain();
+        PROBE_STOP(PROBE_LOOP_ITERATION, iterationStart);
+        if (raining) {
+            tipNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        }
+        iterations++;
+
+        // Fuera de la actividad del sensor el bucle no cambia nada: se salta
+        // hasta el próximo flanco, como máximo un segundo para no perder reportes
+        uint64_t now = hostClockNowUs();
+        uint64_t target = now + loopUs;
+        if (now >= lastEdgeUs + ACTIVE_WINDOW_US) {
+            uint64_t nextSecond = (now / US_PER_S + 1) * US_PER_S;
+            target = std::max(target, std::min(stimulusNext(), nextSecond));
+        }
+        hostClockAdvanceTo(target);
+    }
+#endif
+    while (loggerDrain()) {
+        hostClockAdvanceTo(hostClockNowUs() + loopUs);
+    }
+
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    double simSeconds = (double)hostClockNowUs() / US_PER_S;
+
+    printf("modo               : %s / %s\n",
+           ACQUISITION_MODE == ACQUISITION_TIMER       ? "temporizador"
+           : ACQUISITION_MODE == ACQUISITION_INTERRUPT ? "interrupcion"
+                                                       : "sondeo",
+           MAIN_LOOP_MODE == MAIN_LOOP_EVENTS ? "eventos" : "bucle");
+    printf("tiempo simulado    : %.1f dias\n", simSeconds / 86400.0);
+    printf("tiempo real        : %.3f s (x%.0f)\n", wallSeconds, simSeconds / (wallSeconds > 0 ? wallSeconds : 1e-9));
+    printf("ticks verdaderos   : %llu\n", (unsigned long long)trueTips);
+    printf("ticks detectados   : %llu (%+lld)\n", (unsigned long long)detectedTips,
+           (long long)detectedTips - (long long)trueTips);
+    printf("%-19s: %llu\n", MAIN_LOOP_MODE == MAIN_LOOP_EVENTS ? "despertares" : "vueltas del bucle",
+           (unsigned long long)iterations);
+    printf("costo por tick     : %.0f ns\n", detectedTips ? (double)tipNs / detectedTips : 0.0);
+    printf("bytes serie        : %llu (bloqueado %.3f s)\n", (unsigned long long)hostSerialBytesWritten(),
+           (double)hostSerialBlockedUs() / US_PER_S);
+    loggerStats_t logStats;
+    loggerGetStats(&logStats);
+    printf("registros          : %lu encolados, %lu descartados\n", (unsigned long)logStats.enqueued,
+           (unsigned long)logStats.dropped);
+#if LOGGER_WIRE_MODE == LOGGER_WIRE_FRAMED
+    printf("tramas             : %lu (%.1f mensajes por trama, %lu con error, %lu perdidas)\n",
+           (unsigned long)wireDecoder.stats.frames,
+           wireDecoder.stats.frames ? (double)wireDecoder.stats.messages / wireDecoder.stats.frames : 0.0,
+           (unsigned long)wireDecoder.stats.crcErrors, (unsigned long)wireDecoder.stats.lostFrames);
+#endif
+#if INSTRUMENTATION_ENABLED
+    for (int id = 0; id < PROBE_COUNT; id++) {
+        char line[128];
+        probeFormat((probeId_t)id, line, sizeof(line));
+        printf("%s\n", line);
+    }
+#endif
+    return 0;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,193 @@
+/*
+ * Nombre del archivo: rollupbench.cpp
+ * Descripción: Verifica y mide los acumulados por minuto, hora, día y mes frente a los ticks crudos.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Banco de pruebas de modules/rollup en PC.
+ **
+ ** Simula años de lluvia (con ticks procesados con demora y silencios
+ ** largos) y consulta rangos al azar, desde minutos hasta años. Cada total se
+ ** compara con el recuento de los ticks crudos sobre el rango que el
+ ** resultado dice cubrir, y se verifica que ese rango contenga al pedido
+ ** (no se simulan más años de los que retienen los meses).
+ ** También informa cuántas cubetas suma una consulta frente a la cantidad de
+ ** ticks del rango.
+ **
+ ** --queries N es la cantidad de consultas verificadas, repartidas a lo
+ ** largo de la simulación en proporción al tiempo simulado, y también la de
+ ** consultas medidas al final.
+ **
+ ** Uso:
+ **   rollupbench [--years N] [--queries N] [--seed N]
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "rollup.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define START_TIME 1593561600u  ///< TIME_INI de pluviometer.h
+
+/* === Private variable declarations =========================================================== */
+
+static rollup_t rollup;  ///< Estático por su tamaño
+static uint64_t failures = 0;
+
+/* === Private function implementation ========================================================= */
+
+/**
+ * @brief Ticks crudos en [from, to).
+ */
+static uint64_t rawCount(const std::vector<uint32_t>& sorted, uint32_t from, uint32_t to) {
+    return std::lower_bound(sorted.begin(), sorted.end(), to) - std::lower_bound(sorted.begin(), sorted.end(), from);
+}
+
+/**
+ * @brief Consulta un rango al azar terminado a lo sumo en now y lo verifica.
+ */
+static void checkQuery(std::mt19937_64& rng, const std::vector<uint32_t>& sorted, uint32_t now,
+                       uint64_t* exact, uint64_t* buckets, uint64_t* tips) {
+    static const uint32_t spans[] = {60, 3600, 86400, 31 * 86400, 366 * 86400, 5 * 366 * 86400};
+    uint32_t span = (uint32_t)(rng() % spans[rng() % 6]) + 1;
+    uint32_t to = now - (uint32_t)(rng() % (3 * 366 * 86400u));
+    uint32_t from = to > START_TIME + span ? to - span : START_TIME;
+    if ((rng() % 2) == 0) {
+        to = now + 1;
+    }
+
+    rollupResult_t result;
+    rollupQuery(&rollup, from, to, &result);
+
+    uint64_t expected = rawCount(sorted, result.from, result.to);
+    if (result.tips != expected && failures++ < 10) {
+        fprintf(stderr, "[%u, %u) cubierto [%u, %u): esperado %llu, obtenido %u\n", from, to, result.from,
+                result.to, (unsigned long long)expected, result.tips);
+    }
+    uint32_t nowEnd = now - now % 60 + 60;
+    if (result.from > from || result.to < std::min(to, nowEnd) || result.to > nowEnd) {
+        if (failures++ < 10) {
+            fprintf(stderr, "[%u, %u) cubierto [%u, %u): rango recortado\n", from, to, result.from, result.to);
+        }
+    }
+    *exact += result.from == from - from % 60 && result.to == std::min(to + 59 - (to + 59) % 60, nowEnd) ? 1 : 0;
+    *buckets += result.buckets;
+    *tips += expected;
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char* argv[]) {
+    double years = 6.0;
+    uint64_t queries = 200000;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--years") == 0 && i + 1 < argc) {
+            years = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--queries") == 0 && i + 1 < argc) {
+            queries = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "uso: %s [--years n] [--queries n] [--seed n]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::mt19937_64 rng(seed);
+    std::vector<uint32_t> raw;
+    uint32_t end = START_TIME + (uint32_t)(years * 365.25 * 86400);
+    uint32_t now = START_TIME;
+    uint64_t checked = 0;
+    uint64_t exact = 0;
+    uint64_t buckets = 0;
+    uint64_t tips = 0;
+
+    rollupInit(&rollup, now);
+    auto start = std::chrono::steady_clock::now();
+    while (now < end) {
+        // Tormentas de unas horas separadas por días secos
+        uint32_t kind = (uint32_t)(rng() % 100);
+        now += kind < 90 ? (uint32_t)(rng() % 40) + 1 : kind < 99 ? (uint32_t)(rng() % 86400) : (uint32_t)(rng() % (20 * 86400));
+        uint32_t late = (rng() % 10) == 0 ? (uint32_t)(rng() % 7200) : 0;
+        if ((rng() % 2000) == 0) {
+            late = (uint32_t)(rng() % (4 * 86400));
+        }
+        uint32_t t = now - late > START_TIME ? now - late : START_TIME;
+        rollupAddTips(&rollup, t, 1);
+        raw.push_back(t);
+
+        // Cada 1000 ticks, las consultas que corresponden al tiempo simulado hasta ahora
+        uint64_t due = now < end ? (uint64_t)((double)queries * (now - START_TIME) / (end - START_TIME)) : queries;
+        if (raw.size() % 1000 == 0 && due > checked) {
+            rollupAdvance(&rollup, now);
+            std::vector<uint32_t> sorted(raw);
+            std::sort(sorted.begin(), sorted.end());
+            for (; checked < due; checked++) {
+                checkQuery(rng, sorted, now, &exact, &buckets, &tips);
+            }
+        }
+    }
+    // Las que quedan, al final de la simulación
+    rollupAdvance(&rollup, now);
+    if (checked < queries) {
+        std::vector<uint32_t> sorted(raw);
+        std::sort(sorted.begin(), sorted.end());
+        for (; checked < queries; checked++) {
+            checkQuery(rng, sorted, now, &exact, &buckets, &tips);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Costo de una consulta sola, sobre rangos que terminan en el instante actual
+    uint32_t sink = 0;
+    auto queryStart = std::chrono::steady_clock::now();
+    for (uint64_t q = 0; q < queries; q++) {
+        rollupResult_t result;
+        rollupQuery(&rollup, now - (uint32_t)(rng() % (2 * 366 * 86400u)), now + 1, &result);
+        sink += result.tips;
+    }
+    double queryNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - queryStart).count();
+
+    printf("ticks                : %zu en %.1f años\n", raw.size(), years);
+    printf("consultas            : %llu (%llu exactas al minuto)\n", (unsigned long long)checked,
+           (unsigned long long)exact);
+    printf("cubetas por consulta : %.1f (ticks por consulta %.1f)\n", checked ? (double)buckets / checked : 0.0,
+           checked ? (double)tips / checked : 0.0);
+    printf("tiempo por consulta  : %.0f ns (suma de control %u)\n", queries ? queryNs / queries : 0.0, sink);
+    printf("memoria              : %zu bytes\n", sizeof(rollup_t));
+    printf("tiempo               : %.2f s\n", seconds);
+    printf("errores              : %llu\n", (unsigned long long)failures);
+    return failures == 0 ? 0 : 1;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,330 @@
+/*
+ * Nombre del archivo: schedulertest.cpp
+ * Descripción: Pruebas del planificador alineado al reloj de pared sobre el RTC virtual.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Pruebas de modules/scheduler sobre el RTC virtual de hostsim.
+ **
+ ** Sondea el planificador a intervalos irregulares durante días de tiempo
+ ** virtual y verifica que cada tarea corra en cada límite de su período,
+ ** exactamente una vez y sin derivar; que una demora larga o un set_time()
+ ** hacia adelante produzca una sola ejecución por tarea con los vencimientos
+ ** salteados informados; que un set_time() hacia atrás recalcule los
+ ** vencimientos sin ráfagas; y que el montículo coincida con una referencia
+ ** directa con tareas, avances y retrocesos al azar.
+ **
+ ** Uso:
+ **   schedulertest [--days N] [--seed N]
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include "mbed.h"
+#include "hostsim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <random>
+#include <vector>
+
+#include "scheduler.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define US_PER_S 1000000ULL
+#define START_TIME 1593606896u  ///< 2020-07-01 12:34:56 UTC
+#define UTC_OFFSET (-3 * 3600)  ///< Hora local de las pruebas de medianoche
+
+/* === Private data type declarations ========================================================== */
+
+/**
+ * @brief Ejecuciones observadas de una tarea.
+ */
+typedef struct {
+    const char* name;
+    uint32_t lastDeadline;  ///< Último vencimiento atendido (0 = ninguno)
+    uint32_t runs;
+    uint32_t missed;
+    uint32_t maxLateness;  ///< Mayor demora entre el vencimiento y la ejecución, en s
+} observed_t;
+
+/* === Private variable declarations =========================================================== */
+
+static uint64_t failures = 0;
+
+/* === Private function implementation ========================================================= */
+
+static void fail(const char* name, const char* message, long detail) {
+    if (failures++ < 10) {
+        fprintf(stderr, "%s: %s (%ld)\n", name, message, detail);
+    }
+}
+
+/**
+ * @brief Registra una ejecución y verifica que no haya duplicados ni huecos sin informar.
+ */
+static void record(uint32_t deadline, uint32_t missed, void* context) {
+    observed_t* observed = (observed_t*)context;
+    uint32_t now = (uint32_t)time(NULL);
+
+    if (deadline > now) {
+        fail(observed->name, "corrió antes del vencimiento", (long)deadline);
+    }
+    if (observed->lastDeadline != 0 && deadline <= observed->lastDeadline) {
+        fail(observed->name, "vencimiento repetido", (long)deadline);
+    }
+    if (now - deadline > observed->maxLateness) {
+        observed->maxLateness = now - deadline;
+    }
+    observed->lastDeadline = deadline;
+    observed->runs++;
+    observed->missed += missed;
+}
+
+/**
+ * @brief Avanza el RTC virtual en pasos irregulares de hasta 1,5 s, consultando tras cada paso.
+ */
+static void pollFor(scheduler_t* scheduler, uint64_t seconds, std::mt19937_64& rng) {
+    std::uniform_int_distribution<uint64_t> stepUs(1000, 1500000);
+    uint64_t endUs = hostClockNowUs() + seconds * US_PER_S;
+
+    while (hostClockNowUs() < endUs) {
+        hostClockAdvanceTo(hostClockNowUs() + stepUs(rng));
+        uint32_t now = (uint32_t)time(NULL);
+        if (schedulerNextDeadline(scheduler) <= now) {
+            schedulerRun(scheduler, now);
+        }
+    }
+}
+
+/**
+ * @brief Tareas de minuto, hora y medianoche local sondeadas durante días.
+ */
+static void checkAlignment(uint32_t days, std::mt19937_64& rng) {
+    scheduler_t scheduler;
+    schedulerJob_t minuteJob, hourJob, midnightJob;
+    observed_t minute = {"minuto", 0, 0, 0, 0};
+    observed_t hour = {"hora", 0, 0, 0, 0};
+    observed_t midnight = {"medianoche", 0, 0, 0, 0};
+    const uint32_t midnightPhase = (SCHEDULER_DAY - (uint32_t)(UTC_OFFSET + (int)SCHEDULER_DAY) % SCHEDULER_DAY) %
+                                   SCHEDULER_DAY;
+
+    set_time(START_TIME);
+    schedulerInit(&scheduler, (uint32_t)time(NULL));
+    schedulerAdd(&scheduler, &minuteJob, SCHEDULER_MINUTE, 0, record, &minute);
+    schedulerAdd(&scheduler, &hourJob, SCHEDULER_HOUR, 0, record, &hour);
+    schedulerAdd(&scheduler, &midnightJob, SCHEDULER_DAY, midnightPhase, record, &midnight);
+
+    if (schedulerNextDeadline(&scheduler) != START_TIME + 4) {
+        fail("alineación", "el primer vencimiento no es el próximo :00", (long)schedulerNextDeadline(&scheduler));
+    }
+    if (hourJob.deadline != 1593608400u || midnightJob.deadline != 1593658800u) {
+        fail("alineación", "la hora o la medianoche local no están en su límite", (long)hourJob.deadline);
+    }
+
+    pollFor(&scheduler, (uint64_t)days * SCHEDULER_DAY, rng);
+
+    // Sin huecos: cada límite del rango corrió una vez
+    uint32_t now = (uint32_t)time(NULL);
+    observed_t* all[] = {&minute, &hour, &midnight};
+    schedulerJob_t* jobs[] = {&minuteJob, &hourJob, &midnightJob};
+    for (int i = 0; i < 3; i++) {
+        uint32_t expected = (now - jobs[i]->phase) / jobs[i]->period - (START_TIME - jobs[i]->phase) / jobs[i]->period;
+        if (all[i]->runs != expected || all[i]->missed != 0) {
+            fail(all[i]->name, "ejecuciones distintas de los límites del rango", (long)all[i]->runs);
+        }
+        if (all[i]->lastDeadline % jobs[i]->period != jobs[i]->phase || all[i]->maxLateness > 2) {
+            fail(all[i]->name, "vencimiento desalineado o atrasado", (long)all[i]->lastDeadline);
+        }
+    }
+    printf("alineación        : %u días, %u minutos, %u horas, %u medianoches, atraso máximo %u s\n", days,
+           minute.runs, hour.runs, midnight.runs, minute.maxLateness);
+}
+
+/**
+ * @brief Demora de 10,5 minutos y saltos de set_time() hacia adelante y hacia atrás.
+ */
+static void checkJumps() {
+    scheduler_t scheduler;
+    schedulerJob_t minuteJob, hourJob;
+    observed_t minute = {"minuto", 0, 0, 0, 0};
+    observed_t hour = {"hora", 0, 0, 0, 0};
+
+    set_time(START_TIME);
+    schedulerInit(&scheduler, (uint32_t)time(NULL));
+    schedulerAdd(&scheduler, &minuteJob, SCHEDULER_MINUTE, 0, record, &minute);
+    schedulerAdd(&scheduler, &hourJob, SCHEDULER_HOUR, 0, record, &hour);
+
+    // Demora: once límites de minuto salteados por una sola consulta
+    hostClockAdvanceTo(hostClockNowUs() + 634 * US_PER_S);
+    uint32_t ran = schedulerRun(&scheduler, (uint32_t)time(NULL));
+    if (ran != 1 || minute.runs != 1 || minute.missed != 10 || minute.lastDeadline != START_TIME + 604) {
+        fail("demora", "se esperaba una ejecución con 10 salteados", (long)minute.missed);
+    }
+    if (schedulerRun(&scheduler, (uint32_t)time(NULL)) != 0) {
+        fail("demora", "ejecución repetida en el mismo instante", 0);
+    }
+
+    // Salto hacia adelante de un día: una ejecución por tarea
+    set_time(time(NULL) + SCHEDULER_DAY);
+    ran = schedulerRun(&scheduler, (uint32_t)time(NULL));
+    if (ran != 2 || minute.runs != 2 || hour.runs != 1 || hour.missed != 23) {
+        fail("adelanto", "se esperaba una ejecución por tarea", (long)ran);
+    }
+
+    // Salto hacia atrás de dos horas: nada corre y el minuto vence en el próximo :00
+    uint32_t before = (uint32_t)time(NULL);
+    set_time(before - 2 * SCHEDULER_HOUR);
+    uint32_t now = (uint32_t)time(NULL);
+    if (schedulerRun(&scheduler, now) != 0) {
+        fail("atraso", "corrió algo al retroceder el reloj", 0);
+    }
+    if (minuteJob.deadline != (now / 60 + 1) * 60 || hourJob.deadline != (now / 3600 + 1) * 3600) {
+        fail("atraso", "vencimientos no recalculados desde el nuevo instante", (long)minuteJob.deadline);
+    }
+    uint32_t minuteRuns = minute.runs;
+    minute.lastDeadline = 0;
+    hostClockAdvanceTo(hostClockNowUs() + 61 * US_PER_S);
+    schedulerRun(&scheduler, (uint32_t)time(NULL));
+    if (minute.runs != minuteRuns + 1) {
+        fail("atraso", "el minuto no corrió tras retroceder", (long)minute.runs);
+    }
+    printf("saltos            : demora de 634 s, +1 día y -2 horas sin ejecuciones repetidas\n");
+}
+
+/**
+ * @brief Quita una tarea desde su función y rechaza tareas con el planificador lleno.
+ */
+static schedulerJob_t selfRemovingJob;
+static void removeSelf(uint32_t deadline, uint32_t missed, void* context) {
+    schedulerRemove((scheduler_t*)context, &selfRemovingJob);
+}
+
+static void checkRegistration() {
+    scheduler_t scheduler;
+    schedulerJob_t jobs[SCHEDULER_MAX_JOBS];
+    observed_t observed = {"registro", 0, 0, 0, 0};
+
+    schedulerInit(&scheduler, START_TIME);
+    schedulerAdd(&scheduler, &selfRemovingJob, 10, 0, removeSelf, &scheduler);
+    for (int i = 0; i < SCHEDULER_MAX_JOBS - 1; i++) {
+        if (schedulerAdd(&scheduler, &jobs[i], 60, (uint32_t)i, record, &observed) != 0) {
+            fail("registro", "rechazó una tarea con lugar", i);
+        }
+    }
+    if (schedulerAdd(&scheduler, &jobs[SCHEDULER_MAX_JOBS - 1], 60, 0, record, &observed) != -1) {
+        fail("registro", "aceptó una tarea sin lugar", 0);
+    }
+    schedulerRun(&scheduler, START_TIME + 100);
+    if (scheduler.count != SCHEDULER_MAX_JOBS - 1 || schedulerNextDeadline(&scheduler) <= START_TIME + 100) {
+        fail("registro", "la tarea no se quitó a sí misma", (long)scheduler.count);
+    }
+}
+
+/**
+ * @brief Compara el montículo con el cálculo directo de cada tarea, con avances y retrocesos al azar.
+ */
+static void checkAgainstReference(std::mt19937_64& rng) {
+    std::uniform_int_distribution<uint32_t> periods(1, 5000);
+    std::uniform_int_distribution<int> steps(-3000, 20000);
+
+    for (int round = 0; round < 200; round++) {
+        scheduler_t scheduler;
+        schedulerJob_t jobs[SCHEDULER_MAX_JOBS];
+        observed_t observed[SCHEDULER_MAX_JOBS];
+        uint32_t expectedDeadline[SCHEDULER_MAX_JOBS];
+        uint32_t now = START_TIME + (uint32_t)(rng() % 100000);
+
+        schedulerInit(&scheduler, now);
+        for (int i = 0; i < SCHEDULER_MAX_JOBS; i++) {
+            uint32_t period = periods(rng);
+            observed[i] = {"referencia", 0, 0, 0, 0};
+            schedulerAdd(&scheduler, &jobs[i], period, (uint32_t)(rng() % period), record, &observed[i]);
+            expectedDeadline[i] = (now - jobs[i].phase) / period * period + jobs[i].phase + period;
+        }
+
+        for (int step = 0; step < 2000; step++) {
+            int delta = steps(rng);
+            uint32_t previous = now;
+            now = (uint32_t)((int64_t)now + delta);
+
+            uint32_t expectedRuns = 0;
+            for (int i = 0; i < SCHEDULER_MAX_JOBS; i++) {
+                uint32_t period = jobs[i].period;
+                if (now < previous) {
+                    observed[i].lastDeadline = 0;  // Tras retroceder los vencimientos se repiten
+                    expectedDeadline[i] = (now - jobs[i].phase) / period * period + jobs[i].phase + period;
+                } else if (expectedDeadline[i] <= now) {
+                    expectedDeadline[i] += ((now - expectedDeadline[i]) / period + 1) * period;
+                    expectedRuns++;
+                }
+            }
+
+            set_time(now);
+            if (schedulerRun(&scheduler, now) != expectedRuns) {
+                fail("referencia", "cantidad de ejecuciones", step);
+            }
+            uint32_t earliest = SCHEDULER_NEVER;
+            for (int i = 0; i < SCHEDULER_MAX_JOBS; i++) {
+                if (jobs[i].deadline != expectedDeadline[i]) {
+                    fail("referencia", "vencimiento distinto", i);
+                }
+                earliest = expectedDeadline[i] < earliest ? expectedDeadline[i] : earliest;
+            }
+            if (schedulerNextDeadline(&scheduler) != earliest) {
+                fail("referencia", "el montículo no entrega el mínimo", step);
+            }
+        }
+    }
+    printf("referencia        : 200 planificadores de %d tareas, 2000 pasos cada uno\n", SCHEDULER_MAX_JOBS);
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char* argv[]) {
+    uint32_t days = 30;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--days") == 0 && i + 1 < argc) {
+            days = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "uso: %s [--days n] [--seed n]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::mt19937_64 rng(seed);
+    checkAlignment(days, rng);
+    checkJumps();
+    checkRegistration();
+    checkAgainstReference(rng);
+
+    printf("errores           : %llu\n", (unsigned long long)failures);
+    return failures == 0 ? 0 : 1;
+}
+
+/* === End of documentation ==================================================================== */
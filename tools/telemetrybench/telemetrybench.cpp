@@ -0,0 +1,263 @@
+/*
+ * Nombre del archivo: telemetrybench.cpp
+ * Descripción: Prueba de robustez y medición del decodificador de tramas de telemetría.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Banco de pruebas de modules/telemetry en PC.
+ **
+ ** Arma tramas con lotes al azar de ticks, totales y estado, y daña algunas
+ ** en la línea (bits invertidos, bytes perdidos o insertados, tramas
+ ** enteras perdidas, reinicios de la secuencia). Verifica que cada trama
+ ** intacta se entregue con sus mensajes exactos, que ninguna dañada se
+ ** acepte y que los contadores de pérdidas coincidan. Luego mide el
+ ** rendimiento del decodificador sobre una línea limpia.
+ **
+ ** Uso:
+ **   telemetrybench [--frames N] [--seed N]
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "telemetry.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define START_MS 1593561600000ull  ///< TIME_INI de pluviometer.h en ms
+
+/* === Private data type declarations ========================================================== */
+
+typedef struct {
+    uint32_t sequence;
+    std::vector<tipCodecItem_t> messages;
+} sentFrame_t;
+
+typedef struct {
+    std::deque<sentFrame_t> expected;  ///< Tramas intactas aún no recibidas
+    uint64_t received;
+    uint64_t failures;
+    uint64_t sink;
+} receiver_t;
+
+/* === Private function implementation ========================================================= */
+
+static void fail(receiver_t* receiver, const char* message, uint32_t sequence) {
+    if (receiver->failures++ < 10) {
+        fprintf(stderr, "trama %lu: %s\n", (unsigned long)sequence, message);
+    }
+}
+
+/**
+ * @brief Compara cada mensaje recibido con el de la trama intacta correspondiente.
+ */
+static void checkMessage(void* context, uint32_t sequence, const tipCodecItem_t* message) {
+    receiver_t* receiver = (receiver_t*)context;
+
+    // Las tramas dañadas no están en la lista: una secuencia desconocida es una aceptación falsa
+    while (!receiver->expected.empty() && receiver->expected.front().messages.empty()) {
+        receiver->expected.pop_front();
+    }
+    if (receiver->expected.empty() || receiver->expected.front().sequence != sequence) {
+        fail(receiver, "mensaje de una trama inesperada", sequence);
+        return;
+    }
+    tipCodecItem_t& sent = receiver->expected.front().messages.front();
+    if (sent.mark != message->mark || sent.timestamp != message->timestamp ||
+        (sent.mark && (sent.kind != message->kind || sent.value != message->value))) {
+        fail(receiver, "mensaje distinto", sequence);
+    }
+    receiver->expected.front().messages.erase(receiver->expected.front().messages.begin());
+    receiver->received++;
+}
+
+static void countMessage(void* context, uint32_t sequence, const tipCodecItem_t* message) {
+    receiver_t* receiver = (receiver_t*)context;
+    receiver->received++;
+    receiver->sink += message->timestamp + sequence;
+}
+
+/**
+ * @brief Llena una trama con un lote al azar y devuelve sus mensajes.
+ */
+static void fillFrame(telemetryFramer_t* framer, std::mt19937_64& rng, uint64_t* now,
+                      std::vector<tipCodecItem_t>& messages) {
+    size_t batch = 1 + (size_t)(rng() % 40);
+
+    messages.clear();
+    while (messages.size() < batch && telemetryFramerHasRoom(framer)) {
+        tipCodecItem_t message = {false, 0, 0, 0};
+        *now += 1000 + rng() % 90000;
+        message.timestamp = *now;
+        uint32_t kind = (uint32_t)(rng() % 10);
+        if (kind < 7) {
+            telemetryFramerAddTip(framer, message.timestamp);
+        } else {
+            message.mark = true;
+            message.kind = kind == 7 ? 2 : (uint8_t)(16 + rng() % 4);
+            message.value = (int32_t)(rng() % 100000);
+            telemetryFramerAddMark(framer, message.kind, message.timestamp, message.value);
+        }
+        messages.push_back(message);
+    }
+}
+
+/**
+ * @brief Daña una trama codificada; devuelve false si quedó intacta.
+ */
+static bool damage(std::vector<uint8_t>& frame, std::mt19937_64& rng) {
+    switch (rng() % 40) {
+    case 0:
+        frame[rng() % (frame.size() - 1)] ^= (uint8_t)(1u << (rng() % 8));  // Ruido en un bit
+        return true;
+    case 1:
+        frame.erase(frame.begin() + (long)(rng() % (frame.size() - 1)));  // Byte perdido
+        return true;
+    case 2:
+        frame.insert(frame.begin() + (long)(rng() % (frame.size() - 1)), (uint8_t)rng());  // Byte de más
+        return true;
+    default:
+        return false;
+    }
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char* argv[]) {
+    uint64_t frames = 200000;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "uso: %s [--frames n] [--seed n]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::mt19937_64 rng(seed);
+    telemetryFramer_t framer;
+    telemetryDecoder_t decoder;
+    receiver_t receiver;
+    std::vector<tipCodecItem_t> messages;
+    std::vector<uint8_t> line;
+    uint64_t now = START_MS;
+    uint64_t intact = 0;
+    uint64_t damaged = 0;
+    uint64_t dropped = 0;
+    uint64_t restarts = 0;
+    uint64_t sentMessages = 0;
+
+    receiver.received = 0;
+    receiver.failures = 0;
+    receiver.sink = 0;
+    telemetryFramerInit(&framer);
+    telemetryDecoderInit(&decoder);
+
+    // Línea con daños: se decodifica de a trozos de largo al azar
+    for (uint64_t f = 0; f < frames; f++) {
+        if (rng() % 5000 == 0) {
+            telemetryFramerInit(&framer);  // Reinicio del equipo
+            restarts++;
+        }
+        uint32_t sequence = framer.sequence;
+        fillFrame(&framer, rng, &now, messages);
+        uint8_t out[TELEMETRY_FRAME_MAX];
+        size_t length = telemetryFramerFinish(&framer, out);
+        std::vector<uint8_t> frame(out, out + length);
+
+        if (rng() % 100 == 0) {
+            dropped++;  // La trama entera no llega
+            continue;
+        }
+        if (damage(frame, rng)) {
+            damaged++;
+            receiver.expected.push_back({sequence, {}});
+        } else {
+            intact++;
+            sentMessages += messages.size();
+            receiver.expected.push_back({sequence, messages});
+        }
+        line.insert(line.end(), frame.begin(), frame.end());
+        if (line.size() > 4096 || f + 1 == frames) {
+            size_t offset = 0;
+            while (offset < line.size()) {
+                size_t chunk = std::min(line.size() - offset, (size_t)(1 + rng() % 700));
+                telemetryDecoderPush(&decoder, &line[offset], chunk, checkMessage, &receiver);
+                offset += chunk;
+            }
+            line.clear();
+        }
+    }
+    for (const sentFrame_t& frame : receiver.expected) {
+        if (!frame.messages.empty()) {
+            fail(&receiver, "mensajes no entregados", frame.sequence);
+        }
+    }
+    if (receiver.received != sentMessages) {
+        fail(&receiver, "cantidad de mensajes distinta", 0);
+    }
+    if (decoder.stats.frames != intact) {
+        fail(&receiver, "tramas intactas rechazadas", 0);
+    }
+
+    printf("tramas            : %llu enviadas, %llu intactas, %llu dañadas, %llu perdidas, %llu reinicios\n",
+           (unsigned long long)frames, (unsigned long long)intact, (unsigned long long)damaged,
+           (unsigned long long)dropped, (unsigned long long)restarts);
+    printf("decodificador     : %lu válidas, %lu con error, %lu perdidas, %lu reinicios\n",
+           (unsigned long)decoder.stats.frames, (unsigned long)decoder.stats.crcErrors,
+           (unsigned long)decoder.stats.lostFrames, (unsigned long)decoder.stats.restarts);
+    printf("mensajes          : %llu entregados de %llu\n", (unsigned long long)receiver.received,
+           (unsigned long long)sentMessages);
+
+    // Rendimiento sobre una línea limpia
+    telemetryFramerInit(&framer);
+    line.clear();
+    while (line.size() < (32u << 20)) {
+        fillFrame(&framer, rng, &now, messages);
+        uint8_t out[TELEMETRY_FRAME_MAX];
+        size_t length = telemetryFramerFinish(&framer, out);
+        line.insert(line.end(), out, out + length);
+    }
+    telemetryDecoderInit(&decoder);
+    receiver.received = 0;
+    auto start = std::chrono::steady_clock::now();
+    telemetryDecoderPush(&decoder, line.data(), line.size(), countMessage, &receiver);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("rendimiento       : %.1f MB/s (%.1f M mensajes/s, suma de control %llu)\n",
+           line.size() / seconds / 1e6, receiver.received / seconds / 1e6,
+           (unsigned long long)(receiver.sink & 0xFFFF));
+    printf("errores           : %llu\n", (unsigned long long)receiver.failures);
+    return receiver.failures == 0 ? 0 : 1;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,222 @@
+/*
+ * Nombre del archivo: timebench.cpp
+ * Descripción: Mide y verifica el formateador incremental de fechas frente a strftime().
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Banco de pruebas de modules/timefmt en PC.
+ **
+ ** Sin opciones mide el costo por llamada de timeFormatUpdate() frente al
+ ** camino anterior (localtime() + strftime() con TIME_FORMAT) en tres
+ ** patrones de instantes: segundos consecutivos, separaciones de ticks de
+ ** lluvia y saltos aleatorios. Con --verify compara ambos caminos en cada
+ ** segundo de tramos que cruzan años bisiestos, seculares y cambios de mes.
+ **
+ ** Uso:
+ **   timebench [--count N] [--seed N]
+ **   timebench --verify
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "timefmt.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define TIME_FORMAT "%Y-%m-%d %H:%M:%S"  ///< Igual que en pluviometer.h
+#define DATE_FORMAT "%Y-%m-%d %H:%M"  ///< Igual que en pluviometer.h
+
+/* === Private data type declarations ========================================================== */
+
+/**
+ * @brief Tramo de la verificación exhaustiva.
+ */
+typedef struct {
+    const char* name;
+    timeCivil_t from;
+    timeCivil_t to;
+} sweepRange_t;
+
+/* === Private variable declarations =========================================================== */
+
+static const sweepRange_t sweepRanges[] = {
+    {"bisiesto secular 2000", {1999, 12, 1}, {2000, 3, 31}},
+    {"2023-2024 (bisiesto)", {2023, 1, 1}, {2025, 1, 2}},
+    {"no bisiesto 2100", {2100, 1, 25}, {2100, 3, 5}},
+    {"fin del rango de 32 bits", {2106, 1, 1}, {2106, 2, 7}},
+};
+
+static volatile size_t sink;  ///< Evita que el compilador descarte los formatos medidos
+
+/* === Private function implementation ========================================================= */
+
+/**
+ * @brief Camino anterior: localtime() y strftime() en cada llamada.
+ */
+static const char* strftimeAt(uint32_t seconds) {
+    static char buffer[80];
+    time_t value = (time_t)seconds;
+    strftime(buffer, sizeof(buffer), TIME_FORMAT, localtime(&value));
+    return buffer;
+}
+
+/**
+ * @brief Compara ambos caminos en cada segundo de los tramos de sweepRanges.
+ */
+static int verify() {
+    unsigned long long checked = 0;
+    unsigned long long failures = 0;
+    timeFormat_t format;
+    timeFormatInit(&format);
+
+    for (const sweepRange_t& range : sweepRanges) {
+        uint32_t from = (uint32_t)timeDaysFromCivil(&range.from) * SECONDS_PER_DAY;
+        uint32_t to = (uint32_t)(timeDaysFromCivil(&range.to) * (uint64_t)SECONDS_PER_DAY - 1);
+        for (uint64_t s = from; s <= to; s++) {
+            uint32_t seconds = (uint32_t)s;
+            const char* expected = strftimeAt(seconds);
+            char minutes[TIME_FORMAT_MINUTES_LENGTH + 1];
+            char expectedMinutes[32];
+            time_t value = (time_t)seconds;
+            strftime(expectedMinutes, sizeof(expectedMinutes), DATE_FORMAT, localtime(&value));
+            timeFormatCopy(&format, seconds, TIME_FORMAT_MINUTES_LENGTH, minutes);
+
+            if (strcmp(timeFormatUpdate(&format, seconds), expected) != 0 || strcmp(minutes, expectedMinutes) != 0) {
+                if (failures++ < 10) {
+                    fprintf(stderr, "%u: esperado \"%s\", obtenido \"%s\"\n", seconds, expected, format.text);
+                }
+            }
+            checked++;
+        }
+        printf("%-26s: hasta %s\n", range.name, format.text);
+    }
+
+    // Saltos hacia atrás y lejanos sobre el mismo formateador
+    std::mt19937_64 rng(1);
+    for (int i = 0; i < 1000000; i++) {
+        uint32_t seconds = (uint32_t)rng();
+        if (strcmp(timeFormatUpdate(&format, seconds), strftimeAt(seconds)) != 0 && failures++ < 10) {
+            fprintf(stderr, "%u: esperado \"%s\", obtenido \"%s\"\n", seconds, strftimeAt(seconds), format.text);
+        }
+        checked++;
+    }
+
+    // Ida y vuelta de las fechas civiles
+    for (int32_t days = -800000; days <= 800000; days++) {
+        timeCivil_t date;
+        timeCivilFromDays(days, &date);
+        if (timeDaysFromCivil(&date) != days || date.day < 1 || date.day > timeDaysInMonth(date.year, date.month)) {
+            if (failures++ < 10) {
+                fprintf(stderr, "dia %d: %d-%d-%d\n", days, date.year, date.month, date.day);
+            }
+        }
+        checked++;
+    }
+
+    printf("verificados         : %llu\n", checked);
+    printf("errores             : %llu\n", failures);
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * @brief Mide el costo medio por llamada de cada camino.
+ */
+static void bench(const char* name, const std::vector<uint32_t>& stamps) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t seconds : stamps) {
+        sink = sink + (size_t)strftimeAt(seconds)[18];
+    }
+    double libcNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    timeFormat_t format;
+    timeFormatInit(&format);
+    start = std::chrono::steady_clock::now();
+    for (uint32_t seconds : stamps) {
+        sink = sink + (size_t)timeFormatUpdate(&format, seconds)[18];
+    }
+    double cachedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%-22s: strftime %7.1f ns  timefmt %6.1f ns  (x%.1f)\n", name, libcNs / stamps.size(),
+           cachedNs / stamps.size(), libcNs / (cachedNs > 0 ? cachedNs : 1));
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char* argv[]) {
+    size_t count = 2000000;
+    uint64_t seed = 1;
+    bool runVerify = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--verify") == 0) {
+            runVerify = true;
+        } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            count = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "uso: %s [--verify] [--count n] [--seed n]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // Las horas de Mbed son UTC: se compara contra localtime() en UTC
+    setenv("TZ", "UTC0", 1);
+    tzset();
+
+    if (runVerify) {
+        return verify();
+    }
+
+    std::mt19937_64 rng(seed);
+    std::vector<uint32_t> stamps(count);
+    uint32_t start = 1700000000u;
+
+    for (size_t i = 0; i < count; i++) {
+        stamps[i] = start + (uint32_t)i;
+    }
+    bench("segundos consecutivos", stamps);
+
+    std::exponential_distribution<double> gap(1.0 / 120.0);
+    uint32_t seconds = start;
+    for (size_t i = 0; i < count; i++) {
+        seconds += 1 + (uint32_t)gap(rng);
+        stamps[i] = seconds;
+    }
+    bench("ticks de lluvia", stamps);
+
+    for (size_t i = 0; i < count; i++) {
+        stamps[i] = (uint32_t)rng();
+    }
+    bench("saltos aleatorios", stamps);
+    return 0;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,478 @@
+/*
+ * Nombre del archivo: timerwheeltest.cpp
+ * Descripción: Pruebas y costo de la rueda de temporizadores y de los retardos que respalda.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Pruebas de modules/timer y modules/delay con 10 000 temporizadores concurrentes.
+ **
+ ** Arranca, rearranca y cancela al azar 10 000 temporizadores (de un disparo
+ ** y periódicos, con demoras de 0 ticks, en los bordes de cada nivel y más
+ ** allá del alcance de la rueda) y avanza en pasos de 1 tick a millones de
+ ** ticks, cruzando el desborde de tick_t. Una referencia directa lleva el
+ ** tick exacto de cada vencimiento: cada disparo debe caer en ese tick, los
+ ** cancelados no deben disparar y ninguno debe quedar atrasado. Las funciones
+ ** de vencimiento también se rearrancan y cancelan a sí mismas y a otros.
+ ** Luego compara delayRead()/delayWrite() con la semántica original (tiempo
+ ** transcurrido contra la duración, sin la bandera compartida) sobre el reloj
+ ** virtual, y mide el costo de arrancar, rearrancar, cancelar y vencer.
+ **
+ ** Uso:
+ **   timerwheeltest [--rounds N] [--seed N]
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include "mbed.h"
+#include "hostsim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "delay.h"
+#include "timerwheel.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define WHEEL_TIMERS 10000  ///< Temporizadores concurrentes
+#define WHEEL_SPAN(level) ((tick_t)1 << (TIMER_WHEEL_BITS * (level)))  ///< Ticks por ranura del nivel
+#define WHEEL_RANGE WHEEL_SPAN(TIMER_WHEEL_LEVELS)  ///< Alcance de la rueda
+#define DELAYS 32  ///< Retardos comparados con la referencia
+#define US_PER_MS 1000ULL
+
+/* === Private data type declarations ========================================================== */
+
+/**
+ * @brief Estado esperado de un temporizador.
+ */
+typedef struct {
+    tick_t expected;  ///< Tick en que debe vencer
+    tick_t period;    ///< 0 = un solo disparo
+    uint32_t shots;   ///< Disparos periódicos antes de que su función lo detenga
+    bool armed;       ///< Debe estar en la rueda
+} reference_t;
+
+/**
+ * @brief Retardo con la semántica original de delayRead(), sin la bandera compartida.
+ */
+typedef struct {
+    tick_t startTime;
+    tick_t duration;
+    bool running;
+} delayReference_t;
+
+/* === Private variable declarations =========================================================== */
+
+static timerWheel_t wheel;
+static wheelTimer_t timers[WHEEL_TIMERS];
+static reference_t reference[WHEEL_TIMERS];
+static uint32_t armed = 0;  ///< Temporizadores que la referencia espera en la rueda
+
+static delay_t delays[DELAYS];  ///< Quedan enlazados en la rueda de modules/delay: viven todo el programa
+static delayReference_t delayReference[DELAYS];
+
+static std::mt19937_64 rng;
+static bool callbackActions = true;  ///< Las funciones de vencimiento arrancan y cancelan temporizadores
+static uint64_t fires = 0;
+static uint64_t failures = 0;
+
+/* === Private function implementation ========================================================= */
+
+static void fail(const char* name, const char* message, long detail) {
+    if (failures++ < 10) {
+        fprintf(stderr, "%s: %s (%ld)\n", name, message, detail);
+    }
+}
+
+/**
+ * @brief Arranca un temporizador en la rueda y en la referencia.
+ *
+ * La demora cuenta desde el último tick procesado; con 0 vence en el próximo.
+ */
+static void start(uint32_t index, tick_t delay, tick_t period) {
+    timerWheelStart(&wheel, &timers[index], delay, period);
+    if (!reference[index].armed) {
+        armed++;
+    }
+    reference[index].expected = wheel.current + (delay == 0 ? 1 : delay);
+    reference[index].period = period;
+    reference[index].shots = period != 0 ? (uint32_t)(rng() % 50) + 1 : 0;
+    reference[index].armed = true;
+}
+
+static void cancel(uint32_t index) {
+    timerWheelCancel(&wheel, &timers[index]);
+    if (reference[index].armed) {
+        armed--;
+    }
+    reference[index].armed = false;
+}
+
+/**
+ * @brief Demora al azar: cortas, largas, en los bordes de cada nivel y más allá del alcance.
+ */
+static tick_t randomDelay() {
+    static const tick_t edges[] = {0, 1, 2, WHEEL_SPAN(1) - 1, WHEEL_SPAN(1), WHEEL_SPAN(1) + 1,
+                                   WHEEL_SPAN(2) - 1, WHEEL_SPAN(2), WHEEL_SPAN(2) + 1, WHEEL_SPAN(3) - 1,
+                                   WHEEL_SPAN(3), WHEEL_SPAN(3) + 1, WHEEL_RANGE - 1, WHEEL_RANGE,
+                                   WHEEL_RANGE + 1, 3 * WHEEL_RANGE + 7};
+
+    switch (rng() % 8) {
+    case 0:
+        return edges[rng() % (sizeof(edges) / sizeof(edges[0]))];
+    case 1: {
+        // Justo antes, en y después de la próxima cascada de un nivel
+        tick_t span = WHEEL_SPAN(rng() % (TIMER_WHEEL_LEVELS - 1) + 1);
+        return span - ((wheel.current + 1) & (span - 1)) + (tick_t)(rng() % 3) - 1;
+    }
+    case 2:
+        return (tick_t)(rng() % (2 * (uint64_t)WHEEL_RANGE));
+    case 3:
+    case 4:
+        return (tick_t)(rng() % 300000);
+    default:
+        return (tick_t)(rng() % 200);
+    }
+}
+
+static tick_t randomPeriod() {
+    switch (rng() % 8) {
+    case 0:
+        return (tick_t)(rng() % 70) + 1;
+    case 1:
+        return (tick_t)(rng() % 300000) + 1;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Verifica el disparo contra la referencia y a veces arranca o cancela temporizadores.
+ */
+static void onExpire(wheelTimer_t* timer, void* context) {
+    reference_t* expected = (reference_t*)context;
+    uint32_t index = (uint32_t)(expected - reference);
+
+    fires++;
+    if (!expected->armed) {
+        fail("vencimiento", "disparó un temporizador cancelado", (long)index);
+        return;
+    }
+    if (wheel.current != expected->expected) {
+        fail("vencimiento", "tick distinto de la referencia", (long)(int32_t)(wheel.current - expected->expected));
+    }
+    if (!timer->expired) {
+        fail("vencimiento", "bandera expired sin marcar", (long)index);
+    }
+    if (expected->period == 0) {
+        expected->armed = false;
+        armed--;
+    } else if (--expected->shots == 0) {
+        cancel(index);  // Un periódico que se detiene a sí mismo
+    } else {
+        expected->expected += expected->period;
+    }
+
+    if (!callbackActions) {
+        return;
+    }
+    switch (rng() % 32) {
+    case 0:
+        start(index, 0, 0);  // Se rearranca sin demora: vence en el próximo tick
+        break;
+    case 1:
+        cancel((uint32_t)(rng() % WHEEL_TIMERS));  // Puede ser uno que vence en este mismo tick
+        break;
+    case 2:
+        start((uint32_t)(rng() % WHEEL_TIMERS), randomDelay(), 0);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Avanza la rueda y verifica que nada quede atrasado ni fuera de la rueda.
+ */
+static void advance(tick_t now) {
+    uint64_t before = fires;
+    uint32_t fired = timerWheelAdvance(&wheel, now);
+
+    if (fired != fires - before) {
+        fail("avance", "cantidad de vencimientos distinta de las funciones llamadas", (long)fired);
+    }
+    if (wheel.current != now) {
+        fail("avance", "la rueda no llegó al tick pedido", (long)(int32_t)(now - wheel.current));
+    }
+    if (wheel.count != armed) {
+        fail("avance", "temporizadores en la rueda distintos de la referencia", (long)wheel.count - (long)armed);
+    }
+    for (uint32_t i = 0; i < WHEEL_TIMERS; i++) {
+        if (timers[i].pending != reference[i].armed) {
+            fail("avance", "estado pendiente distinto de la referencia", (long)i);
+        } else if (reference[i].armed && (int32_t)(reference[i].expected - now) <= 0) {
+            fail("avance", "temporizador atrasado", (long)i);
+        }
+    }
+}
+
+/**
+ * @brief Operaciones al azar sobre 10 000 temporizadores comparadas con la referencia.
+ */
+static void checkAgainstReference(uint32_t rounds) {
+    // Arranca cerca del desborde de tick_t para cruzarlo durante la prueba
+    timerWheelInit(&wheel, (tick_t)0 - 5000000);
+    armed = 0;
+    for (uint32_t i = 0; i < WHEEL_TIMERS; i++) {
+        wheelTimerInit(&timers[i], onExpire, &reference[i]);
+        reference[i].armed = false;
+        start(i, randomDelay(), randomPeriod());
+    }
+
+    uint64_t ticks = 0;
+    uint64_t operations = 0;
+    for (uint32_t round = 0; round < rounds; round++) {
+        for (int op = (int)(rng() % 64); op > 0; op--) {
+            uint32_t index = (uint32_t)(rng() % WHEEL_TIMERS);
+            if (rng() % 4 == 0) {
+                cancel(index);
+            } else {
+                start(index, randomDelay(), randomPeriod());  // Rearranca si ya corría
+            }
+            operations++;
+        }
+
+        tick_t step;
+        switch (rng() % 64) {
+        case 0:
+            step = (tick_t)(rng() % (2 * (uint64_t)WHEEL_RANGE)) + 1;
+            break;
+        case 1:
+        case 2:
+            step = 0;  // Avanzar hasta el tick actual no dispara nada
+            break;
+        default:
+            step = (tick_t)(rng() % (rng() % 4 == 0 ? 5000 : 64)) + 1;
+            break;
+        }
+        ticks += step;
+        advance(wheel.current + step);
+    }
+    printf("referencia        : %u rondas, %llu operaciones, %llu vencimientos en %llu ticks\n", rounds,
+           (unsigned long long)operations, (unsigned long long)fires, (unsigned long long)ticks);
+
+    // Sin temporizadores la rueda no dispara nada, ni más allá de su alcance
+    for (uint32_t i = 0; i < WHEEL_TIMERS; i++) {
+        cancel(i);
+    }
+    uint64_t before = fires;
+    advance(wheel.current + 2 * WHEEL_RANGE);
+    if (wheel.count != 0 || fires != before) {
+        fail("referencia", "disparos con la rueda vacía", (long)(fires - before));
+    }
+}
+
+/**
+ * @brief Casos fijos: demora 0, bordes de cascada desde un tick alineado y otro no, y periódicos.
+ */
+static void checkEdges() {
+    static const tick_t origins[] = {0, 0x12345, WHEEL_RANGE - 1, (tick_t)0 - 100};
+    static const tick_t delays[] = {0, 1, WHEEL_SPAN(1) - 1, WHEEL_SPAN(1), WHEEL_SPAN(1) + 1, WHEEL_SPAN(2),
+                                    WHEEL_SPAN(2) + WHEEL_SPAN(1), WHEEL_SPAN(3) - 1, WHEEL_SPAN(3),
+                                    WHEEL_RANGE - 1, WHEEL_RANGE, WHEEL_RANGE + 1, 5 * WHEEL_RANGE + 3};
+    const uint32_t count = sizeof(delays) / sizeof(delays[0]);
+
+    callbackActions = false;
+    for (tick_t origin : origins) {
+        timerWheelInit(&wheel, origin);
+        armed = 0;
+        for (uint32_t i = 0; i < 2 * count; i++) {
+            wheelTimerInit(&timers[i], onExpire, &reference[i]);
+            reference[i].armed = false;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            start(i, delays[i], 0);
+            start(count + i, delays[i] + 1, delays[i] + 1);  // Periódico con el mismo borde
+        }
+
+        // Sin avanzar nada vence, ni siquiera la demora 0
+        uint64_t before = fires;
+        advance(origin);
+        if (fires != before) {
+            fail("bordes", "disparó sin avanzar", (long)origin);
+        }
+        advance(origin + 1);
+        if (reference[0].armed) {
+            fail("bordes", "la demora 0 no venció en el próximo tick", (long)origin);
+        }
+
+        // De a un tick cerca de los bordes y de un salto lejos de ellos
+        for (uint32_t step = 0; step < 3 * WHEEL_SPAN(2); step++) {
+            advance(wheel.current + 1);
+        }
+        advance(wheel.current + 12 * WHEEL_RANGE);
+        for (uint32_t i = 0; i < count; i++) {
+            if (reference[i].armed) {
+                fail("bordes", "un disparo no venció", (long)delays[i]);
+            }
+        }
+        for (uint32_t i = 0; i < 2 * count; i++) {
+            cancel(i);
+        }
+    }
+    callbackActions = true;
+    printf("bordes            : %u demoras desde %u orígenes, de un disparo y periódicas\n", count,
+           (unsigned)(sizeof(origins) / sizeof(origins[0])));
+}
+
+static bool referenceRead(delayReference_t* delay) {
+    tick_t now = HAL_GetTick();
+
+    if (!delay->running) {
+        delay->startTime = now;
+        delay->running = true;
+        return false;
+    }
+    if (now - delay->startTime >= delay->duration) {
+        delay->running = false;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief delayRead()/delayWrite() frente a la semántica original en el reloj virtual.
+ *
+ * De esa semántica dependen el antirrebote y la ventana de analyzeRainfall().
+ */
+static void checkDelays(uint32_t steps) {
+    uint64_t expiries = 0;
+
+    for (uint32_t i = 0; i < DELAYS; i++) {
+        tick_t duration = (tick_t)(rng() % 40);
+        delayInit(&delays[i], duration);
+        delayReference[i] = {0, duration, false};
+    }
+    for (uint32_t step = 0; step < steps; step++) {
+        uint32_t i = (uint32_t)(rng() % DELAYS);
+        hostClockAdvanceTo(hostClockNowUs() + (rng() % 4 == 0 ? 0 : (rng() % 3) * US_PER_MS + rng() % US_PER_MS));
+        if (rng() % 16 == 0) {
+            tick_t duration = (tick_t)(rng() % 40);
+            delayWrite(&delays[i], duration);
+            delayReference[i].duration = duration;
+            continue;
+        }
+        bool expected = referenceRead(&delayReference[i]);
+        if (delayRead(&delays[i]) != expected) {
+            fail("retardos", "delayRead() distinto de la referencia", (long)delayReference[i].duration);
+        }
+        expiries += expected;
+    }
+    printf("retardos          : %d retardos, %u pasos, %llu vencimientos iguales a la referencia\n", DELAYS, steps,
+           (unsigned long long)expiries);
+}
+
+/**
+ * @brief Costo por temporizador de arrancar, rearrancar, cancelar y vencer con 10 000 en la rueda.
+ */
+static void measureCosts() {
+    const int repeats = 20;
+    std::vector<tick_t> delaysA(WHEEL_TIMERS);
+    std::vector<tick_t> delaysB(WHEEL_TIMERS);
+    double startNs = 0, restartNs = 0, cancelNs = 0, expireNs = 0;
+
+    for (uint32_t i = 0; i < WHEEL_TIMERS; i++) {
+        wheelTimerInit(&timers[i], NULL, NULL);
+        delaysA[i] = (tick_t)(rng() % WHEEL_RANGE);
+        delaysB[i] = (tick_t)(rng() % WHEEL_RANGE);
+    }
+    for (int round = 0; round < repeats; round++) {
+        timerWheelInit(&wheel, (tick_t)rng());
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < WHEEL_TIMERS; i++) {
+            timerWheelStart(&wheel, &timers[i], delaysA[i], 0);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < WHEEL_TIMERS; i++) {
+            timerWheelStart(&wheel, &timers[i], delaysB[i], 0);
+        }
+        auto t2 = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < WHEEL_TIMERS; i++) {
+            timerWheelCancel(&wheel, &timers[i]);
+        }
+        auto t3 = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < WHEEL_TIMERS; i++) {
+            timerWheelStart(&wheel, &timers[i], delaysA[i], 0);
+        }
+        auto t4 = std::chrono::steady_clock::now();
+        uint32_t fired = timerWheelAdvance(&wheel, wheel.current + WHEEL_RANGE);
+        auto t5 = std::chrono::steady_clock::now();
+
+        if (fired != WHEEL_TIMERS || wheel.count != 0) {
+            fail("costo", "no vencieron todos los temporizadores", (long)fired);
+        }
+        startNs += std::chrono::duration<double, std::nano>(t1 - t0).count();
+        restartNs += std::chrono::duration<double, std::nano>(t2 - t1).count();
+        cancelNs += std::chrono::duration<double, std::nano>(t3 - t2).count();
+        startNs += std::chrono::duration<double, std::nano>(t4 - t3).count();
+        expireNs += std::chrono::duration<double, std::nano>(t5 - t4).count();
+    }
+
+    double perTimer = (double)repeats * WHEEL_TIMERS;
+    printf("costo             : arranque %.1f ns, rearranque %.1f ns, cancelación %.1f ns, "
+           "vencimiento %.1f ns por temporizador (%d concurrentes, incluye cascadas)\n",
+           startNs / (2 * perTimer), restartNs / perTimer, cancelNs / perTimer, expireNs / perTimer, WHEEL_TIMERS);
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char* argv[]) {
+    uint32_t rounds = 3000;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            rounds = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "uso: %s [--rounds n] [--seed n]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    rng.seed(seed);
+    checkAgainstReference(rounds);
+    checkEdges();
+    checkDelays(1000000);
+    measureCosts();
+
+    printf("errores           : %llu\n", (unsigned long long)failures);
+    return failures == 0 ? 0 : 1;
+}
+
+/* === End of documentation ==================================================================== */
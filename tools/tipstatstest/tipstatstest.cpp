@@ -0,0 +1,540 @@
+/*
+ * Nombre del archivo: tipstatstest.cpp
+ * Descripción: Verificación de exactitud y banco de las estadísticas de los ticks.
+ * Autor: Luis Gómez P.
+ * Derechos de Autor: (C) 2023 Luis Gómez P.
+ * Licencia: GNU General Public License v3.0
+ *
+ * Este programa es software libre: puedes redistribuirlo y/o modificarlo
+ * bajo los términos de la Licencia Pública General GNU publicada por
+ * la Free Software Foundation, ya sea la versión 3 de la Licencia, o
+ * (a tu elección) cualquier versión posterior.
+ *
+ * Este programa se distribuye con la esperanza de que sea útil,
+ * pero SIN NINGUNA GARANTÍA; sin siquiera la garantía implícita
+ * de COMERCIABILIDAD o APTITUD PARA UN PROPÓSITO PARTICULAR. Ver la
+ * Licencia Pública General GNU para más detalles.
+ *
+ * Deberías haber recibido una copia de la Licencia Pública General GNU
+ * junto con este programa. Si no es así, visita <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ */
+
+/** @file
+ ** @brief Verificación y banco de modules/tipstats.
+ **
+ ** Registra intervalos de varias distribuciones (tormentas log-normales,
+ ** ticks con rebotes, uniforme, constante y extremos de 32 bits) y compara
+ ** con el cálculo exacto sobre los valores ordenados: cantidad, mínimo y
+ ** máximo exactos, media y varianza con error relativo menor a 1e-9 y
+ ** cuantiles entre el verdadero y 1/8 por encima. Reparte los mismos
+ ** intervalos al azar entre períodos y pluviómetros y verifica que la
+ ** combinación dé el mismo histograma. Hace correr el monitor sobre
+ ** tormentas limpias (ninguna anomalía) y con inundaciones de rebotes y
+ ** contactos que rebotan inyectadas (una anomalía cada una, dentro de su
+ ** ventana). Luego mide el costo de cada operación.
+ **
+ ** Uso:
+ **   tipstatstest [--count n] [--days n] [--seed n]
+ **   tipstatstest --trace archivo      líneas de printRain(), una por tick
+ **/
+
+/* === Headers files inclusions =============================================================== */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pluviometer.h"
+#include "timefmt.h"
+#include "logformat.h"
+#include "tipstats.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define MOMENT_TOLERANCE 1e-9  ///< Error relativo admitido en la media y la varianza
+#define MERGE_PARTS_MAX 64  ///< Períodos por pluviómetros en que se reparten los intervalos
+#define BENCH_SECONDS 0.3  ///< Tiempo mínimo de cada medición
+#define BENCH_VALUES 65536  ///< Intervalos precalculados para el banco (potencia de 2)
+#define MIN_TIP_MS 300  ///< Tiempo mínimo de vuelco del balancín, como en tools/replay
+#define BOUNCES_MAX 8  ///< Rebotes por tick de un contacto sano, como en tools/replay
+
+/* === Private data type declarations ========================================================== */
+
+/**
+ * @brief Distribución de prueba.
+ */
+typedef struct {
+    const char* name;
+    std::vector<uint32_t> values;
+} sample_t;
+
+/**
+ * @brief Tick o lectura de rebotes que recibe el monitor.
+ */
+typedef struct {
+    uint32_t time;  ///< Segundos desde la época
+    uint32_t intervalMs;  ///< Intervalo desde el tick anterior (0 si es solo una lectura de rebotes)
+    uint32_t bounces;  ///< Rebotes leídos en este instante
+    bool tip;
+} monitorEvent_t;
+
+/* === Private variable declarations =========================================================== */
+
+static const uint32_t permilles[] = {0, 10, 100, 250, 500, 750, 900, 990, 999, 1000};
+
+/* === Private function implementation ========================================================= */
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Arma las distribuciones de prueba.
+ */
+static std::vector<sample_t> buildSamples(size_t count, std::mt19937_64& rng) {
+    std::lognormal_distribution<double> storm(log(20000.0), 1.2);  // mediana 20 s
+    std::uniform_int_distribution<uint32_t> bounce(1, DEBOUNCE_TIME);
+    std::uniform_int_distribution<uint32_t> uniform(0, 1000000);
+    std::uniform_int_distribution<uint32_t> full(0, UINT32_MAX);
+    std::uniform_int_distribution<uint32_t> tiny(0, HISTOGRAM_SUB_BUCKETS - 1);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::vector<sample_t> samples(5);
+
+    samples[0].name = "tormenta";
+    samples[1].name = "rebotes";
+    samples[2].name = "uniforme";
+    samples[3].name = "constante";
+    samples[4].name = "extremos";
+    for (size_t i = 0; i < count; i++) {
+        double interval = std::min(std::max(storm(rng), (double)MIN_TIP_MS), 4e9);
+        samples[0].values.push_back((uint32_t)interval);
+        samples[1].values.push_back(unit(rng) < 0.3 ? bounce(rng) : (uint32_t)interval);
+        samples[2].values.push_back(uniform(rng));
+        samples[3].values.push_back(3600000);
+        samples[4].values.push_back(unit(rng) < 0.5 ? tiny(rng) : full(rng));
+    }
+    return samples;
+}
+
+/**
+ * @brief Compara las estadísticas con el cálculo exacto sobre los valores.
+ *
+ * @param worst Mayor error relativo observado en los cuantiles.
+ * @return Cantidad de valores fuera de las cotas.
+ */
+static uint64_t checkAccuracy(const tipStats_t* stats, const std::vector<uint32_t>& values, double* worst) {
+    std::vector<uint32_t> sorted(values);
+    std::sort(sorted.begin(), sorted.end());
+    uint64_t errors = 0;
+
+    // Media y varianza en dos pasadas con precisión extendida
+    long double sum = 0.0;
+    for (uint32_t value : sorted) {
+        sum += value;
+    }
+    long double mean = sum / sorted.size();
+    long double squares = 0.0;
+    for (uint32_t value : sorted) {
+        squares += ((long double)value - mean) * ((long double)value - mean);
+    }
+    double variance = sorted.size() > 1 ? (double)(squares / (sorted.size() - 1)) : 0.0;
+
+    errors += stats->intervals.count != sorted.size() ? 1 : 0;
+    errors += stats->intervals.min != sorted.front() || stats->intervals.max != sorted.back() ? 1 : 0;
+    errors += fabs(stats->mean - (double)mean) > MOMENT_TOLERANCE * std::max((double)mean, 1.0) ? 1 : 0;
+    errors += fabs(tipStatsVariance(stats) - variance) > MOMENT_TOLERANCE * (variance + (double)(mean * mean)) ? 1 : 0;
+
+    *worst = 0.0;
+    for (uint32_t permille : permilles) {
+        // Misma definición que histogramQuantile(): el registro de posición ceil(n * p / 1000)
+        uint64_t rank = ((uint64_t)sorted.size() * permille + 999) / 1000;
+        uint32_t truth = sorted[rank == 0 ? 0 : rank - 1];
+        uint32_t estimate = tipStatsQuantile(stats, permille);
+        bool exact = truth < HISTOGRAM_SUB_BUCKETS;
+        if (estimate < truth || (exact && estimate != truth) || estimate - truth > truth / HISTOGRAM_SUB_BUCKETS) {
+            fprintf(stderr, "cuantil %u/1000: %lu estimado, %lu exacto\n", (unsigned)permille, (unsigned long)estimate,
+                    (unsigned long)truth);
+            errors++;
+        }
+        if (truth > 0) {
+            *worst = std::max(*worst, (double)(estimate - truth) / truth);
+        }
+    }
+    return errors;
+}
+
+/**
+ * @brief Reparte los valores al azar entre partes, las combina y compara con el registro en una sola.
+ *
+ * @return Diferencias con el registro en una sola.
+ */
+static uint64_t checkMerge(const std::vector<uint32_t>& values, const tipStats_t* whole, std::mt19937_64& rng) {
+    static tipStats_t parts[MERGE_PARTS_MAX];
+    std::uniform_int_distribution<uint32_t> partCount(1, MERGE_PARTS_MAX);
+    std::uniform_int_distribution<uint32_t> rejections(0, 100);
+    uint64_t errors = 0;
+
+    for (int round = 0; round < 8; round++) {
+        uint32_t count = partCount(rng);
+        std::uniform_int_distribution<uint32_t> pick(0, count - 1);
+        uint32_t expectedRejections = 0;
+        for (uint32_t p = 0; p < count; p++) {
+            tipStatsInit(&parts[p]);
+        }
+        for (uint32_t value : values) {
+            tipStats_t* part = &parts[pick(rng)];
+            tipStatsAddInterval(part, value);
+        }
+        for (uint32_t p = 0; p < count; p++) {
+            uint32_t extra = rejections(rng);
+            tipStatsAddRejections(&parts[p], extra);
+            expectedRejections += extra;
+            parts[p].anomalies = (uint8_t)(p == count - 1 ? TIP_ANOMALY_CHATTER : 0);
+        }
+
+        // Como el gateway: por pluviómetro los períodos en orden, y luego los pluviómetros en árbol
+        std::vector<uint32_t> order(count);
+        for (uint32_t p = 0; p < count; p++) {
+            order[p] = p;
+        }
+        std::shuffle(order.begin(), order.end(), rng);
+        for (uint32_t step = 1; step < count; step *= 2) {
+            for (uint32_t p = 0; p + step < count; p += 2 * step) {
+                tipStatsMerge(&parts[order[p]], &parts[order[p + step]]);
+            }
+        }
+        const tipStats_t* merged = &parts[order[0]];
+
+        errors += memcmp(&merged->intervals, &whole->intervals, sizeof(whole->intervals)) != 0 ? 1 : 0;
+        errors += fabs(merged->mean - whole->mean) > MOMENT_TOLERANCE * std::max(whole->mean, 1.0) ? 1 : 0;
+        errors += fabs(merged->m2 - whole->m2) > MOMENT_TOLERANCE * (whole->m2 + whole->mean * whole->mean) ? 1 : 0;
+        errors += merged->rejections != expectedRejections || merged->anomalies != TIP_ANOMALY_CHATTER ? 1 : 0;
+    }
+    return errors;
+}
+
+/**
+ * @brief Tormentas de ticks con rebotes sanos, separadas por períodos secos.
+ *
+ * Los rebotes de cada tick se leen junto con el tick, como en actOnTips().
+ */
+static std::vector<monitorEvent_t> stormEvents(uint32_t days, std::mt19937_64& rng) {
+    std::exponential_distribution<double> dryHours(1.0 / 18.0);
+    std::uniform_real_distribution<double> stormHours(0.2, 10.0);
+    std::lognormal_distribution<double> intensity(1.5, 1.0);  // mm/h
+    std::uniform_int_distribution<uint32_t> bounces(0, BOUNCES_MAX);
+    std::vector<monitorEvent_t> events;
+    uint64_t endMs = ((uint64_t)TIME_INI + (uint64_t)days * SECONDS_PER_DAY) * 1000;
+    uint64_t t = (uint64_t)TIME_INI * 1000;
+    uint64_t last = 0;
+
+    while (t < endMs) {
+        t += (uint64_t)(dryHours(rng) * 3600000.0);
+        uint64_t stormEnd = t + (uint64_t)(stormHours(rng) * 3600000.0);
+        double mmPerHour = std::min(intensity(rng), 150.0);
+        std::exponential_distribution<double> gap(mmPerHour * 10.0 / MM_PER_TICK / 3600000.0);
+        while (t < stormEnd && t < endMs) {
+            t += MIN_TIP_MS + (uint64_t)gap(rng);
+            uint64_t interval = last == 0 ? 0 : t - last;
+            events.push_back({(uint32_t)(t / 1000), interval < UINT32_MAX ? (uint32_t)interval : UINT32_MAX,
+                              bounces(rng), last != 0});
+            last = t;
+        }
+    }
+    return events;
+}
+
+/**
+ * @brief Hace correr el monitor sobre una secuencia de eventos.
+ *
+ * @param raisedAt Instante y banderas de cada anomalía levantada.
+ */
+static void runMonitor(const std::vector<monitorEvent_t>& events,
+                       std::vector<std::pair<uint32_t, uint8_t>>* raisedAt) {
+    tipMonitor_t monitor;
+    tipMonitorInit(&monitor, events.empty() ? TIME_INI : events.front().time);
+    for (const monitorEvent_t& event : events) {
+        uint8_t raised = event.tip ? tipMonitorAddInterval(&monitor, event.time, event.intervalMs) : 0;
+        if (event.bounces > 0) {
+            raised |= tipMonitorAddRejections(&monitor, event.time, event.bounces);
+        }
+        if (raised != 0) {
+            raisedAt->push_back({event.time, raised});
+        }
+    }
+}
+
+/**
+ * @brief Verifica el monitor: sin falsos positivos en tormentas limpias y una detección por anomalía inyectada.
+ *
+ * @return Falsos positivos, anomalías no detectadas y detecciones repetidas.
+ */
+static uint64_t checkMonitor(uint32_t days, std::mt19937_64& rng, uint64_t* stormTips) {
+    uint64_t errors = 0;
+    std::vector<monitorEvent_t> clean = stormEvents(days, rng);
+    std::vector<std::pair<uint32_t, uint8_t>> raised;
+
+    runMonitor(clean, &raised);
+    *stormTips = clean.size();
+    if (!raised.empty()) {
+        fprintf(stderr, "tormenta limpia: %zu anomalías, la primera 0x%02x en %lu\n", raised.size(),
+                raised.front().second, (unsigned long)raised.front().first);
+        errors += raised.size();
+    }
+
+    // Inyecciones en medio de la traza: un contacto que vibra sin volcar durante
+    // 5 ventanas y uno que rebota más que DEBOUNCE_TIME, cada tanto
+    std::uniform_int_distribution<size_t> where(1, clean.size() - 2);
+    for (int round = 0; round < 20; round++) {
+        std::vector<monitorEvent_t> events(clean);
+        size_t at = where(rng);
+        uint32_t start = events[at].time;
+        bool flood = round % 2 == 0;
+        std::vector<monitorEvent_t> injected;
+        if (flood) {
+            // 40 rebotes por segundo leídos cada segundo, durante 5 ventanas
+            for (uint32_t s = 0; s < 5 * TIP_STATS_WINDOW_SECONDS; s++) {
+                injected.push_back({start + s, 0, 40, false});
+            }
+        } else {
+            // Un tick cada 100 ms durante 1 s
+            for (uint32_t i = 0; i < 10; i++) {
+                injected.push_back({start + i / 10, 100, 0, true});
+            }
+        }
+        // Lo inyectado reemplaza a los ticks del mismo lapso
+        uint32_t end = injected.back().time;
+        std::vector<monitorEvent_t> merged(events.begin(), events.begin() + at);
+        merged.insert(merged.end(), injected.begin(), injected.end());
+        for (size_t i = at; i < events.size(); i++) {
+            if (events[i].time > end) {
+                merged.push_back(events[i]);
+            }
+        }
+
+        raised.clear();
+        runMonitor(merged, &raised);
+        uint8_t expected = flood ? TIP_ANOMALY_BOUNCE_FLOOD : TIP_ANOMALY_CHATTER;
+        size_t detections = 0;
+        bool inTime = false;
+        for (const std::pair<uint32_t, uint8_t>& r : raised) {
+            if (r.second & expected) {
+                detections++;
+                inTime = r.first >= start && r.first < start + TIP_STATS_WINDOW_SECONDS;
+            }
+        }
+        if (detections != 1 || !inTime || raised.size() != 1) {
+            fprintf(stderr, "%s en %lu: %zu detecciones, %zu anomalías\n", flood ? "rebotes" : "contacto",
+                    (unsigned long)start, detections, raised.size());
+            errors++;
+        }
+    }
+    return errors;
+}
+
+/**
+ * @brief Mide el costo de cada operación sobre intervalos precalculados.
+ */
+static void bench(std::mt19937_64& rng) {
+    static tipStats_t stats;
+    static tipStats_t other;
+    std::lognormal_distribution<double> storm(log(20000.0), 1.2);
+    std::vector<uint32_t> values(BENCH_VALUES);
+    for (uint32_t& value : values) {
+        value = (uint32_t)std::min(storm(rng), 4e9);
+    }
+
+    tipStatsInit(&stats);
+    uint64_t updates = 0;
+    auto begin = std::chrono::steady_clock::now();
+    do {
+        for (uint32_t value : values) {
+            tipStatsAddInterval(&stats, value);
+        }
+        updates += BENCH_VALUES;
+    } while (secondsSince(begin) < BENCH_SECONDS);
+    double updateNs = secondsSince(begin) * 1e9 / (double)updates;
+
+    tipMonitor_t monitor;
+    tipMonitorInit(&monitor, TIME_INI);
+    uint64_t monitorUpdates = 0;
+    uint32_t flags = 0;
+    uint32_t now = TIME_INI;
+    begin = std::chrono::steady_clock::now();
+    do {
+        for (uint32_t value : values) {
+            now += value / 1000;
+            flags |= tipMonitorAddInterval(&monitor, now, value);
+            flags |= tipMonitorAddRejections(&monitor, now, value & 7);
+        }
+        monitorUpdates += BENCH_VALUES;
+    } while (secondsSince(begin) < BENCH_SECONDS);
+    double monitorNs = secondsSince(begin) * 1e9 / (double)monitorUpdates;
+
+    tipStatsInit(&other);
+    for (uint32_t value : values) {
+        tipStatsAddInterval(&other, value);
+    }
+    uint64_t merges = 0;
+    begin = std::chrono::steady_clock::now();
+    do {
+        for (int i = 0; i < 1024; i++) {
+            tipStatsMerge(&stats, &other);
+        }
+        merges += 1024;
+    } while (secondsSince(begin) < BENCH_SECONDS);
+    double mergeNs = secondsSince(begin) * 1e9 / (double)merges;
+
+    uint64_t queries = 0;
+    uint64_t sink = 0;
+    begin = std::chrono::steady_clock::now();
+    do {
+        for (int i = 0; i < 1024; i++) {
+            sink += tipStatsQuantile(&stats, permilles[i % 10]);
+        }
+        queries += 1024;
+    } while (secondsSince(begin) < BENCH_SECONDS);
+    double queryNs = secondsSince(begin) * 1e9 / (double)queries;
+
+    printf("memoria           : %zu bytes por estadística, %zu por monitor\n", sizeof(tipStats_t),
+           sizeof(tipMonitor_t));
+    printf("registro          : %.1f ns por intervalo (%llu intervalos)\n", updateNs, (unsigned long long)updates);
+    printf("monitor           : %.1f ns por tick con su lectura de rebotes (banderas 0x%02x)\n", monitorNs,
+           (unsigned)flags);
+    printf("combinación       : %.0f ns por par de estadísticas\n", mergeNs);
+    printf("cuantil           : %.0f ns por consulta (suma %llu)\n", queryNs, (unsigned long long)(sink & 0xFF));
+}
+
+/**
+ * @brief Estadísticas de los ticks de una salida de texto del pluviómetro y anomalías que informó.
+ *
+ * Los intervalos tienen la resolución de 1 s del texto, así que el monitor
+ * (que distingue intervalos de menos de TIP_STATS_SHORT_MS) no se aplica.
+ */
+static int runTrace(const char* path) {
+    FILE* input = fopen(path, "r");
+    if (input == NULL) {
+        perror(path);
+        return 1;
+    }
+    static tipStats_t stats;
+    std::vector<uint32_t> values;
+    char line[256];
+    uint32_t last = 0;
+    uint64_t anomalies = 0;
+    tipStatsInit(&stats);
+    while (fgets(line, sizeof(line), input) != NULL) {
+        logRecord_t record;
+        if (!logParseText(line, strlen(line), &record)) {
+            continue;
+        }
+        if (record.id == LOG_EVENT_TIP_ANOMALY) {
+            anomalies++;
+            stats.anomalies |= (uint8_t)record.arg;
+        }
+        if (record.id != LOG_EVENT_RAIN_DETECTED) {
+            continue;
+        }
+        if (last != 0 && record.timestamp >= last) {
+            uint64_t interval = (uint64_t)(record.timestamp - last) * 1000;
+            uint32_t intervalMs = interval < UINT32_MAX ? (uint32_t)interval : UINT32_MAX;
+            tipStatsAddInterval(&stats, intervalMs);
+            values.push_back(intervalMs);
+        }
+        last = record.timestamp;
+    }
+    fclose(input);
+    if (values.empty()) {
+        fprintf(stderr, "la traza no tiene intervalos\n");
+        return 1;
+    }
+
+    double worst;
+    uint64_t errors = checkAccuracy(&stats, values, &worst);
+    printf("intervalos        : n=%lu min=%lu p50=%lu p90=%lu p99=%lu max=%lu ms\n",
+           (unsigned long)stats.intervals.count, (unsigned long)stats.intervals.min,
+           (unsigned long)tipStatsQuantile(&stats, 500), (unsigned long)tipStatsQuantile(&stats, 900),
+           (unsigned long)tipStatsQuantile(&stats, 990), (unsigned long)stats.intervals.max);
+    printf("media             : %.0f ms, desvío %.0f ms\n", stats.mean, sqrt(tipStatsVariance(&stats)));
+    printf("anomalías         : %llu informadas (banderas 0x%02x)\n", (unsigned long long)anomalies,
+           (unsigned)stats.anomalies);
+    printf("errores           : %llu (cuantiles hasta %.2f %% por encima)\n", (unsigned long long)errors,
+           worst * 100.0);
+    return errors == 0 ? 0 : 1;
+}
+
+static int usage(const char* program) {
+    fprintf(stderr,
+            "uso: %s [--count n] [--days n] [--seed n]\n"
+            "     %s --trace archivo\n",
+            program, program);
+    return 2;
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char* argv[]) {
+    size_t count = 1000000;
+    uint32_t days = 365;
+    uint64_t seed = 1;
+    const char* trace = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            count = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--days") == 0 && i + 1 < argc) {
+            days = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace = argv[++i];
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (trace != NULL) {
+        return runTrace(trace);
+    }
+    if (count < 2 || days == 0 || days > 3650) {
+        return usage(argv[0]);
+    }
+
+    std::mt19937_64 rng(seed);
+    static tipStats_t stats;
+    uint64_t errors = 0;
+    for (const sample_t& sample : buildSamples(count, rng)) {
+        tipStatsInit(&stats);
+        for (uint32_t value : sample.values) {
+            tipStatsAddInterval(&stats, value);
+        }
+        double worst;
+        uint64_t accuracyErrors = checkAccuracy(&stats, sample.values, &worst);
+        uint64_t mergeErrors = checkMerge(sample.values, &stats, rng);
+        printf("%-18s: p50=%lu p99=%lu ms, cuantiles hasta %.2f %% por encima, %llu errores, %llu al combinar\n",
+               sample.name, (unsigned long)tipStatsQuantile(&stats, 500), (unsigned long)tipStatsQuantile(&stats, 990),
+               worst * 100.0, (unsigned long long)accuracyErrors, (unsigned long long)mergeErrors);
+        errors += accuracyErrors + mergeErrors;
+    }
+
+    uint64_t stormTips = 0;
+    uint64_t monitorErrors = checkMonitor(days, rng, &stormTips);
+    printf("monitor           : %llu ticks en %u días, 10 inundaciones de rebotes y 10 contactos inyectados, "
+           "%llu errores\n",
+           (unsigned long long)stormTips, (unsigned)days, (unsigned long long)monitorErrors);
+    errors += monitorErrors;
+
+    bench(rng);
+    printf("errores           : %llu\n", (unsigned long long)errors);
+    return errors == 0 ? 0 : 1;
+}
+
+/* === End of documentation ==================================================================== */